@@ -0,0 +1,85 @@
+/**
+ * @file bio_accel.c
+ *
+ * @brief Batched writer of host accelerometer samples to the sensor hub input FIFO
+ */
+
+#include <string.h>
+
+#include "bio_accel.h"
+
+
+void bioAccelInit(struct bioAccelFifo *fifo){
+    memset(fifo, 0, sizeof(*fifo));
+}
+
+
+bool bioAccelPush(struct bioAccelFifo *fifo, const struct bioAccelSample *sample){
+    uint16_t in = fifo->in;
+
+    if((uint16_t)(in - fifo->out) >= BIO_ACCEL_QUEUE_SIZE){ //full
+        fifo->dropped++;
+        return false;
+    }
+    fifo->queue[in & (BIO_ACCEL_QUEUE_SIZE - 1)] = *sample;
+    fifo->in = in + 1; //publish after the sample is in place
+    fifo->pushed++;
+    return true;
+}
+
+
+uint8_t bioAccelFlush(struct bioAccelFifo *fifo){
+    struct bioAccelSample burst[BIO_ACCEL_MAX_BURST];
+    uint16_t out = fifo->out;
+    uint16_t queued = (uint16_t)(fifo->in - out);
+    uint16_t numSamples;
+    uint16_t hubCount;
+    uint8_t statusByte = SUCCESS;
+    uint16_t i;
+
+    if(queued == 0){
+        return SUCCESS;
+    }
+
+    if(fifo->hubSize == 0){ //first flush
+        fifo->hubSize = readInputFifoSize(&statusByte);
+        if(statusByte != SUCCESS){
+            fifo->hubSize = 0;
+            return statusByte;
+        }
+        fifo->hubRoom = 0;
+    }
+
+    if(queued > fifo->hubRoom){ //may not fit: the hub took samples since, read how many are left
+        hubCount = readInputFifoCount(&statusByte);
+        fifo->roomReads++;
+        if(statusByte != SUCCESS){
+            return statusByte;
+        }
+        fifo->hubRoom = hubCount < fifo->hubSize ? fifo->hubSize - hubCount : 0;
+    }
+
+    numSamples = queued < fifo->hubRoom ? queued : fifo->hubRoom;
+    if(numSamples > BIO_ACCEL_MAX_BURST){
+        numSamples = BIO_ACCEL_MAX_BURST;
+    }
+    if(numSamples == 0){ //input FIFO full, the hub is behind
+        return SUCCESS;
+    }
+
+    for(i = 0; i < numSamples; i++){ //contiguous copy of the burst, the queue may wrap
+        burst[i] = fifo->queue[(uint16_t)(out + i) & (BIO_ACCEL_QUEUE_SIZE - 1)];
+    }
+
+    statusByte = writeInputFifo(burst, (uint8_t)numSamples);
+    if(statusByte != SUCCESS){
+        fifo->hubRoom = 0; //unknown what was taken, read it again next time
+        return statusByte;
+    }
+
+    fifo->out = out + numSamples;
+    fifo->hubRoom -= numSamples;
+    fifo->written += numSamples;
+    fifo->bursts++;
+    return SUCCESS;
+}
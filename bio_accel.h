@@ -0,0 +1,83 @@
+/**
+ * @file bio_accel.h
+ *
+ * @brief Batched writer of host accelerometer samples to the sensor hub input FIFO
+ *
+ *  With the host accelerometer enabled (hostAccelControl()), the sensor hub pairs every MAX30101 sample with one
+ *  accelerometer sample from its input FIFO for motion compensation. Writing each sample as it is read costs a
+ *  transaction and a CMD_DELAY per sample. Here the samples are queued on the host by bioAccelPush() (e.g. from the
+ *  accelerometer read) and sent by bioAccelFlush() in bursts of up to BIO_ACCEL_MAX_BURST samples.
+ *
+ *  A burst is sized by the free space of the input FIFO, so the hub never drops a sample. The free space is read
+ *  (input FIFO size once, then READ_NUM_SAMPLES_INPUT) only when the queued samples may not fit: after a write, the
+ *  space known free minus the samples written stays a safe lower bound, since the hub only ever takes samples out.
+ *
+ *  The hub uses one input sample per sample it produces, so the accelerometer stream has to lead the PPG stream by
+ *  at least one flush period of samples. Queue that many samples and flush before enabling the MAX30101.
+ *
+ *  One task may push and one task may flush (they may be the same). Samples pushed while the queue is full are
+ *  dropped and counted.
+ */
+
+#ifndef BIO_ACCEL_H_
+#define BIO_ACCEL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bio_sensor.h"
+
+#define BIO_ACCEL_QUEUE_SIZE  64 //samples queued on the host, power of two
+
+
+/**
+ * @brief Struct of the host side queue and its counters
+ */
+struct bioAccelFifo {
+
+  struct bioAccelSample queue[BIO_ACCEL_QUEUE_SIZE]; ///< Samples not yet sent
+  volatile uint16_t in; ///< Free running index of the next sample pushed, written by bioAccelPush()
+  volatile uint16_t out; ///< Free running index of the next sample sent, written by bioAccelFlush()
+  uint16_t hubSize; ///< Input FIFO size, 0 until read
+  uint16_t hubRoom; ///< Samples the input FIFO is known to have room for
+  uint32_t pushed; ///< Samples accepted by bioAccelPush()
+  uint32_t dropped; ///< Samples dropped because the queue was full
+  uint32_t written; ///< Samples written to the input FIFO
+  uint32_t bursts; ///< Write transactions
+  uint32_t roomReads; ///< READ_NUM_SAMPLES_INPUT reads done to size a burst
+
+};
+
+
+/**
+ * @brief   Clears the queue and its counters. Call again after a hub reset
+ *
+ * @param   *fifo Pointer to queue
+ */
+void bioAccelInit(struct bioAccelFifo *fifo);
+
+
+/**
+ * @brief   Queues one accelerometer sample. No bus traffic
+ *
+ * @param   *fifo   Pointer to queue
+ * @param   *sample Pointer to sample
+ *
+ * @return  true if queued, false if the queue was full (the sample is dropped)
+ */
+bool bioAccelPush(struct bioAccelFifo *fifo, const struct bioAccelSample *sample);
+
+
+/**
+ * @brief   Sends the queued samples that fit in the input FIFO, oldest first, in one transaction. Call it at least
+ *          once per BIO_ACCEL_MAX_BURST samples (e.g. as a bio_sched.h task)
+ *
+ * @pre     hostAccelControl(1)
+ *
+ * @param   *fifo Pointer to queue
+ *
+ * @return  SUCCESS (also when nothing was sent), or the status byte of the failing read or write
+ */
+uint8_t bioAccelFlush(struct bioAccelFifo *fifo);
+
+#endif /* BIO_ACCEL_H_ */
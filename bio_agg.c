@@ -0,0 +1,153 @@
+/**
+ * @file bio_agg.c
+ *
+ * @brief Confidence-weighted windowed aggregation of the algorithm outputs
+ */
+
+#include <string.h>
+
+#include "bio_agg.h"
+
+#define BIO_AGG_FINGER  3 //bioData.status with a finger detected
+
+
+/**
+ * @brief   Clears the running sums for the next interval
+ */
+static void bioAggClear(struct bioAgg *agg){
+    agg->count = 0;
+    agg->used = 0;
+    agg->noFinger = 0;
+    agg->motion = 0;
+    agg->pressure = 0;
+    agg->confidenceSum = 0;
+    agg->heartRateWeight = 0;
+    agg->heartRateSum = 0;
+    agg->heartRateMin = 0xFFFF;
+    agg->heartRateMax = 0;
+    agg->oxygenWeight = 0;
+    agg->oxygenSum = 0;
+    agg->oxygenMin = 0xFFFF;
+    agg->oxygenMax = 0;
+}
+
+
+uint8_t bioAggInit(struct bioAgg *agg, uint16_t sampleRate, uint16_t intervalS){
+    uint32_t interval = (uint32_t)sampleRate * intervalS;
+
+    if(interval == 0 || interval > BIO_AGG_MAX_INTERVAL){
+        return INCORR_PARAM;
+    }
+
+    memset(agg, 0, sizeof(*agg));
+    agg->interval = (uint16_t)interval;
+    bioAggClear(agg);
+    return SUCCESS;
+}
+
+
+/**
+ * @brief   Writes the summary of the current interval
+ */
+static void bioAggSummarize(struct bioAgg *agg){
+    struct bioAggSummary *s = &agg->summary;
+
+    s->sequence = agg->sequence++;
+    s->samples = agg->count;
+    s->used = agg->used;
+    s->noFinger = agg->noFinger;
+    s->motion = agg->motion;
+    s->pressure = agg->pressure;
+    s->heartRateMin = agg->heartRateMin == 0xFFFF ? 0 : agg->heartRateMin;
+    s->heartRateMax = agg->heartRateMax;
+    s->heartRateMeanX10 = agg->heartRateWeight ?
+            (uint16_t)((agg->heartRateSum * 10 + agg->heartRateWeight / 2) / agg->heartRateWeight) : 0;
+    s->oxygenMin = agg->oxygenMin == 0xFFFF ? 0 : (uint8_t)agg->oxygenMin;
+    s->oxygenMax = (uint8_t)agg->oxygenMax;
+    s->oxygenMeanX10 = agg->oxygenWeight ?
+            (uint16_t)((agg->oxygenSum * 10 + agg->oxygenWeight / 2) / agg->oxygenWeight) : 0;
+    s->confidence = agg->used ? (uint8_t)(agg->confidenceSum / agg->used) : 0;
+}
+
+
+bool bioAggUpdate(struct bioAgg *agg, const struct bioData *body){
+    agg->count++;
+
+    if(body->status != BIO_AGG_FINGER || body->extStatus == -1 || body->extStatus == -3 || body->extStatus == -5){
+        agg->noFinger++;
+    }
+    else if(body->extStatus == -2 || body->extStatus == -6){ //device or finger motion
+        agg->motion++;
+    }
+    else if(body->extStatus == -4){ //pressing too hard
+        agg->pressure++;
+    }
+    else{
+        bool extreme = body->confidence >= BIO_AGG_EXTREME_CONFIDENCE;
+
+        agg->used++;
+        agg->confidenceSum += body->confidence;
+        if(body->heartRate != 0){
+            agg->heartRateWeight += body->confidence;
+            agg->heartRateSum += (uint32_t)body->confidence * body->heartRate;
+            if(extreme && body->heartRate < agg->heartRateMin) agg->heartRateMin = body->heartRate;
+            if(extreme && body->heartRate > agg->heartRateMax) agg->heartRateMax = body->heartRate;
+        }
+        if(body->oxygen != 0){
+            agg->oxygenWeight += body->confidence;
+            agg->oxygenSum += (uint32_t)body->confidence * body->oxygen;
+            if(extreme && body->oxygen < agg->oxygenMin) agg->oxygenMin = body->oxygen;
+            if(extreme && body->oxygen > agg->oxygenMax) agg->oxygenMax = body->oxygen;
+        }
+    }
+
+    if(agg->count < agg->interval){
+        return false;
+    }
+    bioAggSummarize(agg);
+    bioAggClear(agg);
+    return true;
+}
+
+
+/**
+ * @brief   Writes a 16-bit value little endian
+ */
+static void bioAggPut16(uint8_t *out, uint16_t value){
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+}
+
+
+void bioAggPack(const struct bioAggSummary *summary, uint8_t *out){
+    bioAggPut16(&out[0], summary->sequence);
+    bioAggPut16(&out[2], summary->samples);
+    bioAggPut16(&out[4], summary->used);
+    bioAggPut16(&out[6], summary->noFinger);
+    bioAggPut16(&out[8], summary->motion);
+    bioAggPut16(&out[10], summary->pressure);
+    bioAggPut16(&out[12], summary->heartRateMin);
+    bioAggPut16(&out[14], summary->heartRateMax);
+    bioAggPut16(&out[16], summary->heartRateMeanX10);
+    out[18] = summary->oxygenMin;
+    out[19] = summary->oxygenMax;
+    bioAggPut16(&out[20], summary->oxygenMeanX10);
+    out[22] = summary->confidence;
+}
+
+
+void bioAggUnpack(const uint8_t *in, struct bioAggSummary *summary){
+    summary->sequence = (uint16_t)(in[0] | (in[1] << 8));
+    summary->samples = (uint16_t)(in[2] | (in[3] << 8));
+    summary->used = (uint16_t)(in[4] | (in[5] << 8));
+    summary->noFinger = (uint16_t)(in[6] | (in[7] << 8));
+    summary->motion = (uint16_t)(in[8] | (in[9] << 8));
+    summary->pressure = (uint16_t)(in[10] | (in[11] << 8));
+    summary->heartRateMin = (uint16_t)(in[12] | (in[13] << 8));
+    summary->heartRateMax = (uint16_t)(in[14] | (in[15] << 8));
+    summary->heartRateMeanX10 = (uint16_t)(in[16] | (in[17] << 8));
+    summary->oxygenMin = in[18];
+    summary->oxygenMax = in[19];
+    summary->oxygenMeanX10 = (uint16_t)(in[20] | (in[21] << 8));
+    summary->confidence = in[22];
+}
@@ -0,0 +1,140 @@
+/**
+ * @file bio_agg.h
+ *
+ * @brief Confidence-weighted windowed aggregation of the algorithm outputs
+ *
+ *  The hub reports heartRate, oxygen and confidence with every sample, far more than a backend needs. Each sample of
+ *  the algorithm path (readAlgoData(), readRawAndAlgoData() or readSensorData() in SENSOR_AND_ALGORITHM mode) goes
+ *  through bioAggUpdate(), which adds it to running sums, and every interval one struct bioAggSummary is emitted:
+ *
+ *  - samples the hub flagged are counted and left out: no finger (status not 3, extStatus -1, -3 or -5), motion
+ *    (extStatus -2 or -6) and pressure (extStatus -4)
+ *
+ *  - the means of heartRate and oxygen are weighted by confidence, so the samples of a settling algorithm count
+ *    less. Values of 0 (not computed yet) are left out of their mean
+ *
+ *  - the minimum and maximum only take samples with at least BIO_AGG_EXTREME_CONFIDENCE, so a low confidence spike
+ *    is not reported as an extreme
+ *
+ *  bioAggPack() writes a summary in BIO_AGG_PACKED_SIZE bytes, against BIO_FRAME_SAMPLE_SIZE bytes per sample in
+ *  bio_frame.h, all multi-byte fields little endian:
+ *
+ *  | offset | size | field            |
+ *  |--------|------|------------------|
+ *  | 0      | 2    | sequence         |
+ *  | 2      | 2    | samples          |
+ *  | 4      | 2    | used             |
+ *  | 6      | 2    | noFinger         |
+ *  | 8      | 2    | motion           |
+ *  | 10     | 2    | pressure         |
+ *  | 12     | 2    | heartRateMin     |
+ *  | 14     | 2    | heartRateMax     |
+ *  | 16     | 2    | heartRateMeanX10 |
+ *  | 18     | 1    | oxygenMin        |
+ *  | 19     | 1    | oxygenMax        |
+ *  | 20     | 2    | oxygenMeanX10    |
+ *  | 22     | 1    | confidence       |
+ */
+
+#ifndef BIO_AGG_H_
+#define BIO_AGG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bio_sensor.h"
+
+#define BIO_AGG_EXTREME_CONFIDENCE 50    //lowest confidence taken for the minimum and maximum, %
+#define BIO_AGG_MAX_INTERVAL       65535 //longest interval, samples
+#define BIO_AGG_PACKED_SIZE        23    //bytes per packed summary
+
+
+/**
+ * @brief Struct of one interval summary. heartRate and oxygen fields are in the units of struct bioData
+ */
+struct bioAggSummary {
+
+  uint16_t sequence; ///< Interval number since bioAggInit() (wraps)
+  uint16_t samples; ///< Samples in the interval
+  uint16_t used; ///< Samples aggregated (not flagged by the hub)
+  uint16_t noFinger; ///< Samples left out for no finger
+  uint16_t motion; ///< Samples left out for motion
+  uint16_t pressure; ///< Samples left out for pressure
+  uint16_t heartRateMin; ///< Lowest heart rate (0 without a confident one)
+  uint16_t heartRateMax; ///< Highest heart rate (0 without a confident one)
+  uint16_t heartRateMeanX10; ///< Confidence-weighted mean heart rate * 10 (0 without one)
+  uint8_t oxygenMin; ///< Lowest SpO2 (0 without a confident one)
+  uint8_t oxygenMax; ///< Highest SpO2 (0 without a confident one)
+  uint16_t oxygenMeanX10; ///< Confidence-weighted mean SpO2 * 10 (0 without one)
+  uint8_t confidence; ///< Mean confidence of the samples used, %
+
+};
+
+
+/**
+ * @brief Struct of the aggregator state
+ */
+struct bioAgg {
+
+  uint16_t interval; ///< Samples per interval
+  uint16_t sequence; ///< Number of the current interval
+  uint16_t count; ///< Samples in the current interval
+  uint16_t used; ///< Samples aggregated in the current interval
+  uint16_t noFinger; ///< Samples left out for no finger
+  uint16_t motion; ///< Samples left out for motion
+  uint16_t pressure; ///< Samples left out for pressure
+  uint32_t confidenceSum; ///< Confidence of the samples used
+  uint32_t heartRateWeight; ///< Confidence of the samples with a heart rate
+  uint64_t heartRateSum; ///< Confidence * heart rate
+  uint16_t heartRateMin; ///< Lowest confident heart rate, 0xFFFF for none
+  uint16_t heartRateMax; ///< Highest confident heart rate
+  uint32_t oxygenWeight; ///< Confidence of the samples with a SpO2
+  uint64_t oxygenSum; ///< Confidence * SpO2
+  uint16_t oxygenMin; ///< Lowest confident SpO2, 0xFFFF for none
+  uint16_t oxygenMax; ///< Highest confident SpO2
+  struct bioAggSummary summary; ///< Last complete interval
+
+};
+
+
+/**
+ * @brief   Clears the aggregator for an interval
+ *
+ * @param   *agg       Pointer to aggregator
+ * @param   sampleRate Rate of the algorithm samples, Hz (readADCSampleRate())
+ * @param   intervalS  Interval between summaries, s. sampleRate * intervalS must be 1 to BIO_AGG_MAX_INTERVAL
+ *
+ * @return  SUCCESS, or INCORR_PARAM for an interval out of range
+ */
+uint8_t bioAggInit(struct bioAgg *agg, uint16_t sampleRate, uint16_t intervalS);
+
+
+/**
+ * @brief   Adds one sample
+ *
+ * @param   *agg  Pointer to aggregator
+ * @param   *body Pointer to sample with algorithm output
+ *
+ * @return  true when an interval was completed, its summary is in agg->summary
+ */
+bool bioAggUpdate(struct bioAgg *agg, const struct bioData *body);
+
+
+/**
+ * @brief   Packs a summary in BIO_AGG_PACKED_SIZE bytes
+ *
+ * @param   *summary Pointer to summary
+ * @param   *out     Pointer to BIO_AGG_PACKED_SIZE bytes
+ */
+void bioAggPack(const struct bioAggSummary *summary, uint8_t *out);
+
+
+/**
+ * @brief   Unpacks a summary written by bioAggPack()
+ *
+ * @param   *in      Pointer to BIO_AGG_PACKED_SIZE bytes
+ * @param   *summary Pointer to summary to fill
+ */
+void bioAggUnpack(const uint8_t *in, struct bioAggSummary *summary);
+
+#endif /* BIO_AGG_H_ */
@@ -0,0 +1,186 @@
+/**
+ * @file bio_codec.c
+ *
+ * @brief Lossless compression of raw IR/red PPG counts, see bio_codec.h for the format
+ */
+
+#include <string.h>
+
+#include "bio_codec.h"
+
+
+/**
+ * @brief   Maps a signed difference to an unsigned value, small magnitudes first (0, -1, 1, -2, 2, ...)
+ */
+static uint32_t bioCodecZigzag(uint32_t current, uint32_t previous){
+    int32_t delta = (int32_t)(current - previous);
+
+    return ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+}
+
+
+static uint32_t bioCodecUnzigzag(uint32_t value){
+    return (value >> 1) ^ (uint32_t)-(int32_t)(value & 1);
+}
+
+
+/**
+ * @brief   Number of bits needed for a value, 0 for 0
+ */
+static uint8_t bioCodecWidth(uint32_t value){
+    uint8_t width = 0;
+
+    while(value){
+        width++;
+        value >>= 1;
+    }
+    return width;
+}
+
+
+void bioCodecInit(struct bioCodec *codec, uint16_t keyInterval){
+    memset(codec, 0, sizeof(*codec));
+    codec->keyInterval = keyInterval ? keyInterval : BIO_CODEC_KEY_INTERVAL;
+}
+
+
+void bioCodecKeyframe(struct bioCodec *codec){
+    codec->blocksToKey = 0;
+}
+
+
+uint16_t bioCodecFlush(struct bioCodec *codec, uint8_t *out){
+    uint32_t deltas[BIO_CODEC_BLOCK][2];
+    uint32_t orBits[2] = {0, 0}; //OR of the deltas of each channel, gives the width
+    uint8_t width[2];
+    uint8_t keyframe = (codec->blocksToKey == 0);
+    uint8_t first = keyframe; //first sample index coded as a delta
+    uint16_t header;
+    uint16_t size = BIO_CODEC_HEADER_SIZE;
+    uint32_t bits = 0; //bit accumulator
+    uint8_t numBits = 0;
+    uint8_t i, ch;
+
+    if(codec->count == 0){ //nothing to write
+        return 0;
+    }
+
+    if(keyframe){ //first sample in full, deltas start from it
+        for(ch = 0; ch < 2; ch++){
+            codec->previous[ch] = codec->pending[0][ch];
+        }
+    }
+
+    for(i = first; i < codec->count; i++){
+        for(ch = 0; ch < 2; ch++){
+            deltas[i][ch] = bioCodecZigzag(codec->pending[i][ch], codec->previous[ch]);
+            codec->previous[ch] = codec->pending[i][ch];
+            orBits[ch] |= deltas[i][ch];
+        }
+    }
+    width[0] = bioCodecWidth(orBits[0]);
+    width[1] = bioCodecWidth(orBits[1]);
+
+    header = (uint16_t)(((codec->count - 1) << BIO_CODEC_COUNT_SHIFT) | (width[1] << BIO_CODEC_RED_SHIFT) | width[0]);
+    if(keyframe){
+        header |= BIO_CODEC_KEYFRAME_MASK;
+    }
+    out[0] = (uint8_t)header;
+    out[1] = (uint8_t)(header >> 8);
+
+    if(keyframe){ //24-bit IR and red counts of the first sample
+        for(ch = 0; ch < 2; ch++){
+            out[size++] = (uint8_t)codec->pending[0][ch];
+            out[size++] = (uint8_t)(codec->pending[0][ch] >> 8);
+            out[size++] = (uint8_t)(codec->pending[0][ch] >> 16);
+        }
+        codec->blocksToKey = codec->keyInterval;
+    }
+    codec->blocksToKey--;
+
+    for(i = first; i < codec->count; i++){ //pack LSB first
+        for(ch = 0; ch < 2; ch++){
+            bits |= deltas[i][ch] << numBits; //width <= 25, so at most 7 + 25 bits are held
+            numBits += width[ch];
+            while(numBits >= 8){
+                out[size++] = (uint8_t)bits;
+                bits >>= 8;
+                numBits -= 8;
+            }
+        }
+    }
+    if(numBits){ //pad the last byte
+        out[size++] = (uint8_t)bits;
+    }
+
+    codec->count = 0;
+    return size;
+}
+
+
+uint16_t bioCodecEncode(struct bioCodec *codec, uint32_t irLed, uint32_t redLed, uint8_t *out){
+    codec->pending[codec->count][0] = irLed & 0xFFFFFF;
+    codec->pending[codec->count][1] = redLed & 0xFFFFFF;
+
+    if(++codec->count < BIO_CODEC_BLOCK){ //block not full yet
+        return 0;
+    }
+    return bioCodecFlush(codec, out);
+}
+
+
+uint16_t bioCodecDecode(struct bioCodec *codec, const uint8_t *in, uint16_t len, uint32_t *irLed, uint32_t *redLed, uint8_t *numSamples){
+    uint16_t header;
+    uint8_t keyframe, count, width[2];
+    uint16_t size;
+    uint32_t bits = 0;
+    uint8_t numBits = 0;
+    uint16_t pos;
+    uint8_t i, ch;
+
+    *numSamples = 0;
+    if(len < BIO_CODEC_HEADER_SIZE){
+        return 0;
+    }
+
+    header = (uint16_t)(in[0] | (in[1] << 8));
+    keyframe = (header & BIO_CODEC_KEYFRAME_MASK) != 0;
+    count = (uint8_t)(((header >> BIO_CODEC_COUNT_SHIFT) & 0x07) + 1);
+    width[0] = header & BIO_CODEC_WIDTH_MASK;
+    width[1] = (header >> BIO_CODEC_RED_SHIFT) & BIO_CODEC_WIDTH_MASK;
+
+    pos = BIO_CODEC_HEADER_SIZE + (keyframe ? BIO_CODEC_KEY_SIZE : 0);
+    size = pos + ((count - keyframe) * (width[0] + width[1]) + 7) / 8;
+    if(len < size){ //block not complete
+        return 0;
+    }
+
+    if(keyframe){
+        for(ch = 0; ch < 2; ch++){
+            codec->previous[ch] = (uint32_t)in[2 + 3 * ch] | ((uint32_t)in[3 + 3 * ch] << 8) | ((uint32_t)in[4 + 3 * ch] << 16);
+        }
+        irLed[0] = codec->previous[0];
+        redLed[0] = codec->previous[1];
+        codec->synced = 1;
+    }
+    else if(!codec->synced){ //deltas without a starting point
+        return size;
+    }
+
+    for(i = keyframe; i < count; i++){
+        for(ch = 0; ch < 2; ch++){
+            while(numBits < width[ch]){ //refill the accumulator
+                bits |= (uint32_t)in[pos++] << numBits;
+                numBits += 8;
+            }
+            codec->previous[ch] = (codec->previous[ch] + bioCodecUnzigzag(bits & ((1UL << width[ch]) - 1))) & 0xFFFFFF;
+            bits >>= width[ch];
+            numBits -= width[ch];
+        }
+        irLed[i] = codec->previous[0];
+        redLed[i] = codec->previous[1];
+    }
+
+    *numSamples = count;
+    return size;
+}
@@ -0,0 +1,110 @@
+/**
+ * @file bio_codec.h
+ *
+ * @brief Lossless compression of raw IR/red PPG counts for UART streaming and flash logging
+ *
+ *  Samples are coded in blocks of up to BIO_CODEC_BLOCK. Each channel is delta coded against the previous sample,
+ *  zigzag mapped to an unsigned value and bit packed at the width of the largest value of the block, so a block of
+ *  slowly changing counts takes a few bits per sample instead of 24. A keyframe block holds its first sample in full,
+ *  every keyInterval blocks, so a decoder can start (or restart after lost data) at any keyframe.
+ *
+ *  Block layout (little endian):
+ *
+ *  | size            | field                                                                              |
+ *  |-----------------|------------------------------------------------------------------------------------|
+ *  | 2               | header: bit 15 keyframe, bits 12-14 samples - 1, bits 5-9 red width, bits 0-4 IR width |
+ *  | 6 (keyframe)    | first sample, IR then red, 24 bits each                                            |
+ *  | packed          | zigzag deltas, IR then red per sample, LSB first, padded to a byte                 |
+ *
+ *  A keyframe block has one delta less per channel (its first sample is sent in full).
+ */
+
+#ifndef BIO_CODEC_H_
+#define BIO_CODEC_H_
+
+#include <stdint.h>
+
+#define BIO_CODEC_BLOCK           8   //samples per block
+#define BIO_CODEC_KEY_INTERVAL    16  //default blocks between keyframes (128 samples)
+#define BIO_CODEC_HEADER_SIZE     2
+#define BIO_CODEC_KEY_SIZE        6   //first sample of a keyframe block
+#define BIO_CODEC_MAX_WIDTH       25  //zigzag of a 24-bit difference
+#define BIO_CODEC_MAX_BLOCK_SIZE  (BIO_CODEC_HEADER_SIZE + BIO_CODEC_KEY_SIZE + (BIO_CODEC_BLOCK * 2 * BIO_CODEC_MAX_WIDTH + 7) / 8)
+
+#define BIO_CODEC_KEYFRAME_MASK   0x8000
+#define BIO_CODEC_COUNT_SHIFT     12
+#define BIO_CODEC_RED_SHIFT       5
+#define BIO_CODEC_WIDTH_MASK      0x1F
+
+
+/**
+ * @brief Struct of an encoder or decoder. Clear with bioCodecInit()
+ */
+struct bioCodec {
+
+  uint32_t previous[2]; ///< Last IR and red counts coded
+  uint32_t pending[BIO_CODEC_BLOCK][2]; ///< Encoder: samples of the block being filled
+  uint16_t keyInterval; ///< Blocks between keyframes
+  uint16_t blocksToKey; ///< Blocks until the next keyframe, 0 when the next block is a keyframe
+  uint8_t  count; ///< Encoder: samples in pending
+  uint8_t  synced; ///< Decoder: a keyframe has been decoded
+
+};
+
+
+/**
+ * @brief   Clears an encoder or decoder. The first block an encoder produces is a keyframe
+ *
+ * @param   *codec      Pointer to codec
+ * @param   keyInterval Blocks between keyframes (0 for BIO_CODEC_KEY_INTERVAL, 1 for keyframes only)
+ */
+void bioCodecInit(struct bioCodec *codec, uint16_t keyInterval);
+
+
+/**
+ * @brief   Makes the next block a keyframe (e.g. after FIFO samples were dropped or a new log file was started)
+ *
+ * @param   *codec Pointer to encoder
+ */
+void bioCodecKeyframe(struct bioCodec *codec);
+
+
+/**
+ * @brief   Adds one sample to the encoder. Every BIO_CODEC_BLOCK samples a block is written
+ *
+ * @param   *codec  Pointer to encoder
+ * @param   irLed   IR LED ADC count (24-bit)
+ * @param   redLed  Red LED ADC count (24-bit)
+ * @param   *out    Pointer to at least BIO_CODEC_MAX_BLOCK_SIZE bytes
+ *
+ * @return  Number of bytes written to out, 0 while the block is not full
+ */
+uint16_t bioCodecEncode(struct bioCodec *codec, uint32_t irLed, uint32_t redLed, uint8_t *out);
+
+
+/**
+ * @brief   Writes the samples of a partially filled block (e.g. at the end of a recording)
+ *
+ * @param   *codec  Pointer to encoder
+ * @param   *out    Pointer to at least BIO_CODEC_MAX_BLOCK_SIZE bytes
+ *
+ * @return  Number of bytes written to out, 0 if no sample was pending
+ */
+uint16_t bioCodecFlush(struct bioCodec *codec, uint8_t *out);
+
+
+/**
+ * @brief   Decodes one block. Blocks received before the first keyframe are skipped
+ *
+ * @param   *codec      Pointer to decoder
+ * @param   *in         Pointer to coded bytes
+ * @param   len         Number of coded bytes available
+ * @param   *irLed      Pointer to BIO_CODEC_BLOCK IR counts to fill
+ * @param   *redLed     Pointer to BIO_CODEC_BLOCK red counts to fill
+ * @param   *numSamples Pointer to number of samples decoded (0 for a skipped block)
+ *
+ * @return  Number of bytes of the block, 0 if len does not hold a whole block
+ */
+uint16_t bioCodecDecode(struct bioCodec *codec, const uint8_t *in, uint16_t len, uint32_t *irLed, uint32_t *redLed, uint8_t *numSamples);
+
+#endif /* BIO_CODEC_H_ */
@@ -0,0 +1,131 @@
+/**
+ * @file bio_decim.c
+ *
+ * @brief CIC and polyphase FIR decimator between the FIFO drain and the sample consumers
+ */
+
+#include <string.h>
+
+#include "bio_decim.h"
+#include "bio_sensor.h"
+
+//Kaiser windowed sinc (cutoff 0.2, beta 5) at the intermediate rate, Q15, sums to 32768
+static const int16_t bioDecimTaps[BIO_DECIM_TAPS] = {
+    -52, -57, 92, 225, 0, -458, -388, 525, 1142, 0, -2112, -1869, 2948, 9829, 13118,
+    9829, 2948, -1869, -2112, 0, 1142, 525, -388, -458, 0, 225, 92, -57, -52
+};
+
+
+uint8_t bioDecimInit(struct bioDecim *decim, uint16_t inputRate, uint16_t outputRate){
+    uint16_t factor;
+    uint8_t k;
+
+    if(outputRate == 0 || inputRate % outputRate != 0){
+        return INCORR_PARAM;
+    }
+    factor = inputRate / outputRate;
+    if(factor > BIO_DECIM_MAX_FACTOR || (factor != 1 && factor % 2 != 0)){
+        return INCORR_PARAM;
+    }
+
+    memset(decim, 0, sizeof(*decim));
+    decim->factor = factor;
+    decim->cicFactor = factor / 2;
+    decim->cicGain = 1;
+    for(k = 0; k < BIO_DECIM_CIC_ORDER; k++){
+        decim->cicGain *= decim->cicFactor;
+    }
+    decim->keep = true;
+    decim->warmup = BIO_DECIM_CIC_ORDER;
+    return SUCCESS;
+}
+
+
+/**
+ * @brief   Runs the CIC combs of one channel and the FIR if this intermediate sample gives an output
+ *
+ * @return  Output count (only meaningful when decim->keep)
+ */
+static uint32_t bioDecimIntermediate(const struct bioDecim *decim, struct bioDecimChannel *ch){
+    uint64_t v = ch->integrator[BIO_DECIM_CIC_ORDER - 1];
+    int64_t acc = 0;
+    int32_t mid;
+    uint8_t k, slot;
+
+    for(k = 0; k < BIO_DECIM_CIC_ORDER; k++){
+        uint64_t delayed = ch->comb[k];
+        ch->comb[k] = v;
+        v -= delayed;
+    }
+    mid = (int32_t)((v * 16U + decim->cicGain / 2) / decim->cicGain); //counts * 16
+
+    if(decim->warmup != 0){
+        if(decim->warmup == 1){ //first complete output: prime the history
+            for(k = 0; k < BIO_DECIM_TAPS; k++){
+                ch->history[k] = mid;
+            }
+        }
+        return 0;
+    }
+    ch->history[decim->next] = mid;
+    if(!decim->keep){
+        return 0;
+    }
+
+    slot = decim->next;
+    for(k = 0; k < BIO_DECIM_TAPS; k++){ //newest to oldest, the taps are symmetric
+        acc += (int64_t)bioDecimTaps[k] * ch->history[slot];
+        slot = slot ? slot - 1 : BIO_DECIM_TAPS - 1;
+    }
+    acc = (acc + (1 << 18)) >> 19; //Q15 and counts * 16 to counts
+    return acc < 0 ? 0 : (uint32_t)acc;
+}
+
+
+uint16_t bioDecimProcess(struct bioDecim *decim, const uint32_t *irLed, const uint32_t *redLed, uint16_t numSamples,
+                         uint32_t *outIr, uint32_t *outRed){
+    const uint32_t *in[BIO_DECIM_CHANNELS] = {irLed, redLed};
+    uint32_t *out[BIO_DECIM_CHANNELS] = {outIr, outRed};
+    uint16_t numOut = 0;
+    uint16_t i;
+    uint8_t c;
+
+    if(decim->factor == 1){ //pass through
+        memcpy(outIr, irLed, numSamples * sizeof(uint32_t));
+        memcpy(outRed, redLed, numSamples * sizeof(uint32_t));
+        return numSamples;
+    }
+
+    for(i = 0; i < numSamples; i++){
+        for(c = 0; c < BIO_DECIM_CHANNELS; c++){ //integrators at the input rate
+            struct bioDecimChannel *ch = &decim->channel[c];
+            uint64_t v = in[c][i];
+            uint8_t k;
+            for(k = 0; k < BIO_DECIM_CIC_ORDER; k++){
+                ch->integrator[k] += v;
+                v = ch->integrator[k];
+            }
+        }
+        if(++decim->phase < decim->cicFactor){
+            continue;
+        }
+        decim->phase = 0;
+
+        for(c = 0; c < BIO_DECIM_CHANNELS; c++){ //combs and FIR at the intermediate rate
+            uint32_t v = bioDecimIntermediate(decim, &decim->channel[c]);
+            if(decim->warmup == 0 && decim->keep){
+                out[c][numOut] = v;
+            }
+        }
+        if(decim->warmup != 0){
+            decim->warmup--;
+            continue;
+        }
+        if(decim->keep){
+            numOut++;
+        }
+        decim->keep = !decim->keep;
+        decim->next = (uint8_t)((decim->next + 1) % BIO_DECIM_TAPS);
+    }
+    return numOut;
+}
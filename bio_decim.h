@@ -0,0 +1,94 @@
+/**
+ * @file bio_decim.h
+ *
+ * @brief CIC and polyphase FIR decimator between the FIFO drain and the sample consumers
+ *
+ *  The MAX30101 can sample at up to 3200Hz (readADCSampleRate()), while the consumers (bio_hr.h, bio_spo2.h, the
+ *  output paths) only need 25 - 100Hz. Sampling fast and decimating averages the noise down instead of aliasing it.
+ *  bioDecimProcess() takes a batch of drained IR/red counts and returns the decimated samples, in two stages:
+ *
+ *  - CIC: a third order cascaded integrator comb filter decimates by factor / 2. It needs no multiplications, and
+ *    its nulls fall on every multiple of the intermediate rate, where the noise and interference alias from
+ *
+ *  - FIR: a 29 tap low-pass with fixed Q15 taps decimates the intermediate rate by 2. It is evaluated only at the
+ *    outputs kept (the polyphase form of a decimating FIR) and removes what the CIC passes between the output
+ *    Nyquist frequency and the intermediate rate. Its passband is flat (0.05dB) to a fifth of the output rate, where
+ *    the CIC droop is under 0.3dB
+ *
+ *  Each channel keeps its own integrators, combs and FIR history, so batches can have any length and the output is
+ *  the same as processing one sample at a time. The CIC outputs are complete after BIO_DECIM_CIC_ORDER intermediate
+ *  samples; those are dropped and the FIR history is primed with the first complete one, so the output starts at the
+ *  signal level rather than ramping up from 0. The group delay is 3 * (factor / 2 - 1) / 2 input samples plus 14
+ *  intermediate samples.
+ */
+
+#ifndef BIO_DECIM_H_
+#define BIO_DECIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BIO_DECIM_MAX_FACTOR  128 //input rate / output rate, even (3200Hz to 25Hz)
+#define BIO_DECIM_CIC_ORDER   3   //CIC integrator/comb pairs
+#define BIO_DECIM_TAPS        29  //FIR taps
+#define BIO_DECIM_CHANNELS    2   //IR and red
+
+
+/**
+ * @brief Struct of the state of one channel
+ */
+struct bioDecimChannel {
+
+  uint64_t integrator[BIO_DECIM_CIC_ORDER]; ///< CIC integrators (modulo 2^64, only their differences matter)
+  uint64_t comb[BIO_DECIM_CIC_ORDER]; ///< CIC comb delays
+  int32_t history[BIO_DECIM_TAPS]; ///< Last intermediate samples, counts * 16, ring indexed by bioDecim.next
+
+};
+
+
+/**
+ * @brief Struct of the decimator state
+ */
+struct bioDecim {
+
+  uint16_t factor; ///< Input rate / output rate
+  uint16_t cicFactor; ///< CIC decimation, factor / 2
+  uint32_t cicGain; ///< cicFactor ^ BIO_DECIM_CIC_ORDER
+  uint16_t phase; ///< Input samples into the current CIC output
+  uint8_t next; ///< History slot of the next intermediate sample
+  bool keep; ///< The next intermediate sample gives an output
+  uint8_t warmup; ///< Incomplete CIC outputs still to drop
+  struct bioDecimChannel channel[BIO_DECIM_CHANNELS]; ///< IR, red
+
+};
+
+
+/**
+ * @brief   Clears the decimator for a rate pair
+ *
+ * @param   *decim     Pointer to decimator
+ * @param   inputRate  MAX30101 sample rate, Hz (readADCSampleRate())
+ * @param   outputRate Rate the consumers need, Hz. inputRate / outputRate must be 1 (pass through) or even, up to
+ *                     BIO_DECIM_MAX_FACTOR
+ *
+ * @return  SUCCESS, or INCORR_PARAM for a rate pair that does not fit
+ */
+uint8_t bioDecimInit(struct bioDecim *decim, uint16_t inputRate, uint16_t outputRate);
+
+
+/**
+ * @brief   Decimates a batch of samples
+ *
+ * @param   *decim      Pointer to decimator
+ * @param   *irLed      IR counts of the batch
+ * @param   *redLed     Red counts of the batch
+ * @param   numSamples  Samples in the batch
+ * @param   *outIr      Filled with the output IR counts, room for numSamples / factor + 1
+ * @param   *outRed     Filled with the output red counts, room for numSamples / factor + 1
+ *
+ * @return  Number of output samples
+ */
+uint16_t bioDecimProcess(struct bioDecim *decim, const uint32_t *irLed, const uint32_t *redLed, uint16_t numSamples,
+                         uint32_t *outIr, uint32_t *outRed);
+
+#endif /* BIO_DECIM_H_ */
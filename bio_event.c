@@ -0,0 +1,189 @@
+/**
+ * @file bio_event.c
+ *
+ * @brief Streaming threshold and event detector over decoded samples
+ */
+
+#include <string.h>
+
+#include "bio_event.h"
+
+#define BIO_EVENT_FINGER  3    //bioData.status with a finger detected
+#define BIO_EVENT_START   0x80 //start bit of the packed type byte
+
+
+void bioEventInit(struct bioEvent *ev, uint16_t sampleRate){
+    memset(ev, 0, sizeof(*ev));
+    ev->sampleRate = sampleRate ? sampleRate : 1;
+}
+
+
+uint8_t bioEventAdd(struct bioEvent *ev, uint8_t type, uint16_t low, uint16_t high, uint32_t holdMs){
+    struct bioEventRule *rule;
+
+    if(ev->numRules >= BIO_EVENT_MAX_RULES || type > BIO_EVENT_MOTION){
+        return 0xFF;
+    }
+
+    rule = &ev->rule[ev->numRules];
+    memset(rule, 0, sizeof(*rule));
+    rule->type = type;
+    rule->low = low;
+    rule->high = high;
+    rule->hold = (uint32_t)((uint64_t)holdMs * ev->sampleRate / 1000);
+    if(rule->hold == 0){
+        rule->hold = 1;
+    }
+    return ev->numRules++;
+}
+
+
+/**
+ * @brief   Queues a record, or counts it as dropped when the queue is full
+ */
+static void bioEventPush(struct bioEvent *ev, const struct bioEventRule *rule, uint8_t index, bool start){
+    struct bioEventRecord *record;
+
+    if((uint16_t)(ev->in - ev->out) >= BIO_EVENT_QUEUE_SIZE){
+        ev->dropped++;
+        return;
+    }
+
+    record = &ev->queue[ev->in & (BIO_EVENT_QUEUE_SIZE - 1)];
+    record->timeMs = (uint32_t)((uint64_t)(start ? rule->started : rule->since) * 1000 / ev->sampleRate);
+    record->durationMs = start ? 0 : (uint32_t)((uint64_t)(rule->since - rule->started) * 1000 / ev->sampleRate);
+    record->value = rule->worst;
+    record->rule = index;
+    record->type = rule->type;
+    record->start = start;
+    ev->in++;
+    ev->pushed++;
+}
+
+
+/**
+ * @brief   Evaluates the condition of a rule on a sample
+ *
+ * @return  1 when the condition holds, 0 when it does not, -1 when the sample has no value for it
+ */
+static int8_t bioEventCondition(const struct bioEventRule *rule, const struct bioData *body, uint16_t *value){
+    switch(rule->type){
+    case BIO_EVENT_DESAT:
+        *value = body->oxygen;
+        return body->oxygen == 0 ? -1 : body->oxygen < rule->low;
+    case BIO_EVENT_HR_BAND:
+        *value = body->heartRate;
+        return body->heartRate == 0 ? -1 : (body->heartRate < rule->low || body->heartRate > rule->high);
+    case BIO_EVENT_FINGER_OFF:
+        *value = body->status;
+        return body->status != BIO_EVENT_FINGER;
+    default: //BIO_EVENT_MOTION
+        *value = (uint8_t)body->extStatus;
+        return body->extStatus == -2 || body->extStatus == -6;
+    }
+}
+
+
+/**
+ * @brief   Keeps the worse of two values for a rule: the lowest oxygen, the heart rate furthest out of the band.
+ *          FINGER_OFF and MOTION keep the first
+ */
+static uint16_t bioEventWorse(const struct bioEventRule *rule, uint16_t worst, uint16_t value){
+    if(rule->type == BIO_EVENT_DESAT){
+        return value < worst ? value : worst;
+    }
+    if(rule->type == BIO_EVENT_HR_BAND){
+        uint16_t outWorst = worst < rule->low ? rule->low - worst : (worst > rule->high ? worst - rule->high : 0);
+        uint16_t outValue = value < rule->low ? rule->low - value : (value > rule->high ? value - rule->high : 0);
+        return outValue > outWorst ? value : worst;
+    }
+    return worst;
+}
+
+
+uint8_t bioEventUpdate(struct bioEvent *ev, const struct bioData *body){
+    uint32_t pushed = ev->pushed;
+    uint8_t i;
+
+    for(i = 0; i < ev->numRules; i++){
+        struct bioEventRule *rule = &ev->rule[i];
+        uint16_t value;
+        int8_t holds = bioEventCondition(rule, body, &value);
+
+        if(holds < 0){ //no value: the rule stays as it is
+            continue;
+        }
+
+        if(!rule->active){
+            if(!holds){
+                rule->run = 0;
+                continue;
+            }
+            if(rule->run++ == 0){
+                rule->since = ev->n;
+                rule->worst = value;
+            }
+            rule->worst = bioEventWorse(rule, rule->worst, value);
+            if(rule->run >= rule->hold){ //held long enough: the episode started where the run did
+                rule->active = true;
+                rule->started = rule->since;
+                rule->run = 0;
+                bioEventPush(ev, rule, i, true);
+            }
+        }
+        else{
+            if(holds){
+                rule->run = 0;
+                rule->worst = bioEventWorse(rule, rule->worst, value);
+                continue;
+            }
+            if(rule->run++ == 0){
+                rule->since = ev->n;
+            }
+            if(rule->run >= rule->hold){ //absent long enough: the episode ended where the run started
+                rule->active = false;
+                rule->run = 0;
+                bioEventPush(ev, rule, i, false);
+            }
+        }
+    }
+
+    ev->n++;
+    return (uint8_t)(ev->pushed - pushed);
+}
+
+
+bool bioEventPop(struct bioEvent *ev, struct bioEventRecord *record){
+    if(ev->out == ev->in){
+        return false;
+    }
+    *record = ev->queue[ev->out & (BIO_EVENT_QUEUE_SIZE - 1)];
+    ev->out++;
+    return true;
+}
+
+
+void bioEventPack(const struct bioEventRecord *record, uint8_t *out){
+    out[0] = (uint8_t)record->timeMs;
+    out[1] = (uint8_t)(record->timeMs >> 8);
+    out[2] = (uint8_t)(record->timeMs >> 16);
+    out[3] = (uint8_t)(record->timeMs >> 24);
+    out[4] = (uint8_t)record->durationMs;
+    out[5] = (uint8_t)(record->durationMs >> 8);
+    out[6] = (uint8_t)(record->durationMs >> 16);
+    out[7] = (uint8_t)(record->durationMs >> 24);
+    out[8] = (uint8_t)record->value;
+    out[9] = (uint8_t)(record->value >> 8);
+    out[10] = record->rule;
+    out[11] = (uint8_t)(record->type | (record->start ? BIO_EVENT_START : 0));
+}
+
+
+void bioEventUnpack(const uint8_t *in, struct bioEventRecord *record){
+    record->timeMs = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+    record->durationMs = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+    record->value = (uint16_t)(in[8] | (in[9] << 8));
+    record->rule = in[10];
+    record->type = in[11] & (uint8_t)~BIO_EVENT_START;
+    record->start = (in[11] & BIO_EVENT_START) != 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * @file bio_event.h
+ *
+ * @brief Streaming threshold and event detector over decoded samples
+ *
+ *  For products that should stay silent while nothing happens: instead of every sample, only the start and end of
+ *  episodes are reported. Rules are added to a fixed table with bioEventAdd(), each with its own state, and each
+ *  decoded sample (readAlgoData(), readRawAndAlgoData() or readSensorData() in SENSOR_AND_ALGORITHM mode) goes
+ *  through bioEventUpdate(), which does constant work per rule. The conditions are:
+ *
+ *  - BIO_EVENT_DESAT: oxygen below the threshold
+ *
+ *  - BIO_EVENT_HR_BAND: heartRate below the low or above the high limit
+ *
+ *  - BIO_EVENT_FINGER_OFF: status is not 3 (finger detected)
+ *
+ *  - BIO_EVENT_MOTION: extStatus -2 (device motion) or -6 (finger motion)
+ *
+ *  An episode starts once its condition held for the rule's hold time in a row, and ends once the condition was
+ *  absent for as long, so a short dip or a single noisy sample neither starts nor ends one. Samples without a value
+ *  (oxygen or heartRate 0, the algorithm has none) leave a DESAT or HR_BAND rule as it is. Both edges are pushed as a
+ *  struct bioEventRecord to a queue read with bioEventPop(), dated when the condition started or stopped rather than
+ *  when the hold ran out. Records pushed while the queue is full are dropped and counted.
+ *
+ *  bioEventPack() writes a record in BIO_EVENT_PACKED_SIZE bytes, all multi-byte fields little endian:
+ *
+ *  | offset | size | field                          |
+ *  |--------|------|--------------------------------|
+ *  | 0      | 4    | timeMs                         |
+ *  | 4      | 4    | durationMs                     |
+ *  | 8      | 2    | value                          |
+ *  | 10     | 1    | rule                           |
+ *  | 11     | 1    | type (bits 0-6), start (bit 7) |
+ */
+
+#ifndef BIO_EVENT_H_
+#define BIO_EVENT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bio_sensor.h"
+
+#define BIO_EVENT_MAX_RULES    8  //rules per detector
+#define BIO_EVENT_QUEUE_SIZE   16 //records queued, power of two
+#define BIO_EVENT_PACKED_SIZE  12 //bytes per packed record
+
+
+/**
+ * @brief Rule conditions
+ */
+enum BIO_EVENT_TYPE {
+
+  BIO_EVENT_DESAT = 0, ///< oxygen below low
+  BIO_EVENT_HR_BAND, ///< heartRate below low or above high
+  BIO_EVENT_FINGER_OFF, ///< status not 3
+  BIO_EVENT_MOTION ///< extStatus -2 or -6
+
+};
+
+
+/**
+ * @brief Struct of one event record
+ */
+struct bioEventRecord {
+
+  uint32_t timeMs; ///< Time the condition started (start) or stopped (end), ms of samples since bioEventInit()
+  uint32_t durationMs; ///< Length of the episode, ms (0 for a start)
+  uint16_t value; ///< Worst value: lowest oxygen, heartRate furthest out of the band, first status or extStatus byte
+  uint8_t rule; ///< Rule index returned by bioEventAdd()
+  uint8_t type; ///< Rule condition, BIO_EVENT_TYPE
+  bool start; ///< true for the start of an episode, false for its end
+
+};
+
+
+/**
+ * @brief Struct of a rule and its state
+ */
+struct bioEventRule {
+
+  uint8_t type; ///< Condition, BIO_EVENT_TYPE
+  uint16_t low; ///< DESAT threshold, HR_BAND low limit
+  uint16_t high; ///< HR_BAND high limit
+  uint32_t hold; ///< Hold time, samples
+  bool active; ///< An episode is running
+  uint32_t run; ///< Samples in a row the condition held (inactive) or was absent (active)
+  uint32_t since; ///< Sample index where the run started
+  uint32_t started; ///< Sample index where the episode started
+  uint16_t worst; ///< Worst value of the run or episode
+
+};
+
+
+/**
+ * @brief Struct of the detector state. Set up with bioEventInit()
+ */
+struct bioEvent {
+
+  uint16_t sampleRate; ///< Sample rate, Hz
+  uint32_t n; ///< Samples processed
+  uint8_t numRules; ///< Number of rules
+  struct bioEventRule rule[BIO_EVENT_MAX_RULES]; ///< Rules
+  struct bioEventRecord queue[BIO_EVENT_QUEUE_SIZE]; ///< Records not yet popped
+  uint16_t in; ///< Free running index of the next record pushed
+  uint16_t out; ///< Free running index of the next record popped
+  uint32_t pushed; ///< Records queued
+  uint32_t dropped; ///< Records dropped because the queue was full
+
+};
+
+
+/**
+ * @brief   Sets up a detector with no rules
+ *
+ * @param   *ev        Pointer to detector
+ * @param   sampleRate Rate of the samples, Hz (readADCSampleRate())
+ */
+void bioEventInit(struct bioEvent *ev, uint16_t sampleRate);
+
+
+/**
+ * @brief   Adds a rule
+ *
+ * @param   *ev    Pointer to detector
+ * @param   type   Condition, BIO_EVENT_TYPE
+ * @param   low    DESAT: oxygen threshold, %. HR_BAND: lowest heart rate in the band, bpm. Otherwise unused
+ * @param   high   HR_BAND: highest heart rate in the band, bpm. Otherwise unused
+ * @param   holdMs Time the condition must hold to start an episode, and be absent to end it, ms
+ *
+ * @return  Rule index, 0xFF if the table is full or the type is unknown
+ */
+uint8_t bioEventAdd(struct bioEvent *ev, uint8_t type, uint16_t low, uint16_t high, uint32_t holdMs);
+
+
+/**
+ * @brief   Runs every rule on one sample
+ *
+ * @param   *ev   Pointer to detector
+ * @param   *body Pointer to decoded sample
+ *
+ * @return  Number of records pushed for this sample
+ */
+uint8_t bioEventUpdate(struct bioEvent *ev, const struct bioData *body);
+
+
+/**
+ * @brief   Takes the oldest record from the queue
+ *
+ * @param   *ev     Pointer to detector
+ * @param   *record Pointer to record to fill
+ *
+ * @return  true if a record was taken, false if the queue is empty
+ */
+bool bioEventPop(struct bioEvent *ev, struct bioEventRecord *record);
+
+
+/**
+ * @brief   Packs a record in BIO_EVENT_PACKED_SIZE bytes
+ *
+ * @param   *record Pointer to record
+ * @param   *out    Pointer to BIO_EVENT_PACKED_SIZE bytes
+ */
+void bioEventPack(const struct bioEventRecord *record, uint8_t *out);
+
+
+/**
+ * @brief   Unpacks a record written by bioEventPack()
+ *
+ * @param   *in     Pointer to BIO_EVENT_PACKED_SIZE bytes
+ * @param   *record Pointer to record to fill
+ */
+void bioEventUnpack(const uint8_t *in, struct bioEventRecord *record);
+
+#endif /* BIO_EVENT_H_ */
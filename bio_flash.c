@@ -0,0 +1,210 @@
+/**
+ * @file bio_flash.c
+ *
+ * @brief MAX32664 firmware update from a streamed .msbl image
+ */
+
+#include <string.h>
+
+#include "bio_flash.h"
+
+
+/**
+ * @brief   Little endian uint16_t of the .msbl header
+ */
+static uint16_t bioFlashGet16(const uint8_t *buf){
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+
+/**
+ * @brief   Reads the status byte of the command just written until it is no longer a try again. The first read waits
+ *          until the expected busy time has passed, then the reads back off from BIO_FLASH_POLL_MIN_US to
+ *          BIO_FLASH_POLL_MAX_US
+ *
+ * @param   startUs   Time the command was written
+ * @param   *busyUs   Expected busy time, raised to the longest time the hub was seen busy (may be NULL for none)
+ * @param   timeoutUs Time after which the hub is considered to have dropped the command
+ * @param   *stats    Pointer to counters
+ *
+ * @return  Status byte, ERR_BTLDR_TRY_AGAIN on timeout
+ */
+static uint8_t bioFlashPoll(uint32_t startUs, uint32_t *busyUs, uint32_t timeoutUs, struct bioFlashStats *stats){
+    uint32_t backoffUs = BIO_FLASH_POLL_MIN_US;
+    uint32_t elapsedUs = bioGetTimeUs() - startUs;
+    uint8_t statusByte;
+
+    if(busyUs != NULL && elapsedUs < *busyUs){ //no point asking before the last page took
+        bioUsleep(*busyUs - elapsedUs);
+    }
+
+    while(1){
+        statusByte = I2CReadStatusByte();
+        stats->statusPolls++;
+        if(statusByte != ERR_BTLDR_TRY_AGAIN && statusByte != ERR_TRY_AGAIN){ //done
+            return statusByte;
+        }
+        stats->tryAgains++;
+
+        elapsedUs = bioGetTimeUs() - startUs;
+        if(elapsedUs >= timeoutUs){
+            if(busyUs != NULL){ //the command was dropped, not slow: learn again
+                *busyUs = 0;
+            }
+            return ERR_BTLDR_TRY_AGAIN;
+        }
+        if(busyUs != NULL && elapsedUs > *busyUs){ //still busy: the next command will be at least this long
+            *busyUs = elapsedUs;
+        }
+        bioUsleep(backoffUs);
+        backoffUs = backoffUs * 2 > BIO_FLASH_POLL_MAX_US ? BIO_FLASH_POLL_MAX_US : backoffUs * 2;
+    }
+}
+
+
+/**
+ * @brief   Sends a bootloader command and waits for its status, sending it again after a timeout
+ *
+ * @param   *command  Pointer to family byte, index byte and write bytes
+ * @param   length    Number of bytes
+ * @param   timeoutUs Time allowed per send
+ * @param   *stats    Pointer to counters
+ *
+ * @return  Status byte of the command
+ */
+static uint8_t bioFlashCommand(uint8_t *command, uint16_t length, uint32_t timeoutUs, struct bioFlashStats *stats){
+    uint8_t statusByte = ERR_BTLDR_TRY_AGAIN;
+    uint8_t send;
+
+    for(send = 0; send < BIO_FLASH_MAX_SENDS && statusByte == ERR_BTLDR_TRY_AGAIN; send++){
+        uint32_t startUs = bioGetTimeUs();
+
+        if(send > 0){
+            stats->resends++;
+            bioStatsRetry();
+        }
+        if(I2CWriteCommand(command, length) != SUCCESS){
+            return ERR_UNKNOWN;
+        }
+        statusByte = bioFlashPoll(startUs, NULL, timeoutUs, stats);
+    }
+    return statusByte;
+}
+
+
+/**
+ * @brief   Fetches the next page of the image behind its command bytes
+ *
+ * @return  true if a whole page and its MAC were read
+ */
+static bool bioFlashFetch(bioMsblReadFxn readFxn, void *arg, uint8_t *page, struct bioFlashStats *stats){
+    uint32_t startUs = bioGetTimeUs();
+    uint16_t len;
+
+    page[0] = BOOTLOADER_FLASH;
+    page[1] = SEND_PAGE_VALUE;
+    len = readFxn(arg, &page[2], BIO_FLASH_PAGE_SIZE + BIO_MSBL_PAGE_MAC_SIZE);
+    stats->fetchUs += bioGetTimeUs() - startUs;
+    return len == BIO_FLASH_PAGE_SIZE + BIO_MSBL_PAGE_MAC_SIZE;
+}
+
+
+uint8_t bioFlashMsbl(bioMsblReadFxn readFxn, void *arg, uint8_t *work, struct bioFlashStats *stats){
+    struct bioFlashStats localStats;
+    uint8_t *header = work; //the header is done with before the first page is fetched
+    uint8_t *page[2] = {work, work + BIO_FLASH_PAGE_BUFFER};
+    uint8_t command[2 + BIO_MSBL_AUTH_SIZE];
+    uint32_t startUs = bioGetTimeUs();
+    uint32_t pageBusyUs = 0; //learnt page write time
+    uint8_t statusByte = SUCCESS;
+    uint16_t numPages;
+    uint16_t p;
+
+    if(stats == NULL){
+        stats = &localStats;
+    }
+    memset(stats, 0, sizeof(*stats));
+
+    if(readFxn(arg, header, BIO_MSBL_HEADER_SIZE) != BIO_MSBL_HEADER_SIZE || memcmp(header, "msbl", 4) != 0){ //not an .msbl image
+        return ERR_DATA_FORMAT;
+    }
+    numPages = bioFlashGet16(&header[BIO_MSBL_NUM_PAGES_OFFSET]);
+    if(numPages == 0 || bioFlashGet16(&header[BIO_MSBL_PAGE_SIZE_OFFSET]) != BIO_FLASH_PAGE_SIZE){
+        return ERR_DATA_FORMAT;
+    }
+    stats->numPages = numPages;
+
+    if(setDeviceMode(ENTER_BOOTLOADER, &statusByte) != ENTER_BOOTLOADER){
+        return statusByte != SUCCESS ? statusByte : ERR_UNKNOWN;
+    }
+    if(I2CReadInt(BOOTLOADER_INFO, PAGE_SIZE, &statusByte) != BIO_FLASH_PAGE_SIZE || statusByte != SUCCESS){ //hub built for other pages
+        return statusByte != SUCCESS ? statusByte : ERR_DATA_FORMAT;
+    }
+
+    command[0] = BOOTLOADER_FLASH;
+    command[1] = SET_NUM_PAGES;
+    command[2] = (uint8_t)(numPages >> 8); //MSB first on the bus
+    command[3] = (uint8_t)numPages;
+    statusByte = bioFlashCommand(command, 4, BIO_FLASH_CMD_TIMEOUT_US, stats);
+    if(statusByte != SUCCESS){
+        return statusByte;
+    }
+
+    command[1] = SET_INIT_VECTOR_BYTES;
+    memcpy(&command[2], &header[BIO_MSBL_IV_OFFSET], BIO_MSBL_IV_SIZE);
+    statusByte = bioFlashCommand(command, 2 + BIO_MSBL_IV_SIZE, BIO_FLASH_CMD_TIMEOUT_US, stats);
+    if(statusByte != SUCCESS){
+        return statusByte;
+    }
+
+    command[1] = SET_AUTH_BYTES;
+    memcpy(&command[2], &header[BIO_MSBL_AUTH_OFFSET], BIO_MSBL_AUTH_SIZE);
+    statusByte = bioFlashCommand(command, 2 + BIO_MSBL_AUTH_SIZE, BIO_FLASH_CMD_TIMEOUT_US, stats);
+    if(statusByte != SUCCESS){
+        return statusByte;
+    }
+
+    command[1] = ERASE_FLASH;
+    statusByte = bioFlashCommand(command, 2, BIO_FLASH_ERASE_TIMEOUT_US, stats);
+    if(statusByte != SUCCESS){
+        return statusByte;
+    }
+
+    if(!bioFlashFetch(readFxn, arg, page[0], stats)){
+        return ERR_DATA_FORMAT;
+    }
+
+    for(p = 0; p < numPages; p++){
+        uint8_t *current = page[p & 1];
+        uint8_t send;
+
+        statusByte = ERR_BTLDR_TRY_AGAIN;
+        for(send = 0; send < BIO_FLASH_MAX_SENDS && statusByte == ERR_BTLDR_TRY_AGAIN; send++){
+            uint32_t sendUs = bioGetTimeUs();
+            uint32_t fetchUs = stats->fetchUs;
+
+            if(send > 0){
+                stats->resends++;
+                bioStatsRetry();
+            }
+            if(I2CWriteCommand(current, BIO_FLASH_PAGE_BUFFER) != SUCCESS){
+                return ERR_UNKNOWN;
+            }
+            if(send == 0 && p + 1 < numPages && !bioFlashFetch(readFxn, arg, page[(p + 1) & 1], stats)){ //next page while this one is written
+                return ERR_DATA_FORMAT;
+            }
+            fetchUs = stats->fetchUs - fetchUs; //the timeout starts once the next page is in
+            statusByte = bioFlashPoll(sendUs, &pageBusyUs, BIO_FLASH_CMD_TIMEOUT_US + fetchUs, stats);
+        }
+        if(statusByte != SUCCESS){
+            return statusByte;
+        }
+        stats->pagesWritten++;
+    }
+
+    if(setDeviceMode(EXIT_BOOTLOADER, &statusByte) != EXIT_BOOTLOADER){ //start the new application
+        return statusByte != SUCCESS ? statusByte : ERR_BTLDR_INVALID_APP;
+    }
+    stats->totalUs = bioGetTimeUs() - startUs;
+    return SUCCESS;
+}
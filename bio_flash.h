@@ -0,0 +1,88 @@
+/**
+ * @file bio_flash.h
+ *
+ * @brief MAX32664 firmware update: streams an .msbl image through the bootloader, page by page
+ *
+ *  The image is pulled from a caller supplied read function (a file, external flash, a UART or BLE transfer) in
+ *  header and page sized pieces, so only two pages are ever held in RAM. While the hub writes a page to its flash,
+ *  the next page is fetched into the other buffer, and the status is then polled with a backoff instead of sleeping
+ *  for a fixed worst-case time. A page costs its bus time plus the longer of the hub write time and the fetch time.
+ *
+ *  Sequence (MAX32664 User's Guide, bootloader): ENTER_BOOTLOADER, PAGE_SIZE check, SET_NUM_PAGES,
+ *  SET_INIT_VECTOR_BYTES, SET_AUTH_BYTES, ERASE_FLASH, SEND_PAGE_VALUE for every page, EXIT_BOOTLOADER.
+ *
+ *  .msbl layout: a BIO_MSBL_HEADER_SIZE byte header ("msbl" magic, IV at 0x28, auth bytes at 0x34, page count at
+ *  0x44 and page size at 0x46, little endian), then each page followed by its BIO_MSBL_PAGE_MAC_SIZE authentication
+ *  bytes, then a CRC32 of the file that the hub does not need (the pages are authenticated on the hub).
+ */
+
+#ifndef BIO_FLASH_H_
+#define BIO_FLASH_H_
+
+#include <stdint.h>
+
+#include "bio_sensor.h"
+
+#define BIO_MSBL_HEADER_SIZE        0x4C    //bytes before the first page
+#define BIO_MSBL_IV_OFFSET          0x28    //SET_INIT_VECTOR_BYTES payload
+#define BIO_MSBL_IV_SIZE            11
+#define BIO_MSBL_AUTH_OFFSET        0x34    //SET_AUTH_BYTES payload
+#define BIO_MSBL_AUTH_SIZE          16
+#define BIO_MSBL_NUM_PAGES_OFFSET   0x44    //uint16_t, little endian
+#define BIO_MSBL_PAGE_SIZE_OFFSET   0x46    //uint16_t, little endian
+#define BIO_MSBL_PAGE_MAC_SIZE      16      //authentication bytes after each page
+
+#define BIO_FLASH_PAGE_SIZE         8192    //MAX32664 bootloader page size (BOOTLOADER_INFO, PAGE_SIZE)
+#define BIO_FLASH_PAGE_BUFFER       (2 + BIO_FLASH_PAGE_SIZE + BIO_MSBL_PAGE_MAC_SIZE) //command bytes + page + MAC
+#define BIO_FLASH_WORK_SIZE         (2 * BIO_FLASH_PAGE_BUFFER) //RAM bioFlashMsbl() needs: the page on the hub and the next one
+
+#define BIO_FLASH_POLL_MIN_US       1000    //first status poll backoff, doubled on every ERR_BTLDR_TRY_AGAIN
+#define BIO_FLASH_POLL_MAX_US       20000   //backoff cap, bounds how late a finished page write is noticed
+#define BIO_FLASH_ERASE_TIMEOUT_US  5000000 //time allowed for ERASE_FLASH before the command is sent again
+#define BIO_FLASH_CMD_TIMEOUT_US    1000000 //time allowed for any other command before it is sent again
+#define BIO_FLASH_MAX_SENDS         3       //times a command is sent before giving up
+
+
+/**
+ * @brief   Image read function: copies the next len bytes of the .msbl image into buf
+ *
+ * @return  Number of bytes copied, less than len at the end of the image or on an error
+ */
+typedef uint16_t (*bioMsblReadFxn)(void *arg, uint8_t *buf, uint16_t len);
+
+
+/**
+ * @brief Struct of firmware update counters, filled by bioFlashMsbl()
+ */
+struct bioFlashStats {
+
+  uint16_t numPages; ///< Pages in the image
+  uint16_t pagesWritten; ///< Pages the hub accepted
+  uint32_t statusPolls; ///< Status reads
+  uint32_t tryAgains; ///< ERR_BTLDR_TRY_AGAIN (or ERR_TRY_AGAIN) status bytes read
+  uint32_t resends; ///< Commands sent again after their timeout (also counted in bioStats.retries)
+  uint32_t fetchUs; ///< Time spent in the read function, us
+  uint32_t totalUs; ///< Time from start to EXIT_BOOTLOADER, us
+
+};
+
+
+/**
+ * @brief   Flashes an .msbl image into the MAX32664. The hub is left in application mode on success; allow it the
+ *          usual start-up time and run beginI2C()/configMAX32664() again
+ *
+ * @pre     beginI2C()
+ *
+ * @param   readFxn  Image read function, called once for the header and once per page, in order
+ * @param   *arg     Argument passed to readFxn
+ * @param   *work    Pointer to BIO_FLASH_WORK_SIZE bytes of RAM
+ * @param   *stats   Pointer to counters to fill (may be NULL)
+ *
+ * @return  SUCCESS, ERR_DATA_FORMAT for an image that is short, not an .msbl file or built for another page size,
+ *          ERR_BTLDR_TRY_AGAIN if the hub stayed busy, or the status byte of the failing command (e.g.
+ *          ERR_BTLDR_AUTH, ERR_BTLDR_CHECKSUM). After a failure past ERASE_FLASH the hub stays in the bootloader
+ *          until a complete image is written
+ */
+uint8_t bioFlashMsbl(bioMsblReadFxn readFxn, void *arg, uint8_t *work, struct bioFlashStats *stats);
+
+#endif /* BIO_FLASH_H_ */
@@ -0,0 +1,90 @@
+/**
+ * @file bio_format.c
+ *
+ * @brief printf-free text formatting of struct bioData for human-readable streaming
+ */
+
+#include "bio_format.h"
+
+
+uint8_t bioFormatUnsigned(char *out, uint32_t value, uint8_t minWidth){
+    char digits[10]; //least significant first
+    uint8_t numDigits = 0;
+    uint8_t len = 0;
+
+    do{
+        digits[numDigits++] = (char)('0' + value % 10);
+        value /= 10;
+    } while(value);
+
+    while(minWidth > numDigits){ //zero padding
+        out[len++] = '0';
+        minWidth--;
+    }
+    while(numDigits){
+        out[len++] = digits[--numDigits];
+    }
+    return len;
+}
+
+
+/**
+ * @brief   Signed value, printf "%02d": the sign counts in the width, so only 0 - 9 get a padding zero
+ */
+static uint8_t bioFormatSigned(char *out, int32_t value){
+    if(value < 0){
+        out[0] = '-';
+        return 1 + bioFormatUnsigned(&out[1], (uint32_t)-value, 1);
+    }
+    return bioFormatUnsigned(out, (uint32_t)value, 2);
+}
+
+
+/**
+ * @brief   Fixed-point value with two decimals, printf "%02.2f" (the width of 2 is always exceeded)
+ */
+static uint8_t bioFormatHundredths(char *out, float value){
+    uint32_t hundredths;
+    uint8_t len = 0;
+
+    if(value < 0.0f){
+        out[len++] = '-';
+        value = -value;
+    }
+
+    if(value > 40000000.0f){ //keep the hundredths in 32 bits (printf would print more digits)
+        value = 40000000.0f;
+    }
+    hundredths = (uint32_t)(value * 100.0f + 0.5f); //round half up to 0.01
+    len += bioFormatUnsigned(&out[len], hundredths / 100, 1);
+    out[len++] = '.';
+    len += bioFormatUnsigned(&out[len], hundredths % 100, 2);
+    return len;
+}
+
+
+uint16_t bioFormatCsv(char *out, const struct bioData *body, const char *eol){
+    uint16_t len = 0;
+
+    len += bioFormatUnsigned(&out[len], body->irLed, 2);
+    out[len++] = ',';
+    len += bioFormatUnsigned(&out[len], body->redLed, 2);
+    out[len++] = ',';
+    len += bioFormatUnsigned(&out[len], body->heartRate, 2);
+    out[len++] = ',';
+    len += bioFormatUnsigned(&out[len], body->confidence, 2);
+    out[len++] = ',';
+    len += bioFormatUnsigned(&out[len], body->oxygen, 2);
+    out[len++] = ',';
+    len += bioFormatUnsigned(&out[len], body->status, 2);
+    out[len++] = ',';
+    len += bioFormatSigned(&out[len], body->extStatus);
+    out[len++] = ',';
+    len += bioFormatHundredths(&out[len], body->rValue);
+
+    while(eol && *eol){
+        out[len++] = *eol++;
+    }
+    out[len] = '\0';
+    return len;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file bio_format.h
+ *
+ * @brief printf-free text formatting of struct bioData for human-readable streaming
+ *
+ *  Writes the data stream CSV line of bio_sensor_library_test.c with integer arithmetic only, straight into a caller
+ *  buffer: no varargs, no float formatting and no printf code pulled into the image.
+ */
+
+#ifndef BIO_FORMAT_H_
+#define BIO_FORMAT_H_
+
+#include <stdint.h>
+
+#include "bio_sensor.h"
+
+#define BIO_FORMAT_CSV_MAX  72 //longest line bioFormatCsv() writes, line ending and terminator included
+
+
+/**
+ * @brief   Formats a sample as the data stream CSV line, the same text as
+ *          printf("%02u,%02u,%02u,%02u,%02u,%02u,%02d,%02.2f", irLed, redLed, heartRate, confidence, oxygen, status,
+ *          extStatus, rValue). rValue is rounded half up to hundredths, which matches printf for every value
+ *          readRawAndAlgoData() produces (tenths)
+ *
+ * @param   *out    Pointer to at least BIO_FORMAT_CSV_MAX characters
+ * @param   *body   Pointer to sample
+ * @param   eol     Line ending to append ("\r\n" for a terminal, NULL or "" for none)
+ *
+ * @return  Number of characters written, the terminator not included
+ */
+uint16_t bioFormatCsv(char *out, const struct bioData *body, const char *eol);
+
+
+/**
+ * @brief   Writes an unsigned value in decimal, zero padded to a minimum width (printf "%0*u")
+ *
+ * @param   *out     Pointer to at least 10 characters (or minWidth if larger)
+ * @param   value    Value
+ * @param   minWidth Minimum number of digits
+ *
+ * @return  Number of characters written (no terminator)
+ */
+uint8_t bioFormatUnsigned(char *out, uint32_t value, uint8_t minWidth);
+
+#endif /* BIO_FORMAT_H_ */
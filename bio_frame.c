@@ -0,0 +1,234 @@
+/**
+ * @file bio_frame.c
+ *
+ * @brief Compact binary framing of decoded samples for UART streaming, see bio_frame.h for the format
+ */
+
+#include <string.h>
+
+#include "bio_frame.h"
+
+
+/**
+ * @brief CRC16-CCITT of one nibble, indexed by (crc >> 12) ^ nibble
+ */
+static const uint16_t crc16Nibble[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+
+uint16_t bioFrameCrc16(uint16_t crc, const uint8_t *buf, uint16_t len){
+    while(len--){
+        crc = (uint16_t)(crc << 4) ^ crc16Nibble[(crc >> 12) ^ (*buf >> 4)]; //high nibble
+        crc = (uint16_t)(crc << 4) ^ crc16Nibble[(crc >> 12) ^ (*buf & 0x0F)]; //low nibble
+        buf++;
+    }
+    return crc;
+}
+
+
+void bioFramePackSample(const struct bioData *sample, uint8_t *out){
+    uint16_t rValue = (uint16_t)(sample->rValue * 10.0f + 0.5f); //back to the 0.1 LSB the hub reports
+
+    out[0] = (uint8_t)sample->irLed;
+    out[1] = (uint8_t)(sample->irLed >> 8);
+    out[2] = (uint8_t)(sample->irLed >> 16);
+    out[3] = (uint8_t)sample->redLed;
+    out[4] = (uint8_t)(sample->redLed >> 8);
+    out[5] = (uint8_t)(sample->redLed >> 16);
+    out[6] = (uint8_t)sample->heartRate;
+    out[7] = (uint8_t)(sample->heartRate >> 8);
+    out[8] = sample->confidence;
+    out[9] = (uint8_t)sample->oxygen;
+    out[10] = (uint8_t)(sample->oxygen >> 8);
+    out[11] = sample->status;
+    out[12] = (uint8_t)sample->extStatus;
+    out[13] = (uint8_t)rValue;
+    out[14] = (uint8_t)(rValue >> 8);
+}
+
+
+void bioFrameUnpackSample(const uint8_t *in, struct bioData *sample){
+    sample->irLed = (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16);
+    sample->redLed = (uint32_t)in[3] | ((uint32_t)in[4] << 8) | ((uint32_t)in[5] << 16);
+    sample->heartRate = (uint16_t)(in[6] | (in[7] << 8));
+    sample->confidence = in[8];
+    sample->oxygen = (uint16_t)(in[9] | (in[10] << 8));
+    sample->status = in[11];
+    sample->extStatus = (int8_t)in[12];
+    sample->rValue = (uint16_t)(in[13] | (in[14] << 8)); //convert the integer to float
+    sample->rValue /= 10.0; //divide by 10 to get the rValue, as readRawAndAlgoData() does
+    sample->reserveOne = 0;
+    sample->resserveTwo = 0;
+}
+
+
+uint16_t bioFrameEncode(uint8_t *frame, uint16_t sequence, const struct bioData *samples, uint8_t numSamples){
+    uint16_t payload = (uint16_t)numSamples * BIO_FRAME_SAMPLE_SIZE;
+    uint16_t crc;
+    uint8_t i;
+
+    if(numSamples == 0 || numSamples > BIO_FRAME_MAX_SAMPLES){ //payload length must fit the length byte
+        return 0;
+    }
+
+    frame[0] = BIO_FRAME_SYNC0;
+    frame[1] = BIO_FRAME_SYNC1;
+    frame[2] = BIO_FRAME_TYPE_SAMPLES;
+    frame[3] = (uint8_t)payload;
+    frame[4] = (uint8_t)sequence;
+    frame[5] = (uint8_t)(sequence >> 8);
+
+    for(i = 0; i < numSamples; i++){
+        bioFramePackSample(&samples[i], &frame[BIO_FRAME_HEADER_SIZE + i * BIO_FRAME_SAMPLE_SIZE]);
+    }
+
+    crc = bioFrameCrc16(0xFFFF, &frame[2], BIO_FRAME_HEADER_SIZE - 2 + payload); //everything after the sync word
+    frame[BIO_FRAME_HEADER_SIZE + payload] = (uint8_t)crc;
+    frame[BIO_FRAME_HEADER_SIZE + payload + 1] = (uint8_t)(crc >> 8);
+
+    return BIO_FRAME_HEADER_SIZE + payload + BIO_FRAME_CRC_SIZE;
+}
+
+
+void bioFrameParserInit(struct bioFrameParser *parser){
+    memset(parser, 0, sizeof(*parser));
+}
+
+
+/**
+ * @brief   Drops the current frame, keeping the bytes from the next sync word it holds (if any) so a frame that started
+ *          inside a corrupted one is not lost. The kept bytes are parsed again by bioFrameParseNext()
+ */
+static void bioFrameResync(struct bioFrameParser *parser){
+    uint16_t buffered = parser->received + parser->held;
+    uint16_t i;
+
+    for(i = 1; i < buffered; i++){
+        if(parser->frame[i] == BIO_FRAME_SYNC0 && (i + 1 == buffered || parser->frame[i + 1] == BIO_FRAME_SYNC1)){
+            break;
+        }
+    }
+
+    parser->skipped += i;
+    parser->held = buffered - i;
+    memmove(parser->frame, &parser->frame[i], parser->held);
+    parser->received = 0;
+    parser->expected = 0;
+}
+
+
+/**
+ * @brief   Drops the first buffered byte while looking for a sync word
+ */
+static void bioFrameDrop(struct bioFrameParser *parser){
+    parser->skipped++;
+    memmove(parser->frame, &parser->frame[1], parser->held);
+}
+
+
+/**
+ * @brief   Drops the frame returned by the previous call, keeping the bytes held after it
+ */
+static void bioFrameRelease(struct bioFrameParser *parser){
+    if(parser->expected != 0 && parser->received == parser->expected){
+        memmove(parser->frame, &parser->frame[parser->expected], parser->held);
+        parser->received = 0;
+        parser->expected = 0;
+    }
+}
+
+
+/**
+ * @brief   Checks the CRC of a complete frame
+ */
+static uint8_t bioFrameCheck(struct bioFrameParser *parser){
+    uint16_t crc = bioFrameCrc16(0xFFFF, &parser->frame[2], parser->expected - 2 - BIO_FRAME_CRC_SIZE);
+
+    if(parser->frame[parser->expected - 2] != (uint8_t)crc || parser->frame[parser->expected - 1] != (uint8_t)(crc >> 8)){
+        bioFrameResync(parser);
+        return BIO_FRAME_BAD_CRC;
+    }
+    return BIO_FRAME_OK; //frame stays in the buffer until the next call
+}
+
+
+/**
+ * @brief   Parses the next byte, already stored at parser->frame[parser->received] and no longer counted in held
+ */
+static uint8_t bioFrameStep(struct bioFrameParser *parser, uint8_t byte){
+    if(parser->received == 0 && byte != BIO_FRAME_SYNC0){ //waiting for a sync word
+        bioFrameDrop(parser);
+        return BIO_FRAME_MORE;
+    }
+    if(parser->received == 1 && byte != BIO_FRAME_SYNC1){ //first sync byte was data
+        parser->skipped++;
+        memmove(parser->frame, &parser->frame[1], parser->held + 1);
+        parser->received = (byte == BIO_FRAME_SYNC0) ? 1 : 0;
+        if(parser->received == 0){
+            bioFrameDrop(parser);
+        }
+        return BIO_FRAME_MORE;
+    }
+
+    parser->received++;
+
+    if(parser->expected == 0){ //header not checked yet
+        if(parser->received < 4){
+            return BIO_FRAME_MORE;
+        }
+        if(parser->frame[2] != BIO_FRAME_TYPE_SAMPLES || parser->frame[3] == 0 || parser->frame[3] > BIO_FRAME_MAX_PAYLOAD ||
+           parser->frame[3] % BIO_FRAME_SAMPLE_SIZE != 0){
+            bioFrameResync(parser);
+            return BIO_FRAME_BAD_HEADER;
+        }
+        parser->expected = BIO_FRAME_HEADER_SIZE + parser->frame[3] + BIO_FRAME_CRC_SIZE;
+    }
+
+    if(parser->received < parser->expected){ //frame not complete yet
+        return BIO_FRAME_MORE;
+    }
+    return bioFrameCheck(parser);
+}
+
+
+uint8_t bioFrameParseNext(struct bioFrameParser *parser){
+    uint8_t result;
+
+    bioFrameRelease(parser);
+    while(parser->held > 0){
+        parser->held--;
+        result = bioFrameStep(parser, parser->frame[parser->received]);
+        if(result != BIO_FRAME_MORE){
+            return result;
+        }
+    }
+    return BIO_FRAME_MORE;
+}
+
+
+uint8_t bioFrameParse(struct bioFrameParser *parser, uint8_t byte){
+    bioFrameRelease(parser);
+    parser->frame[parser->received + parser->held] = byte;
+    if(parser->held == 0){ //nothing else buffered, the usual case
+        return bioFrameStep(parser, byte);
+    }
+    parser->held++;
+    return bioFrameParseNext(parser);
+}
+
+
+uint8_t bioFrameNumSamples(const struct bioFrameParser *parser){
+    return parser->frame[3] / BIO_FRAME_SAMPLE_SIZE;
+}
+
+
+uint16_t bioFrameSequence(const struct bioFrameParser *parser){
+    return (uint16_t)(parser->frame[4] | (parser->frame[5] << 8));
+}
+
+
+void bioFrameSample(const struct bioFrameParser *parser, uint8_t index, struct bioData *sample){
+    bioFrameUnpackSample(&parser->frame[BIO_FRAME_HEADER_SIZE + index * BIO_FRAME_SAMPLE_SIZE], sample);
+}
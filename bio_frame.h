@@ -0,0 +1,179 @@
+/**
+ * @file bio_frame.h
+ *
+ * @brief Compact binary framing of decoded samples for UART streaming
+ *
+ *  Replaces the CSV line printed per sample in data stream mode (~40 bytes of text and a printf with a float) by a
+ *  binary frame holding one or more packed samples. All multi-byte fields are little endian.
+ *
+ *  Frame layout:
+ *
+ *  | offset | size        | field                                                              |
+ *  |--------|-------------|--------------------------------------------------------------------|
+ *  | 0      | 2           | sync word, BIO_FRAME_SYNC0 BIO_FRAME_SYNC1                         |
+ *  | 2      | 1           | frame type, BIO_FRAME_TYPE_SAMPLES                                 |
+ *  | 3      | 1           | payload length, bytes                                              |
+ *  | 4      | 2           | sequence number of the first sample (counts samples, wraps)        |
+ *  | 6      | length      | payload: payload length / BIO_FRAME_SAMPLE_SIZE packed samples     |
+ *  | 6+len  | 2           | CRC16-CCITT (poly 0x1021, init 0xFFFF) of bytes 2 to 5+len         |
+ *
+ *  Packed sample (BIO_FRAME_SAMPLE_SIZE bytes), fields of struct bioData:
+ *
+ *  | offset | size | field                                  |
+ *  |--------|------|----------------------------------------|
+ *  | 0      | 3    | irLed (24-bit ADC count)               |
+ *  | 3      | 3    | redLed (24-bit ADC count)              |
+ *  | 6      | 2    | heartRate                              |
+ *  | 8      | 1    | confidence                             |
+ *  | 9      | 2    | oxygen                                 |
+ *  | 11     | 1    | status                                 |
+ *  | 12     | 1    | extStatus (signed)                     |
+ *  | 13     | 2    | rValue * 10 (the hub reports 0.1 LSB)  |
+ *
+ *  One sample per frame is 23 bytes, and each extra sample in the same frame adds 15 bytes.
+ */
+
+#ifndef BIO_FRAME_H_
+#define BIO_FRAME_H_
+
+#include <stdint.h>
+
+#include "bio_sensor.h"
+
+#define BIO_FRAME_SYNC0          0xA5 //first sync byte
+#define BIO_FRAME_SYNC1          0x5A //second sync byte
+#define BIO_FRAME_TYPE_SAMPLES   0x01 //payload is packed samples
+#define BIO_FRAME_HEADER_SIZE    6    //sync, type, length, sequence
+#define BIO_FRAME_CRC_SIZE       2
+#define BIO_FRAME_SAMPLE_SIZE    15   //bytes per packed sample
+#define BIO_FRAME_MAX_SAMPLES    16   //samples per frame, keeps the payload length in one byte
+#define BIO_FRAME_MAX_PAYLOAD    (BIO_FRAME_MAX_SAMPLES * BIO_FRAME_SAMPLE_SIZE)
+#define BIO_FRAME_MAX_SIZE       (BIO_FRAME_HEADER_SIZE + BIO_FRAME_MAX_PAYLOAD + BIO_FRAME_CRC_SIZE)
+#define BIO_FRAME_SIZE(samples)  (BIO_FRAME_HEADER_SIZE + (samples) * BIO_FRAME_SAMPLE_SIZE + BIO_FRAME_CRC_SIZE)
+
+
+/**
+ * @brief Parser result codes of bioFrameParse()
+ */
+enum BIO_FRAME_PARSE {
+
+  BIO_FRAME_MORE = 0, ///< Frame not complete yet
+  BIO_FRAME_OK, ///< A frame was received and its CRC matched
+  BIO_FRAME_BAD_CRC, ///< A frame was received but its CRC did not match, it is dropped
+  BIO_FRAME_BAD_HEADER ///< Unknown type or length after a sync word, the parser resynchronizes
+
+};
+
+
+/**
+ * @brief Struct of the frame parser state. Clear with bioFrameParserInit()
+ */
+struct bioFrameParser {
+
+  uint16_t received; ///< Bytes of the current frame received so far
+  uint16_t expected; ///< Size of the current frame, 0 until the header is in
+  uint16_t held; ///< Bytes buffered after the current frame and not parsed yet (kept by a resync or after a frame)
+  uint8_t  frame[BIO_FRAME_MAX_SIZE]; ///< Current frame
+  uint32_t skipped; ///< Bytes dropped while looking for a sync word
+
+};
+
+
+/**
+ * @brief   CRC16-CCITT (poly 0x1021, no reflection, no final xor) of a buffer
+ *
+ * @param   crc    Initial value, 0xFFFF for a new CRC or the result of a previous call to continue it
+ * @param   *buf   Pointer to data
+ * @param   len    Number of bytes
+ *
+ * @return  Updated CRC
+ */
+uint16_t bioFrameCrc16(uint16_t crc, const uint8_t *buf, uint16_t len);
+
+
+/**
+ * @brief   Packs one sample in BIO_FRAME_SAMPLE_SIZE bytes
+ *
+ * @param   *sample Pointer to decoded sample
+ * @param   *out    Pointer to BIO_FRAME_SAMPLE_SIZE bytes
+ */
+void bioFramePackSample(const struct bioData *sample, uint8_t *out);
+
+
+/**
+ * @brief   Unpacks one sample packed by bioFramePackSample(). Reserved fields are cleared
+ *
+ * @param   *in     Pointer to BIO_FRAME_SAMPLE_SIZE bytes
+ * @param   *sample Pointer to sample to fill
+ */
+void bioFrameUnpackSample(const uint8_t *in, struct bioData *sample);
+
+
+/**
+ * @brief   Builds a sample frame
+ *
+ * @param   *frame     Pointer to output buffer, at least BIO_FRAME_SIZE(numSamples) bytes
+ * @param   sequence   Sequence number of the first sample. Add numSamples for the next frame
+ * @param   *samples   Pointer to decoded samples
+ * @param   numSamples Number of samples, 1 to BIO_FRAME_MAX_SAMPLES
+ *
+ * @return  Frame size, bytes. 0 if numSamples is out of range
+ */
+uint16_t bioFrameEncode(uint8_t *frame, uint16_t sequence, const struct bioData *samples, uint8_t numSamples);
+
+
+/**
+ * @brief   Clears a parser
+ *
+ * @param   *parser Pointer to parser
+ */
+void bioFrameParserInit(struct bioFrameParser *parser);
+
+
+/**
+ * @brief   Feeds one received byte to a parser. Bytes before a sync word are skipped. After BIO_FRAME_OK the frame
+ *          stays in parser->frame until the next call; read it with bioFrameSequence() and bioFrameSample().
+ *          After any result other than BIO_FRAME_MORE the parser may still hold complete frames (a resync keeps the
+ *          bytes from the next sync word), so call bioFrameParseNext() until it returns BIO_FRAME_MORE
+ *
+ * @param   *parser Pointer to parser
+ * @param   byte    Received byte
+ *
+ * @return  BIO_FRAME_MORE, BIO_FRAME_OK, BIO_FRAME_BAD_CRC or BIO_FRAME_BAD_HEADER
+ */
+uint8_t bioFrameParse(struct bioFrameParser *parser, uint8_t byte);
+
+
+/**
+ * @brief   Parses the bytes a parser holds without feeding a new one: the bytes kept by a resync, or the bytes after
+ *          the frame returned by the previous call
+ *
+ * @param   *parser Pointer to parser
+ *
+ * @return  BIO_FRAME_MORE once no complete frame is left, otherwise as bioFrameParse()
+ */
+uint8_t bioFrameParseNext(struct bioFrameParser *parser);
+
+
+/**
+ * @brief   Number of samples in the frame held by a parser after BIO_FRAME_OK
+ */
+uint8_t bioFrameNumSamples(const struct bioFrameParser *parser);
+
+
+/**
+ * @brief   Sequence number of the first sample in the frame held by a parser after BIO_FRAME_OK
+ */
+uint16_t bioFrameSequence(const struct bioFrameParser *parser);
+
+
+/**
+ * @brief   Unpacks a sample of the frame held by a parser after BIO_FRAME_OK
+ *
+ * @param   *parser Pointer to parser
+ * @param   index   Sample index, 0 to bioFrameNumSamples() - 1
+ * @param   *sample Pointer to sample to fill
+ */
+void bioFrameSample(const struct bioFrameParser *parser, uint8_t index, struct bioData *sample);
+
+#endif /* BIO_FRAME_H_ */
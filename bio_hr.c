@@ -0,0 +1,143 @@
+/**
+ * @file bio_hr.c
+ *
+ * @brief Incremental fixed-point heart rate engine on raw IR counts
+ */
+
+#include <string.h>
+
+#include "bio_hr.h"
+
+#define BIO_HR_TWO_PI_X1000  6283 //2 * pi * 1000
+
+
+void bioHrInit(struct bioHr *hr, uint16_t sampleRate){
+    uint32_t lowW = BIO_HR_TWO_PI_X1000 * BIO_HR_LOWPASS_HZ; //corner angular frequency * 1000
+
+    memset(hr, 0, sizeof(*hr));
+    hr->sampleRate = sampleRate;
+    hr->baseAlpha = (int32_t)(32768U / ((uint32_t)sampleRate * BIO_HR_BASELINE_MS / 1000U + 1U)); //dt / (tau + dt)
+    hr->lowAlpha = (int32_t)(32768ULL * lowW / ((uint64_t)sampleRate * 1000U + lowW)); //w / (1 + w), w = 2 pi fc / fs
+    hr->refractory = (uint32_t)sampleRate * 60U / BIO_HR_MAX_BPM;
+    hr->maxGap = (uint32_t)sampleRate * BIO_HR_MAX_GAP_MS / 1000U;
+    hr->fitSpan = (uint32_t)sampleRate * BIO_HR_FIT_MS / 1000U;
+    if(hr->fitSpan < 1) hr->fitSpan = 1;
+    if(hr->fitSpan > BIO_HR_HISTORY / 2 - 1) hr->fitSpan = BIO_HR_HISTORY / 2 - 1;
+}
+
+
+/**
+ * @brief   Median of the stored intervals (BIO_HR_RR_COUNT of them)
+ */
+static uint32_t bioHrMedian(const struct bioHr *hr){
+    uint32_t sorted[BIO_HR_RR_COUNT];
+    uint8_t i, j;
+
+    for(i = 0; i < BIO_HR_RR_COUNT; i++){ //insertion sort
+        uint32_t v = hr->rrQ8[i];
+        for(j = i; j > 0 && sorted[j - 1] > v; j--){
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+    return sorted[BIO_HR_RR_COUNT / 2];
+}
+
+
+/**
+ * @brief   Ends a pulse: places the beat at its maximum and updates the intervals
+ *
+ * @return  true if the beat was accepted
+ */
+static bool bioHrBeat(struct bioHr *hr){
+    int32_t curve = hr->peak[0] - 2 * hr->peak[1] + hr->peak[2];
+    int32_t offsetQ8 = 0;
+    uint32_t beatQ8, rrQ8;
+
+    if(curve < 0){ //vertex of the parabola through the three samples, within half a span of the maximum
+        int32_t limit = (int32_t)(128 * hr->fitSpan);
+        offsetQ8 = (int32_t)((int64_t)(hr->peak[0] - hr->peak[2]) * limit / curve);
+        if(offsetQ8 > limit) offsetQ8 = limit;
+        if(offsetQ8 < -limit) offsetQ8 = -limit;
+    }
+    beatQ8 = (hr->peakIndex << 8) + (uint32_t)offsetQ8;
+
+    if(hr->beats > 0){
+        rrQ8 = beatQ8 - hr->lastBeatQ8;
+        if(rrQ8 < (hr->refractory << 8)){ //too soon: dicrotic notch or noise
+            return false;
+        }
+        if(rrQ8 <= (hr->maxGap << 8)){
+            hr->lastRrQ8 = rrQ8;
+            hr->rrQ8[hr->rrNext] = rrQ8;
+            hr->rrNext = (uint8_t)((hr->rrNext + 1) % BIO_HR_RR_COUNT);
+            if(hr->rrCount < BIO_HR_RR_COUNT){
+                hr->rrCount++;
+            }
+            if(hr->rrCount == BIO_HR_RR_COUNT){
+                uint32_t median = bioHrMedian(hr);
+                hr->heartRate = (uint16_t)((600U * hr->sampleRate * 256U + median / 2) / median);
+            }
+        }
+        else{
+            hr->lastRrQ8 = 0;
+        }
+    }
+
+    hr->amplitude += (hr->peak[1] - hr->amplitude) >> 2;
+    hr->lastBeatQ8 = beatQ8;
+    hr->lastActivity = hr->peakIndex;
+    hr->beats++;
+    return true;
+}
+
+
+bool bioHrUpdate(struct bioHr *hr, uint32_t irLed){
+    int32_t x = (int32_t)(irLed << 8);
+    int32_t threshold = hr->amplitude >> 1;
+    int32_t y;
+    bool beat = false;
+
+    if(hr->n == 0){ //start on the baseline
+        hr->baseline = x;
+    }
+    hr->baseline += (int32_t)(((int64_t)(x - hr->baseline) * hr->baseAlpha) >> 15);
+    hr->filtered += (int32_t)(((int64_t)(hr->baseline - x - hr->filtered) * hr->lowAlpha) >> 15); //inverted: systole up
+    y = hr->filtered;
+
+    hr->history[hr->n % BIO_HR_HISTORY] = y;
+    if(hr->wantNext && hr->n == hr->peakIndex + hr->fitSpan){ //both fit samples are known
+        hr->peak[0] = hr->history[(hr->n - 2 * hr->fitSpan) % BIO_HR_HISTORY];
+        hr->peak[2] = y;
+        hr->wantNext = false;
+    }
+
+    if(!hr->inPulse){
+        if(y > threshold && y > 0){ //pulse starts
+            hr->inPulse = true;
+            hr->peak[1] = y;
+            hr->peakIndex = hr->n;
+            hr->wantNext = true;
+        }
+    }
+    else if(y > hr->peak[1]){ //still rising
+        hr->peak[1] = y;
+        hr->peakIndex = hr->n;
+        hr->wantNext = true;
+    }
+    else if(y < threshold && !hr->wantNext){ //pulse over
+        hr->inPulse = false;
+        beat = bioHrBeat(hr);
+    }
+
+    if(hr->n - hr->lastActivity > hr->maxGap){ //no beat for too long: lower the threshold and start over
+        hr->amplitude >>= 1;
+        hr->lastActivity = hr->n;
+        hr->rrCount = 0;
+        hr->lastRrQ8 = 0;
+        hr->heartRate = 0;
+    }
+
+    hr->n++;
+    return beat;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file bio_hr.h
+ *
+ * @brief Incremental fixed-point heart rate engine on raw IR counts
+ *
+ *  For SENSOR_DATA mode, where the sensor hub sends raw counts only and the heart rate is computed on the host. Each
+ *  IR count from readRawData() (or readSensorData()) goes through bioHrUpdate(), which does constant work:
+ *
+ *  - band-pass: the baseline (a one-pole low-pass with a BIO_HR_BASELINE_MS time constant) is subtracted and the
+ *    result, inverted so that the systolic peak is positive, goes through a one-pole low-pass at BIO_HR_LOWPASS_HZ
+ *
+ *  - adaptive peak detector: a pulse starts when the filtered signal rises above half of the average beat amplitude
+ *    and ends when it falls back below it. The beat is at the pulse maximum, refined to a fraction of a sample by a
+ *    parabola through the maximum and the samples BIO_HR_FIT_MS before and after it (wide enough that the noise on
+ *    the flat top of the pulse does not move the vertex). Beats closer than BIO_HR_MAX_BPM allows are ignored, and
+ *    the amplitude estimate halves after BIO_HR_MAX_GAP_MS without a beat so the detector recovers from a lost pulse
+ *
+ *  - heart rate: the median of the last BIO_HR_RR_COUNT beat to beat intervals. A gap longer than BIO_HR_MAX_GAP_MS
+ *    (finger off, lost signal) clears the intervals and the heart rate
+ *
+ *  All state is in struct bioHr (no allocation, a short ring of the filtered signal for the parabola). The filters run on counts scaled by 256 in
+ *  int32_t, with Q15 coefficients computed once by bioHrInit() for the sample rate.
+ */
+
+#ifndef BIO_HR_H_
+#define BIO_HR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BIO_HR_BASELINE_MS  500  //baseline time constant, sets the high-pass corner (0.3Hz)
+#define BIO_HR_LOWPASS_HZ   5    //low-pass corner, passes heart rates up to 300bpm
+#define BIO_HR_MAX_BPM      220  //shortest interval accepted between beats
+#define BIO_HR_MAX_GAP_MS   2000 //no beat for this long (30bpm): amplitude estimate halved, interval not used
+#define BIO_HR_RR_COUNT     5    //intervals in the median, odd
+#define BIO_HR_FIT_MS       40   //spacing of the three samples the beat time is fitted to
+#define BIO_HR_HISTORY      64   //filtered samples kept for the fit, power of two (limits the spacing at high rates)
+
+
+/**
+ * @brief Struct of the engine state
+ */
+struct bioHr {
+
+  uint16_t sampleRate; ///< Sample rate, Hz
+  int32_t baseAlpha; ///< Baseline coefficient, Q15
+  int32_t lowAlpha; ///< Low-pass coefficient, Q15
+  uint32_t refractory; ///< Shortest interval between beats, samples
+  uint32_t maxGap; ///< BIO_HR_MAX_GAP_MS, samples
+  uint32_t fitSpan; ///< BIO_HR_FIT_MS, samples (at least 1, at most BIO_HR_HISTORY / 2 - 1)
+  int32_t baseline; ///< Baseline, counts * 256
+  int32_t filtered; ///< Band-passed signal, counts * 256
+  int32_t amplitude; ///< Average beat amplitude of the band-passed signal, counts * 256
+  uint32_t n; ///< Samples processed
+  bool inPulse; ///< Signal above the detection threshold
+  bool wantNext; ///< The sample fitSpan after the pulse maximum is still to come
+  int32_t peak[3]; ///< Band-passed values fitSpan before, at and fitSpan after the pulse maximum
+  int32_t history[BIO_HR_HISTORY]; ///< Last band-passed values, by sample index modulo BIO_HR_HISTORY
+  uint32_t peakIndex; ///< Sample index of the pulse maximum
+  uint32_t lastBeatQ8; ///< Time of the last beat, samples * 256 since the first sample (wraps after 2^24 samples)
+  uint32_t lastRrQ8; ///< Interval ending at the last beat, samples * 256 (0 after a gap)
+  uint32_t lastActivity; ///< Sample index of the last beat or amplitude decay
+  uint32_t rrQ8[BIO_HR_RR_COUNT]; ///< Last intervals, samples * 256
+  uint8_t rrCount; ///< Intervals stored, up to BIO_HR_RR_COUNT
+  uint8_t rrNext; ///< Slot of the next interval
+  uint16_t heartRate; ///< Median heart rate, LSB = 0.1bpm (0 until BIO_HR_RR_COUNT intervals in a row were seen)
+  uint32_t beats; ///< Beats detected
+
+};
+
+
+/**
+ * @brief   Clears the engine for a sample rate
+ *
+ * @param   *hr        Pointer to engine
+ * @param   sampleRate MAX30101 sample rate, Hz (readADCSampleRate())
+ */
+void bioHrInit(struct bioHr *hr, uint16_t sampleRate);
+
+
+/**
+ * @brief   Processes one sample. Samples must be contiguous (reinitialize after FIFO overflows or gaps)
+ *
+ * @param   *hr   Pointer to engine
+ * @param   irLed IR count of the sample
+ *
+ * @return  true when a beat was detected. It is a few samples in the past, at hr->lastBeatQ8
+ */
+bool bioHrUpdate(struct bioHr *hr, uint32_t irLed);
+
+#endif /* BIO_HR_H_ */
@@ -0,0 +1,106 @@
+/**
+ * @file bio_hrv.c
+ *
+ * @brief Beat to beat interval stream with rolling heart rate variability on raw IR counts
+ */
+
+#include <string.h>
+
+#include "bio_hrv.h"
+#include "bio_math.h"
+
+
+void bioHrvInit(struct bioHrv *hrv, uint16_t sampleRate){
+    memset(hrv, 0, sizeof(*hrv));
+    bioHrInit(&hrv->hr, sampleRate);
+}
+
+
+/**
+ * @brief   Empties the window
+ */
+static void bioHrvClear(struct bioHrv *hrv){
+    hrv->count = 0;
+    hrv->next = 0;
+    hrv->sum = 0;
+    hrv->sumSquares = 0;
+    hrv->sumDiffSquares = 0;
+    hrv->rejected = 0;
+}
+
+
+/**
+ * @brief   Adds an interval to the window, dropping the oldest one when it is full
+ */
+static void bioHrvAdd(struct bioHrv *hrv, uint32_t ibiUs){
+    if(hrv->count == BIO_HRV_WINDOW){ //the oldest is in the slot about to be written
+        uint32_t oldest = hrv->ibiUs[hrv->next];
+        int64_t d = (int64_t)hrv->ibiUs[(hrv->next + 1) % BIO_HRV_WINDOW] - oldest;
+
+        hrv->sum -= oldest;
+        hrv->sumSquares -= (uint64_t)oldest * oldest;
+        hrv->sumDiffSquares -= (uint64_t)(d * d);
+        hrv->count--;
+    }
+    if(hrv->count > 0){
+        int64_t d = (int64_t)ibiUs - hrv->ibiUs[(hrv->next + BIO_HRV_WINDOW - 1) % BIO_HRV_WINDOW];
+
+        hrv->sumDiffSquares += (uint64_t)(d * d);
+    }
+    hrv->ibiUs[hrv->next] = ibiUs;
+    hrv->next = (uint8_t)((hrv->next + 1) % BIO_HRV_WINDOW);
+    hrv->sum += ibiUs;
+    hrv->sumSquares += (uint64_t)ibiUs * ibiUs;
+    hrv->count++;
+}
+
+
+bool bioHrvUpdate(struct bioHrv *hrv, uint32_t irLed, struct bioHrvBeat *beat){
+    uint32_t sampleRate = hrv->hr.sampleRate;
+    uint32_t ageQ8, ibiUs;
+
+    if(!bioHrUpdate(&hrv->hr, irLed)){
+        return false;
+    }
+
+    ageQ8 = (hrv->hr.n << 8) - hrv->hr.lastBeatQ8; //samples * 256 since the beat, both wrap together
+    beat->timeMs = (uint32_t)(((uint64_t)hrv->hr.n * 256000U - (uint64_t)ageQ8 * 1000U) / (256U * sampleRate));
+    ibiUs = (uint32_t)(((uint64_t)hrv->hr.lastRrQ8 * 1000000U + 128U * sampleRate) / (256U * sampleRate));
+    beat->ibiMs = (uint16_t)((ibiUs + 500U) / 1000U);
+    beat->artifact = false;
+
+    if(ibiUs == 0){ //first beat, or first after a gap
+        bioHrvClear(hrv);
+    }
+    else{
+        uint64_t mean = hrv->count ? hrv->sum / hrv->count : ibiUs;
+        uint64_t diff = ibiUs > mean ? ibiUs - mean : mean - ibiUs;
+
+        if(diff * 100U > mean * BIO_HRV_MAX_CHANGE_PCT){
+            beat->artifact = true;
+            hrv->artifacts++;
+            if(++hrv->rejected >= BIO_HRV_MAX_ARTIFACTS){ //the rhythm changed: start over from this interval
+                bioHrvClear(hrv);
+                bioHrvAdd(hrv, ibiUs);
+            }
+        }
+        else{
+            hrv->rejected = 0;
+            bioHrvAdd(hrv, ibiUs);
+        }
+    }
+
+    beat->intervals = hrv->count;
+    beat->rmssdX10 = 0;
+    beat->sdnnX10 = 0;
+    if(hrv->count >= 2){
+        uint64_t n = hrv->count;
+        uint64_t variance = (n * hrv->sumSquares - hrv->sum * hrv->sum) / (n * (n - 1)); //us^2
+
+        beat->rmssdX10 = (uint16_t)((bioSqrt(hrv->sumDiffSquares / (n - 1)) + 50U) / 100U);
+        beat->sdnnX10 = (uint16_t)((bioSqrt(variance) + 50U) / 100U);
+    }
+
+    hrv->beats++;
+    return true;
+}
@@ -0,0 +1,90 @@
+/**
+ * @file bio_hrv.h
+ *
+ * @brief Beat to beat interval stream with rolling heart rate variability on raw IR counts
+ *
+ *  The sensor hub only reports an averaged heart rate. Here each IR count from the raw sample path (readRawData(),
+ *  readRawAndAlgoData() or readSensorData()) goes through bioHrvUpdate(), which runs the bio_hr.h beat detector and
+ *  emits one struct bioHrvBeat per beat instead of one value per sample:
+ *
+ *  - the time of the beat, to a fraction of a sample, and the inter-beat interval (IBI) ending at it
+ *
+ *  - RMSSD (root mean square of successive IBI differences) and SDNN (standard deviation of the IBIs) over the last
+ *    BIO_HRV_WINDOW intervals. Both come from running sums (IBI, IBI^2, successive difference^2) that add the new
+ *    interval and subtract the one leaving the window, so each beat costs the same whatever the window length
+ *
+ *  An interval that differs from the window mean by more than BIO_HRV_MAX_CHANGE_PCT (missed or extra beat, motion)
+ *  is reported as an artifact and kept out of the window. BIO_HRV_MAX_ARTIFACTS artifacts in a row (the rhythm
+ *  really changed) or a gap in the detector (no beat for BIO_HR_MAX_GAP_MS) clear the window.
+ *
+ *  All state is in struct bioHrv: the detector and a ring of BIO_HRV_WINDOW intervals.
+ */
+
+#ifndef BIO_HRV_H_
+#define BIO_HRV_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bio_hr.h"
+
+#define BIO_HRV_WINDOW          32 //intervals in the RMSSD/SDNN window, power of two
+#define BIO_HRV_MAX_CHANGE_PCT  25 //largest difference from the window mean not flagged as an artifact
+#define BIO_HRV_MAX_ARTIFACTS   4  //artifacts in a row that restart the window
+
+
+/**
+ * @brief Struct of one beat event
+ */
+struct bioHrvBeat {
+
+  uint32_t timeMs; ///< Time of the beat, ms since the first sample
+  uint16_t ibiMs; ///< Interval ending at this beat, ms (0 for the first beat, or the first after a gap)
+  uint16_t rmssdX10; ///< RMSSD over the window, LSB = 0.1ms (0 until the window has 2 intervals)
+  uint16_t sdnnX10; ///< SDNN over the window, LSB = 0.1ms (0 until the window has 2 intervals)
+  uint8_t intervals; ///< Intervals in the window, up to BIO_HRV_WINDOW
+  bool artifact; ///< ibiMs was rejected and is not in the window
+
+};
+
+
+/**
+ * @brief Struct of the stream state
+ */
+struct bioHrv {
+
+  struct bioHr hr; ///< Beat detector
+  uint32_t ibiUs[BIO_HRV_WINDOW]; ///< Intervals in the window, us
+  uint8_t count; ///< Intervals in the window
+  uint8_t next; ///< Slot of the next interval
+  uint64_t sum; ///< Sum of the intervals, us
+  uint64_t sumSquares; ///< Sum of the squared intervals, us^2
+  uint64_t sumDiffSquares; ///< Sum of the squared differences of adjacent intervals in the window, us^2
+  uint8_t rejected; ///< Artifacts in a row
+  uint32_t beats; ///< Events emitted
+  uint32_t artifacts; ///< Intervals rejected
+
+};
+
+
+/**
+ * @brief   Clears the stream for a sample rate
+ *
+ * @param   *hrv       Pointer to stream
+ * @param   sampleRate MAX30101 sample rate, Hz (readADCSampleRate())
+ */
+void bioHrvInit(struct bioHrv *hrv, uint16_t sampleRate);
+
+
+/**
+ * @brief   Processes one sample. Samples must be contiguous (reinitialize after FIFO overflows or gaps)
+ *
+ * @param   *hrv   Pointer to stream
+ * @param   irLed  IR count of the sample
+ * @param   *beat  Pointer to the event to fill
+ *
+ * @return  true when a beat was detected and *beat filled. The beat is a few samples in the past (beat->timeMs)
+ */
+bool bioHrvUpdate(struct bioHrv *hrv, uint32_t irLed, struct bioHrvBeat *beat);
+
+#endif /* BIO_HRV_H_ */
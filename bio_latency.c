@@ -0,0 +1,102 @@
+/**
+ * @file bio_latency.c
+ *
+ * @brief Log-bucketed latency histograms
+ */
+
+#include <string.h>
+
+#include "bio_latency.h"
+
+
+/**
+ * @brief   Bucket of a latency: 0 - 3 hold 0 - 3us, then 4 buckets per power of two
+ */
+static uint8_t bioLatencyBucket(uint32_t latencyUs){
+
+    uint8_t msb = 2; //position of the most significant bit
+
+    if(latencyUs < BIO_LATENCY_SUB_BUCKETS){ //small values get a bucket each
+        return (uint8_t)latencyUs;
+    }
+
+    if(latencyUs >= ((uint32_t)1 << BIO_LATENCY_MAX_OCTAVE)){ //off the scale
+        return BIO_LATENCY_BUCKETS - 1;
+    }
+
+    while((latencyUs >> (msb + 1)) != 0){ //find the most significant bit
+        msb++;
+    }
+
+    return (uint8_t)((msb - 1) * BIO_LATENCY_SUB_BUCKETS + ((latencyUs >> (msb - 2)) & (BIO_LATENCY_SUB_BUCKETS - 1)));
+}
+
+
+void bioLatencyHistInit(struct bioLatencyHist *hist){
+    memset(hist, 0, sizeof(*hist));
+    hist->minUs = UINT32_MAX;
+}
+
+
+void bioLatencyHistAdd(struct bioLatencyHist *hist, uint32_t latencyUs){
+    hist->bucket[bioLatencyBucket(latencyUs)]++;
+    hist->count++;
+
+    if(latencyUs < hist->minUs){ //new minimum
+        hist->minUs = latencyUs;
+    }
+    if(latencyUs > hist->maxUs){ //new maximum
+        hist->maxUs = latencyUs;
+    }
+}
+
+
+uint32_t bioLatencyBucketLowUs(uint8_t bucket){
+
+    uint8_t msb = 0;
+    uint8_t sub = 0;
+
+    if(bucket < BIO_LATENCY_SUB_BUCKETS){ //one value per bucket
+        return bucket;
+    }
+
+    msb = bucket / BIO_LATENCY_SUB_BUCKETS + 1;
+    sub = bucket % BIO_LATENCY_SUB_BUCKETS;
+    return (uint32_t)(BIO_LATENCY_SUB_BUCKETS + sub) << (msb - 2);
+}
+
+
+uint32_t bioLatencyPercentileUs(const struct bioLatencyHist *hist, uint8_t percent){
+
+    uint32_t rank = 0; //number of latencies at or below the percentile
+    uint32_t seen = 0;
+    uint8_t bucket = 0;
+    uint32_t upperUs = 0;
+
+    if(hist->count == 0){ //nothing recorded
+        return 0;
+    }
+
+    if(percent > 100){
+        percent = 100;
+    }
+
+    rank = (uint32_t)(((uint64_t)hist->count * percent + 99) / 100); //round up
+    if(rank == 0){
+        rank = 1;
+    }
+
+    for(bucket = 0; bucket < BIO_LATENCY_BUCKETS; bucket++){
+        seen += hist->bucket[bucket];
+        if(seen >= rank){ //the percentile is in this bucket
+            break;
+        }
+    }
+
+    if(bucket >= BIO_LATENCY_BUCKETS - 1){ //last bucket has no upper bound
+        return hist->maxUs;
+    }
+
+    upperUs = bioLatencyBucketLowUs(bucket + 1) - 1;
+    return (upperUs < hist->maxUs) ? upperUs : hist->maxUs;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file bio_latency.h
+ *
+ * @brief Log-bucketed latency histograms
+ *
+ *  Used by bio_sensor.c to track how old samples are when they are drained from the MAX32664 output FIFO
+ *  and when the consumer of the samples gets them. Buckets are spaced by a quarter of a power of two
+ *  (4 buckets per octave, within 19% of each other) from 1us to 2^26us (67s), so percentiles stay meaningful
+ *  in the tail without keeping every sample.
+ */
+
+#ifndef BIO_LATENCY_H_
+#define BIO_LATENCY_H_
+
+#include <stdint.h>
+
+#define BIO_LATENCY_SUB_BUCKETS  4   //buckets per power of two
+#define BIO_LATENCY_MAX_OCTAVE   26  //latencies of 2^26us (67s) and more go to the last bucket
+#define BIO_LATENCY_BUCKETS      ((BIO_LATENCY_MAX_OCTAVE - 1) * BIO_LATENCY_SUB_BUCKETS) //100 buckets
+
+
+/**
+ * @brief Struct of a latency histogram
+ */
+struct bioLatencyHist {
+
+  uint32_t count; ///< Number of latencies recorded
+  uint32_t minUs; ///< Smallest latency recorded, us
+  uint32_t maxUs; ///< Largest latency recorded, us
+  uint32_t bucket[BIO_LATENCY_BUCKETS]; ///< Number of latencies per bucket, see bioLatencyBucketLowUs()
+
+};
+
+
+/**
+ * @brief   Clears a histogram
+ *
+ * @param   *hist Pointer to histogram
+ */
+void bioLatencyHistInit(struct bioLatencyHist *hist);
+
+
+/**
+ * @brief   Records one latency
+ *
+ * @param   *hist     Pointer to histogram
+ * @param   latencyUs Latency, us
+ */
+void bioLatencyHistAdd(struct bioLatencyHist *hist, uint32_t latencyUs);
+
+
+/**
+ * @brief   Smallest latency that falls in a bucket
+ *
+ * @param   bucket Bucket index, 0 to BIO_LATENCY_BUCKETS - 1
+ *
+ * @return  Lower bound of the bucket, us
+ */
+uint32_t bioLatencyBucketLowUs(uint8_t bucket);
+
+
+/**
+ * @brief   Latency below which the given percentage of the recorded latencies fall. The result is the upper
+ *          bound of the bucket holding the percentile (never above the largest latency recorded)
+ *
+ * @param   *hist   Pointer to histogram
+ * @param   percent Percentile, 0 - 100 (e.g. 99 for the p99 latency)
+ *
+ * @return  Percentile latency, us. 0 if the histogram is empty
+ */
+uint32_t bioLatencyPercentileUs(const struct bioLatencyHist *hist, uint8_t percent);
+
+#endif /* BIO_LATENCY_H_ */
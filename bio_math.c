@@ -0,0 +1,28 @@
+/**
+ * @file bio_math.c
+ *
+ * @brief Integer math shared by the signal processing modules
+ */
+
+#include "bio_math.h"
+
+
+uint32_t bioSqrt(uint64_t v){
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while(bit > v){
+        bit >>= 2;
+    }
+    while(bit != 0){
+        if(v >= root + bit){
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else{
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
@@ -0,0 +1,22 @@
+/**
+ * @file bio_math.h
+ *
+ * @brief Integer math shared by the signal processing modules
+ */
+
+#ifndef BIO_MATH_H_
+#define BIO_MATH_H_
+
+#include <stdint.h>
+
+
+/**
+ * @brief   Integer square root, rounded down
+ *
+ * @param   v Value
+ *
+ * @return  Largest root whose square is at most v
+ */
+uint32_t bioSqrt(uint64_t v);
+
+#endif /* BIO_MATH_H_ */
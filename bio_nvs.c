@@ -0,0 +1,170 @@
+/**
+ * @file bio_nvs.c
+ *
+ * @brief Hub snapshot kept in non-volatile storage
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "bio_nvs.h"
+#include "bio_frame.h"
+
+
+/**
+ * @brief   NVS driver backend read
+ */
+static uint8_t bioNvsDriverRead(void *ctx, uint32_t offset, void *buf, uint16_t len){
+    return NVS_read((NVS_Handle)ctx, offset, buf, len) == NVS_STATUS_SUCCESS ? SUCCESS : ERR_UNKNOWN;
+}
+
+
+/**
+ * @brief   NVS driver backend write: erases the sectors covered, writes and reads back
+ */
+static uint8_t bioNvsDriverWrite(void *ctx, uint32_t offset, const void *buf, uint16_t len){
+    int_fast16_t status = NVS_write((NVS_Handle)ctx, offset, (void *)buf, len, NVS_WRITE_ERASE | NVS_WRITE_POST_VERIFY);
+
+    return status == NVS_STATUS_SUCCESS ? SUCCESS : ERR_UNKNOWN;
+}
+
+
+/**
+ * @brief   RAM backend read
+ */
+static uint8_t bioNvsRamRead(void *ctx, uint32_t offset, void *buf, uint16_t len){
+    struct bioNvsRam *ram = (struct bioNvsRam *)ctx;
+
+    if(offset + len > sizeof(ram->data)){
+        return ERR_UNKNOWN;
+    }
+    memcpy(buf, &ram->data[offset], len);
+    return SUCCESS;
+}
+
+
+/**
+ * @brief   RAM backend write
+ */
+static uint8_t bioNvsRamWrite(void *ctx, uint32_t offset, const void *buf, uint16_t len){
+    struct bioNvsRam *ram = (struct bioNvsRam *)ctx;
+
+    if(offset + len > sizeof(ram->data)){
+        return ERR_UNKNOWN;
+    }
+    memcpy(&ram->data[offset], buf, len);
+    return SUCCESS;
+}
+
+
+void bioNvsUseDriver(struct bioNvsBackend *nvs, NVS_Handle handle){
+    nvs->read = bioNvsDriverRead;
+    nvs->write = bioNvsDriverWrite;
+    nvs->ctx = handle;
+}
+
+
+void bioNvsUseRam(struct bioNvsBackend *nvs, struct bioNvsRam *ram){
+    memset(ram->data, 0xFF, sizeof(ram->data)); //erased
+    nvs->read = bioNvsRamRead;
+    nvs->write = bioNvsRamWrite;
+    nvs->ctx = ram;
+}
+
+
+/**
+ * @brief   CRC of a snapshot, crc field excluded
+ */
+static uint16_t bioSnapshotCrc(const struct bioSnapshot *snap){
+    return bioFrameCrc16(0xFFFF, (const uint8_t *)snap, offsetof(struct bioSnapshot, crc));
+}
+
+
+uint8_t bioSnapshotCapture(struct bioSnapshot *snap){
+    uint8_t statusByte = SUCCESS;
+    uint8_t firstError = SUCCESS;
+
+    memset(snap, 0, sizeof(*snap)); //padding included, it is covered by the CRC
+
+    readSensorHubVersion(&statusByte); //fills the identity cache
+    if(firstError == SUCCESS) firstError = statusByte;
+    readAlgorithmVersion(&statusByte); //deprecated on current hub firmware: BIO_IDENTITY_ALGO_VERS then stays clear
+    readBootloaderVersion(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    getMcuType(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    bioGetIdentity(&snap->identity);
+
+    snap->max30101Attr = getAfeAttributesMAX30101(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    snap->accelAttr = getAfeAttributesAccelerometer(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    snap->algoRange = readAlgoRange(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    snap->algoStepSize = readAlgoStepSize(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    snap->algoSensitivity = readAlgoSensitivity(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    snap->algoSamples = readAlgoSamples(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    snap->algoSampleRate = readAlgoSampleRate(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    statusByte = readMaximFastCoef(snap->maximFastCoef);
+    if(firstError == SUCCESS) firstError = statusByte;
+
+    return firstError;
+}
+
+
+uint8_t bioSnapshotSave(const struct bioNvsBackend *nvs, struct bioSnapshot *snap){
+    snap->magic = BIO_SNAPSHOT_MAGIC;
+    snap->layout = BIO_SNAPSHOT_LAYOUT;
+    snap->size = sizeof(*snap);
+    snap->crc = bioSnapshotCrc(snap);
+
+    return nvs->write(nvs->ctx, BIO_SNAPSHOT_OFFSET, snap, sizeof(*snap));
+}
+
+
+uint8_t bioSnapshotLoad(const struct bioNvsBackend *nvs, struct bioSnapshot *snap){
+    if(nvs->read(nvs->ctx, BIO_SNAPSHOT_OFFSET, snap, sizeof(*snap)) != SUCCESS){
+        return ERR_UNKNOWN;
+    }
+
+    if(snap->magic != BIO_SNAPSHOT_MAGIC || snap->layout != BIO_SNAPSHOT_LAYOUT || snap->size != sizeof(*snap)
+            || snap->crc != bioSnapshotCrc(snap)){ //erased, older layout or torn write
+        return ERR_DATA_FORMAT;
+    }
+    return SUCCESS;
+}
+
+
+uint8_t bioSnapshotRestore(const struct bioNvsBackend *nvs, struct bioSnapshot *snap, bool *warm){
+    struct version hubVer;
+    uint8_t statusByte = SUCCESS;
+
+    if(warm){
+        *warm = false;
+    }
+
+    hubVer = readSensorHubVersion(&statusByte); //the one command of a warm boot
+    if(statusByte != SUCCESS){
+        return statusByte;
+    }
+
+    if(bioSnapshotLoad(nvs, snap) == SUCCESS && (snap->identity.valid & BIO_IDENTITY_HUB_VERS)
+            && memcmp(&snap->identity.sensorHubVer, &hubVer, sizeof(hubVer)) == 0){ //same firmware as when stored
+        bioSetIdentity(&snap->identity);
+        if(warm){
+            *warm = true;
+        }
+        return SUCCESS;
+    }
+
+    statusByte = bioSnapshotCapture(snap); //new hub or firmware: discover and store
+    if(statusByte != SUCCESS){
+        return statusByte;
+    }
+    bioSnapshotSave(nvs, snap);
+    return SUCCESS;
+}
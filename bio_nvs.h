@@ -0,0 +1,143 @@
+/**
+ * @file bio_nvs.h
+ *
+ * @brief Hub snapshot kept in non-volatile storage, to skip identity and configuration discovery on warm boots
+ *
+ *  A snapshot holds what the application discovers about the hub after configMAX32664(): the identity (versions, MCU
+ *  type), the AFE attributes, the AGC settings, the algorithm sample rate and the MaximFast coefficients. bioSnapshotRestore() reads the stored
+ *  snapshot and checks it against the hub with one command (the sensor hub version). On a match the snapshot is used
+ *  as is and seeds the identity cache of bio_sensor.c. Otherwise the hub is queried again and the new snapshot is
+ *  stored.
+ *
+ *  Storage goes through a struct bioNvsBackend: bioNvsUseDriver() for the TI-Drivers NVS region on target,
+ *  bioNvsUseRam() for a RAM stand-in (host programs, or retention RAM on a board without a spare flash sector).
+ */
+
+#ifndef BIO_NVS_H_
+#define BIO_NVS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <ti/drivers/NVS.h>
+
+#include "bio_sensor.h"
+
+#define BIO_SNAPSHOT_MAGIC   0x31534E42 //"BNS1" in little endian, first word of a stored snapshot
+#define BIO_SNAPSHOT_LAYOUT  2          //bumped whenever struct bioSnapshot changes, older snapshots are then ignored
+#define BIO_SNAPSHOT_OFFSET  0          //offset of the snapshot in the NVS region
+
+
+/**
+ * @brief Struct of a storage backend. Each function returns SUCCESS or ERR_UNKNOWN
+ */
+struct bioNvsBackend {
+
+  uint8_t (*read)(void *ctx, uint32_t offset, void *buf, uint16_t len); ///< Reads len bytes at offset
+  uint8_t (*write)(void *ctx, uint32_t offset, const void *buf, uint16_t len); ///< Replaces len bytes at offset (erasing as needed)
+  void *ctx; ///< Backend state passed to read and write
+
+};
+
+
+/**
+ * @brief Struct of what is discovered about a configured hub
+ */
+struct bioSnapshot {
+
+  uint32_t magic; ///< BIO_SNAPSHOT_MAGIC
+  uint16_t layout; ///< BIO_SNAPSHOT_LAYOUT
+  uint16_t size; ///< sizeof(struct bioSnapshot)
+  struct bioIdentity identity; ///< Versions and MCU type, sensorHubVer is the key checked at boot
+  struct sensorAttr max30101Attr; ///< getAfeAttributesMAX30101()
+  struct sensorAttr accelAttr; ///< getAfeAttributesAccelerometer()
+  uint8_t algoRange; ///< readAlgoRange()
+  uint8_t algoStepSize; ///< readAlgoStepSize()
+  uint8_t algoSensitivity; ///< readAlgoSensitivity()
+  uint8_t algoSamples; ///< readAlgoSamples()
+  uint16_t algoSampleRate; ///< readAlgoSampleRate()
+  int32_t maximFastCoef[NUM_MAXIM_FAST_COEF]; ///< readMaximFastCoef()
+  uint16_t crc; ///< CRC16-CCITT of everything above
+
+};
+
+
+/**
+ * @brief Struct of the RAM backend storage
+ */
+struct bioNvsRam {
+
+  uint8_t data[BIO_SNAPSHOT_OFFSET + sizeof(struct bioSnapshot)]; ///< Stored bytes
+
+};
+
+
+/**
+ * @brief   Sets up a backend on a TI-Drivers NVS region (e.g. NVS_open(CONFIG_NVSINTERNAL, &params)). Writes erase
+ *          the sectors they cover and are verified
+ *
+ * @param   *nvs    Pointer to backend
+ * @param   handle  Open NVS handle
+ */
+void bioNvsUseDriver(struct bioNvsBackend *nvs, NVS_Handle handle);
+
+
+/**
+ * @brief   Sets up a backend on RAM. The storage starts erased (a snapshot read from it is invalid)
+ *
+ * @param   *nvs    Pointer to backend
+ * @param   *ram    Pointer to storage, must outlive the backend
+ */
+void bioNvsUseRam(struct bioNvsBackend *nvs, struct bioNvsRam *ram);
+
+
+/**
+ * @brief   Discovers the hub: identity, AFE attributes, AGC settings and MaximFast coefficients
+ *
+ * @pre     configMAX32664(), so the AGC settings read are the ones in use
+ *
+ * @param   *snap Pointer to snapshot to fill
+ *
+ * @return  SUCCESS, or the status byte of the first failing read. readAlgorithmVersion() is deprecated on current hub
+ *          firmware and may fail without failing the capture; BIO_IDENTITY_ALGO_VERS is then left clear
+ */
+uint8_t bioSnapshotCapture(struct bioSnapshot *snap);
+
+
+/**
+ * @brief   Stores a snapshot (its magic, layout, size and CRC are set here)
+ *
+ * @param   *nvs  Pointer to backend
+ * @param   *snap Pointer to snapshot
+ *
+ * @return  SUCCESS, or ERR_UNKNOWN if the backend failed
+ */
+uint8_t bioSnapshotSave(const struct bioNvsBackend *nvs, struct bioSnapshot *snap);
+
+
+/**
+ * @brief   Reads the stored snapshot and checks its magic, layout, size and CRC. No bus traffic
+ *
+ * @param   *nvs  Pointer to backend
+ * @param   *snap Pointer to snapshot to fill
+ *
+ * @return  SUCCESS, ERR_DATA_FORMAT if nothing valid is stored, ERR_UNKNOWN if the backend failed
+ */
+uint8_t bioSnapshotLoad(const struct bioNvsBackend *nvs, struct bioSnapshot *snap);
+
+
+/**
+ * @brief   Warm boot: uses the stored snapshot if its sensor hub version matches the hub's, otherwise discovers the
+ *          hub with bioSnapshotCapture() and stores the result. Either way the identity cache is filled
+ *
+ * @pre     beginI2C() and configMAX32664()
+ *
+ * @param   *nvs  Pointer to backend
+ * @param   *snap Pointer to snapshot to fill
+ * @param   *warm Set to true when the stored snapshot was used (may be NULL)
+ *
+ * @return  SUCCESS, or the status byte of the failing hub read. A failed store is not an error (the next boot
+ *          discovers again)
+ */
+uint8_t bioSnapshotRestore(const struct bioNvsBackend *nvs, struct bioSnapshot *snap, bool *warm);
+
+#endif /* BIO_NVS_H_ */
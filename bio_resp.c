@@ -0,0 +1,184 @@
+/**
+ * @file bio_resp.c
+ *
+ * @brief Respiratory rate from the baseline and amplitude modulation of the raw IR counts
+ */
+
+#include <string.h>
+
+#include "bio_resp.h"
+
+//second order Butterworth low-pass at BIO_RESP_LOWPASS_MHZ for BIO_RESP_RATE_HZ, Q14 (b1 = 2 * b0, b2 = b0)
+#define BIO_RESP_B0  329
+#define BIO_RESP_A1  (-25576)
+#define BIO_RESP_A2  10508
+
+#define BIO_RESP_PULSE_W     (6283 * BIO_RESP_PULSE_MHZ / 1000) //pulse high-pass corner angular frequency * 1000
+#define BIO_RESP_PULSE_ALPHA (32768 * BIO_RESP_PULSE_W / (BIO_RESP_RATE_HZ * 1000 + BIO_RESP_PULSE_W)) //Q15, w / (1 + w)
+#define BIO_RESP_PULSE_MAX   32767 //pulse clamp: its square, and the envelope low-pass overshoot on it, fit int32_t
+#define BIO_RESP_DC_ALPHA    (32768 / (BIO_RESP_RATE_HZ * BIO_RESP_DC_MS / 1000 + 1)) //Q15
+#define BIO_RESP_MIN_GAP     (BIO_RESP_RATE_HZ * 60 / BIO_RESP_MAX_BRPM) //shortest interval, low rate samples
+#define BIO_RESP_MAX_GAP     (BIO_RESP_RATE_HZ * 60 / BIO_RESP_MIN_BRPM) //longest interval, low rate samples
+#define BIO_RESP_OUTPUT_GAP  (BIO_RESP_RATE_HZ * BIO_RESP_OUTPUT_MS / 1000) //low rate samples between updates
+
+
+void bioRespInit(struct bioResp *resp, uint16_t sampleRate){
+    memset(resp, 0, sizeof(*resp));
+    resp->blockSize = sampleRate / BIO_RESP_RATE_HZ;
+    if(resp->blockSize == 0){
+        resp->blockSize = 1;
+    }
+    resp->nextOutput = BIO_RESP_OUTPUT_GAP;
+}
+
+
+/**
+ * @brief   Runs one low-pass section
+ */
+static int32_t bioRespBiquad(struct bioRespBiquad *bq, int32_t x){
+    int64_t acc = (int64_t)BIO_RESP_B0 * ((int64_t)x + 2 * (int64_t)bq->x1 + bq->x2)
+                  - (int64_t)BIO_RESP_A1 * bq->y1 - (int64_t)BIO_RESP_A2 * bq->y2;
+    int32_t y = (int32_t)(acc >> 14);
+
+    bq->x2 = bq->x1;
+    bq->x1 = x;
+    bq->y2 = bq->y1;
+    bq->y1 = y;
+    return y;
+}
+
+
+/**
+ * @brief   Median of the stored intervals (BIO_RESP_BREATHS of them), with their spread (largest - smallest)
+ */
+static uint32_t bioRespMedian(const struct bioRespTrack *track, uint32_t *spread){
+    uint32_t sorted[BIO_RESP_BREATHS];
+    uint8_t i, j;
+
+    for(i = 0; i < BIO_RESP_BREATHS; i++){ //insertion sort
+        uint32_t v = track->intervalQ8[i];
+        for(j = i; j > 0 && sorted[j - 1] > v; j--){
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+    *spread = sorted[BIO_RESP_BREATHS - 1] - sorted[0];
+    return sorted[BIO_RESP_BREATHS / 2];
+}
+
+
+/**
+ * @brief   Runs the breath detector of one modulation signal on its low rate value
+ */
+static void bioRespTrack(struct bioRespTrack *track, uint32_t n, int32_t y){
+    int32_t magnitude = y < 0 ? -y : y;
+
+    if(magnitude > track->extreme){
+        track->extreme = magnitude;
+    }
+    if(y < -(track->swing >> 2)){
+        track->armed = true;
+    }
+
+    if(track->armed && track->previous < 0 && y >= 0 && n > 0){ //upward zero crossing: a breath
+        uint32_t breathQ8 = ((n - 1) << 8) + (uint32_t)(((int64_t)-track->previous << 8) / ((int64_t)y - track->previous));
+        uint32_t intervalQ8 = breathQ8 - track->lastBreathQ8;
+
+        track->armed = false;
+        if(!track->started || intervalQ8 >= (BIO_RESP_MIN_GAP << 8)){
+            if(track->started && intervalQ8 <= (BIO_RESP_MAX_GAP << 8)){
+                track->intervalQ8[track->next] = intervalQ8;
+                track->next = (uint8_t)((track->next + 1) % BIO_RESP_BREATHS);
+                if(track->count < BIO_RESP_BREATHS){
+                    track->count++;
+                }
+                if(track->count == BIO_RESP_BREATHS){
+                    uint32_t spread;
+                    uint32_t median = bioRespMedian(track, &spread);
+                    track->rateX10 = (uint16_t)((600U * BIO_RESP_RATE_HZ * 256U + median / 2) / median);
+                }
+            }
+            track->swing += (track->extreme - track->swing) >> 2;
+            track->extreme = 0;
+            track->lastBreathQ8 = breathQ8;
+            track->started = true;
+        }
+    }
+
+    if(track->started && n - (track->lastBreathQ8 >> 8) > BIO_RESP_MAX_GAP){ //no breath for too long: start over
+        track->started = false;
+        track->count = 0;
+        track->rateX10 = 0;
+        track->swing >>= 1;
+    }
+
+    track->previous = y;
+}
+
+
+/**
+ * @brief   Fuses the BM and AM rates
+ */
+static uint16_t bioRespFuse(const struct bioResp *resp){
+    uint32_t bmSpread, amSpread, bmMedian, amMedian;
+    uint32_t bm = resp->bm.rateX10, am = resp->am.rateX10;
+
+    if(bm == 0 || am == 0){
+        return (uint16_t)(bm ? bm : am);
+    }
+    if((bm > am ? bm - am : am - bm) * 200U <= (bm + am) * BIO_RESP_AGREE_PCT){
+        return (uint16_t)((bm + am + 1) / 2);
+    }
+
+    bmMedian = bioRespMedian(&resp->bm, &bmSpread);
+    amMedian = bioRespMedian(&resp->am, &amSpread);
+    return (uint64_t)bmSpread * amMedian <= (uint64_t)amSpread * bmMedian ? (uint16_t)bm : (uint16_t)am; //relative spread
+}
+
+
+/**
+ * @brief   Runs the low rate chain on the mean of one block
+ */
+static void bioRespLowRate(struct bioResp *resp, int32_t x){
+    int32_t hp, bm, pulse, envelope;
+
+    if(resp->n == 0){ //start on the DC
+        resp->dc = x;
+    }
+    resp->dc += (int32_t)(((int64_t)(x - resp->dc) * BIO_RESP_DC_ALPHA) >> 15);
+    hp = x - resp->dc;
+
+    bm = bioRespBiquad(&resp->low[1], bioRespBiquad(&resp->low[0], hp));
+    resp->pulseLow[0] += (int32_t)(((int64_t)(hp - resp->pulseLow[0]) * BIO_RESP_PULSE_ALPHA) >> 15);
+    pulse = hp - resp->pulseLow[0];
+    resp->pulseLow[1] += (int32_t)(((int64_t)(pulse - resp->pulseLow[1]) * BIO_RESP_PULSE_ALPHA) >> 15);
+    pulse -= resp->pulseLow[1];
+    pulse >>= 6; //counts / 4
+    if(pulse > BIO_RESP_PULSE_MAX) pulse = BIO_RESP_PULSE_MAX; //a step (finger placed) could overflow the square
+    if(pulse < -BIO_RESP_PULSE_MAX) pulse = -BIO_RESP_PULSE_MAX;
+    envelope = bioRespBiquad(&resp->envelope[1], bioRespBiquad(&resp->envelope[0], pulse * pulse));
+    resp->envelopeDc += (int32_t)(((int64_t)(envelope - resp->envelopeDc) * BIO_RESP_DC_ALPHA) >> 15);
+
+    bioRespTrack(&resp->bm, resp->n, bm);
+    bioRespTrack(&resp->am, resp->n, envelope - resp->envelopeDc);
+    resp->n++;
+}
+
+
+bool bioRespUpdate(struct bioResp *resp, uint32_t irLed){
+    resp->blockSum += irLed;
+    if(++resp->blockCount < resp->blockSize){
+        return false;
+    }
+
+    bioRespLowRate(resp, (int32_t)(((uint64_t)resp->blockSum * 16U) / resp->blockSize)); //counts * 16
+    resp->blockSum = 0;
+    resp->blockCount = 0;
+
+    if(resp->n == resp->nextOutput){
+        resp->rateX10 = bioRespFuse(resp);
+        resp->nextOutput += BIO_RESP_OUTPUT_GAP;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file bio_resp.h
+ *
+ * @brief Respiratory rate from the baseline and amplitude modulation of the raw IR counts
+ *
+ *  Breathing moves the PPG baseline (venous return) and scales the pulse amplitude (stroke volume). Each IR count
+ *  from the raw sample path (readRawData(), readSensorData()) goes through bioRespUpdate(), which only adds it to a
+ *  block sum. Once a block of sampleRate / BIO_RESP_RATE_HZ samples is complete, its mean goes through the low rate
+ *  chain, so the cost per sample is an addition and a compare:
+ *
+ *  - baseline modulation (BM): a slow high-pass removes the DC and two second order low-pass sections at
+ *    BIO_RESP_LOWPASS_MHZ remove the pulse
+ *
+ *  - amplitude modulation (AM): the pulse, high-passed twice at BIO_RESP_PULSE_MHZ, is squared into its power, and
+ *    two low-pass sections and the slow high-pass turn that into the envelope. Squaring (rather than rectifying)
+ *    keeps the harmonics below the low rate Nyquist frequency, where they would alias into the respiratory band
+ *
+ *  Each modulation signal has its own breath detector: a breath is an upward zero crossing (interpolated between
+ *  the low rate samples) after the signal went below a quarter of its average swing, and the rate is the median of
+ *  the last BIO_RESP_BREATHS intervals. Every BIO_RESP_OUTPUT_MS the two rates are fused: their mean when they
+ *  agree within BIO_RESP_AGREE_PCT, else the one with the more regular intervals.
+ *
+ *  The low-pass sections have fixed Q14 coefficients for the BIO_RESP_RATE_HZ rate, which every MAX30101 sample rate
+ *  divides into. The pulse is only removed well above the corner, so slow heart rates leak into BM and bias it.
+ */
+
+#ifndef BIO_RESP_H_
+#define BIO_RESP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BIO_RESP_RATE_HZ     10   //low rate chain sample rate
+#define BIO_RESP_LOWPASS_MHZ 500  //low-pass corner, mHz (30 breaths/min), the Q14 coefficients in bio_resp.c are for it
+#define BIO_RESP_PULSE_MHZ   800  //AM pulse high-pass corner, mHz
+#define BIO_RESP_DC_MS       3000 //DC high-pass time constant
+#define BIO_RESP_MIN_BRPM    4    //longer breaths restart the detector
+#define BIO_RESP_MAX_BRPM    40   //shortest interval accepted between breaths
+#define BIO_RESP_BREATHS     5    //intervals in the median, odd
+#define BIO_RESP_OUTPUT_MS   5000 //rate update interval
+#define BIO_RESP_AGREE_PCT   15   //BM and AM rates closer than this are averaged
+
+
+/**
+ * @brief Struct of one second order low-pass section (direct form I)
+ */
+struct bioRespBiquad {
+
+  int32_t x1, x2; ///< Last inputs
+  int32_t y1, y2; ///< Last outputs
+
+};
+
+
+/**
+ * @brief Struct of the breath detector of one modulation signal
+ */
+struct bioRespTrack {
+
+  int32_t previous; ///< Previous low rate value
+  int32_t swing; ///< Average peak magnitude per breath
+  int32_t extreme; ///< Largest magnitude since the last breath
+  bool armed; ///< Went below -swing / 4 since the last breath
+  bool started; ///< A breath was seen (lastBreathQ8 valid)
+  uint32_t lastBreathQ8; ///< Time of the last breath, low rate samples * 256
+  uint32_t intervalQ8[BIO_RESP_BREATHS]; ///< Last intervals, low rate samples * 256
+  uint8_t count; ///< Intervals stored, up to BIO_RESP_BREATHS
+  uint8_t next; ///< Slot of the next interval
+  uint16_t rateX10; ///< Median rate, LSB = 0.1 breaths/min (0 until BIO_RESP_BREATHS intervals in a row)
+
+};
+
+
+/**
+ * @brief Struct of the estimator state
+ */
+struct bioResp {
+
+  uint32_t blockSize; ///< Samples per low rate sample
+  uint32_t blockCount; ///< Samples in the current block
+  uint32_t blockSum; ///< Sum of the current block, counts
+  uint32_t n; ///< Low rate samples processed
+  uint32_t nextOutput; ///< Low rate sample index of the next rate update
+  int32_t dc; ///< DC, counts * 16
+  struct bioRespBiquad low[2]; ///< BM low-pass sections
+  int32_t pulseLow[2]; ///< AM pulse high-pass stages
+  struct bioRespBiquad envelope[2]; ///< AM envelope low-pass sections
+  int32_t envelopeDc; ///< AM envelope DC
+  struct bioRespTrack bm; ///< Baseline modulation breaths
+  struct bioRespTrack am; ///< Amplitude modulation breaths
+  uint16_t rateX10; ///< Fused respiratory rate, LSB = 0.1 breaths/min (0 when neither signal has a rate)
+
+};
+
+
+/**
+ * @brief   Clears the estimator for a sample rate
+ *
+ * @param   *resp      Pointer to estimator
+ * @param   sampleRate MAX30101 sample rate, Hz (readADCSampleRate()), a multiple of BIO_RESP_RATE_HZ
+ */
+void bioRespInit(struct bioResp *resp, uint16_t sampleRate);
+
+
+/**
+ * @brief   Processes one sample. Samples must be contiguous (reinitialize after FIFO overflows, gaps or finger off)
+ *
+ * @param   *resp Pointer to estimator
+ * @param   irLed IR count of the sample
+ *
+ * @return  true when resp->rateX10 was updated (every BIO_RESP_OUTPUT_MS)
+ */
+bool bioRespUpdate(struct bioResp *resp, uint32_t irLed);
+
+#endif /* BIO_RESP_H_ */
@@ -0,0 +1,176 @@
+/**
+ * @file bio_sched.c
+ *
+ * @brief Multi-rate scheduler for the streaming loop
+ */
+
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "bio_sched.h"
+
+
+/**
+ * @brief   Signed difference of two bioGetTimeUs() times, positive when a is after b
+ */
+static int32_t bioSchedDiff(uint32_t a, uint32_t b){
+    return (int32_t)(a - b);
+}
+
+
+void bioSchedInit(struct bioSched *sched, bioSchedFxn drainFxn, void *drainArg, uint32_t drainPeriodUs, uint32_t slackUs){
+    memset(sched, 0, sizeof(*sched));
+    sched->drainFxn = drainFxn;
+    sched->drainArg = drainArg;
+    sched->drainPeriodUs = drainPeriodUs ? drainPeriodUs : 1;
+    sched->slackUs = slackUs;
+    sched->nextDrainUs = bioGetTimeUs();
+}
+
+
+uint8_t bioSchedAdd(struct bioSched *sched, bioSchedFxn fxn, void *arg, uint32_t periodMs, uint32_t costUs){
+    struct bioSchedTask *task;
+
+    if(sched->numTasks >= BIO_SCHED_MAX_TASKS){ //no room
+        return 0xFF;
+    }
+
+    task = &sched->task[sched->numTasks];
+    memset(task, 0, sizeof(*task));
+    task->fxn = fxn;
+    task->arg = arg;
+    task->periodUs = periodMs * 1000;
+    task->costUs = costUs ? costUs : BIO_SCHED_DEFAULT_COST;
+    task->dueUs = bioGetTimeUs();
+    task->requested = 1; //first run as soon as it fits
+
+    return sched->numTasks++;
+}
+
+
+void bioSchedRequest(struct bioSched *sched, uint8_t index){
+    if(index < sched->numTasks){
+        sched->task[index].requested = 1;
+    }
+}
+
+
+void bioSchedSkip(struct bioSched *sched, uint8_t index){
+    if(index < sched->numTasks){
+        sched->task[index].requested = 0;
+        sched->task[index].dueUs = bioGetTimeUs() + sched->task[index].periodUs;
+    }
+}
+
+
+/**
+ * @brief   Keeps an expected duration: a longer run is taken as is, a shorter one pulls the estimate down by 1/8 of
+ *          the difference
+ */
+static void bioSchedCost(uint32_t *costUs, uint32_t durationUs){
+    if(durationUs > *costUs){
+        *costUs = durationUs;
+    }
+    else{
+        *costUs -= (*costUs - durationUs) / 8;
+    }
+}
+
+
+/**
+ * @brief   Runs a drain and moves the drain time on
+ */
+static void bioSchedDrain(struct bioSched *sched, uint32_t now){
+    uint32_t durationUs;
+
+    if(bioSchedDiff(now, sched->nextDrainUs) > (int32_t)sched->drainPeriodUs){ //started more than a period late
+        sched->lateDrains++;
+    }
+
+    if(sched->drainFxn(sched->drainArg) != SUCCESS){
+        sched->drainErrors++;
+    }
+    sched->drains++;
+    sched->nextDrainUs += sched->drainPeriodUs;
+
+    durationUs = bioGetTimeUs() - now;
+    bioSchedCost(&sched->drainCostUs, durationUs);
+    if(durationUs > sched->drainPeriodUs){ //the drains cannot keep their period, see bioSchedInit()
+        sched->slowDrains++;
+    }
+
+    now = bioGetTimeUs();
+    if(bioSchedDiff(now, sched->nextDrainUs) > (int32_t)(BIO_SCHED_MAX_BACKLOG * sched->drainPeriodUs)){ //too far behind to catch up
+        sched->skippedDrains += (uint32_t)bioSchedDiff(now, sched->nextDrainUs) / sched->drainPeriodUs;
+        sched->nextDrainUs = now;
+    }
+}
+
+
+/**
+ * @brief   Runs a query and updates its expected duration
+ */
+static void bioSchedQuery(struct bioSchedTask *task, uint32_t now){
+    task->lastStatus = task->fxn(task->arg);
+    bioSchedCost(&task->costUs, bioGetTimeUs() - now);
+
+    task->runs++;
+    if(task->lastStatus != SUCCESS){
+        task->errors++;
+    }
+
+    task->requested = 0;
+    if(task->periodUs){
+        task->dueUs = now + task->periodUs;
+    }
+}
+
+
+uint8_t bioSchedStep(struct bioSched *sched){
+    uint32_t now = bioGetTimeUs();
+    int32_t gapUs = bioSchedDiff(sched->nextDrainUs, now) + (int32_t)sched->slackUs; //time a query may take
+    struct bioSchedTask *best = NULL;
+    int32_t bestLateness = 0;
+    uint8_t i;
+
+    if(bioSchedDiff(now, sched->nextDrainUs) >= 0){ //drain time
+        bioSchedDrain(sched, now);
+        return BIO_SCHED_DRAIN;
+    }
+
+    for(i = 0; i < sched->numTasks; i++){ //most overdue query that fits
+        struct bioSchedTask *task = &sched->task[i];
+        int32_t lateness;
+
+        if(!task->requested && (task->periodUs == 0 || bioSchedDiff(now, task->dueUs) < 0)){ //not due
+            continue;
+        }
+        if((int32_t)task->costUs > gapUs){ //would delay the next drain
+            task->deferred++;
+            continue;
+        }
+
+        lateness = task->requested ? INT32_MAX : bioSchedDiff(now, task->dueUs); //requests first
+        if(best == NULL || lateness > bestLateness){
+            best = task;
+            bestLateness = lateness;
+        }
+    }
+
+    if(best){
+        bioSchedQuery(best, now);
+        return BIO_SCHED_QUERY;
+    }
+
+    gapUs = bioSchedDiff(sched->nextDrainUs, now); //nothing fits: wait for the drain
+    if(gapUs > 0){
+        sched->idleUs += (uint32_t)gapUs;
+    }
+    while(gapUs > 0){ //usleep() takes less than one second
+        uint32_t sleepUs = (gapUs > BIO_SCHED_MAX_SLEEP_US) ? BIO_SCHED_MAX_SLEEP_US : (uint32_t)gapUs;
+
+        bioUsleep(sleepUs);
+        gapUs -= (int32_t)sleepUs;
+    }
+    return BIO_SCHED_IDLE;
+}
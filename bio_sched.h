@@ -0,0 +1,143 @@
+/**
+ * @file bio_sched.h
+ *
+ * @brief Multi-rate scheduler for the streaming loop: FIFO drains at the sample rate, configuration and identity
+ *        queries at low rates or on request, fitted into the bus idle time between drains
+ *
+ *  Call bioSchedStep() in a loop. Each step does one of:
+ *
+ *  - a drain, when the drain time has come (drains that fell behind run back to back until they catch up)
+ *
+ *  - the most overdue query whose expected duration fits before the next drain (plus the allowed slack). A query's
+ *    expected duration starts at the value given to bioSchedAdd() and follows the measured durations
+ *
+ *  - a bioUsleep() until the next drain, when nothing fits (split into calls of less than a second for long periods)
+ *
+ *  Queries that are due but do not fit are counted as deferred, so a starved query shows up in its counters instead
+ *  of delaying the drains. Times come from bioGetTimeUs().
+ *
+ *  The drains must take less than one drain period, or they fall further behind with every period until
+ *  BIO_SCHED_MAX_BACKLOG drops them, and queries only run within the slack. A readSensorData() per drain costs three
+ *  command round trips (~18ms), so one sample per drain only keeps up to about 50Hz. At higher rates, drain with
+ *  readSensorDataBatch() every few sample periods: two round trips per drain plus one per sample. drainCostUs and
+ *  slowDrains show whether a drain fits its period.
+ */
+
+#ifndef BIO_SCHED_H_
+#define BIO_SCHED_H_
+
+#include <stdint.h>
+
+#define BIO_SCHED_MAX_TASKS     16      //queries per scheduler
+#define BIO_SCHED_DEFAULT_COST  8000    //expected query duration when none is given, us (one command round trip + margin)
+#define BIO_SCHED_MAX_BACKLOG   64      //drains a late scheduler catches up on (output FIFO depth), older ones are skipped
+#define BIO_SCHED_MAX_SLEEP_US  999999  //longest bioUsleep() of an idle wait, longer waits are split (usleep() takes less than 1s)
+
+#define BIO_SCHED_IDLE   0  //bioSchedStep() slept until the next drain
+#define BIO_SCHED_DRAIN  1  //bioSchedStep() ran the drain
+#define BIO_SCHED_QUERY  2  //bioSchedStep() ran a query
+
+/**
+ * @brief Drain or query function. Returns the status byte of its transactions (SUCCESS when all went well)
+ */
+typedef uint8_t (*bioSchedFxn)(void *arg);
+
+
+/**
+ * @brief Struct of a scheduled query
+ */
+struct bioSchedTask {
+
+  bioSchedFxn fxn; ///< Query function
+  void *arg; ///< Argument passed to fxn
+  uint32_t periodUs; ///< Time between runs, us. 0 to run only on bioSchedRequest()
+  uint32_t dueUs; ///< Time of the next run (bioGetTimeUs() clock)
+  uint32_t costUs; ///< Expected duration, us
+  uint8_t requested; ///< Run as soon as it fits, whatever the period
+  uint8_t lastStatus; ///< Status byte of the last run
+  uint32_t runs; ///< Completed runs
+  uint32_t errors; ///< Runs that did not return SUCCESS
+  uint32_t deferred; ///< Steps where the query was due but did not fit before the next drain
+
+};
+
+
+/**
+ * @brief Struct of a scheduler. Set up with bioSchedInit()
+ */
+struct bioSched {
+
+  bioSchedFxn drainFxn; ///< Drain function (e.g. readSensorData() and output of the sample)
+  void *drainArg; ///< Argument passed to drainFxn
+  uint32_t drainPeriodUs; ///< Time between drains, us (sample period)
+  uint32_t nextDrainUs; ///< Time of the next drain
+  uint32_t slackUs; ///< Lateness a query may cause to the next drain, us (0: queries only run in free gaps)
+  uint8_t numTasks; ///< Number of queries
+  struct bioSchedTask task[BIO_SCHED_MAX_TASKS]; ///< Queries
+  uint32_t drains; ///< Drains run
+  uint32_t drainErrors; ///< Drains that did not return SUCCESS
+  uint32_t lateDrains; ///< Drains that started more than one drain period after their time
+  uint32_t skippedDrains; ///< Drains dropped after falling BIO_SCHED_MAX_BACKLOG periods behind
+  uint32_t idleUs; ///< Time slept waiting for the next drain, us
+  uint32_t drainCostUs; ///< Expected drain duration, us, measured as for the queries
+  uint32_t slowDrains; ///< Drains that took longer than drainPeriodUs
+
+};
+
+
+/**
+ * @brief   Sets up a scheduler with no queries. The first drain is due immediately
+ *
+ * @param   *sched        Pointer to scheduler
+ * @param   drainFxn      Drain function
+ * @param   *drainArg     Argument passed to drainFxn
+ * @param   drainPeriodUs Time between drains, us: the sample period for one sample per drain, a multiple of it for
+ *                        drains that empty the output FIFO. Must be longer than a drain takes
+ * @param   slackUs       Lateness a query may cause to a drain, us. 0 keeps queries strictly in the free gaps
+ */
+void bioSchedInit(struct bioSched *sched, bioSchedFxn drainFxn, void *drainArg, uint32_t drainPeriodUs, uint32_t slackUs);
+
+
+/**
+ * @brief   Adds a query. It is due immediately, then every periodMs
+ *
+ * @param   *sched   Pointer to scheduler
+ * @param   fxn      Query function
+ * @param   *arg     Argument passed to fxn
+ * @param   periodMs Time between runs, ms. 0 to run once now and then only on bioSchedRequest()
+ * @param   costUs   Expected duration, us. 0 for BIO_SCHED_DEFAULT_COST
+ *
+ * @return  Query index for bioSchedRequest(), 0xFF if the scheduler is full
+ */
+uint8_t bioSchedAdd(struct bioSched *sched, bioSchedFxn fxn, void *arg, uint32_t periodMs, uint32_t costUs);
+
+
+/**
+ * @brief   Asks for a query to run as soon as it fits (e.g. after the configuration it reads was changed)
+ *
+ * @param   *sched Pointer to scheduler
+ * @param   index  Query index returned by bioSchedAdd()
+ */
+void bioSchedRequest(struct bioSched *sched, uint8_t index);
+
+
+/**
+ * @brief   Drops a query's pending run (e.g. the first one, when its values are already known). A periodic query
+ *          next runs one period from now, one without a period on bioSchedRequest()
+ *
+ * @param   *sched Pointer to scheduler
+ * @param   index  Query index returned by bioSchedAdd()
+ */
+void bioSchedSkip(struct bioSched *sched, uint8_t index);
+
+
+/**
+ * @brief   Runs one drain, one query, or sleeps until the next drain
+ *
+ * @param   *sched Pointer to scheduler
+ *
+ * @return  BIO_SCHED_DRAIN, BIO_SCHED_QUERY or BIO_SCHED_IDLE
+ */
+uint8_t bioSchedStep(struct bioSched *sched);
+
+#endif /* BIO_SCHED_H_ */
@@ -33,6 +33,8 @@ kk
 
 
 #include "bio_sensor.h"
+#include <string.h>
+#include <time.h>
 #include <ti/drivers/I2C.h>
 
 
@@ -43,6 +45,283 @@ uint8_t userAlgoMode; ///< Selected User Mode (disabled, algorithm Mode 1 or Mod
 uint8_t userOutputMode; ///< Selected User Output Mode (Raw data, algorithm data, raw + algo data)
 uint8_t sampleNum = 100; ///< Number of samples averaged by the AGC algorithm
 
+static volatile struct bioStats gBioStats; ///< transport counters, written only by the task using the library, read lock-free by bioGetStats()
+
+static uint32_t gBioLatencyPeriodUs; ///< output FIFO sample period used to estimate capture times, 0 while latency tracking is disabled
+static uint32_t gBioDrainUs; ///< drain timestamp of the last sample read
+static uint32_t gBioCaptureUs; ///< estimated capture time of the last sample read
+static struct bioLatencyHist gBioCaptureToDrain; ///< capture to drain latencies, written by the task using the library
+static struct bioLatencyHist gBioDrainToPop; ///< drain to consumer latencies, written by the consumer
+
+static struct bioIdentity gBioIdentity; ///< identity read since the last reset or bootloader entry, see bioInvalidateIdentity()
+
+
+/**
+ * @brief   Reads the monotonic clock (CLOCK_MONOTONIC) used for library timestamps
+ *
+ * @return  Time, us (wraps after ~71 minutes, use differences)
+ */
+uint32_t bioGetTimeUs(void){
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)now.tv_sec * 1000000 + (uint32_t)(now.tv_nsec / 1000);
+}
+
+
+/**
+ * @brief   Copies the identity cache without any bus traffic
+ *
+ * @param   *identity Pointer to struct to fill, entries whose bit is not set in the returned mask are 0
+ *
+ * @return  BIO_IDENTITY_* bits of the entries read since the last reset
+ */
+uint8_t bioGetIdentity(struct bioIdentity *identity){
+    *identity = gBioIdentity;
+    return gBioIdentity.valid;
+}
+
+
+/**
+ * @brief   Fills the identity cache from a copy taken earlier
+ *
+ * @param   *identity Pointer to identity, only the entries whose bit is set in identity->valid are used
+ */
+void bioSetIdentity(const struct bioIdentity *identity){
+    if(identity->valid & BIO_IDENTITY_HUB_VERS){
+        gBioIdentity.sensorHubVer = identity->sensorHubVer;
+    }
+    if(identity->valid & BIO_IDENTITY_ALGO_VERS){
+        gBioIdentity.algoVer = identity->algoVer;
+    }
+    if(identity->valid & BIO_IDENTITY_BOOT_VERS){
+        gBioIdentity.bootVer = identity->bootVer;
+    }
+    if(identity->valid & BIO_IDENTITY_MCU_TYPE){
+        gBioIdentity.mcuType = identity->mcuType;
+    }
+    gBioIdentity.valid |= identity->valid & (BIO_IDENTITY_HUB_VERS | BIO_IDENTITY_ALGO_VERS | BIO_IDENTITY_BOOT_VERS | BIO_IDENTITY_MCU_TYPE);
+}
+
+
+/**
+ * @brief   Drops the identity cache
+ */
+void bioInvalidateIdentity(void){
+    memset(&gBioIdentity, 0, sizeof(gBioIdentity));
+}
+
+
+/**
+ * @brief   Timestamps a sample just read by readSensorData() and records its capture to drain latency.
+ *          The sample read is the oldest of the numSamples in the output FIFO: the newest one finished within the
+ *          last sample period, so the oldest finished about (numSamples - 1/2) periods ago
+ *
+ * @param   numSamples Output FIFO depth read before the sample
+ */
+static void bioLatencyDrained(uint8_t numSamples){
+    if(gBioLatencyPeriodUs == 0 || numSamples == 0){ //tracking disabled, or nothing was in the FIFO
+        return;
+    }
+
+    gBioDrainUs = bioGetTimeUs();
+    gBioCaptureUs = gBioDrainUs - (numSamples * gBioLatencyPeriodUs - gBioLatencyPeriodUs / 2);
+    bioLatencyHistAdd(&gBioCaptureToDrain, gBioDrainUs - gBioCaptureUs);
+}
+
+
+/**
+ * @brief   Marks the start of a counter update (sequence becomes odd)
+ */
+static void bioStatsBegin(void){
+    gBioStats.sequence++;
+}
+
+
+/**
+ * @brief   Marks the end of a counter update (sequence becomes even)
+ */
+static void bioStatsEnd(void){
+    gBioStats.sequence++;
+}
+
+
+/**
+ * @brief   Counts a status byte read from the MAX32664 by its READ_STATUS_BYTE_VALUE. Must be called inside bioStatsBegin()/bioStatsEnd()
+ *
+ * @param   statusByte Status byte read from the MAX32664
+ */
+static void bioStatsCountStatus(uint8_t statusByte){
+    if(statusByte == SUCCESS){ //nothing to count
+        return;
+    }
+
+    gBioStats.statusErrors++;
+
+    switch(statusByte){
+    case ERR_UNAVAIL_CMD:       gBioStats.errUnavailCmd++;      break;
+    case ERR_UNAVAIL_FUNC:      gBioStats.errUnavailFunc++;     break;
+    case ERR_DATA_FORMAT:       gBioStats.errDataFormat++;      break;
+    case ERR_INPUT_VALUE:       gBioStats.errInputValue++;      break;
+    case ERR_BTLDR_TRY_AGAIN:   gBioStats.errBtldrTryAgain++;   break;
+    case ERR_BTLDR_GENERAL:
+    case ERR_BTLDR_CHECKSUM:
+    case ERR_BTLDR_AUTH:
+    case ERR_BTLDR_INVALID_APP: gBioStats.errBtldr++;           break;
+    case ERR_TRY_AGAIN:         gBioStats.errTryAgain++;        break;
+    case ERR_UNKNOWN:           gBioStats.errUnknown++;         break;
+    default:                    gBioStats.errOther++;           break;
+    }
+}
+
+
+#ifdef BIO_TRACE
+static struct bioTraceRecord gBioTrace[BIO_TRACE_DEPTH]; ///< trace ring
+static uint32_t gBioTraceTotal; ///< records written since the last clear, gBioTrace[gBioTraceTotal % BIO_TRACE_DEPTH] is the next slot
+static struct bioTraceRecord gBioTracePending; ///< command whose write phase is done and whose read phase is awaited
+static bool gBioTraceHasPending; ///< true while gBioTracePending holds a command
+static uint32_t gBioTraceWriteEndUs; ///< end of the pending command's write phase
+
+
+/**
+ * @brief   Saturates a duration to the 16-bit fields of a trace record
+ */
+static uint16_t bioTraceDuration(uint32_t startUs, uint32_t endUs){
+    uint32_t duration = endUs - startUs;
+    return (duration > 0xFFFF) ? 0xFFFF : (uint16_t)duration;
+}
+
+
+/**
+ * @brief   Copies the pending command into the ring
+ */
+static void bioTraceCommit(void){
+    gBioTrace[gBioTraceTotal % BIO_TRACE_DEPTH] = gBioTracePending;
+    gBioTraceTotal++;
+    gBioTraceHasPending = false;
+}
+
+
+/**
+ * @brief   Records one I2C transfer. A write phase opens a record, the following read phase completes it
+ *
+ * @param   *transaction Pointer to the transaction that was just performed
+ * @param   transferOk   Return value of I2C_transfer()
+ * @param   startUs      Time the transfer started
+ * @param   endUs        Time the transfer ended
+ */
+static void bioTraceTransfer(I2C_Transaction *transaction, bool transferOk, uint32_t startUs, uint32_t endUs){
+    uint8_t *writeBuf = (uint8_t *)transaction->writeBuf;
+    uint8_t byteCount = 0;
+
+    if(transaction->writeCount > 0){ //write phase: a new command
+        if(gBioTraceHasPending){ //previous command never got its read phase
+            bioTraceCommit();
+        }
+
+        memset(&gBioTracePending, 0, sizeof(gBioTracePending));
+        gBioTracePending.startUs = startUs;
+        gBioTracePending.familyByte = writeBuf[0];
+        gBioTracePending.indexByte = (transaction->writeCount > 1) ? writeBuf[1] : 0;
+        gBioTracePending.writeCount = (transaction->writeCount > 2) ? (uint8_t)(transaction->writeCount - 2) : 0;
+        for(byteCount = 0; byteCount < gBioTracePending.writeCount && byteCount < BIO_TRACE_WRITE_BYTES; byteCount++){
+            gBioTracePending.writeBytes[byteCount] = writeBuf[2 + byteCount]; //keep the first write bytes
+        }
+        gBioTracePending.statusByte = BIO_TRACE_NO_STATUS;
+        gBioTracePending.i2cStatus = (int8_t)transaction->status;
+        gBioTraceWriteEndUs = endUs;
+        gBioTraceHasPending = true;
+
+        if(!transferOk){ //no read phase will follow a failed write
+            bioTraceCommit();
+            return;
+        }
+    }
+
+    if(transaction->readCount > 0){ //read phase: complete the command
+        if(!gBioTraceHasPending){ //read without a traced write phase
+            memset(&gBioTracePending, 0, sizeof(gBioTracePending));
+            gBioTracePending.startUs = startUs;
+            gBioTraceWriteEndUs = startUs;
+        }
+
+        gBioTracePending.gapUs = (transaction->writeCount > 0) ? 0 : bioTraceDuration(gBioTraceWriteEndUs, startUs);
+        gBioTracePending.readUs = bioTraceDuration(startUs, endUs);
+        gBioTracePending.statusByte = transferOk ? ((uint8_t *)transaction->readBuf)[0] : BIO_TRACE_NO_STATUS;
+        gBioTracePending.i2cStatus = (int8_t)transaction->status;
+        bioTraceCommit();
+    }
+}
+#endif /* BIO_TRACE */
+
+
+/**
+ * @brief   Performs an I2C transfer on the global I2C handle and updates the transport counters.
+ *          Every read transaction of the MAX32664 starts with its status byte, which is counted here
+ *
+ * @param   *transaction Pointer to the I2C transaction to perform
+ *
+ * @return  true on success, false if the I2C driver reported an error (status in transaction->status)
+ */
+static bool bioTransfer(I2C_Transaction *transaction){
+#ifdef BIO_TRACE
+    uint32_t startUs = bioGetTimeUs(); //time the transfer
+#endif
+    bool transferOk = I2C_transfer(gi2cHandle, transaction); //do the transfer
+    int_fast16_t errorIndex = -transaction->status; //I2C_STATUS_* codes are negative
+
+#ifdef BIO_TRACE
+    bioTraceTransfer(transaction, transferOk, startUs, bioGetTimeUs()); //record it in the trace ring
+#endif
+
+    bioStatsBegin();
+    gBioStats.transactions++;
+    if(transferOk){ //count what went on the wire
+        gBioStats.bytesTx += transaction->writeCount;
+        gBioStats.bytesRx += transaction->readCount;
+        if(transaction->readCount > 0){ //read phase, first byte is the status byte
+            bioStatsCountStatus(((uint8_t *)transaction->readBuf)[0]);
+        }
+    }
+    else{ //count the driver failure by its status
+        if(errorIndex <= 0 || errorIndex >= BIO_STATS_I2C_ERRORS){ //status we don't know about
+            errorIndex = 0;
+        }
+        gBioStats.i2cErrors[errorIndex]++;
+    }
+    bioStatsEnd();
+
+    return transferOk;
+}
+
+
+/**
+ * @brief   usleep() that counts the time slept in the transport counters
+ *
+ * @param   microseconds Time to sleep, us (less than 1 second)
+ */
+void bioUsleep(uint32_t microseconds){
+    usleep(microseconds);
+
+    bioStatsBegin();
+    gBioStats.sleepUs += microseconds;
+    bioStatsEnd();
+}
+
+
+/**
+ * @brief   sleep() that counts the time slept in the transport counters
+ *
+ * @param   seconds Time to sleep, s
+ */
+static void bioSleep(uint32_t seconds){
+    sleep(seconds);
+
+    bioStatsBegin();
+    gBioStats.sleepUs += seconds * 1000000;
+    bioStatsEnd();
+}
+
 
 /**
  * @brief      Takes the I2C handle object to read the current sensor hub mode
@@ -63,6 +342,7 @@ uint8_t sampleNum = 100; ///< Number of samples averaged by the AGC algorithm
 uint8_t beginI2C(I2C_Handle i2cHandle, uint8_t *statusByte){
 //    gi2cTransaction = i2cTrans;
     gi2cHandle = i2cHandle; //copy over the I2C Handle object
+    bioInvalidateIdentity(); //may be a different hub, or one that was reset or reflashed since
 
     uint8_t mode = readDeviceMode(statusByte); //read the current device mode
 
@@ -72,7 +352,7 @@ uint8_t beginI2C(I2C_Handle i2cHandle, uint8_t *statusByte){
 
     if(mode == RESET || mode == ENTER_BOOTLOADER){ //if we're in reset mode or bootloader mode
         mode = setDeviceMode(EXIT_BOOTLOADER, statusByte); //set us into operating mode
-        sleep(2); //sleep for 2 seconds to ensure that it's back in application mode and ready to receive I2C transactions
+        bioSleep(2); //sleep for 2 seconds to ensure that it's back in application mode and ready to receive I2C transactions
     }
 
     if(*statusByte != SUCCESS){ //if there was an I2C transaction error
@@ -116,7 +396,7 @@ uint8_t configMAX32664(uint8_t outputFormat, uint8_t algoMode, uint8_t intThresh
         userOutputMode = outputFormat; //save the current output format
     }
 
-    usleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
+    bioUsleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
 
     if(algoMode != MODE_ONE && algoMode != MODE_TWO){ //if we don't have a valid algorithm mode
         return INCORR_PARAM; //return incorrect parameter error
@@ -125,42 +405,42 @@ uint8_t configMAX32664(uint8_t outputFormat, uint8_t algoMode, uint8_t intThresh
         userAlgoMode = algoMode; //save the current algorithm mode
     }
 
-    usleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
+    bioUsleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
 
     statusChauf = setOutputMode(outputFormat); //set the output mode to be the passed format
     if(statusChauf != SUCCESS){ //if setting the output mode wasn't successful
         return statusChauf; //return the status byte of I2C transaction
     }
 
-    usleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
+    bioUsleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
 
     statusChauf = setFifoThreshold(intThresh); //set the FIFO threshold to the passed number
     if(statusChauf != SUCCESS){ //if setting FIFO threshold wasn't successful
         return statusChauf; //return the status byte of I2C transaction
     }
 
-    usleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
+    bioUsleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
 
     statusChauf = agcAlgoControl(ENABLE); //enable to AGC algorithm
     if(statusChauf != SUCCESS){ //if enabling the AGC algorithm wasn't successful
         return statusChauf; //return the status byte of I2C transaction
     }
 
-    usleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
+    bioUsleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
 
     statusChauf = max30101Control(ENABLE);  //enable the MAX30101 sensor
     if(statusChauf != SUCCESS){ //if enabling the sensor wasn't successful
         return statusChauf; //return the status byte of I2C transaction
     }
 
-    usleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
+    bioUsleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
 
     statusChauf = maximFastAlgoControl(algoMode);  //set the WHRM algorithm mode or disable
     if(statusChauf != SUCCESS){ //if setting the algorithm didn't work
         return statusChauf; //return the status byte of I2C transaction
     }
 
-    usleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
+    bioUsleep(20000); //sleep for 20ms after getting ERR_TRY_AGAIN
 
     sampleNum = readAlgoSamples(&statusChauf); //read the number of samples averaged by the AGC algorithm
 
@@ -256,6 +536,8 @@ struct bioData readSensorData(uint8_t *statusByte){
             return libData; //return this data
         }
 
+        bioLatencyDrained(numSamples); //timestamp the sample
+
         return libData; //return the raw data
     }
 
@@ -277,6 +559,8 @@ struct bioData readSensorData(uint8_t *statusByte){
             return libData; //return this data
         }
 
+        bioLatencyDrained(numSamples); //timestamp the sample
+
         return libData; //return the algorithm data
     }
 
@@ -298,6 +582,8 @@ struct bioData readSensorData(uint8_t *statusByte){
             return libData; //return this data
         }
 
+        bioLatencyDrained(numSamples); //timestamp the sample
+
         return libData; //return the raw+algorithm data
     }
 
@@ -317,6 +603,75 @@ struct bioData readSensorData(uint8_t *statusByte){
 }
 
 
+/**
+ * @brief       Reads every sample waiting in the MAX32664 output FIFO (up to maxSamples), reading the hub status and
+ *              the FIFO count once for the whole batch
+ *
+ * familyByte  N/A   - multiple I2C transactions internally
+ *
+ * indexByte   N/A   - multiple I2C transactions internally
+ *
+ * writeByte0  N/A   - multiple I2C transactions internally
+ *
+ * writeByteN  N/A   - multiple I2C transactions internally
+ *
+ * @pre         configMAX32664() or other function(s) that configures the data output format
+ *
+ * @param       *samples    Pointer to array of maxSamples samples to fill
+ * @param       maxSamples  Size of the array
+ * @param       *statusByte Pointer to status byte
+ *
+ * @return      Number of samples read
+ */
+uint8_t readSensorDataBatch(struct bioData *samples, uint8_t maxSamples, uint8_t *statusByte){
+
+    uint8_t statusChauf; // The status chauffeur captures return values.
+    uint8_t numSamples; //output FIFO depth before the batch
+    uint8_t count; //samples read
+
+    statusChauf = readSensorHubStatus(statusByte);
+
+    if(statusChauf & 0x01){ //if there was a communication error (Err0[0] bit == Sensor Communication Problem)
+        *statusByte = ERR_UNKNOWN;
+        return 0;
+    }
+    else if(*statusByte != SUCCESS){ //if the status byte is non-zero (some error in I2C communication)
+        return 0;
+    }
+
+    numSamples = numSamplesOutFifo(statusByte);
+
+    if(*statusByte != SUCCESS){ //if the status byte is non-zero (some error in I2C communication)
+        return 0;
+    }
+
+    for(count = 0; count < numSamples && count < maxSamples; count++){
+
+        if(userOutputMode == SENSOR_DATA){ //raw ADC readings
+            samples[count] = readRawData(statusByte);
+        }
+        else if(userOutputMode == ALGO_DATA){ //algorithm data
+            samples[count] = readAlgoData(statusByte);
+        }
+        else if(userOutputMode == SENSOR_AND_ALGORITHM){ //raw + algorithm data
+            samples[count] = readRawAndAlgoData(statusByte);
+        }
+        else{ //not a valid output mode supported by this library
+            *statusByte = INCORR_PARAM;
+            return count;
+        }
+
+        if(*statusByte != SUCCESS){ //if the status byte is non-zero (some error in I2C communication)
+            return count; //the samples before this one are valid
+        }
+
+        bioLatencyDrained(numSamples - count); //timestamp the sample by its depth in the FIFO
+    }
+
+    return count;
+}
+
+
 /**
  * @brief   Reads the raw sensor data, assuming only the raw sensor data is being output
  *
@@ -722,7 +1077,7 @@ uint8_t softwareResetMAX32664(void){
         return statusByte; //return the error we had
     }
 
-    usleep(10000); //sleep for 10ms
+    bioUsleep(10000); //sleep for 10ms
 
     mode = setDeviceMode(EXIT_BOOTLOADER, &statusByte); //set it into application mode
 
@@ -730,7 +1085,7 @@ uint8_t softwareResetMAX32664(void){
         return statusByte; //return the error we had
     }
 
-    sleep(2); //sleep for 2s to ensure initialization is complete
+    bioSleep(2); //sleep for 2s to ensure initialization is complete
 
     if(mode != EXIT_BOOTLOADER){ //if we're not in application mode
        return ERR_UNKNOWN; //return an error
@@ -770,7 +1125,7 @@ uint8_t softwareResetMAX30101(void){
         return statusByte; //return the status byte
     }
 
-    sleep(2); //delay to ensure MAX30101 has reset
+    bioSleep(2); //delay to ensure MAX30101 has reset
 
     return SUCCESS; //return success
 }
@@ -1032,6 +1387,8 @@ uint8_t setDeviceMode(uint8_t operatingMode, uint8_t *statusByte){
         return INCORR_PARAM; //return incorrect parameter value
     }
 
+    bioInvalidateIdentity(); //a reset or bootloader entry (or a failed attempt at one) may change what the hub reports
+
     uint8_t setModeStatus = I2CWriteByte(SET_DEVICE_MODE, 0x00, operatingMode); //write the correct device mode
 
     if(setModeStatus){ //if there was an error in setting the device mode
@@ -1071,6 +1428,12 @@ uint8_t readSensorHubStatus(uint8_t *statusByte){ //read the sensor hub status
 
     uint8_t status = I2CReadByte(HUB_STATUS, 0x00, statusByte); //sensor hub status read
 
+    if(*statusByte == SUCCESS && (status & HUB_STATUS_OUT_OVR_MASK)){ //if the output FIFO overflowed since the last status read
+        bioStatsBegin();
+        gBioStats.fifoOverflows++;
+        bioStatsEnd();
+    }
+
     return status;
 }
 
@@ -1236,6 +1599,12 @@ uint8_t readMaximFastCoef(int32_t *coefArray){
 struct version readSensorHubVersion(uint8_t *statusByte){
     struct version sensorHubVers; //struct for version data
     uint8_t versionArray[3]; //array for read data
+
+    if(gBioIdentity.valid & BIO_IDENTITY_HUB_VERS){ //read since the last reset
+        *statusByte = SUCCESS;
+        return gBioIdentity.sensorHubVer;
+    }
+
     uint8_t readStatus = I2CReadFillArray(IDENTITY, READ_SENSOR_HUB_VERS, 3, versionArray); //perform I2C transaction, reading into array
 
     if(readStatus != SUCCESS){ //if we get a non-zero response (NOT a success)
@@ -1250,6 +1619,8 @@ struct version readSensorHubVersion(uint8_t *statusByte){
     sensorHubVers.major = versionArray[0]; //get sensor hub major version number
     sensorHubVers.minor = versionArray[1]; //get sensor hub minor version number
     sensorHubVers.revision = versionArray[2]; //get sensor hub revision number
+    gBioIdentity.sensorHubVer = sensorHubVers;
+    gBioIdentity.valid |= BIO_IDENTITY_HUB_VERS;
     *statusByte = SUCCESS; //successful transaction, so set status byte
     return sensorHubVers; //return the version data
 }
@@ -1276,6 +1647,12 @@ struct version readSensorHubVersion(uint8_t *statusByte){
 struct version readAlgorithmVersion(uint8_t *statusByte){
     struct version algoVers; //struct for version data
     uint8_t versionArray[3]; //array for read data
+
+    if(gBioIdentity.valid & BIO_IDENTITY_ALGO_VERS){ //read since the last reset
+        *statusByte = SUCCESS;
+        return gBioIdentity.algoVer;
+    }
+
     uint8_t readStatus = I2CReadFillArray(IDENTITY, READ_ALGO_VERS, 3, versionArray); //perform I2C transaction, reading into array
 
     if(readStatus){ //if we get a non-zero response (NOT a success)
@@ -1290,6 +1667,8 @@ struct version readAlgorithmVersion(uint8_t *statusByte){
     algoVers.major = versionArray[0]; //get major algorithm version number
     algoVers.minor = versionArray[1]; //get minor algorithm version number
     algoVers.revision = versionArray[2]; //get algorithm revision number
+    gBioIdentity.algoVer = algoVers;
+    gBioIdentity.valid |= BIO_IDENTITY_ALGO_VERS;
     *statusByte = SUCCESS; //successful transaction, so set status byte appropriately
     return algoVers;
 }
@@ -1316,6 +1695,12 @@ struct version readAlgorithmVersion(uint8_t *statusByte){
 struct version readBootloaderVersion(uint8_t *statusByte){
     struct version bootVers; //struct for version data
     uint8_t versionArray[3]; //array for read data
+
+    if(gBioIdentity.valid & BIO_IDENTITY_BOOT_VERS){ //read since the last reset
+        *statusByte = SUCCESS;
+        return gBioIdentity.bootVer;
+    }
+
     uint8_t readStatus = I2CReadFillArray(BOOTLOADER_INFO, BOOTLOADER_VERS, 3, versionArray); //perform I2C transaction, reading into array
 
     if(readStatus){ //if we get a non-zero response (NOT a success)
@@ -1330,6 +1715,8 @@ struct version readBootloaderVersion(uint8_t *statusByte){
     bootVers.major = versionArray[0]; //get major algorithm version number
     bootVers.minor = versionArray[1]; //get minor algorithm version number
     bootVers.revision = versionArray[2]; //get algorithm revision number
+    gBioIdentity.bootVer = bootVers;
+    gBioIdentity.valid |= BIO_IDENTITY_BOOT_VERS;
     *statusByte = SUCCESS;
     return bootVers;
 }
@@ -1352,12 +1739,22 @@ struct version readBootloaderVersion(uint8_t *statusByte){
  */
 uint8_t getMcuType(uint8_t *statusByte){
 
+    if(gBioIdentity.valid & BIO_IDENTITY_MCU_TYPE){ //read since the last reset
+        *statusByte = SUCCESS;
+        return gBioIdentity.mcuType;
+    }
+
     uint8_t mcuType = I2CReadByte(IDENTITY, READ_MCU_TYPE, statusByte); //read the mcu Type
 
     if(mcuType != SUCCESS && mcuType != 0x01){ //if we don't get a valid MCU type
         return ERR_UNKNOWN; //return error message
     }
 
+    if(*statusByte == SUCCESS){ //only cache a clean read
+        gBioIdentity.mcuType = mcuType;
+        gBioIdentity.valid |= BIO_IDENTITY_MCU_TYPE;
+    }
+
     return mcuType; //return the MCU type (0x00 = MAX32625, 0x01 = MAX32660/MAX32664)
 }
 
@@ -1654,6 +2051,128 @@ uint8_t getExtAccelMode(uint8_t *statusByte){
 }
 
 
+/**
+ * @brief   Enables or disables the host accelerometer. While enabled, the sensor hub pairs every sample with one sample
+ *          of its input FIFO (see writeInputFifo()), and flags an underflow when the input FIFO is empty
+ *
+ * familyByte  - ENABLE_SENSOR (0x44)
+ *
+ * indexByte   - ENABLE_ACCELEROMETER (0x04)
+ *
+ * writeByte0  - enable
+ *
+ * writeByteN  - BIO_ACCEL_HOST (0x01)
+ *
+ * @param   enable Host accelerometer enable (0x01)/disable (0x00) parameter
+ *
+ * @return  Status byte of I2C transaction, INCORR_PARAM on an invalid parameter
+ */
+uint8_t hostAccelControl(uint8_t enable){
+
+    if(enable != 0 && enable != 1){ //if passed an incorrect parameter
+        return INCORR_PARAM; //return error byte
+    }
+
+    uint8_t localTxBuffer[4] = {ENABLE_SENSOR, ENABLE_ACCELEROMETER, enable, BIO_ACCEL_HOST};
+
+    if(I2CWriteCommand(localTxBuffer, 4) != SUCCESS){ //if I2C write did not work
+        return ERR_UNKNOWN;
+    }
+
+    bioUsleep(ENABLE_CMD_DELAY * 1000); //sensor enables take longer than other commands
+
+    return I2CReadStatusByte(); //return the status byte
+}
+
+
+/**
+ * @brief   Reads the size of the input FIFO, in host accelerometer samples
+ *
+ * familyByte  - READ_DATA_INPUT (0x13)
+ *
+ * indexByte   - READ_INPUT_DATA (0x01)
+ *
+ * writeByte0  - none
+ *
+ * writeByteN  - none
+ *
+ * @param   *statusByte Pointer to status byte
+ *
+ * @return  fifoSize - Number of samples the input FIFO holds, 0 on a failure (check status byte!)
+ */
+uint16_t readInputFifoSize(uint8_t *statusByte){
+    return I2CReadInt(READ_DATA_INPUT, READ_INPUT_DATA, statusByte); //read the input FIFO size
+}
+
+
+/**
+ * @brief   Reads the number of host accelerometer samples waiting in the input FIFO
+ *
+ * familyByte  - READ_DATA_INPUT (0x13)
+ *
+ * indexByte   - READ_NUM_SAMPLES_INPUT (0x03)
+ *
+ * writeByte0  - none
+ *
+ * writeByteN  - none
+ *
+ * @param   *statusByte Pointer to status byte
+ *
+ * @return  numSamples - Samples in the input FIFO, 0 on a failure (check status byte!)
+ */
+uint16_t readInputFifoCount(uint8_t *statusByte){
+    return I2CReadInt(READ_DATA_INPUT, READ_NUM_SAMPLES_INPUT, statusByte); //read the samples in the input FIFO
+}
+
+
+/**
+ * @brief   Writes host accelerometer samples to the input FIFO in one transaction. Samples that do not fit are lost,
+ *          so size the burst by readInputFifoSize() - readInputFifoCount() (bio_accel.h does this)
+ *
+ * familyByte  - WRITE_INPUT (0x14)
+ *
+ * indexByte   - WRITE_EXTERNAL_TO_FIFO (0x00)
+ *
+ * writeByte0  - X MSB of samples[0]
+ *
+ * writeByteN  - Z LSB of samples[numSamples - 1]
+ *
+ * @param   *samples   Pointer to samples, oldest first
+ * @param   numSamples Number of samples, 1 to BIO_ACCEL_MAX_BURST
+ *
+ * @return  Status byte of I2C transaction, INCORR_PARAM on an invalid number of samples
+ */
+uint8_t writeInputFifo(const struct bioAccelSample *samples, uint8_t numSamples){
+
+    uint8_t localTxBuffer[2 + BIO_ACCEL_MAX_BURST * BIO_ACCEL_SAMPLE_BYTES]; //family byte, index byte, samples
+    uint8_t *byte = &localTxBuffer[2];
+    uint8_t i;
+
+    if(numSamples == 0 || numSamples > BIO_ACCEL_MAX_BURST){ //if passed an incorrect number of samples
+        return INCORR_PARAM;
+    }
+
+    localTxBuffer[0] = WRITE_INPUT;
+    localTxBuffer[1] = WRITE_EXTERNAL_TO_FIFO;
+    for(i = 0; i < numSamples; i++){ //each axis MSB first
+        *byte++ = (uint8_t)((uint16_t)samples[i].x >> 8);
+        *byte++ = (uint8_t)samples[i].x;
+        *byte++ = (uint8_t)((uint16_t)samples[i].y >> 8);
+        *byte++ = (uint8_t)samples[i].y;
+        *byte++ = (uint8_t)((uint16_t)samples[i].z >> 8);
+        *byte++ = (uint8_t)samples[i].z;
+    }
+
+    if(I2CWriteCommand(localTxBuffer, 2 + numSamples * BIO_ACCEL_SAMPLE_BYTES) != SUCCESS){ //if I2C write did not work
+        return ERR_UNKNOWN;
+    }
+
+    bioUsleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
+
+    return I2CReadStatusByte(); //return the status byte
+}
+
+
 /**
  * @brief   Reads the value in specific register in the MAX30101. Passed parameter selects the specific register
  *
@@ -1703,6 +2222,202 @@ uint8_t writeRegisterMAX30101(uint8_t regAddr, uint8_t regVal){
 
 
 
+/**
+ * @brief   Takes a snapshot of the transport counters. Does not lock and may be called from any task or a Swi/Hwi,
+ *          including while another task is in the middle of an I2C transaction. If every attempt overlapped an update,
+ *          the last copy is returned with an odd sequence number; each counter is still valid on its own.
+ *
+ * @param   *stats Pointer to struct to fill
+ */
+void bioGetStats(struct bioStats *stats){
+
+    uint8_t tries = 0;
+    uint32_t sequence = 0;
+
+    for(tries = 0; tries < BIO_STATS_READ_TRIES; tries++){ //a preempted update can't finish while we spin, so only try a few times
+        sequence = gBioStats.sequence; //sequence before the copy
+        *stats = gBioStats; //copy every counter (each 32-bit word is read atomically)
+
+        if(!(sequence & 0x01) && sequence == gBioStats.sequence){ //no update in progress and none happened during the copy
+            return;
+        }
+    }
+}
+
+
+/**
+ * @brief   Clears the transport counters. Call from the task that uses the library, while no transaction is in progress
+ */
+void bioResetStats(void){
+
+    uint32_t sequence = gBioStats.sequence;
+
+    bioStatsBegin();
+    memset((void *)&gBioStats, 0, sizeof(gBioStats)); //clear all counters
+    gBioStats.sequence = sequence + 1; //keep the sequence moving so readers see the change (still odd: update in progress)
+    bioStatsEnd();
+}
+
+
+/**
+ * @brief   Counts a command re-sent after ERR_TRY_AGAIN or ERR_BTLDR_TRY_AGAIN. Call from the task that uses the library
+ */
+void bioStatsRetry(void){
+
+    bioStatsBegin();
+    gBioStats.retries++;
+    bioStatsEnd();
+}
+
+
+/**
+ * @brief   Starts latency tracking in readSensorData(). Each sample read gets a drain timestamp and a capture time
+ *          estimated from the output FIFO depth and the sample rate, and capture to drain latency is recorded.
+ *          Both histograms are cleared
+ *
+ * familyByte - READ_REGISTER (0x41) when sampleRate is 0
+ *
+ * indexByte  - READ_MAX30101 (0x03) when sampleRate is 0
+ *
+ * writeByte0 - CONFIGURATION_REGISTER (0x0A) when sampleRate is 0
+ *
+ * writeByteN - none
+ *
+ * @param   sampleRate Output FIFO sample rate, Hz. 0 to read it from the MAX30101 (readADCSampleRate())
+ *
+ * @return  SUCCESS, or the status byte of the sample rate read
+ */
+uint8_t bioLatencyEnable(uint16_t sampleRate){
+
+    uint8_t statusByte = SUCCESS;
+
+    if(sampleRate == 0){ //read the configured sample rate
+        sampleRate = readADCSampleRate(&statusByte);
+
+        if(statusByte != SUCCESS || sampleRate == 0){ //if there was an I2C transaction issue
+            return (statusByte != SUCCESS) ? statusByte : ERR_UNKNOWN;
+        }
+    }
+
+    bioLatencyHistInit(&gBioCaptureToDrain); //minUs starts above any latency
+    bioLatencyHistInit(&gBioDrainToPop);
+    gBioLatencyPeriodUs = 1000000 / sampleRate; //sample period
+
+    return SUCCESS;
+}
+
+
+/**
+ * @brief   Stops latency tracking. Recorded histograms are kept
+ */
+void bioLatencyDisable(void){
+    gBioLatencyPeriodUs = 0;
+}
+
+
+/**
+ * @brief   Drain timestamp of the last sample returned by readSensorData() while latency tracking is enabled.
+ *          Pass it along with the sample so the consumer can call bioLatencyPop()
+ *
+ * @return  Time the sample was read from the output FIFO, us (bioGetTimeUs() clock)
+ */
+uint32_t bioGetDrainTimeUs(void){
+    return gBioDrainUs;
+}
+
+
+/**
+ * @brief   Estimated capture time of the last sample returned by readSensorData() while latency tracking is enabled
+ *
+ * @return  Time the MAX30101 finished the sample, us (bioGetTimeUs() clock)
+ */
+uint32_t bioGetCaptureTimeUs(void){
+    return gBioCaptureUs;
+}
+
+
+/**
+ * @brief   Records drain to consumer latency. Call from the consumer when it takes a sample, with the drain
+ *          timestamp given by bioGetDrainTimeUs() for that sample. Only one consumer task may call it
+ *
+ * @param   drainUs Drain timestamp of the sample
+ */
+void bioLatencyPop(uint32_t drainUs){
+    bioLatencyHistAdd(&gBioDrainToPop, bioGetTimeUs() - drainUs);
+}
+
+
+/**
+ * @brief   Copies the latency histograms. A copy taken while a latency is being recorded may be off by that one latency
+ *
+ * @param   *captureToDrain Pointer to histogram to fill with capture to drain latencies, NULL to skip
+ * @param   *drainToPop     Pointer to histogram to fill with drain to consumer latencies, NULL to skip
+ */
+void bioGetLatency(struct bioLatencyHist *captureToDrain, struct bioLatencyHist *drainToPop){
+    if(captureToDrain){
+        *captureToDrain = gBioCaptureToDrain;
+    }
+    if(drainToPop){
+        *drainToPop = gBioDrainToPop;
+    }
+}
+
+
+/**
+ * @brief   Clears the latency histograms
+ */
+void bioResetLatency(void){
+    bioLatencyHistInit(&gBioCaptureToDrain);
+    bioLatencyHistInit(&gBioDrainToPop);
+}
+
+
+#ifdef BIO_TRACE
+/**
+ * @brief   Streams the trace ring out: a struct bioTraceHeader, then the records from oldest to newest.
+ *          Call from the task that uses the library (the ring is not locked). Tracing continues afterwards
+ *
+ * @param   writeFxn Function called with each piece of the dump
+ * @param   *arg     Argument passed through to writeFxn
+ *
+ * @return  Number of records sent
+ */
+uint16_t bioTraceDump(bioTraceWriteFxn writeFxn, void *arg){
+
+    struct bioTraceHeader header;
+    uint32_t first = 0; //oldest record still in the ring
+    uint32_t record = 0;
+
+    if(gBioTraceHasPending){ //include a command still waiting for its read phase
+        bioTraceCommit();
+    }
+
+    first = (gBioTraceTotal > BIO_TRACE_DEPTH) ? gBioTraceTotal - BIO_TRACE_DEPTH : 0;
+
+    header.magic = BIO_TRACE_MAGIC;
+    header.recordSize = sizeof(struct bioTraceRecord);
+    header.numRecords = (uint16_t)(gBioTraceTotal - first);
+    header.totalRecords = gBioTraceTotal;
+    writeFxn(&header, sizeof(header), arg); //send the header
+
+    for(record = first; record < gBioTraceTotal; record++){ //send the records oldest first
+        writeFxn(&gBioTrace[record % BIO_TRACE_DEPTH], sizeof(struct bioTraceRecord), arg);
+    }
+
+    return header.numRecords;
+}
+
+
+/**
+ * @brief   Empties the trace ring
+ */
+void bioTraceClear(void){
+    gBioTraceTotal = 0;
+    gBioTraceHasPending = false;
+}
+#endif /* BIO_TRACE */
+
+
 ///////////////////////////////////////////////////////////////////
 
 /*
@@ -1740,12 +2455,12 @@ uint8_t I2CReadByte(uint8_t familyByte, uint8_t indexByte, uint8_t *statusByte){
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 0;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C write did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
         *statusByte = ERR_UNKNOWN; //set the status byte to be an error
         return 0; //return a read byte of 0
     }
 
-    usleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
+    bioUsleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
 
     gi2cTransaction.slaveAddress = BIO_ADDRESS;
     gi2cTransaction.writeBuf = localTxBuffer;
@@ -1753,7 +2468,7 @@ uint8_t I2CReadByte(uint8_t familyByte, uint8_t indexByte, uint8_t *statusByte){
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 2;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C read did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C read did not work
         *statusByte = ERR_UNKNOWN; //set the status byte to be an error
         return 0; //return a read byte of 0
     }
@@ -1800,12 +2515,12 @@ uint8_t I2CReadBytewithWriteByte(uint8_t familyByte, uint8_t indexByte, uint8_t
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 0;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C write did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
         *statusByte = ERR_UNKNOWN; //set the status byte to be an error
         return 0; //return a read byte of 0
     }
 
-    usleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
+    bioUsleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
 
     gi2cTransaction.slaveAddress = BIO_ADDRESS;
     gi2cTransaction.writeBuf = localTxBuffer;
@@ -1813,7 +2528,7 @@ uint8_t I2CReadBytewithWriteByte(uint8_t familyByte, uint8_t indexByte, uint8_t
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 2;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C read did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C read did not work
         *statusByte = ERR_UNKNOWN; //set the status byte to be an error
         return 0; //return a read byte of 0
     }
@@ -1860,14 +2575,14 @@ uint8_t I2CReadFillArray(uint8_t familyByte, uint8_t indexByte, uint8_t arraySiz
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 0;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C write did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
         for(arrayCount = 0; arrayCount < arraySize; arrayCount++){ //for the full array
             arraytoFill[arrayCount] = 0; //set all values to 0
         }
         return ERR_UNKNOWN; //return and error statusy byte
     }
 
-    usleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
+    bioUsleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
 
     gi2cTransaction.slaveAddress = BIO_ADDRESS;
     gi2cTransaction.writeBuf = localTxBuffer;
@@ -1875,7 +2590,7 @@ uint8_t I2CReadFillArray(uint8_t familyByte, uint8_t indexByte, uint8_t arraySiz
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = I2_READ_STATUS_BYTE_COUNT + arraySize;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C read did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C read did not work
         for(arrayCount = 0; arrayCount < arraySize; arrayCount++){ //for the full array
             arraytoFill[arrayCount] = 0; //set all values to 0
         }
@@ -1891,6 +2606,12 @@ uint8_t I2CReadFillArray(uint8_t familyByte, uint8_t indexByte, uint8_t arraySiz
         for(arrayCount = 0; arrayCount < arraySize; arrayCount++){
             arraytoFill[arrayCount] = localRxBuffer[I2_READ_STATUS_BYTE_COUNT + arrayCount];
         }
+
+        if(familyByte == READ_DATA_OUTPUT && indexByte == READ_DATA){ //if we just drained a sample from the output FIFO
+            bioStatsBegin();
+            gBioStats.samplesDrained++;
+            bioStatsEnd();
+        }
     }
 
     return localRxBuffer[0]; //return status byte
@@ -1926,12 +2647,12 @@ uint16_t I2CReadInt(uint8_t familyByte, uint8_t indexByte, uint8_t *statusByte){
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 0;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C write did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
         *statusByte = ERR_UNKNOWN; //set the status byte to be an error
         return 0; //return a read byte of 0
     }
 
-    usleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
+    bioUsleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
 
     gi2cTransaction.slaveAddress = BIO_ADDRESS;
     gi2cTransaction.writeBuf = localTxBuffer;
@@ -1939,7 +2660,7 @@ uint16_t I2CReadInt(uint8_t familyByte, uint8_t indexByte, uint8_t *statusByte){
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 3;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C read did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C read did not work
         *statusByte = ERR_UNKNOWN; //set the status byte to be an error
         return 0; //return a read byte of 0
     }
@@ -1991,12 +2712,12 @@ uint16_t I2CReadIntWithWriteByte(uint8_t familyByte, uint8_t indexByte, uint8_t
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 0;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C write did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
         *statusByte = ERR_UNKNOWN; //set the status byte to be an error
         return 0; //return a read byte of 0
     }
 
-    usleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
+    bioUsleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
 
     gi2cTransaction.slaveAddress = BIO_ADDRESS;
     gi2cTransaction.writeBuf = localTxBuffer;
@@ -2004,7 +2725,7 @@ uint16_t I2CReadIntWithWriteByte(uint8_t familyByte, uint8_t indexByte, uint8_t
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 3;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C read did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C read did not work
         *statusByte = ERR_UNKNOWN; //set the status byte to be an error
         return 0; //return a read byte of 0
     }
@@ -2056,12 +2777,12 @@ int32_t I2CRead32BitValue(uint8_t familyByte, uint8_t indexByte, uint8_t dataByt
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 0;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C write did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
         *statusByte = ERR_UNKNOWN; //set the status byte to be an error
         return 0; //return a read byte of 0
     }
 
-    usleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
+    bioUsleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
 
     gi2cTransaction.slaveAddress = BIO_ADDRESS;
     gi2cTransaction.writeBuf = localTxBuffer;
@@ -2069,7 +2790,7 @@ int32_t I2CRead32BitValue(uint8_t familyByte, uint8_t indexByte, uint8_t dataByt
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = I2_READ_STATUS_BYTE_COUNT + sizeof(int32_t);
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C read did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C read did not work
         *statusByte = ERR_UNKNOWN; //set the status byte to be an error
         return 0; //return a read byte of 0
     }
@@ -2122,14 +2843,14 @@ uint8_t I2CReadMultiple32BitValues(uint8_t familyByte, uint8_t indexByte, uint8_
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 0;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C write did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
         for(arrayCount = 0; arrayCount < numReads; arrayCount++){ //for everything in the array
             numArray[arrayCount] = 0; //set it to zero
         }
         return ERR_UNKNOWN; //return an error status byte
     }
 
-    usleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
+    bioUsleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
 
     gi2cTransaction.slaveAddress = BIO_ADDRESS;
     gi2cTransaction.writeBuf = localTxBuffer;
@@ -2137,7 +2858,7 @@ uint8_t I2CReadMultiple32BitValues(uint8_t familyByte, uint8_t indexByte, uint8_
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = I2_READ_STATUS_BYTE_COUNT + sizeof(int32_t) * numReads;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C read did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C read did not work
         for(arrayCount = 0; arrayCount < numReads; arrayCount++){ //for everything in the array
             numArray[arrayCount] = 0; //set it to zero
         }
@@ -2193,11 +2914,11 @@ uint8_t I2CWriteByte(uint8_t familyByte, uint8_t indexByte, uint8_t dataByte){
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 0;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C write did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
         return ERR_UNKNOWN; //return an error status byte
     }
 
-    usleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
+    bioUsleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
 
     gi2cTransaction.slaveAddress = BIO_ADDRESS;
     gi2cTransaction.writeBuf = localTxBuffer;
@@ -2205,7 +2926,7 @@ uint8_t I2CWriteByte(uint8_t familyByte, uint8_t indexByte, uint8_t dataByte){
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 1; //expect a status byte
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C read did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C read did not work
         return ERR_UNKNOWN; //return a read byte of 0
     }
 
@@ -2244,11 +2965,11 @@ uint8_t I2CWrite2Bytes(uint8_t familyByte, uint8_t indexByte, uint8_t dataByte0,
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 0;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C write did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
         return ERR_UNKNOWN; //return an error status byte
     }
 
-    usleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
+    bioUsleep(CMD_DELAY * 1000); //sleep for 6 milliseconds
 
     gi2cTransaction.slaveAddress = BIO_ADDRESS;
     gi2cTransaction.writeBuf = localTxBuffer;
@@ -2256,7 +2977,7 @@ uint8_t I2CWrite2Bytes(uint8_t familyByte, uint8_t indexByte, uint8_t dataByte0,
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 1; //expect a status byte
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C read did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C read did not work
         return ERR_UNKNOWN; //return an error status byte
     }
 
@@ -2295,11 +3016,11 @@ uint8_t I2CenableWriteByte(uint8_t familyByte, uint8_t indexByte, uint8_t dataBy
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 0;
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C write did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
         return ERR_UNKNOWN; //return an error status byte
     }
 
-    usleep(ENABLE_CMD_DELAY * 1000); //sleep for 45 milliseconds
+    bioUsleep(ENABLE_CMD_DELAY * 1000); //sleep for 45 milliseconds
 
     gi2cTransaction.slaveAddress = BIO_ADDRESS;
     gi2cTransaction.writeBuf = localTxBuffer;
@@ -2307,7 +3028,64 @@ uint8_t I2CenableWriteByte(uint8_t familyByte, uint8_t indexByte, uint8_t dataBy
     gi2cTransaction.readBuf = localRxBuffer;
     gi2cTransaction.readCount = 1; //expect a status byte
 
-    if(!I2C_transfer(gi2cHandle, &gi2cTransaction)){ //if I2C write did not work
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
+        return ERR_UNKNOWN; //return an error status byte
+    }
+
+    return localRxBuffer[0]; //return the status byte
+}
+
+
+/**
+ * @brief   Does only the write phase of a MAX32664 command, for commands longer than the helpers above take
+ *          (e.g. bootloader pages). Read the status byte with I2CReadStatusByte() once the hub has had time to
+ *          process it
+ *
+ * familyByte - command[0]
+ *
+ * indexByte  - command[1]
+ *
+ * writeByte0 - command[2]
+ *
+ * writeByteN - command[length - 1]
+ *
+ * @param   *command Pointer to family byte, index byte and write bytes
+ * @param   length   Number of bytes to write
+ *
+ * @return  SUCCESS, or ERR_UNKNOWN if the I2C write did not work
+ */
+uint8_t I2CWriteCommand(uint8_t *command, uint16_t length){
+
+    uint8_t localRxBuffer[1];
+    gi2cTransaction.slaveAddress = BIO_ADDRESS;
+    gi2cTransaction.writeBuf = command;
+    gi2cTransaction.writeCount = length;
+    gi2cTransaction.readBuf = localRxBuffer;
+    gi2cTransaction.readCount = 0;
+
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C write did not work
+        return ERR_UNKNOWN; //return an error status byte
+    }
+
+    return SUCCESS;
+}
+
+
+/**
+ * @brief   Does only the read phase of a MAX32664 command: reads the status byte of the last command written
+ *
+ * @return  Status byte of the command, ERR_UNKNOWN if the I2C read did not work
+ */
+uint8_t I2CReadStatusByte(void){
+
+    uint8_t localRxBuffer[1];
+    gi2cTransaction.slaveAddress = BIO_ADDRESS;
+    gi2cTransaction.writeBuf = localRxBuffer;
+    gi2cTransaction.writeCount = 0;
+    gi2cTransaction.readBuf = localRxBuffer;
+    gi2cTransaction.readCount = 1; //expect a status byte
+
+    if(!bioTransfer(&gi2cTransaction)){ //if I2C read did not work
         return ERR_UNKNOWN; //return an error status byte
     }
 
@@ -40,6 +40,7 @@ kk
 #include <ti/drivers/I2C.h>
 /* Driver configuration */
 #include "ti_drivers_config.h"
+#include "bio_latency.h"
 
 
 
@@ -146,6 +147,18 @@ struct sensorAttr {
 
 };
 
+
+/**
+ * @brief Struct of one host accelerometer sample for the sensor hub input FIFO (sent MSB first, X then Y then Z)
+ */
+struct bioAccelSample {
+
+  int16_t x; ///< X axis, 2's complement
+  int16_t y; ///< Y axis, 2's complement
+  int16_t z; ///< Z axis, 2's complement
+
+};
+
 // Status Bytes are communicated back after every I-squared-C transmission and
 // are indicators of success or failure of the previous transmission.
 enum READ_STATUS_BYTE_VALUE {
@@ -402,6 +415,112 @@ enum IDENTITY_INDEX_BYTES {
 #define READ_MAX_FAST_RATE_ID  0x00 //Maxim Fast sampling rate ID
 
 #define NUM_MAXIM_FAST_COEF    0x03 //number of Maxim Fast algorithm coefficients
+
+#define HUB_STATUS_OUT_OVR_MASK 0x10 //mask for reading the output FIFO overflow bit [4] of the sensor hub status
+
+#define BIO_STATS_I2C_ERRORS   12 //number of I2C driver failure counters, indexed by -I2C_STATUS_* (-1 through -11), 0 for unrecognized statuses
+#define BIO_STATS_READ_TRIES   4  //attempts bioGetStats() makes to get a snapshot that no update overlapped
+
+#define BIO_IDENTITY_HUB_VERS  0x01 //bioIdentity.valid bit: sensorHubVer cached
+#define BIO_IDENTITY_ALGO_VERS 0x02 //bioIdentity.valid bit: algoVer cached
+#define BIO_IDENTITY_BOOT_VERS 0x04 //bioIdentity.valid bit: bootVer cached
+#define BIO_IDENTITY_MCU_TYPE  0x08 //bioIdentity.valid bit: mcuType cached
+
+#define BIO_ACCEL_SAMPLE_BYTES 6  //bytes per host accelerometer sample in the input FIFO (3 axes x 16-bit)
+#define BIO_ACCEL_MAX_BURST    32 //most samples writeInputFifo() sends in one transaction
+#define BIO_ACCEL_HOST         0x01 //writeByte1 of ENABLE_ACCELEROMETER: samples come from the host
+
+
+/**
+ * @brief Struct of transport counters, maintained by the low level I2C transaction functions.
+ *        Every counter is a 32-bit word that wraps around, use differences between two snapshots.
+ */
+struct bioStats {
+
+  uint32_t sequence; ///< Incremented before and after every update: odd while an update is in progress
+  uint32_t transactions; ///< I2C_transfer() calls. A command is a write transaction followed by a read transaction
+  uint32_t bytesTx; ///< Bytes written by successful transactions, excluding the address byte
+  uint32_t bytesRx; ///< Bytes read by successful transactions (status byte included), excluding the address byte
+  uint32_t i2cErrors[BIO_STATS_I2C_ERRORS]; ///< Failed I2C_transfer() calls by driver status: i2cErrors[-I2C_STATUS_ADDR_NACK] counts address NACKs, etc.
+  uint32_t statusErrors; ///< Non-zero status bytes read from the MAX32664 (sum of the err* counters below)
+  uint32_t errUnavailCmd; ///< ERR_UNAVAIL_CMD (0x01) status bytes
+  uint32_t errUnavailFunc; ///< ERR_UNAVAIL_FUNC (0x02) status bytes
+  uint32_t errDataFormat; ///< ERR_DATA_FORMAT (0x03) status bytes
+  uint32_t errInputValue; ///< ERR_INPUT_VALUE (0x04) status bytes
+  uint32_t errBtldrTryAgain; ///< ERR_INVALID_MODE/ERR_BTLDR_TRY_AGAIN (0x05) status bytes
+  uint32_t errBtldr; ///< ERR_BTLDR_GENERAL, ERR_BTLDR_CHECKSUM, ERR_BTLDR_AUTH and ERR_BTLDR_INVALID_APP (0x80 - 0x83) status bytes
+  uint32_t errTryAgain; ///< ERR_TRY_AGAIN (0xFE) status bytes
+  uint32_t errUnknown; ///< ERR_UNKNOWN (0xFF) status bytes
+  uint32_t errOther; ///< Any other non-zero status byte
+  uint32_t retries; ///< Commands re-sent after an ERR_TRY_AGAIN or ERR_BTLDR_TRY_AGAIN status byte, see bioStatsRetry()
+  uint32_t sleepUs; ///< Time spent sleeping between and around transactions, us (wraps after ~71 minutes)
+  uint32_t samplesDrained; ///< Successful reads of output FIFO samples (READ_DATA_OUTPUT, READ_DATA)
+  uint32_t fifoOverflows; ///< Sensor hub status reads reporting an output FIFO overflow. Counts overflow events, not samples: the hub does not report how many samples were dropped since the previous status read
+
+};
+
+
+/**
+ * @brief Struct of the sensor hub identity cached by readSensorHubVersion(), readAlgorithmVersion(),
+ *        readBootloaderVersion() and getMcuType(). Entries stay valid until the hub is reset or enters the bootloader
+ */
+struct bioIdentity {
+
+  uint8_t valid; ///< BIO_IDENTITY_* bits of the cached entries
+  struct version sensorHubVer; ///< Sensor hub version
+  struct version algoVer; ///< Algorithm version
+  struct version bootVer; ///< Bootloader version
+  uint8_t mcuType; ///< MCU type (0x00 = MAX32625, 0x01 = MAX32660/MAX32664)
+
+};
+
+
+//Binary transaction trace. Define BIO_TRACE in the build (e.g. -DBIO_TRACE) to record every hub transaction in a RAM ring
+#ifdef BIO_TRACE
+
+#ifndef BIO_TRACE_DEPTH
+#define BIO_TRACE_DEPTH        128 //number of records kept in the trace ring (16 bytes each)
+#endif
+
+#define BIO_TRACE_WRITE_BYTES  3          //write bytes (after family and index byte) kept per record
+#define BIO_TRACE_MAGIC        0x31525442 //"BTR1" in little endian, first word of a trace dump
+#define BIO_TRACE_NO_STATUS    0xFF       //status byte recorded when no read phase took place (same value as ERR_UNKNOWN)
+
+/**
+ * @brief Struct of one traced hub transaction (write phase + read phase). 16 bytes, little endian on the wire
+ */
+struct bioTraceRecord {
+
+  uint32_t startUs; ///< Start of the write phase, us (CLOCK_MONOTONIC, wraps after ~71 minutes)
+  uint16_t gapUs; ///< End of the write phase to start of the read phase, us (saturates at 65535)
+  uint16_t readUs; ///< Duration of the read phase, us (saturates at 65535)
+  uint8_t  familyByte; ///< Family byte of the command
+  uint8_t  indexByte; ///< Index byte of the command
+  uint8_t  writeCount; ///< Number of write bytes after the family and index bytes
+  uint8_t  statusByte; ///< Status byte returned in the read phase, BIO_TRACE_NO_STATUS if there was none
+  int8_t   i2cStatus; ///< I2C driver status (I2C_STATUS_*) of the failing phase, or of the read phase
+  uint8_t  writeBytes[BIO_TRACE_WRITE_BYTES]; ///< First write bytes of the command
+
+};
+
+/**
+ * @brief Struct sent at the start of a trace dump, followed by numRecords records, oldest first
+ */
+struct bioTraceHeader {
+
+  uint32_t magic; ///< BIO_TRACE_MAGIC
+  uint16_t recordSize; ///< sizeof(struct bioTraceRecord)
+  uint16_t numRecords; ///< Number of records that follow
+  uint32_t totalRecords; ///< Records written since the last clear. totalRecords - numRecords were overwritten
+
+};
+
+/**
+ * @brief Function called by bioTraceDump() to send out a piece of the dump (e.g. wraps UART_write())
+ */
+typedef void (*bioTraceWriteFxn)(const void *buf, size_t len, void *arg);
+
+#endif /* BIO_TRACE */
 /////////////////////////////////////////////////////////////////////////////
 
 
@@ -472,6 +591,31 @@ uint8_t configMAX32664(uint8_t outputFormat, uint8_t algoMode, uint8_t intThresh
 struct bioData readSensorData(uint8_t *statusByte);
 
 
+/**
+ * @brief       Reads every sample waiting in the MAX32664 output FIFO (up to maxSamples) with one hub status and one
+ *              FIFO count read, instead of the two readSensorData() spends on each sample. A streaming loop that drains
+ *              with it needs one data read per sample plus two per drain, so it keeps up at rates where one
+ *              readSensorData() per sample period cannot (3 round trips, ~18ms, against 10ms at the default 100Hz)
+ *
+ * familyByte  N/A   - multiple I2C transactions internally
+ *
+ * indexByte   N/A   - multiple I2C transactions internally
+ *
+ * writeByte0  N/A   - multiple I2C transactions internally
+ *
+ * writeByteN  N/A   - multiple I2C transactions internally
+ *
+ * @pre         configMAX32664() or other function(s) that configures the data output format
+ *
+ * @param       *samples    Pointer to array of maxSamples samples to fill, same contents as readSensorData()
+ * @param       maxSamples  Size of the array. Samples beyond it stay in the FIFO for the next call
+ * @param       *statusByte Pointer to status byte
+ *
+ * @return      Number of samples read. On an error the samples before it are valid (check status byte!)
+ */
+uint8_t readSensorDataBatch(struct bioData *samples, uint8_t maxSamples, uint8_t *statusByte);
+
+
 /**
  * @brief   Reads the raw sensor data, assuming only the raw sensor data is being output
  *
@@ -863,6 +1007,7 @@ uint8_t readMaximFastCoef(int32_t *coefArray);
 /**
  * @brief   Reads the current version of the sensor hub. Format of version is
  *          major.minor.revision
+ *          Served from the identity cache after the first successful read (no bus traffic)
  *
  * familyByte - IDENTITY (0xFF)
  *
@@ -884,6 +1029,7 @@ struct version readSensorHubVersion(uint8_t *statusByte);
 /**
  * @brief   Reads the current version of the algorithm. Format of version is
  *          major.minor.revision
+ *          Served from the identity cache after the first successful read (no bus traffic)
  *
  * familyByte - IDENTITY (0xFF)
  *
@@ -905,6 +1051,7 @@ struct version readAlgorithmVersion(uint8_t *statusByte);
 /**
  * @brief   Reads the current version of the bootloader. Format of version is
  *          major.minor.revision
+ *          Served from the identity cache after the first successful read (no bus traffic)
  *
  * familyByte - BOOTLOADER_INFO (0x81)
  *
@@ -925,6 +1072,7 @@ struct version readBootloaderVersion(uint8_t *statusByte);
 
 /**
  * @brief   Reads the MCU type of biometric sensor hub (expect MAX32660/MAX32664)
+ *          Served from the identity cache after the first successful read (no bus traffic)
  *
  * familyByte - IDENTITY (0xFF)
  *
@@ -1060,6 +1208,81 @@ struct sensorAttr getAfeAttributesAccelerometer(uint8_t *statusByte);
 uint8_t getExtAccelMode(uint8_t *statusByte);
 
 
+/**
+ * @brief   Enables or disables the host accelerometer. While enabled, the sensor hub pairs every sample with one sample
+ *          of its input FIFO (see writeInputFifo()), and flags an underflow when the input FIFO is empty
+ *
+ * familyByte  - ENABLE_SENSOR (0x44)
+ *
+ * indexByte   - ENABLE_ACCELEROMETER (0x04)
+ *
+ * writeByte0  - enable
+ *
+ * writeByteN  - BIO_ACCEL_HOST (0x01)
+ *
+ * @param   enable Host accelerometer enable (0x01)/disable (0x00) parameter
+ *
+ * @return  Status byte of I2C transaction, INCORR_PARAM on an invalid parameter
+ */
+uint8_t hostAccelControl(uint8_t enable);
+
+
+/**
+ * @brief   Reads the size of the input FIFO, in host accelerometer samples
+ *
+ * familyByte  - READ_DATA_INPUT (0x13)
+ *
+ * indexByte   - READ_INPUT_DATA (0x01)
+ *
+ * writeByte0  - none
+ *
+ * writeByteN  - none
+ *
+ * @param   *statusByte Pointer to status byte
+ *
+ * @return  fifoSize - Number of samples the input FIFO holds, 0 on a failure (check status byte!)
+ */
+uint16_t readInputFifoSize(uint8_t *statusByte);
+
+
+/**
+ * @brief   Reads the number of host accelerometer samples waiting in the input FIFO
+ *
+ * familyByte  - READ_DATA_INPUT (0x13)
+ *
+ * indexByte   - READ_NUM_SAMPLES_INPUT (0x03)
+ *
+ * writeByte0  - none
+ *
+ * writeByteN  - none
+ *
+ * @param   *statusByte Pointer to status byte
+ *
+ * @return  numSamples - Samples in the input FIFO, 0 on a failure (check status byte!)
+ */
+uint16_t readInputFifoCount(uint8_t *statusByte);
+
+
+/**
+ * @brief   Writes host accelerometer samples to the input FIFO in one transaction. Samples that do not fit are lost,
+ *          so size the burst by readInputFifoSize() - readInputFifoCount() (bio_accel.h does this)
+ *
+ * familyByte  - WRITE_INPUT (0x14)
+ *
+ * indexByte   - WRITE_EXTERNAL_TO_FIFO (0x00)
+ *
+ * writeByte0  - X MSB of samples[0]
+ *
+ * writeByteN  - Z LSB of samples[numSamples - 1]
+ *
+ * @param   *samples   Pointer to samples, oldest first
+ * @param   numSamples Number of samples, 1 to BIO_ACCEL_MAX_BURST
+ *
+ * @return  Status byte of I2C transaction, INCORR_PARAM on an invalid number of samples
+ */
+uint8_t writeInputFifo(const struct bioAccelSample *samples, uint8_t numSamples);
+
+
 /**
  * @brief   Reads the value in specific register in the MAX30101. Passed parameter selects the specific register
  *
@@ -1101,6 +1324,163 @@ uint8_t writeRegisterMAX30101(uint8_t regAddr, uint8_t regVal);
 
 
 
+/**
+ * @brief   Takes a snapshot of the transport counters. Does not lock and may be called from any task or a Swi/Hwi,
+ *          including while another task is in the middle of an I2C transaction. If every attempt overlapped an update,
+ *          the last copy is returned with an odd sequence number; each counter is still valid on its own.
+ *
+ * @param   *stats Pointer to struct to fill
+ */
+void bioGetStats(struct bioStats *stats);
+
+
+/**
+ * @brief   Clears the transport counters. Call from the task that uses the library, while no transaction is in progress
+ */
+void bioResetStats(void);
+
+
+/**
+ * @brief   Counts a command re-sent after an ERR_TRY_AGAIN or ERR_BTLDR_TRY_AGAIN status byte in bioStats.retries.
+ *          The single command functions report the status byte and leave the retry to the caller, so whatever loops
+ *          on them calls this once per re-send. Call from the task that uses the library
+ */
+void bioStatsRetry(void);
+
+
+/**
+ * @brief   usleep() that counts the time slept in bioStats.sleepUs. The library's own waits go through it; so should
+ *          the waits of code built on the library, so the counter covers its bus traffic too
+ *
+ * @param   microseconds Time to sleep, us (less than 1 second)
+ */
+void bioUsleep(uint32_t microseconds);
+
+
+/**
+ * @brief   Copies the identity cache without any bus traffic
+ *
+ * @param   *identity Pointer to struct to fill, entries whose bit is not set in the returned mask are 0
+ *
+ * @return  BIO_IDENTITY_* bits of the entries read since the last reset
+ */
+uint8_t bioGetIdentity(struct bioIdentity *identity);
+
+
+/**
+ * @brief   Fills the identity cache from a copy taken earlier (e.g. a snapshot kept in NVS, see bio_nvs.h). Only the
+ *          entries whose bit is set in identity->valid are used
+ *
+ * @param   *identity Pointer to identity
+ */
+void bioSetIdentity(const struct bioIdentity *identity);
+
+
+/**
+ * @brief   Drops the identity cache. The library does this in beginI2C() and setDeviceMode(); call it after resetting
+ *          the hub through its reset pin
+ */
+void bioInvalidateIdentity(void);
+
+
+/**
+ * @brief   Reads the monotonic clock (CLOCK_MONOTONIC) used for library timestamps
+ *
+ * @return  Time, us (wraps after ~71 minutes, use differences)
+ */
+uint32_t bioGetTimeUs(void);
+
+
+/**
+ * @brief   Starts latency tracking in readSensorData(). Each sample read gets a drain timestamp and a capture time
+ *          estimated from the output FIFO depth and the sample rate, and capture to drain latency is recorded.
+ *          Both histograms are cleared
+ *
+ * familyByte - READ_REGISTER (0x41) when sampleRate is 0
+ *
+ * indexByte  - READ_MAX30101 (0x03) when sampleRate is 0
+ *
+ * writeByte0 - CONFIGURATION_REGISTER (0x0A) when sampleRate is 0
+ *
+ * writeByteN - none
+ *
+ * @param   sampleRate Output FIFO sample rate, Hz. 0 to read it from the MAX30101 (readADCSampleRate())
+ *
+ * @return  SUCCESS, or the status byte of the sample rate read
+ */
+uint8_t bioLatencyEnable(uint16_t sampleRate);
+
+
+/**
+ * @brief   Stops latency tracking. Recorded histograms are kept
+ */
+void bioLatencyDisable(void);
+
+
+/**
+ * @brief   Drain timestamp of the last sample returned by readSensorData() while latency tracking is enabled.
+ *          Pass it along with the sample so the consumer can call bioLatencyPop()
+ *
+ * @return  Time the sample was read from the output FIFO, us (bioGetTimeUs() clock)
+ */
+uint32_t bioGetDrainTimeUs(void);
+
+
+/**
+ * @brief   Estimated capture time of the last sample returned by readSensorData() while latency tracking is enabled
+ *
+ * @return  Time the MAX30101 finished the sample, us (bioGetTimeUs() clock)
+ */
+uint32_t bioGetCaptureTimeUs(void);
+
+
+/**
+ * @brief   Records drain to consumer latency. Call from the consumer when it takes a sample, with the drain
+ *          timestamp given by bioGetDrainTimeUs() for that sample. Only one consumer task may call it
+ *
+ * @param   drainUs Drain timestamp of the sample
+ */
+void bioLatencyPop(uint32_t drainUs);
+
+
+/**
+ * @brief   Copies the latency histograms. A copy taken while a latency is being recorded may be off by that one latency
+ *
+ * @param   *captureToDrain Pointer to histogram to fill with capture to drain latencies, NULL to skip
+ * @param   *drainToPop     Pointer to histogram to fill with drain to consumer latencies, NULL to skip
+ */
+void bioGetLatency(struct bioLatencyHist *captureToDrain, struct bioLatencyHist *drainToPop);
+
+
+/**
+ * @brief   Clears the latency histograms
+ */
+void bioResetLatency(void);
+
+
+#ifdef BIO_TRACE
+/**
+ * @brief   Streams the trace ring out: a struct bioTraceHeader, then the records from oldest to newest.
+ *          Call from the task that uses the library (the ring is not locked). Tracing continues afterwards
+ *
+ * @param   writeFxn Function called with each piece of the dump
+ * @param   *arg     Argument passed through to writeFxn
+ *
+ * @return  Number of records sent
+ */
+uint16_t bioTraceDump(bioTraceWriteFxn writeFxn, void *arg);
+
+
+/**
+ * @brief   Empties the trace ring
+ */
+void bioTraceClear(void);
+#endif
+
+
+
+
+
 ///////////////////////////////////////////////////////////////////
 
 /*
@@ -1318,6 +1698,35 @@ uint8_t I2CWrite2Bytes(uint8_t familyByte, uint8_t indexByte, uint8_t dataByte0,
 uint8_t I2CenableWriteByte(uint8_t familyByte, uint8_t indexByte, uint8_t dataByte);
 
 
+/**
+ * @brief   Does only the write phase of a MAX32664 command, for commands longer than the helpers above take
+ *          (e.g. bootloader pages). Read the status byte with I2CReadStatusByte() once the hub has had time to
+ *          process it
+ *
+ * familyByte - command[0]
+ *
+ * indexByte  - command[1]
+ *
+ * writeByte0 - command[2]
+ *
+ * writeByteN - command[length - 1]
+ *
+ * @param   *command Pointer to family byte, index byte and write bytes
+ * @param   length   Number of bytes to write
+ *
+ * @return  SUCCESS, or ERR_UNKNOWN if the I2C write did not work
+ */
+uint8_t I2CWriteCommand(uint8_t *command, uint16_t length);
+
+
+/**
+ * @brief   Does only the read phase of a MAX32664 command: reads the status byte of the last command written
+ *
+ * @return  Status byte of the command, ERR_UNKNOWN if the I2C read did not work
+ */
+uint8_t I2CReadStatusByte(void);
+
+
 
 
 
@@ -42,6 +42,8 @@
 /* Driver Header files */
 #include <ti/drivers/GPIO.h>
 #include <ti/drivers/I2C.h>
+#include <ti/drivers/NVS.h>
+#include <ti/drivers/UART.h>
 #include <ti/display/Display.h>
 
 /* Driver configuration */
@@ -50,12 +52,52 @@
 #define TASKSTACKSIZE       640
 
 #include "bio_sensor.h"
+#include "bio_frame.h"
+#include "bio_uart_out.h"
+#include "bio_format.h"
+#include "bio_sched.h"
+#include "bio_nvs.h"
+
+#define STREAM_CONFIG_MS        1000    //how often the data stream re-reads the sensor configuration
+#define STREAM_SLACK_PERIODS    8       //sample periods a telemetry query may delay a drain (the output FIFO holds 64)
+#define STREAM_DRAIN_PERIODS    8       //sample periods between drains, each drain empties the output FIFO
+#define STREAM_DRAIN_BATCH      16      //most samples a drain reads, room for drains delayed by the slack
+#define STREAM_MAX_DRAIN_ERRORS 16      //failed drains in a row that end the data stream (hub unplugged or NAKing)
+#define STREAM_STALL_MS         2000    //time without a new sample that ends the data stream (e.g. FIFO stays empty)
+
+
+/**
+ * @brief State of the data stream: output settings and the latest telemetry, kept up to date by the scheduler
+ */
+struct streamContext {
+    bool binaryStream; //send bio_frame.h frames instead of CSV text
+    uint16_t frameSequence; //sequence number of the next sample frame
+    uint32_t samples; //samples read so far
+    struct version sensorHubVer; //identity, read once
+    struct version algoVer;
+    struct version bootVer;
+    uint8_t mcuType;
+    uint16_t adcRate; //configuration, re-read every STREAM_CONFIG_MS
+    uint16_t adcRange;
+    uint16_t ledPulseWidth;
+    uint8_t ledArray[4];
+    uint8_t operatingMode;
+    uint8_t algoRange;
+    uint8_t algoStepSize;
+    uint8_t algoSensitivity;
+    uint16_t algoSampleRate;
+};
 
 
 static Display_Handle display;
 
 static void i2cErrorHandler(I2C_Transaction *transaction,
     Display_Handle display);
+static uint8_t streamDrain(void *arg);
+static uint8_t streamReadIdentity(void *arg);
+static uint8_t streamReadAfeConfig(void *arg);
+static uint8_t streamReadAlgoConfig(void *arg);
+static void streamSeed(struct streamContext *stream, const struct bioSnapshot *snapshot);
 
 extern I2C_Transaction gi2cTransaction;
 
@@ -79,6 +121,16 @@ void *mainThread(void *arg0)
     uint8_t globalStatus = 0x01; //global status for testing library
     bool libraryTest = false; //variable for testing the library
     bool dataStream = true; //log data via excel data streamer
+    bool binaryStream = false; //with dataStream, send bio_frame.h binary frames instead of CSV text (decode with host/bio_record.c)
+
+    struct streamContext stream = {0}; //data stream state, used with dataStream when not testing the library
+    struct bioSched sched; //runs the data stream: drains at the sample rate, telemetry queries in between
+    uint8_t identityTask, algoTask; //query indices, skipped once on a warm boot
+    NVS_Handle nvsHandle; //internal flash region holding the hub snapshot
+    NVS_Params nvsParams;
+    struct bioNvsBackend nvs; //snapshot storage on nvsHandle
+    struct bioSnapshot snapshot; //identity and configuration of the hub, from NVS on a warm boot
+    bool warmBoot = false; //snapshot in NVS matched the hub
 
 
     uint8_t userMode = MODE_TWO;
@@ -115,6 +167,7 @@ void *mainThread(void *arg0)
 //    Board_init();
     GPIO_init();
     I2C_init();
+    NVS_init();
 
     sleep(1);
 
@@ -139,10 +192,18 @@ void *mainThread(void *arg0)
 
 
 
-    /* Open the HOST display for output */
-    display = Display_open(Display_Type_UART, NULL);
-    if (display == NULL) {
-        while (1);
+    if(dataStream){ //streamed samples go through the double-buffered UART output, sent while the next sample is read
+        UART_init();
+        if (bioUartOutOpen(CONFIG_UART_0, 115200) == NULL) {
+            while (1);
+        }
+    }
+    else{
+        /* Open the HOST display for output */
+        display = Display_open(Display_Type_UART, NULL);
+        if (display == NULL) {
+            while (1);
+        }
     }
 
     /* Create I2C for usage */
@@ -517,6 +578,21 @@ void *mainThread(void *arg0)
 
 
 
+        if(!libraryTest){ //reuse what an earlier boot discovered about this hub, one version read instead of ~13 queries
+            NVS_Params_init(&nvsParams);
+            nvsHandle = NVS_open(CONFIG_NVSINTERNAL, &nvsParams);
+            if(nvsHandle){
+                bioNvsUseDriver(&nvs, nvsHandle);
+                if(bioSnapshotRestore(&nvs, &snapshot, &warmBoot) != SUCCESS){
+                    globalStatus &= 0x00;
+                }
+                NVS_close(nvsHandle);
+            }
+            if(!dataStream) Display_printf(display, 0, 0, "Hub discovery: %s", warmBoot ? "from NVS" : "queried");
+        }
+
+
+
         //////////////////////////////////////////////////////////////////
 
 
@@ -529,6 +605,9 @@ void *mainThread(void *arg0)
         if(libraryTest){ //if want to test the library (run through once)
             sampleLoop = 1;
         }
+        else if(dataStream){ //data stream runs on the scheduler below instead
+            sampleLoop = 0;
+        }
         else{
             sampleLoop = numSamples;
         }
@@ -991,19 +1070,6 @@ void *mainThread(void *arg0)
 
 
 
-            if(!libraryTest && dataStream){ //if we want to log data and we're not testing the library, put it into usable format
-//                Display_printf(display, 0, 0, "%02.2u,%u,%02.2u,%u,%d,%f,%u,%u,%u,%u,%f,%f,%f,%f,%u,%u,%u",
-//                               body.heartRate, body.confidence, body.oxygen, body.status, body.extStatus, body.rValue,
-//                               adcRate, adcRange, operatingMode, ledPulseWidth,
-//                               (float)ledArray[0] * 0.2f, (float)ledArray[1] * 0.2f, (float)ledArray[2] * 0.2f, (float)ledArray[3] * 0.2f,
-//                               algoRange, algoStepSize, algoSensitivity
-//                                ); //print out data in format that is usable by Excel Data Stream
-                Display_printf(display, 0, 0, "%02u,%02u,%02u,%02u,%02u,%02u,%02d,%02.2f",
-                               body.irLed, body.redLed, body.heartRate, body.confidence, body.oxygen, body.status, body.extStatus, body.rValue);
-            }
-
-
-
             //reset all values so if we have a communication error we aren't using old data
             body.heartRate = 0;
             body.confidence = 0;
@@ -1053,6 +1119,47 @@ void *mainThread(void *arg0)
         }
 
 
+        if(!libraryTest && dataStream){ //stream numSamples samples: a drain every sample period, telemetry only where it fits
+            adcRate = readADCSampleRate(&statusByte);
+            if(statusByte || adcRate == 0){ //fall back to the default MAX30101 rate
+                adcRate = 100;
+            }
+            stream.binaryStream = binaryStream;
+            stream.samples = 0;
+            bioSchedInit(&sched, streamDrain, &stream, STREAM_DRAIN_PERIODS * (1000000UL / adcRate), STREAM_SLACK_PERIODS * (1000000UL / adcRate)); //8 samples take ~60ms to read, 80ms at 100Hz
+            identityTask = bioSchedAdd(&sched, streamReadIdentity, &stream, 0, 0); //once: versions and MCU type do not change
+            bioSchedAdd(&sched, streamReadAfeConfig, &stream, STREAM_CONFIG_MS, 0);
+            algoTask = bioSchedAdd(&sched, streamReadAlgoConfig, &stream, STREAM_CONFIG_MS, 0);
+            if(warmBoot){ //identity and algorithm settings come from the snapshot, their first queries are dropped
+                streamSeed(&stream, &snapshot);
+                bioSchedSkip(&sched, identityTask);
+                bioSchedSkip(&sched, algoTask);
+            }
+
+            uint32_t lastSamples = 0; //samples at the last progress check
+            uint32_t progressUs = bioGetTimeUs(); //time a new sample last arrived
+            uint32_t drainErrors = 0; //sched.drainErrors after the last drain
+            uint8_t failedDrains = 0; //failed drains in a row
+            while(stream.samples < (uint32_t)numSamples){
+                if(bioSchedStep(&sched) == BIO_SCHED_DRAIN){
+                    failedDrains = (sched.drainErrors != drainErrors) ? failedDrains + 1 : 0;
+                    drainErrors = sched.drainErrors;
+                }
+                if(stream.samples != lastSamples){
+                    lastSamples = stream.samples;
+                    progressUs = bioGetTimeUs();
+                }
+                if(failedDrains >= STREAM_MAX_DRAIN_ERRORS || bioGetTimeUs() - progressUs > STREAM_STALL_MS * 1000UL){ //hub gone or not sampling
+                    break;
+                }
+            }
+
+            if(sched.drainErrors || stream.samples < (uint32_t)numSamples){ //a drain failed or the stream stopped early, queries only refresh telemetry
+                globalStatus &= 0x00;
+            }
+        }
+
+
         I2C_close(i2c);
         if(libraryTest && !dataStream) Display_printf(display, 0, 0, "\nI2C closed!");
 
@@ -1091,6 +1198,136 @@ void *mainThread(void *arg0)
 
 
 
+/**
+ * @brief   Scheduler drain of the data stream: reads the samples waiting in the output FIFO and queues each on the
+ *          UART as a CSV line or frame
+ *
+ * @param   *arg Pointer to the struct streamContext
+ *
+ * @return  Status byte of readSensorDataBatch()
+ */
+static uint8_t streamDrain(void *arg){
+    struct streamContext *stream = (struct streamContext *)arg;
+    static struct bioData body[STREAM_DRAIN_BATCH]; //off the task stack, only the streaming loop drains
+    uint8_t statusByte = 0;
+    uint8_t *outRecord;
+    uint8_t count;
+    uint8_t n;
+
+    count = readSensorDataBatch(body, STREAM_DRAIN_BATCH, &statusByte);
+    if(statusByte == SUCCESS && gi2cTransaction.status){ //driver error behind a success status
+        statusByte = ERR_UNKNOWN;
+    }
+
+    for(n = 0; n < count; n++){ //samples read before an error are still sent
+        stream->samples++;
+
+        outRecord = bioUartOutReserve(stream->binaryStream ? BIO_FRAME_SIZE(1) : BIO_FORMAT_CSV_MAX); //NULL when the UART is behind, sample is skipped
+        if(outRecord && stream->binaryStream){ //23 byte frame instead of ~40 bytes of text
+            bioUartOutCommit(bioFrameEncode(outRecord, stream->frameSequence, &body[n], 1));
+        }
+        else if(outRecord){
+            bioUartOutCommit(bioFormatCsv((char *)outRecord, &body[n], "\r\n")); //"%02u,%02u,%02u,%02u,%02u,%02u,%02d,%02.2f" without printf
+        }
+        stream->frameSequence++; //skipped samples show up as sequence gaps
+    }
+    return statusByte;
+}
+
+
+/**
+ * @brief   Scheduler query: sensor hub, algorithm and bootloader versions and MCU type
+ *
+ * @param   *arg Pointer to the struct streamContext
+ *
+ * @return  SUCCESS, or the status byte of the first failing read
+ */
+static uint8_t streamReadIdentity(void *arg){
+    struct streamContext *stream = (struct streamContext *)arg;
+    uint8_t statusByte = 0;
+    uint8_t firstError = SUCCESS;
+
+    stream->sensorHubVer = readSensorHubVersion(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    stream->algoVer = readAlgorithmVersion(&statusByte); //deprecated on current hub firmware, its failure is expected
+    stream->bootVer = readBootloaderVersion(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    stream->mcuType = getMcuType(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    return firstError;
+}
+
+
+/**
+ * @brief   Scheduler query: MAX30101 sample rate, ADC range, pulse width, LED currents and LED mode
+ *
+ * @param   *arg Pointer to the struct streamContext
+ *
+ * @return  SUCCESS, or the status byte of the first failing read
+ */
+static uint8_t streamReadAfeConfig(void *arg){
+    struct streamContext *stream = (struct streamContext *)arg;
+    uint8_t statusByte = 0;
+    uint8_t firstError = SUCCESS;
+
+    stream->adcRate = readADCSampleRate(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    stream->adcRange = readADCRange(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    stream->ledPulseWidth = readPulseWidth(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    readPulseAmp(stream->ledArray, &statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    stream->operatingMode = readMAX30101Mode(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    return firstError;
+}
+
+
+/**
+ * @brief   Scheduler query: AGC range, step size and sensitivity and the algorithm sample rate
+ *
+ * @param   *arg Pointer to the struct streamContext
+ *
+ * @return  SUCCESS, or the status byte of the first failing read
+ */
+static uint8_t streamReadAlgoConfig(void *arg){
+    struct streamContext *stream = (struct streamContext *)arg;
+    uint8_t statusByte = 0;
+    uint8_t firstError = SUCCESS;
+
+    stream->algoRange = readAlgoRange(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    stream->algoStepSize = readAlgoStepSize(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    stream->algoSensitivity = readAlgoSensitivity(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    stream->algoSampleRate = readAlgoSampleRate(&statusByte);
+    if(firstError == SUCCESS) firstError = statusByte;
+    return firstError;
+}
+
+
+/**
+ * @brief   Fills the identity and the algorithm settings of the data stream from a hub snapshot, in place of the first
+ *          streamReadIdentity() and streamReadAlgoConfig() runs. The AFE settings are not in the snapshot
+ *
+ * @param   *stream   Pointer to the struct streamContext
+ * @param   *snapshot Pointer to the snapshot restored by bioSnapshotRestore()
+ */
+static void streamSeed(struct streamContext *stream, const struct bioSnapshot *snapshot){
+    stream->sensorHubVer = snapshot->identity.sensorHubVer;
+    stream->algoVer = snapshot->identity.algoVer; //zeros when the hub firmware no longer reports it
+    stream->bootVer = snapshot->identity.bootVer;
+    stream->mcuType = snapshot->identity.mcuType;
+    stream->algoRange = snapshot->algoRange;
+    stream->algoStepSize = snapshot->algoStepSize;
+    stream->algoSensitivity = snapshot->algoSensitivity;
+    stream->algoSampleRate = snapshot->algoSampleRate;
+}
+
+
+
 /*
  *  ======== i2cErrorHandler ========
  */
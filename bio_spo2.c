@@ -0,0 +1,90 @@
+/**
+ * @file bio_spo2.c
+ *
+ * @brief Incremental fixed-point ratio of ratios SpO2 engine on raw IR and red counts
+ */
+
+#include <string.h>
+
+#include "bio_spo2.h"
+#include "bio_math.h"
+
+#define BIO_SPO2_TWO_PI_X1000  6283 //2 * pi * 1000
+
+
+void bioSpo2Init(struct bioSpo2 *spo2, uint16_t sampleRate, const int32_t *coef){
+    uint32_t lowW = BIO_SPO2_TWO_PI_X1000 * BIO_SPO2_LOWPASS_HZ; //corner angular frequency * 1000
+
+    memset(spo2, 0, sizeof(*spo2));
+    memcpy(spo2->coef, coef, sizeof(spo2->coef));
+    spo2->dcAlpha = (int32_t)(32768U / ((uint32_t)sampleRate * BIO_SPO2_DC_MS / 1000U + 1U)); //dt / (tau + dt)
+    spo2->lowAlpha = (int32_t)(32768ULL * lowW / ((uint64_t)sampleRate * 1000U + lowW)); //w / (1 + w), w = 2 pi fc / fs
+    spo2->powerAlpha = (int32_t)(32768U / ((uint32_t)sampleRate * BIO_SPO2_WINDOW_MS / 1000U + 1U));
+    spo2->settle = (uint32_t)sampleRate * BIO_SPO2_SETTLE_MS / 1000U;
+    spo2->interval = (uint32_t)sampleRate * BIO_SPO2_OUTPUT_MS / 1000U;
+    spo2->nextOutput = spo2->settle;
+}
+
+
+/**
+ * @brief   Runs one channel's filters and AC power window on a count
+ */
+static void bioSpo2Filter(const struct bioSpo2 *spo2, struct bioSpo2Channel *ch, uint32_t count){
+    int32_t x = (int32_t)(count << 8);
+    int32_t ac16;
+
+    if(spo2->n == 0){ //start on the DC
+        ch->dc = x;
+    }
+    ch->dc += (int32_t)(((int64_t)(x - ch->dc) * spo2->dcAlpha) >> 15);
+    ch->baseline += (int32_t)(((int64_t)(x - ch->dc - ch->baseline) * spo2->dcAlpha) >> 15);
+    ch->ac += (int32_t)(((int64_t)(x - ch->dc - ch->baseline - ch->ac) * spo2->lowAlpha) >> 15);
+
+    ac16 = ch->ac >> 4; //counts * 16, so the square fits the window arithmetic
+    ch->power += (((int64_t)ac16 * ac16 - ch->power) * spo2->powerAlpha) >> 15;
+}
+
+
+/**
+ * @brief   Takes R from the two windows and maps it to SpO2
+ */
+static void bioSpo2Ratio(struct bioSpo2 *spo2){
+    uint64_t ratioQ16;
+    int64_t r, poly, oxygen;
+
+    spo2->rValue = 0;
+    spo2->oxygen = 0;
+    if(spo2->ir.power <= 0 || spo2->red.power <= 0 || spo2->ir.dc <= 0 || spo2->red.dc <= 0){
+        return; //no pulse or no light
+    }
+
+    ratioQ16 = ((uint64_t)spo2->red.power << 16) / (uint64_t)spo2->ir.power; //(ACred / ACir)^2
+    if(ratioQ16 >= (1ULL << 47)){
+        return;
+    }
+    r = (int64_t)bioSqrt(ratioQ16 << 16) * spo2->ir.dc / spo2->red.dc; //(ACred / ACir) * (DCir / DCred), Q16
+    spo2->rValue = (uint32_t)r;
+
+    poly = ((((int64_t)spo2->coef[0] * r) >> 16) * r + (int64_t)spo2->coef[1] * r) >> 16; //coef0 R^2 + coef1 R
+    oxygen = (poly + spo2->coef[2] + 5000) / 10000; //* 100,000 to LSB = 0.1%
+    if(oxygen < 0) oxygen = 0;
+    if(oxygen > 1000) oxygen = 1000;
+    spo2->oxygen = (uint16_t)oxygen;
+}
+
+
+bool bioSpo2Update(struct bioSpo2 *spo2, uint32_t irLed, uint32_t redLed){
+    bool updated = false;
+
+    bioSpo2Filter(spo2, &spo2->ir, irLed);
+    bioSpo2Filter(spo2, &spo2->red, redLed);
+
+    if(spo2->n == spo2->nextOutput){
+        bioSpo2Ratio(spo2);
+        spo2->nextOutput += spo2->interval;
+        updated = true;
+    }
+
+    spo2->n++;
+    return updated;
+}
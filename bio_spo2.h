@@ -0,0 +1,99 @@
+/**
+ * @file bio_spo2.h
+ *
+ * @brief Incremental fixed-point ratio of ratios SpO2 engine on raw IR and red counts
+ *
+ *  For SENSOR_DATA mode, where the sensor hub sends raw counts only and the WHRM algorithm (with its setup delays
+ *  and its output bytes) can stay disabled. Each IR/red pair from readRawData() (or readSensorData()) goes through
+ *  bioSpo2Update(), which does constant work per channel:
+ *
+ *  - DC: a one-pole low-pass with a BIO_SPO2_DC_MS time constant
+ *
+ *  - AC: the count minus its DC goes through a second high-pass of the same time constant and a one-pole low-pass at
+ *    BIO_SPO2_LOWPASS_HZ. The two high-pass stages keep the respiratory baseline swing, which is the same fraction of
+ *    DC on both channels and would pull R towards 1, out of the pulse. They also attenuate slow heart rates, but by
+ *    the same factor on both channels
+ *
+ *  - AC power: the squared AC in a sliding exponential window of BIO_SPO2_WINDOW_MS (a running sum with a constant
+ *    decay instead of a ring of samples, so there is no window buffer)
+ *
+ *  Every BIO_SPO2_OUTPUT_MS the ratio of ratios R = (ACred / DCred) / (ACir / DCir) is taken from the RMS of the
+ *  two windows and mapped through the MaximFast calibration, SpO2 = (coef0 * R^2 + coef1 * R + coef2) / 100,000,
+ *  with the coefficients read by readMaximFastCoef(). Both channels go through the same filters, so their gains
+ *  cancel in R.
+ *
+ *  All state is in struct bioSpo2. The filters run on counts scaled by 256 in int32_t, with Q15 coefficients computed
+ *  once by bioSpo2Init() for the sample rate.
+ */
+
+#ifndef BIO_SPO2_H_
+#define BIO_SPO2_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bio_sensor.h"
+
+#define BIO_SPO2_DC_MS       150  //DC time constant, the AC path is high-passed twice at this corner (1Hz)
+#define BIO_SPO2_LOWPASS_HZ  4    //AC low-pass corner, passes heart rates up to 240bpm
+#define BIO_SPO2_WINDOW_MS   4000 //AC power window time constant
+#define BIO_SPO2_SETTLE_MS   6000 //no value before this much signal
+#define BIO_SPO2_OUTPUT_MS   1000 //R and SpO2 update interval
+
+
+/**
+ * @brief Struct of the filter state of one LED channel
+ */
+struct bioSpo2Channel {
+
+  int32_t dc; ///< DC, counts * 256
+  int32_t baseline; ///< Baseline left after the DC is removed, counts * 256
+  int32_t ac; ///< Band-passed count, counts * 256
+  int64_t power; ///< Windowed AC power, counts^2 * 256
+
+};
+
+
+/**
+ * @brief Struct of the engine state
+ */
+struct bioSpo2 {
+
+  int32_t coef[NUM_MAXIM_FAST_COEF]; ///< Calibration coefficients * 100,000 (readMaximFastCoef())
+  int32_t dcAlpha; ///< DC and baseline coefficient, Q15
+  int32_t lowAlpha; ///< AC low-pass coefficient, Q15
+  int32_t powerAlpha; ///< AC power window coefficient, Q15
+  uint32_t settle; ///< BIO_SPO2_SETTLE_MS, samples
+  uint32_t interval; ///< BIO_SPO2_OUTPUT_MS, samples
+  uint32_t n; ///< Samples processed
+  uint32_t nextOutput; ///< Sample index of the next R and SpO2 update
+  struct bioSpo2Channel ir; ///< IR channel
+  struct bioSpo2Channel red; ///< Red channel
+  uint32_t rValue; ///< Last ratio of ratios, Q16 (0 until the first update or when a channel has no pulse)
+  uint16_t oxygen; ///< Last SpO2, LSB = 0.1% (0 when rValue is 0), clamped to 0 - 100%
+
+};
+
+
+/**
+ * @brief   Clears the engine for a sample rate and calibration
+ *
+ * @param   *spo2      Pointer to engine
+ * @param   sampleRate MAX30101 sample rate, Hz (readADCSampleRate())
+ * @param   *coef      The 3 MaximFast coefficients * 100,000, as read by readMaximFastCoef()
+ */
+void bioSpo2Init(struct bioSpo2 *spo2, uint16_t sampleRate, const int32_t *coef);
+
+
+/**
+ * @brief   Processes one sample. Samples must be contiguous (reinitialize after FIFO overflows, gaps or finger off)
+ *
+ * @param   *spo2  Pointer to engine
+ * @param   irLed  IR count of the sample
+ * @param   redLed Red count of the sample
+ *
+ * @return  true when spo2->rValue and spo2->oxygen were updated (every BIO_SPO2_OUTPUT_MS once settled)
+ */
+bool bioSpo2Update(struct bioSpo2 *spo2, uint32_t irLed, uint32_t redLed);
+
+#endif /* BIO_SPO2_H_ */
@@ -0,0 +1,195 @@
+/**
+ * @file bio_sqi.c
+ *
+ * @brief Incremental signal quality index on raw IR/red counts
+ */
+
+#include <string.h>
+
+#include "bio_sqi.h"
+#include "bio_math.h"
+
+#define BIO_SQI_FULL_SCALE  0x3FFFF //MAX30101 ADC is 18-bit whatever the range
+#define BIO_SQI_MIN_RANGE   2048    //smallest ADC range, nA (readADCRange() returns ERR_UNKNOWN below it)
+#define BIO_SQI_UNIT        16384   //template points are scaled to this energy root (Q14 unit energy)
+
+
+/**
+ * @brief   Scores a factor from 0 at bad to 100 at good (either way round), linear in between
+ */
+static uint8_t bioSqiScore(int32_t value, int32_t bad, int32_t good){
+    int32_t score = (value - bad) * 100 / (good - bad);
+
+    if(score < 0) return 0;
+    if(score > 100) return 100;
+    return (uint8_t)score;
+}
+
+
+void bioSqiInit(struct bioSqi *sqi, uint16_t sampleRate, uint16_t adcRange){
+    memset(sqi, 0, sizeof(*sqi));
+    bioHrInit(&sqi->hr, sampleRate);
+    sqi->windowSize = (uint32_t)sampleRate * BIO_SQI_WINDOW_MS / 1000;
+    sqi->clipHigh = (uint32_t)BIO_SQI_FULL_SCALE * BIO_SQI_CLIP_PCT / 100;
+    if(adcRange >= BIO_SQI_MIN_RANGE){
+        sqi->clipLow = (uint32_t)((uint64_t)BIO_SQI_MIN_DC_NA * (BIO_SQI_FULL_SCALE + 1) / adcRange);
+    }
+    sqi->dcAlpha = 32768 / (BIO_SQI_RATE_HZ * BIO_SQI_DC_MS / 1000 + 1);
+    sqi->blockSize = sampleRate / BIO_SQI_RATE_HZ;
+    if(sqi->blockSize == 0){
+        sqi->blockSize = 1;
+    }
+    sqi->hubOk = true;
+}
+
+
+void bioSqiHubStatus(struct bioSqi *sqi, uint8_t status, int8_t extStatus){
+    if(status != 3 || extStatus < 0){ //no finger, something else on the sensor, motion or pressure
+        sqi->hubOk = false;
+    }
+}
+
+
+/**
+ * @brief   Cuts the pending beat from the ring, measures its amplitude and correlates it with the template
+ *
+ * @return  false while the ring does not cover the beat yet
+ */
+static bool bioSqiBeat(struct bioSqi *sqi){
+    uint32_t newest = sqi->ringCount - 1;
+    uint32_t newestQ8 = ((sqi->n - 1) << 8) - ((sqi->blockSize - 1) << 7); //center of the newest block, wraps like beatQ8
+    int32_t endQ8 = (int32_t)(newestQ8 - sqi->beatQ8) / (int32_t)sqi->blockSize; //ring samples * 256 back from newest
+    uint32_t spanQ8 = sqi->rrQ8 / sqi->blockSize;
+    uint32_t covered = sqi->ringCount < BIO_SQI_HISTORY ? sqi->ringCount : BIO_SQI_HISTORY;
+    int32_t point[BIO_SQI_POINTS];
+    int32_t minimum = INT32_MAX, maximum = INT32_MIN;
+    int64_t sum = 0, dot = 0;
+    uint64_t energy = 0, shapeEnergy = 0;
+    uint32_t norm, shapeNorm;
+    uint8_t k;
+
+    if(endQ8 < 0){
+        return false;
+    }
+    if(((uint32_t)endQ8 + spanQ8) / 256 + 1 >= covered){ //longer than the ring holds
+        return true;
+    }
+
+    for(k = 0; k < BIO_SQI_POINTS; k++){ //from the previous beat to this one, linear interpolation
+        uint32_t backQ8 = (uint32_t)endQ8 + spanQ8 - spanQ8 * k / BIO_SQI_POINTS;
+        uint32_t i = newest - (backQ8 >> 8);
+        int32_t frac = (int32_t)(backQ8 & 255);
+        int32_t v = (int32_t)(((int64_t)sqi->ring[i % BIO_SQI_HISTORY] * (256 - frac)
+                               + (int64_t)sqi->ring[(i - 1) % BIO_SQI_HISTORY] * frac) >> 8);
+        point[k] = v;
+        sum += v;
+        if(v < minimum) minimum = v;
+        if(v > maximum) maximum = v;
+    }
+    for(k = 0; k < BIO_SQI_POINTS; k++){
+        point[k] -= (int32_t)(sum / BIO_SQI_POINTS);
+        energy += (uint64_t)((int64_t)point[k] * point[k]);
+    }
+    norm = bioSqrt(energy);
+    if(norm == 0){
+        return true;
+    }
+
+    sqi->amplitudeSum += (uint32_t)(maximum - minimum);
+    sqi->beats++;
+    for(k = 0; k < BIO_SQI_POINTS; k++){
+        point[k] = (int32_t)((int64_t)point[k] * BIO_SQI_UNIT / norm);
+        dot += (int64_t)point[k] * sqi->shape[k];
+        shapeEnergy += (uint64_t)((int64_t)sqi->shape[k] * sqi->shape[k]);
+    }
+    shapeNorm = bioSqrt(shapeEnergy);
+    if(sqi->shapeValid && shapeNorm != 0){
+        int64_t r = dot * 100 / ((int64_t)BIO_SQI_UNIT * shapeNorm);
+        sqi->correlationSum += r < 0 ? 0 : (uint32_t)r;
+        sqi->correlated++;
+    }
+
+    for(k = 0; k < BIO_SQI_POINTS; k++){ //template follows the beats, a quarter per beat
+        sqi->shape[k] = sqi->shapeValid ? sqi->shape[k] + ((point[k] - sqi->shape[k]) >> 2) : point[k];
+    }
+    sqi->shapeValid = true;
+    return true;
+}
+
+
+/**
+ * @brief   Scores the window and starts the next one
+ */
+static void bioSqiWindowEnd(struct bioSqi *sqi){
+    struct bioSqiWindow *w = &sqi->window;
+    uint32_t amplitude = sqi->beats ? sqi->amplitudeSum / sqi->beats : 0;
+    uint32_t drift = (uint32_t)(sqi->dc > sqi->windowDc ? sqi->dc - sqi->windowDc : sqi->windowDc - sqi->dc);
+    uint64_t driftPct = amplitude ? (uint64_t)drift * 100 / amplitude : 65535;
+    uint8_t score, factor[4];
+    uint8_t k;
+
+    w->beats = sqi->beats;
+    w->perfusionX100 = sqi->dc > 0 ? (uint16_t)((uint64_t)amplitude * 10000 / (uint32_t)sqi->dc) : 0;
+    w->clippedPct = (uint8_t)(sqi->clipped * 100 / sqi->count);
+    w->driftPct = driftPct > 65535 ? 65535 : (uint16_t)driftPct;
+    w->correlationPct = sqi->correlated ? (uint8_t)(sqi->correlationSum / sqi->correlated) : 0;
+    w->hubOk = sqi->hubOk;
+
+    factor[0] = bioSqiScore(w->perfusionX100, BIO_SQI_PI_BAD, BIO_SQI_PI_GOOD);
+    factor[1] = bioSqiScore(w->clippedPct, BIO_SQI_CLIP_BAD, 0);
+    factor[2] = bioSqiScore(w->driftPct, BIO_SQI_DRIFT_BAD, BIO_SQI_DRIFT_GOOD);
+    factor[3] = bioSqiScore(w->correlationPct, BIO_SQI_CORR_BAD, BIO_SQI_CORR_GOOD);
+    score = factor[0];
+    for(k = 1; k < 4; k++){ //the weakest factor
+        if(factor[k] < score){
+            score = factor[k];
+        }
+    }
+    w->score = sqi->hubOk ? score : 0;
+
+    sqi->count = 0;
+    sqi->clipped = 0;
+    sqi->amplitudeSum = 0;
+    sqi->correlationSum = 0;
+    sqi->beats = 0;
+    sqi->correlated = 0;
+    sqi->hubOk = true;
+    sqi->windowDc = sqi->dc;
+}
+
+
+bool bioSqiUpdate(struct bioSqi *sqi, uint32_t irLed, uint32_t redLed){
+    if(bioHrUpdate(&sqi->hr, irLed) && sqi->hr.lastRrQ8 != 0){
+        sqi->beatPending = true;
+        sqi->beatQ8 = sqi->hr.lastBeatQ8;
+        sqi->rrQ8 = sqi->hr.lastRrQ8;
+    }
+    if(irLed >= sqi->clipHigh || redLed >= sqi->clipHigh || irLed < sqi->clipLow || redLed < sqi->clipLow){
+        sqi->clipped++;
+    }
+    sqi->n++;
+    sqi->count++;
+
+    sqi->blockSum += irLed;
+    if(++sqi->blockCount == sqi->blockSize){
+        int32_t x = (int32_t)(((uint64_t)sqi->blockSum * 16U) / sqi->blockSize); //counts * 16
+        if(sqi->ringCount == 0){ //start on the DC
+            sqi->dc = x;
+            sqi->windowDc = x;
+        }
+        sqi->dc += (int32_t)(((int64_t)(x - sqi->dc) * sqi->dcAlpha) >> 15);
+        sqi->ring[sqi->ringCount % BIO_SQI_HISTORY] = x;
+        sqi->ringCount++;
+        sqi->blockSum = 0;
+        sqi->blockCount = 0;
+        if(sqi->beatPending && bioSqiBeat(sqi)){
+            sqi->beatPending = false;
+        }
+    }
+
+    if(sqi->count == sqi->windowSize){
+        bioSqiWindowEnd(sqi);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,137 @@
+/**
+ * @file bio_sqi.h
+ *
+ * @brief Incremental signal quality index on raw IR/red counts
+ *
+ *  Scores each BIO_SQI_WINDOW_MS window of the raw sample path (readRawData(), readRawAndAlgoData() or
+ *  readSensorData()) from 0 (garbage) to 100, so the consumers can skip processing and sending windows that cannot
+ *  give a reading. Each IR/red pair goes through bioSqiUpdate(), which does constant work per sample. Four factors
+ *  are scored from 0 to 100 between a bad and a good threshold, and the window score is the lowest of them:
+ *
+ *  - perfusion index: the mean pulse amplitude (trough to peak of each beat) over the IR DC, in 0.01%
+ *
+ *  - clipping: the share of samples where a channel is at the top of the 18-bit ADC or below BIO_SQI_MIN_DC_NA of
+ *    photocurrent (no finger, LEDs off). The ADC range (readADCRange()) sets the current of one count, so it sets
+ *    that floor in counts
+ *
+ *  - DC drift: how far the IR DC moved over the window, against the pulse amplitude (motion, pressure changes)
+ *
+ *  - template correlation: each beat is resampled to BIO_SQI_POINTS points and correlated with a running template
+ *    of the previous beats, so noise and motion that still trigger the beat detector score low
+ *
+ *  Beats come from the bio_hr.h detector. Its intervals are cut from a ring of IR block means at BIO_SQI_RATE_HZ, so
+ *  a beat costs BIO_SQI_POINTS steps whatever the sample rate. When the hub's algorithm output is also read,
+ *  bioSqiHubStatus() gates the window on its status and extStatus: a window in which the hub reported no finger,
+ *  motion or pressure scores 0.
+ */
+
+#ifndef BIO_SQI_H_
+#define BIO_SQI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bio_hr.h"
+
+#define BIO_SQI_WINDOW_MS   2000 //scoring window
+#define BIO_SQI_RATE_HZ     25   //rate of the beat ring, divides every MAX30101 sample rate
+#define BIO_SQI_HISTORY     64   //ring length, power of two (2.56s, longer than the longest beat BIO_HR_MAX_GAP_MS)
+#define BIO_SQI_POINTS      16   //points per beat in the template
+#define BIO_SQI_DC_MS       1500 //DC low-pass time constant
+#define BIO_SQI_MIN_DC_NA   500  //photocurrent below this is not a finger, nA
+#define BIO_SQI_CLIP_PCT    98   //counts above this share of full scale are clipped
+#define BIO_SQI_USABLE      50   //scores from this up are worth processing
+
+#define BIO_SQI_PI_BAD      5    //perfusion index scoring 0, 0.01%
+#define BIO_SQI_PI_GOOD     30   //perfusion index scoring 100, 0.01%
+#define BIO_SQI_CLIP_BAD    5    //clipped samples scoring 0, %
+#define BIO_SQI_DRIFT_GOOD  100  //DC drift scoring 100, % of the pulse amplitude
+#define BIO_SQI_DRIFT_BAD   300  //DC drift scoring 0, % of the pulse amplitude
+#define BIO_SQI_CORR_BAD    75   //template correlation scoring 0, %
+#define BIO_SQI_CORR_GOOD   95   //template correlation scoring 100, %
+
+
+/**
+ * @brief Struct of the factors and score of one window
+ */
+struct bioSqiWindow {
+
+  uint16_t perfusionX100; ///< Perfusion index, LSB = 0.01% (0 without a beat)
+  uint8_t clippedPct; ///< Samples clipped on either channel, %
+  uint16_t driftPct; ///< IR DC change over the window, % of the pulse amplitude (saturates at 65535)
+  uint8_t correlationPct; ///< Mean beat to template correlation, % (0 without a beat)
+  uint8_t beats; ///< Beats in the window
+  bool hubOk; ///< The hub reported a finger and no motion or pressure (true when bioSqiHubStatus() is not used)
+  uint8_t score; ///< Signal quality, 0 - 100, the lowest factor score (0 when !hubOk)
+
+};
+
+
+/**
+ * @brief Struct of the engine state
+ */
+struct bioSqi {
+
+  struct bioHr hr; ///< Beat detector
+  uint32_t windowSize; ///< BIO_SQI_WINDOW_MS, samples
+  uint32_t clipHigh; ///< Clipped at or above, counts
+  uint32_t clipLow; ///< Clipped below (BIO_SQI_MIN_DC_NA), counts
+  int32_t dcAlpha; ///< DC coefficient, Q15
+  uint32_t blockSize; ///< Samples per ring sample
+  uint32_t blockCount; ///< Samples in the current block
+  uint32_t blockSum; ///< IR sum of the current block, counts
+  uint32_t n; ///< Samples processed
+  uint32_t ringCount; ///< Ring samples written
+  int32_t ring[BIO_SQI_HISTORY]; ///< IR block means, counts * 16, by ring sample index modulo BIO_SQI_HISTORY
+  int32_t dc; ///< IR DC, counts * 16
+  int32_t windowDc; ///< IR DC at the start of the window, counts * 16
+  bool beatPending; ///< A beat waits for the ring to cover it
+  uint32_t beatQ8; ///< Time of the pending beat, samples * 256
+  uint32_t rrQ8; ///< Interval ending at the pending beat, samples * 256
+  int32_t shape[BIO_SQI_POINTS]; ///< Template, mean removed, energy root about 16384 (Q14 unit energy)
+  bool shapeValid; ///< A beat was stored in the template
+  uint32_t count; ///< Samples in the window
+  uint32_t clipped; ///< Clipped samples in the window
+  uint32_t amplitudeSum; ///< Beat amplitudes in the window, counts * 16
+  uint32_t correlationSum; ///< Beat correlations in the window, %
+  uint8_t beats; ///< Beats measured in the window
+  uint8_t correlated; ///< Beats correlated with the template in the window
+  bool hubOk; ///< No hub fault reported in the window
+  struct bioSqiWindow window; ///< Last complete window
+
+};
+
+
+/**
+ * @brief   Clears the engine for a sample rate and ADC range
+ *
+ * @param   *sqi       Pointer to engine
+ * @param   sampleRate MAX30101 sample rate, Hz (readADCSampleRate()), a multiple of BIO_SQI_RATE_HZ
+ * @param   adcRange   MAX30101 ADC full scale, nA (readADCRange())
+ */
+void bioSqiInit(struct bioSqi *sqi, uint16_t sampleRate, uint16_t adcRange);
+
+
+/**
+ * @brief   Processes one sample. Samples must be contiguous (reinitialize after FIFO overflows or gaps)
+ *
+ * @param   *sqi   Pointer to engine
+ * @param   irLed  IR count of the sample
+ * @param   redLed Red count of the sample
+ *
+ * @return  true when a window was completed, its result is in sqi->window
+ */
+bool bioSqiUpdate(struct bioSqi *sqi, uint32_t irLed, uint32_t redLed);
+
+
+/**
+ * @brief   Gates the current window on the hub's algorithm output of a sample (readRawAndAlgoData(),
+ *          readSensorData() in SENSOR_AND_ALGORITHM mode). Call before bioSqiUpdate() of the same sample
+ *
+ * @param   *sqi      Pointer to engine
+ * @param   status    bioData.status, 3 when a finger is detected
+ * @param   extStatus bioData.extStatus, negative for no finger, motion or pressure
+ */
+void bioSqiHubStatus(struct bioSqi *sqi, uint8_t status, int8_t extStatus);
+
+#endif /* BIO_SQI_H_ */
@@ -0,0 +1,188 @@
+/**
+ * @file bio_uart_out.c
+ *
+ * @brief Double-buffered, non-blocking UART output stage for streaming samples
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <ti/drivers/dpl/HwiP.h>
+
+#include "bio_sensor.h"
+#include "bio_uart_out.h"
+
+
+static UART_Handle gUartOutHandle; ///< UART opened by bioUartOutOpen()
+static uint8_t gUartOutBuf[2][BIO_UART_OUT_BUFFER_SIZE]; ///< buffer being filled and buffer being sent
+static volatile uint16_t gUartOutLevel[2]; ///< bytes queued in each buffer
+static volatile uint8_t gUartOutFill; ///< index of the buffer being filled
+static volatile uint8_t gUartOutBusy; ///< a UART_write() is in progress
+static volatile uint16_t gUartOutReserved; ///< size of the open reservation, the callback does not swap while it is open
+static volatile struct bioUartOutStats gUartOutStats; ///< counters, bytesSent is written by the callback
+
+
+/**
+ * @brief   Swaps the buffers and sends the filled one if the UART is idle and there is something to send.
+ *          Called with interrupts disabled, or from the write callback
+ *
+ * @return  Index of the buffer to send, 0xFF if nothing was started
+ */
+static uint8_t bioUartOutSwap(void){
+    uint8_t send = gUartOutFill;
+
+    if(gUartOutBusy || gUartOutReserved || gUartOutLevel[send] == 0){ //sending, being formatted, or nothing queued
+        return 0xFF;
+    }
+
+    gUartOutFill = send ^ 1;
+    gUartOutLevel[gUartOutFill] = 0;
+    gUartOutBusy = 1;
+    gUartOutStats.writes++;
+    return send;
+}
+
+
+/**
+ * @brief   Starts sending a buffer returned by bioUartOutSwap()
+ */
+static void bioUartOutSend(uint8_t send){
+    if(send == 0xFF){
+        return;
+    }
+
+    if(UART_write(gUartOutHandle, gUartOutBuf[send], gUartOutLevel[send]) == UART_ERROR){ //driver refused the write
+        gUartOutStats.writeErrors++;
+        gUartOutStats.bytesDropped += gUartOutLevel[send];
+        gUartOutBusy = 0;
+    }
+}
+
+
+/**
+ * @brief   UART write callback (interrupt context): counts the bytes sent and sends the next buffer
+ */
+static void bioUartOutCallback(UART_Handle handle, void *buf, size_t count){
+    (void)handle;
+    (void)buf;
+
+    gUartOutStats.bytesSent += count;
+    gUartOutBusy = 0;
+    bioUartOutSend(bioUartOutSwap());
+}
+
+
+UART_Handle bioUartOutOpen(uint_least8_t index, uint32_t baudRate){
+    UART_Params uartParams;
+
+    UART_Params_init(&uartParams);
+    uartParams.writeMode = UART_MODE_CALLBACK;
+    uartParams.writeCallback = bioUartOutCallback;
+    uartParams.writeDataMode = UART_DATA_BINARY;
+    uartParams.readDataMode = UART_DATA_BINARY;
+    uartParams.readEcho = UART_ECHO_OFF;
+    uartParams.baudRate = baudRate;
+
+    gUartOutLevel[0] = 0;
+    gUartOutLevel[1] = 0;
+    gUartOutFill = 0;
+    gUartOutBusy = 0;
+    gUartOutReserved = 0;
+    bioUartOutResetStats();
+
+    gUartOutHandle = UART_open(index, &uartParams);
+    return gUartOutHandle;
+}
+
+
+void bioUartOutClose(void){
+    if(gUartOutHandle == NULL){
+        return;
+    }
+
+    while(gUartOutBusy || gUartOutLevel[gUartOutFill]){ //let both buffers drain
+        uintptr_t key = HwiP_disable();
+        uint8_t send = bioUartOutSwap();
+        HwiP_restore(key);
+        bioUartOutSend(send);
+        usleep(1000);
+    }
+
+    UART_close(gUartOutHandle);
+    gUartOutHandle = NULL;
+}
+
+
+uint8_t *bioUartOutReserve(uint16_t len){
+    uintptr_t key = HwiP_disable();
+    uint8_t fill = gUartOutFill;
+    uint16_t level = gUartOutLevel[fill];
+
+    if(gUartOutHandle == NULL || len > BIO_UART_OUT_BUFFER_SIZE - level){ //backpressure: drop the whole record
+        gUartOutStats.recordsDropped++;
+        gUartOutStats.bytesDropped += len;
+        HwiP_restore(key);
+        return NULL;
+    }
+
+    gUartOutReserved = len; //the callback leaves this buffer alone until the commit
+    HwiP_restore(key);
+    return &gUartOutBuf[fill][level];
+}
+
+
+void bioUartOutCommit(uint16_t len){
+    uintptr_t key = HwiP_disable();
+    uint8_t send;
+
+    if(len > gUartOutReserved){ //cannot queue more than was reserved
+        len = gUartOutReserved;
+    }
+    gUartOutReserved = 0;
+
+    if(len){
+        gUartOutLevel[gUartOutFill] += len;
+        gUartOutStats.recordsQueued++;
+        gUartOutStats.bytesQueued += len;
+        if(gUartOutLevel[gUartOutFill] > gUartOutStats.highWater){
+            gUartOutStats.highWater = gUartOutLevel[gUartOutFill];
+        }
+    }
+
+    send = bioUartOutSwap(); //UART idle: send right away
+    HwiP_restore(key);
+    bioUartOutSend(send);
+}
+
+
+uint8_t bioUartOutWrite(const void *buf, uint16_t len){
+    uint8_t *out = bioUartOutReserve(len);
+
+    if(out == NULL){ //no room, dropped
+        return ERR_TRY_AGAIN;
+    }
+
+    memcpy(out, buf, len);
+    bioUartOutCommit(len);
+    return SUCCESS;
+}
+
+
+uint16_t bioUartOutFree(void){
+    return BIO_UART_OUT_BUFFER_SIZE - gUartOutLevel[gUartOutFill];
+}
+
+
+void bioUartOutGetStats(struct bioUartOutStats *stats){
+    uintptr_t key = HwiP_disable();
+
+    memcpy(stats, (const void *)&gUartOutStats, sizeof(*stats));
+    HwiP_restore(key);
+}
+
+
+void bioUartOutResetStats(void){
+    uintptr_t key = HwiP_disable();
+
+    memset((void *)&gUartOutStats, 0, sizeof(gUartOutStats));
+    HwiP_restore(key);
+}
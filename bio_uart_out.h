@@ -0,0 +1,112 @@
+/**
+ * @file bio_uart_out.h
+ *
+ * @brief Double-buffered, non-blocking UART output stage for streaming samples
+ *
+ *  Records (CSV lines, bio_frame.h frames, ...) are formatted straight into one of two preallocated buffers while the
+ *  UART driver sends the other one in callback mode. When a write completes, the write callback swaps the buffers and
+ *  starts sending the filled one, so sending overlaps with I2C acquisition instead of adding to the sample period.
+ *
+ *  When the UART cannot keep up, the buffer being filled runs out of space and new records are dropped whole (never
+ *  cut). The drops are counted in struct bioUartOutStats so the application can lower its output rate.
+ *
+ *  Only one task may produce records. The write callback runs in interrupt context.
+ */
+
+#ifndef BIO_UART_OUT_H_
+#define BIO_UART_OUT_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <ti/drivers/UART.h>
+
+#define BIO_UART_OUT_BUFFER_SIZE  512 //bytes per buffer (two are allocated)
+
+
+/**
+ * @brief Struct of output stage counters, read with bioUartOutGetStats()
+ */
+struct bioUartOutStats {
+
+  uint32_t recordsQueued; ///< Records accepted
+  uint32_t bytesQueued; ///< Bytes accepted
+  uint32_t bytesSent; ///< Bytes the driver reported sent
+  uint32_t writes; ///< UART_write() calls (buffer swaps)
+  uint32_t recordsDropped; ///< Records dropped because the buffer being filled was full (backpressure)
+  uint32_t bytesDropped; ///< Bytes of the dropped records
+  uint32_t writeErrors; ///< UART_write() calls the driver refused, their bytes are dropped
+  uint16_t highWater; ///< Most bytes waiting in the buffer being filled, out of BIO_UART_OUT_BUFFER_SIZE
+
+};
+
+
+/**
+ * @brief   Opens the UART in binary callback write mode and clears the output stage
+ *
+ * @param   index    UART index from ti_drivers_config.h (e.g. CONFIG_UART_0)
+ * @param   baudRate Baud rate, e.g. 115200
+ *
+ * @return  UART handle, NULL if the UART could not be opened
+ */
+UART_Handle bioUartOutOpen(uint_least8_t index, uint32_t baudRate);
+
+
+/**
+ * @brief   Waits for the buffered bytes to be sent (polling with usleep()), then closes the UART
+ */
+void bioUartOutClose(void);
+
+
+/**
+ * @brief   Reserves space for a record in the buffer being filled. Format the record in place, then call
+ *          bioUartOutCommit(). Nothing is sent until the commit
+ *
+ * @param   len Largest size of the record, bytes
+ *
+ * @return  Pointer to len bytes, NULL if they are not free (the record is counted as dropped)
+ */
+uint8_t *bioUartOutReserve(uint16_t len);
+
+
+/**
+ * @brief   Queues the record formatted in the space given by bioUartOutReserve(), and starts sending if the UART
+ *          is idle
+ *
+ * @param   len Actual size of the record, bytes (0 to cancel the reservation)
+ */
+void bioUartOutCommit(uint16_t len);
+
+
+/**
+ * @brief   Copies a record into the buffer being filled and starts sending if the UART is idle
+ *
+ * @param   *buf Pointer to record
+ * @param   len  Size of the record, bytes
+ *
+ * @return  SUCCESS, or ERR_TRY_AGAIN if the record did not fit and was dropped
+ */
+uint8_t bioUartOutWrite(const void *buf, uint16_t len);
+
+
+/**
+ * @brief   Bytes free in the buffer being filled, so a producer can skip or shorten records before they are dropped
+ *
+ * @return  Free bytes
+ */
+uint16_t bioUartOutFree(void);
+
+
+/**
+ * @brief   Copies the output stage counters
+ *
+ * @param   *stats Pointer to struct to fill
+ */
+void bioUartOutGetStats(struct bioUartOutStats *stats);
+
+
+/**
+ * @brief   Clears the output stage counters
+ */
+void bioUartOutResetStats(void);
+
+#endif /* BIO_UART_OUT_H_ */
@@ -0,0 +1,173 @@
+/**
+ * @file bench_accel.c
+ *
+ * @brief Host accelerometer benchmark: feeding the sensor hub input FIFO at 50Hz
+ *
+ * The simulated hub streams at 50Hz with the host accelerometer enabled, so each sample it produces takes one
+ * accelerometer sample from the input FIFO. The host reads its accelerometer every 20ms for BENCH_ACCEL_SECONDS and
+ * feeds the hub either:
+ *
+ * - per_sample: writeInputFifo() with each sample as it is read
+ *
+ * - batch_<n>ms: bioAccelPush() with each sample and bioAccelFlush() every n ms (bio_accel.h)
+ *
+ * Before the run the input FIFO is primed with the lead each case needs: the samples of one write period plus
+ * BENCH_ACCEL_MARGIN. Each row reports I2C transactions, bus time and time blocked in CMD_DELAY sleeps per second of
+ * streaming, the input FIFO underflows and overflows seen by the hub, the reads done to size bursts and the lead
+ * (how far the accelerometer data is ahead of the PPG samples, i.e. the motion data latency the batching costs).
+ *
+ * Usage: bench_accel [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "bio_accel.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_ACCEL_RATE     50    //MAX30101 and accelerometer sample rate, Hz
+#define BENCH_ACCEL_PERIOD_US (1000000 / BENCH_ACCEL_RATE)
+#define BENCH_ACCEL_SECONDS  30    //streaming time per case
+#define BENCH_ACCEL_MARGIN   2     //lead samples on top of one write period
+
+
+/**
+ * @brief   Brings the simulated hub up in raw + algorithm mode at 50Hz
+ *
+ * @return  SUCCESS, or the status byte of the failing step
+ */
+static uint8_t accelBringUp(void){
+    I2C_Params params;
+    uint8_t status = SUCCESS;
+    uint8_t regVal;
+
+    max32664SimInit(NULL);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    if(status != SUCCESS){
+        return status;
+    }
+    status = configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1);
+    if(status != SUCCESS){
+        return status;
+    }
+    regVal = readRegisterMAX30101(CONFIGURATION_REGISTER, &status); //50Hz: first entry of the sample rate table
+    if(status != SUCCESS){
+        return status;
+    }
+    return writeRegisterMAX30101(CONFIGURATION_REGISTER, regVal & SAMP_MASK);
+}
+
+
+/**
+ * @brief   Accelerometer sample k: a slow sway on X and Y, gravity on Z
+ */
+static void accelSample(uint32_t k, struct bioAccelSample *sample){
+    sample->x = (int16_t)((k % 50) * 20 - 500);
+    sample->y = (int16_t)(250 - (k % 25) * 20);
+    sample->z = 4096; //1g at +-8g full scale
+}
+
+
+/**
+ * @brief   Runs one case and adds its row
+ *
+ * @param   *table     Results table
+ * @param   *name      Case name
+ * @param   flushTicks Accelerometer periods between flushes, 0 to write each sample as it is read
+ * @param   *cols      Column indices: transactions, bus, sleep, underflows, overflows, room reads, lead
+ *
+ * @return  0 on success, 1 on a failure
+ */
+static int accelCase(struct benchTable *table, const char *name, uint32_t flushTicks, const uint8_t *cols){
+    static struct bioAccelFifo fifo;
+    struct bioAccelSample sample[BIO_ACCEL_MAX_BURST];
+    struct max32664SimCounters before, after;
+    struct benchMeasure measure;
+    struct benchCost cost;
+    struct benchRow *row;
+    uint32_t lead = (flushTicks ? flushTicks : 1) + BENCH_ACCEL_MARGIN;
+    uint32_t k;
+    uint64_t startUs, tickUs;
+    uint64_t waitUs = 0; //sleeps until the next accelerometer read
+    uint8_t status;
+
+    if(accelBringUp() != SUCCESS || hostAccelControl(1) != SUCCESS){
+        return 1;
+    }
+
+    for(k = 0; k < lead; k++){ //prime the input FIFO
+        accelSample(k, &sample[k]);
+    }
+    if(writeInputFifo(sample, (uint8_t)lead) != SUCCESS){
+        return 1;
+    }
+    bioAccelInit(&fifo);
+    bioAccelFlush(&fifo); //reads the input FIFO size outside of the measurement
+
+    max32664SimGetCounters(&before);
+    benchStart(&measure);
+    startUs = max32664SimNowUs();
+    for(tickUs = BENCH_ACCEL_PERIOD_US; tickUs <= BENCH_ACCEL_SECONDS * 1000000ULL; tickUs += BENCH_ACCEL_PERIOD_US, k++){
+        uint64_t nowUs = max32664SimNowUs() - startUs;
+
+        if(nowUs < tickUs){ //next accelerometer read
+            usleep((useconds_t)(tickUs - nowUs));
+            waitUs += tickUs - nowUs;
+        }
+        accelSample(k, &sample[0]);
+
+        if(flushTicks == 0){
+            status = writeInputFifo(&sample[0], 1);
+        }
+        else{
+            bioAccelPush(&fifo, &sample[0]);
+            status = (tickUs / BENCH_ACCEL_PERIOD_US) % flushTicks == 0 ? bioAccelFlush(&fifo) : SUCCESS;
+        }
+        if(status != SUCCESS){
+            fprintf(stderr, "bench_accel: %s write failed, status 0x%02X\n", name, status);
+            return 1;
+        }
+    }
+    benchStop(&measure, &cost);
+    max32664SimGetCounters(&after);
+
+    row = benchAddRow(table, name);
+    row->value[cols[0]] = cost.transactions / (double)BENCH_ACCEL_SECONDS;
+    row->value[cols[1]] = cost.busUs / 1000.0 / BENCH_ACCEL_SECONDS;
+    row->value[cols[2]] = (cost.sleepUs - waitUs) / 1000.0 / BENCH_ACCEL_SECONDS; //CMD_DELAY sleeps
+    row->value[cols[3]] = after.accelUnderflows - before.accelUnderflows;
+    row->value[cols[4]] = after.accelOverflows - before.accelOverflows;
+    row->value[cols[5]] = fifo.roomReads;
+    row->value[cols[6]] = lead * 1000.0 / BENCH_ACCEL_RATE;
+    return 0;
+}
+
+
+int main(int argc, char **argv){
+    struct benchTable table;
+    uint8_t cols[7];
+
+    benchTableInit(&table);
+    cols[0] = benchAddColumn(&table, "transactions_per_s", BENCH_LOWER_IS_BETTER);
+    cols[1] = benchAddColumn(&table, "bus_ms_per_s", BENCH_LOWER_IS_BETTER);
+    cols[2] = benchAddColumn(&table, "blocked_ms_per_s", BENCH_LOWER_IS_BETTER);
+    cols[3] = benchAddColumn(&table, "underflows", BENCH_LOWER_IS_BETTER);
+    cols[4] = benchAddColumn(&table, "overflows", BENCH_LOWER_IS_BETTER);
+    cols[5] = benchAddColumn(&table, "room_reads", BENCH_INFO);
+    cols[6] = benchAddColumn(&table, "lead_ms", BENCH_INFO);
+
+    if(accelCase(&table, "per_sample", 0, cols)
+            || accelCase(&table, "batch_100ms", 5, cols)
+            || accelCase(&table, "batch_200ms", 10, cols)
+            || accelCase(&table, "batch_400ms", 20, cols)){
+        return 1;
+    }
+
+    return benchMain(&table, argc, argv);
+}
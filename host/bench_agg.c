@@ -0,0 +1,230 @@
+/**
+ * @file bench_agg.c
+ *
+ * @brief Accuracy and data reduction of the windowed aggregation (bio_agg.h)
+ *
+ * The simulated hub streams raw counts and its algorithm output (SENSOR_AND_ALGORITHM, mode 2) at 50Hz through
+ * readSensorData() for BENCH_AGG_SECONDS. The heart rate rises from 72 to 110bpm from 40 to 70 s and SpO2 drops
+ * (R from 0.5 to 0.9) from 100 to 130 s. The hub reports device motion from 20 to 30 s and pressing too hard from
+ * 140 to 150 s, and for those samples the bench replaces the hub's output by what a disturbed algorithm reports: the
+ * heart rate 45bpm high, SpO2 8% low, confidence 70%. The finger is off from 155 to 165 s.
+ *
+ * Each interval's summary is compared with the undisturbed values of the samples with a finger and no flag: their
+ * confidence-weighted means, and their extremes at BIO_AGG_EXTREME_CONFIDENCE or more. The _naive rows summarize every sample without weights or exclusions, as averaging the stream would. Rows report the
+ * largest error over the intervals of the mean heart rate, of its minimum and maximum, of the mean SpO2 and of its
+ * minimum, the bytes of 16 sample frames (bio_frame.h) over the bytes of the packed summaries, and the host CPU time
+ * per sample. Every summary must come back unchanged through bioAggPack() and bioAggUnpack().
+ *
+ * Usage: bench_agg [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "bio_agg.h"
+#include "bio_frame.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_AGG_SECONDS  180
+#define BENCH_AGG_RATE     50
+
+#define AGG_SAMPLES  (BENCH_AGG_SECONDS * BENCH_AGG_RATE)
+
+static struct benchTable table;
+static uint8_t colHrMean, colHrExtreme, colSpo2Mean, colSpo2Min, colRatio, colNs;
+static struct bioData aggBody[AGG_SAMPLES]; //as reported, disturbed samples included
+static struct bioData aggTrue[AGG_SAMPLES]; //undisturbed values
+static bool aggValid[AGG_SAMPLES]; //finger on, no flag: the samples the reference is taken from
+
+
+static double aggAbs(double v){
+    return v < 0.0 ? -v : v;
+}
+
+
+static double aggMax(double a, double b){
+    return a > b ? a : b;
+}
+
+
+/**
+ * @brief   Streams the scenario from the simulated hub
+ *
+ * @return  0 on success, 1 on a failure or an output FIFO overflow
+ */
+static int aggCollect(void){
+    struct max32664SimCounters counters;
+    I2C_Params params;
+    uint8_t status = SUCCESS;
+    uint8_t regVal;
+    uint32_t n = 0;
+
+    max32664SimInit(NULL);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    if(status != SUCCESS || configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1) != SUCCESS){
+        return 1;
+    }
+    regVal = readRegisterMAX30101(CONFIGURATION_REGISTER, &status); //50Hz: first entry of the sample rate table
+    if(status != SUCCESS || writeRegisterMAX30101(CONFIGURATION_REGISTER, regVal & SAMP_MASK) != SUCCESS){
+        return 1;
+    }
+    max32664SimResetCounters();
+
+    while(n < AGG_SAMPLES){
+        uint32_t t = n / BENCH_AGG_RATE;
+        bool motion = t >= 20 && t < 30;
+        bool pressure = t >= 140 && t < 150;
+        bool finger = !(t >= 155 && t < 165);
+        struct bioData body;
+
+        max32664SimSetVitals(t >= 40 && t < 70 ? 1100 : 720, t >= 100 && t < 130 ? 900 : 500);
+        max32664SimSetExtStatus(motion ? -2 : (pressure ? -4 : 0));
+        max32664SimSetFinger(finger);
+        body = readSensorData(&status);
+        if(status != SUCCESS || body.irLed == 0){ //no sample in the FIFO
+            usleep(1000);
+            continue;
+        }
+        aggTrue[n] = body;
+        aggValid[n] = finger && !motion && !pressure && body.status == 3;
+        if(motion || pressure){
+            body.heartRate += 45;
+            body.oxygen -= 8;
+            body.confidence = 70;
+        }
+        aggBody[n] = body;
+        n++;
+    }
+    max32664SimGetCounters(&counters);
+    return counters.samplesOverflowed == 0 ? 0 : 1;
+}
+
+
+/**
+ * @brief   Summarizes every sample of an interval without weights or exclusions
+ */
+static void aggNaive(uint32_t first, uint32_t count, struct bioAggSummary *s){
+    uint32_t hrSum = 0, spo2Sum = 0, n;
+
+    memset(s, 0, sizeof(*s));
+    s->heartRateMin = 0xFFFF;
+    s->oxygenMin = 0xFF;
+    for(n = first; n < first + count; n++){
+        const struct bioData *b = &aggBody[n];
+        hrSum += b->heartRate;
+        spo2Sum += b->oxygen;
+        if(b->heartRate < s->heartRateMin) s->heartRateMin = b->heartRate;
+        if(b->heartRate > s->heartRateMax) s->heartRateMax = b->heartRate;
+        if(b->oxygen < s->oxygenMin) s->oxygenMin = (uint8_t)b->oxygen;
+        if(b->oxygen > s->oxygenMax) s->oxygenMax = (uint8_t)b->oxygen;
+    }
+    s->heartRateMeanX10 = (uint16_t)((hrSum * 10 + count / 2) / count);
+    s->oxygenMeanX10 = (uint16_t)((spo2Sum * 10 + count / 2) / count);
+}
+
+
+/**
+ * @brief   Runs the aggregator (or the naive summary) at an interval and adds the row
+ *
+ * @return  0 on success, 1 on a failure
+ */
+static int aggRun(const char *name, uint16_t intervalS, bool naive){
+    static struct bioAgg agg;
+    struct benchRow *row;
+    double hrMean = 0.0, hrExtreme = 0.0, spo2Mean = 0.0, spo2Min = 0.0;
+    uint32_t interval = (uint32_t)intervalS * BENCH_AGG_RATE;
+    uint32_t summaries = 0, n;
+    uint64_t cpuNs;
+
+    if(bioAggInit(&agg, BENCH_AGG_RATE, intervalS) != SUCCESS){
+        return 1;
+    }
+    cpuNs = benchCpuNs();
+    for(n = 0; n < AGG_SAMPLES; n++){
+        bioAggUpdate(&agg, &aggBody[n]);
+    }
+    cpuNs = benchCpuNs() - cpuNs;
+
+    bioAggInit(&agg, BENCH_AGG_RATE, intervalS);
+    for(n = 0; n < AGG_SAMPLES; n++){
+        struct bioAggSummary summary, unpacked;
+        uint8_t packed[BIO_AGG_PACKED_SIZE];
+        uint32_t first = n + 1 - interval, hrMin = 0xFFFF, hrMax = 0, oxMin = 0xFFFF, weight = 0, k;
+        double hrSum = 0.0, spo2Sum = 0.0;
+
+        if(!bioAggUpdate(&agg, &aggBody[n])){
+            continue;
+        }
+        summary = agg.summary;
+        bioAggPack(&summary, packed);
+        bioAggUnpack(packed, &unpacked);
+        if(memcmp(&summary, &unpacked, sizeof(summary)) != 0){
+            fprintf(stderr, "bench_agg: summary %u changed through pack and unpack\n", summary.sequence);
+            return 1;
+        }
+        if(naive){
+            aggNaive(first, interval, &summary);
+        }
+        summaries++;
+
+        for(k = first; k <= n; k++){ //reference from the undisturbed samples
+            if(aggValid[k]){
+                const struct bioData *b = &aggTrue[k];
+                hrSum += (double)b->confidence * b->heartRate;
+                spo2Sum += (double)b->confidence * b->oxygen;
+                weight += b->confidence;
+                if(b->confidence >= BIO_AGG_EXTREME_CONFIDENCE){
+                    if(b->heartRate < hrMin) hrMin = b->heartRate;
+                    if(b->heartRate > hrMax) hrMax = b->heartRate;
+                    if(b->oxygen < oxMin) oxMin = b->oxygen;
+                }
+            }
+        }
+        if(weight == 0){ //no undisturbed sample to compare with
+            continue;
+        }
+        hrMean = aggMax(hrMean, aggAbs(summary.heartRateMeanX10 / 10.0 - hrSum / weight));
+        hrExtreme = aggMax(hrExtreme, aggAbs((double)summary.heartRateMin - hrMin));
+        hrExtreme = aggMax(hrExtreme, aggAbs((double)summary.heartRateMax - hrMax));
+        spo2Mean = aggMax(spo2Mean, aggAbs(summary.oxygenMeanX10 / 10.0 - spo2Sum / weight));
+        spo2Min = aggMax(spo2Min, aggAbs((double)summary.oxygenMin - oxMin));
+    }
+
+    row = benchAddRow(&table, name);
+    row->value[colHrMean] = hrMean;
+    row->value[colHrExtreme] = hrExtreme;
+    row->value[colSpo2Mean] = spo2Mean;
+    row->value[colSpo2Min] = spo2Min;
+    row->value[colRatio] = (double)AGG_SAMPLES * BIO_FRAME_SIZE(BIO_FRAME_MAX_SAMPLES) / BIO_FRAME_MAX_SAMPLES
+                           / (summaries * BIO_AGG_PACKED_SIZE);
+    row->value[colNs] = naive ? 0.0 : (double)cpuNs / AGG_SAMPLES;
+    return 0;
+}
+
+
+int main(int argc, char **argv){
+    benchTableInit(&table);
+    colHrMean = benchAddColumn(&table, "hr_mean_err_bpm", BENCH_LOWER_IS_BETTER);
+    colHrExtreme = benchAddColumn(&table, "hr_extreme_err_bpm", BENCH_LOWER_IS_BETTER);
+    colSpo2Mean = benchAddColumn(&table, "spo2_mean_err_pct", BENCH_LOWER_IS_BETTER);
+    colSpo2Min = benchAddColumn(&table, "spo2_min_err_pct", BENCH_LOWER_IS_BETTER);
+    colRatio = benchAddColumn(&table, "bytes_ratio", BENCH_INFO);
+    colNs = benchAddColumn(&table, "cpu_ns_per_sample", BENCH_INFO);
+
+    if(aggCollect()){
+        fprintf(stderr, "bench_agg: hub stream failed or dropped samples\n");
+        return 1;
+    }
+    if(aggRun("hub_50Hz_10s", 10, false) || aggRun("hub_50Hz_10s_naive", 10, true)
+            || aggRun("hub_50Hz_60s", 60, false) || aggRun("hub_50Hz_60s_naive", 60, true)){
+        return 1;
+    }
+
+    return benchMain(&table, argc, argv);
+}
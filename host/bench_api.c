@@ -0,0 +1,217 @@
+/**
+ * @file bench_api.c
+ *
+ * @brief Per-API benchmark of the bio sensor library against the simulated MAX32664
+ *
+ * Every public function of bio_sensor.h is called BENCH_API_REPS times on a configured hub
+ * (SENSOR_AND_ALGORITHM, MODE_TWO, as in bio_sensor_library_test.c) and the average cost of one call is reported:
+ *
+ * - wall_us: on-target elapsed time (simulated clock)
+ *
+ * - sleep_us: part of wall_us spent in usleep()/sleep()
+ *
+ * - bus_us: part of wall_us spent clocking bytes on the 400kHz bus
+ *
+ * - transactions: I2C_transfer() calls
+ *
+ * - bytes: bytes on the wire (write + read, address bytes excluded)
+ *
+ * - cpu_ns: host CPU time, for information only
+ *
+ * Functions that reset or reconfigure the hub get a fresh bring-up before every call, outside of the measurement.
+ * readSensorDataBatch() reads up to 4 samples per call.
+ *
+ * Usage: bench_api [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+
+#include "bio_sensor.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_API_REPS 10 //calls per API
+
+static I2C_Handle benchHandle; //I2C handle of the simulated bus
+static uint8_t benchStatus; //status byte of the last call
+static int32_t benchCoef[NUM_MAXIM_FAST_COEF];
+static uint8_t benchLeds[4];
+static uint8_t benchArray[MAX30101_LED_ARRAY + MAXFAST_ARRAY_SIZE + MAXFAST_EXTENDED_DATA + 1];
+
+
+/**
+ * @brief   Powers up the simulated hub, opens the I2C driver and configures the hub like the test program
+ *
+ * @param   outputMode Output format passed to configMAX32664()
+ */
+static void benchBringUp(uint8_t outputMode){
+    I2C_Params params;
+    uint8_t status;
+
+    max32664SimInit(NULL);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    benchHandle = I2C_open(CONFIG_I2C_0, &params);
+    beginI2C(benchHandle, &status);
+    configMAX32664(outputMode, MODE_TWO, 1);
+    sleep(1); //let the FIFO fill
+}
+
+
+static void apiBeginI2C(void){ beginI2C(benchHandle, &benchStatus); }
+static void apiConfigMAX32664(void){ configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1); }
+static void apiReadSensorData(void){ readSensorData(&benchStatus); }
+static void apiReadSensorDataBatch(void){ struct bioData body[4]; readSensorDataBatch(body, 4, &benchStatus); }
+static void apiReadRawData(void){ readRawData(&benchStatus); }
+static void apiReadAlgoData(void){ readAlgoData(&benchStatus); }
+static void apiReadRawAndAlgoData(void){ readRawAndAlgoData(&benchStatus); }
+static void apiSoftwareResetMAX32664(void){ softwareResetMAX32664(); }
+static void apiSoftwareResetMAX30101(void){ softwareResetMAX30101(); }
+static void apiSetOutputMode(void){ setOutputMode(SENSOR_AND_ALGORITHM); }
+static void apiSetFifoThreshold(void){ setFifoThreshold(1); }
+static void apiNumSamplesOutFifo(void){ numSamplesOutFifo(&benchStatus); }
+static void apiAgcAlgoControl(void){ agcAlgoControl(ENABLE); }
+static void apiMax30101Control(void){ max30101Control(ENABLE); }
+static void apiReadMAX30101State(void){ readMAX30101State(&benchStatus); }
+static void apiMaximFastAlgoControl(void){ maximFastAlgoControl(MODE_TWO); }
+static void apiReadDeviceMode(void){ readDeviceMode(&benchStatus); }
+static void apiSetDeviceMode(void){ setDeviceMode(EXIT_BOOTLOADER, &benchStatus); }
+static void apiReadSensorHubStatus(void){ readSensorHubStatus(&benchStatus); }
+static void apiReadAlgoSamples(void){ readAlgoSamples(&benchStatus); }
+static void apiReadAlgoRange(void){ readAlgoRange(&benchStatus); }
+static void apiReadAlgoStepSize(void){ readAlgoStepSize(&benchStatus); }
+static void apiReadAlgoSensitivity(void){ readAlgoSensitivity(&benchStatus); }
+static void apiReadAlgoSampleRate(void){ readAlgoSampleRate(&benchStatus); }
+static void apiReadMaximFastCoef(void){ readMaximFastCoef(benchCoef); }
+static void apiReadSensorHubVersion(void){ readSensorHubVersion(&benchStatus); }
+static void apiReadAlgorithmVersion(void){ readAlgorithmVersion(&benchStatus); }
+static void apiReadBootloaderVersion(void){ readBootloaderVersion(&benchStatus); }
+static void apiGetMcuType(void){ getMcuType(&benchStatus); }
+static void apiReadADCSampleRate(void){ readADCSampleRate(&benchStatus); }
+static void apiReadADCRange(void){ readADCRange(&benchStatus); }
+static void apiReadPulseWidth(void){ readPulseWidth(&benchStatus); }
+static void apiReadPulseAmp(void){ readPulseAmp(benchLeds, &benchStatus); }
+static void apiReadMAX30101Mode(void){ readMAX30101Mode(&benchStatus); }
+static void apiGetAfeAttributesMAX30101(void){ getAfeAttributesMAX30101(&benchStatus); }
+static void apiGetAfeAttributesAccelerometer(void){ getAfeAttributesAccelerometer(&benchStatus); }
+static void apiGetExtAccelMode(void){ getExtAccelMode(&benchStatus); }
+static void apiReadRegisterMAX30101(void){ readRegisterMAX30101(CONFIGURATION_REGISTER, &benchStatus); }
+static void apiWriteRegisterMAX30101(void){ writeRegisterMAX30101(LED1_REGISTER, 0x24); }
+static void apiI2CReadByte(void){ I2CReadByte(READ_DEVICE_MODE, 0x00, &benchStatus); }
+static void apiI2CReadBytewithWriteByte(void){ I2CReadBytewithWriteByte(READ_REGISTER, READ_MAX30101, MODE_REGISTER, &benchStatus); }
+static void apiI2CReadFillArray(void){ I2CReadFillArray(READ_DATA_OUTPUT, READ_DATA, sizeof(benchArray) - 1, benchArray); }
+static void apiI2CReadInt(void){ I2CReadInt(READ_DATA_INPUT, READ_NUM_SAMPLES_INPUT, &benchStatus); }
+static void apiI2CReadIntWithWriteByte(void){ I2CReadIntWithWriteByte(READ_ALGORITHM_CONFIG, READ_MAX_FAST_RATE, READ_MAX_FAST_RATE_ID, &benchStatus); }
+static void apiI2CRead32BitValue(void){ I2CRead32BitValue(READ_ALGORITHM_CONFIG, READ_MAX_FAST_COEF, READ_MAX_FAST_COEF_ID, &benchStatus); }
+static void apiI2CReadMultiple32BitValues(void){ I2CReadMultiple32BitValues(READ_ALGORITHM_CONFIG, READ_MAX_FAST_COEF, READ_MAX_FAST_COEF_ID, NUM_MAXIM_FAST_COEF, benchCoef); }
+static void apiI2CWriteByte(void){ I2CWriteByte(OUTPUT_MODE, WRITE_SET_THRESHOLD, 1); }
+static void apiI2CWrite2Bytes(void){ I2CWrite2Bytes(WRITE_REGISTER, WRITE_MAX30101, LED2_REGISTER, 0x24); }
+static void apiI2CenableWriteByte(void){ I2CenableWriteByte(ENABLE_ALGORITHM, ENABLE_AGC_ALGO, ENABLE); }
+
+
+/**
+ * @brief One benchmarked API
+ */
+struct benchApi {
+    const char *name;   //case name
+    void (*call)(void); //one call of the API
+    uint8_t fresh;      //1 if the call disturbs the hub and needs a bring-up before each repetition
+    uint8_t outputMode; //output format the hub is configured with
+};
+
+static const struct benchApi benchApis[] = {
+    {"beginI2C",                        apiBeginI2C,                        0, SENSOR_AND_ALGORITHM},
+    {"configMAX32664",                  apiConfigMAX32664,                  1, SENSOR_AND_ALGORITHM},
+    {"readSensorData",                  apiReadSensorData,                  0, SENSOR_AND_ALGORITHM},
+    {"readSensorDataBatch",             apiReadSensorDataBatch,             0, SENSOR_AND_ALGORITHM},
+    {"readRawData",                     apiReadRawData,                     0, SENSOR_DATA},
+    {"readAlgoData",                    apiReadAlgoData,                    0, ALGO_DATA},
+    {"readRawAndAlgoData",              apiReadRawAndAlgoData,              0, SENSOR_AND_ALGORITHM},
+    {"softwareResetMAX32664",           apiSoftwareResetMAX32664,           1, SENSOR_AND_ALGORITHM},
+    {"softwareResetMAX30101",           apiSoftwareResetMAX30101,           1, SENSOR_AND_ALGORITHM},
+    {"setOutputMode",                   apiSetOutputMode,                   1, SENSOR_AND_ALGORITHM},
+    {"setFifoThreshold",                apiSetFifoThreshold,                0, SENSOR_AND_ALGORITHM},
+    {"numSamplesOutFifo",               apiNumSamplesOutFifo,               0, SENSOR_AND_ALGORITHM},
+    {"agcAlgoControl",                  apiAgcAlgoControl,                  0, SENSOR_AND_ALGORITHM},
+    {"max30101Control",                 apiMax30101Control,                 0, SENSOR_AND_ALGORITHM},
+    {"readMAX30101State",               apiReadMAX30101State,               0, SENSOR_AND_ALGORITHM},
+    {"maximFastAlgoControl",            apiMaximFastAlgoControl,            0, SENSOR_AND_ALGORITHM},
+    {"readDeviceMode",                  apiReadDeviceMode,                  0, SENSOR_AND_ALGORITHM},
+    {"setDeviceMode",                   apiSetDeviceMode,                   0, SENSOR_AND_ALGORITHM},
+    {"readSensorHubStatus",             apiReadSensorHubStatus,             0, SENSOR_AND_ALGORITHM},
+    {"readAlgoSamples",                 apiReadAlgoSamples,                 0, SENSOR_AND_ALGORITHM},
+    {"readAlgoRange",                   apiReadAlgoRange,                   0, SENSOR_AND_ALGORITHM},
+    {"readAlgoStepSize",                apiReadAlgoStepSize,                0, SENSOR_AND_ALGORITHM},
+    {"readAlgoSensitivity",             apiReadAlgoSensitivity,             0, SENSOR_AND_ALGORITHM},
+    {"readAlgoSampleRate",              apiReadAlgoSampleRate,              0, SENSOR_AND_ALGORITHM},
+    {"readMaximFastCoef",               apiReadMaximFastCoef,               0, SENSOR_AND_ALGORITHM},
+    {"readSensorHubVersion",            apiReadSensorHubVersion,            0, SENSOR_AND_ALGORITHM},
+    {"readAlgorithmVersion",            apiReadAlgorithmVersion,            0, SENSOR_AND_ALGORITHM},
+    {"readBootloaderVersion",           apiReadBootloaderVersion,           0, SENSOR_AND_ALGORITHM},
+    {"getMcuType",                      apiGetMcuType,                      0, SENSOR_AND_ALGORITHM},
+    {"readADCSampleRate",               apiReadADCSampleRate,               0, SENSOR_AND_ALGORITHM},
+    {"readADCRange",                    apiReadADCRange,                    0, SENSOR_AND_ALGORITHM},
+    {"readPulseWidth",                  apiReadPulseWidth,                  0, SENSOR_AND_ALGORITHM},
+    {"readPulseAmp",                    apiReadPulseAmp,                    0, SENSOR_AND_ALGORITHM},
+    {"readMAX30101Mode",                apiReadMAX30101Mode,                0, SENSOR_AND_ALGORITHM},
+    {"getAfeAttributesMAX30101",        apiGetAfeAttributesMAX30101,        0, SENSOR_AND_ALGORITHM},
+    {"getAfeAttributesAccelerometer",   apiGetAfeAttributesAccelerometer,   0, SENSOR_AND_ALGORITHM},
+    {"getExtAccelMode",                 apiGetExtAccelMode,                 0, SENSOR_AND_ALGORITHM},
+    {"readRegisterMAX30101",            apiReadRegisterMAX30101,            0, SENSOR_AND_ALGORITHM},
+    {"writeRegisterMAX30101",           apiWriteRegisterMAX30101,           0, SENSOR_AND_ALGORITHM},
+    {"I2CReadByte",                     apiI2CReadByte,                     0, SENSOR_AND_ALGORITHM},
+    {"I2CReadBytewithWriteByte",        apiI2CReadBytewithWriteByte,        0, SENSOR_AND_ALGORITHM},
+    {"I2CReadFillArray",                apiI2CReadFillArray,                0, SENSOR_AND_ALGORITHM},
+    {"I2CReadInt",                      apiI2CReadInt,                      0, SENSOR_AND_ALGORITHM},
+    {"I2CReadIntWithWriteByte",         apiI2CReadIntWithWriteByte,         0, SENSOR_AND_ALGORITHM},
+    {"I2CRead32BitValue",               apiI2CRead32BitValue,               0, SENSOR_AND_ALGORITHM},
+    {"I2CReadMultiple32BitValues",      apiI2CReadMultiple32BitValues,      0, SENSOR_AND_ALGORITHM},
+    {"I2CWriteByte",                    apiI2CWriteByte,                    0, SENSOR_AND_ALGORITHM},
+    {"I2CWrite2Bytes",                  apiI2CWrite2Bytes,                  0, SENSOR_AND_ALGORITHM},
+    {"I2CenableWriteByte",              apiI2CenableWriteByte,              0, SENSOR_AND_ALGORITHM},
+};
+
+
+int main(int argc, char **argv){
+    struct benchTable table;
+    uint8_t colWall, colSleep, colBus, colTrans, colBytes, colCpu;
+    size_t i;
+    int rep;
+
+    benchTableInit(&table);
+    colWall = benchAddColumn(&table, "wall_us", BENCH_LOWER_IS_BETTER);
+    colSleep = benchAddColumn(&table, "sleep_us", BENCH_LOWER_IS_BETTER);
+    colBus = benchAddColumn(&table, "bus_us", BENCH_LOWER_IS_BETTER);
+    colTrans = benchAddColumn(&table, "transactions", BENCH_LOWER_IS_BETTER);
+    colBytes = benchAddColumn(&table, "bytes", BENCH_LOWER_IS_BETTER);
+    colCpu = benchAddColumn(&table, "cpu_ns", BENCH_INFO);
+
+    for(i = 0; i < sizeof(benchApis) / sizeof(benchApis[0]); i++){
+        struct benchRow *row = benchAddRow(&table, benchApis[i].name);
+
+        benchBringUp(benchApis[i].outputMode);
+
+        for(rep = 0; rep < BENCH_API_REPS; rep++){
+            struct benchMeasure measure;
+            struct benchCost cost;
+
+            if(benchApis[i].fresh && rep > 0){
+                benchBringUp(benchApis[i].outputMode);
+            }
+
+            benchStart(&measure);
+            benchApis[i].call();
+            benchStop(&measure, &cost);
+
+            row->value[colWall] += (double)cost.wallUs / BENCH_API_REPS;
+            row->value[colSleep] += (double)cost.sleepUs / BENCH_API_REPS;
+            row->value[colBus] += (double)cost.busUs / BENCH_API_REPS;
+            row->value[colTrans] += (double)cost.transactions / BENCH_API_REPS;
+            row->value[colBytes] += (double)cost.bytes / BENCH_API_REPS;
+            row->value[colCpu] += (double)cost.cpuNs / BENCH_API_REPS;
+        }
+    }
+
+    return benchMain(&table, argc, argv);
+}
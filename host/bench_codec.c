@@ -0,0 +1,150 @@
+/**
+ * @file bench_codec.c
+ *
+ * @brief Compression benchmark of the raw PPG codec (bio_codec.h) on samples streamed from the simulated MAX32664
+ *
+ * For every MAX30101 sample rate (50 - 3200Hz) BENCH_CODEC_SAMPLES raw samples are read with readSensorData()
+ * in SENSOR_DATA mode, coded with bioCodecEncode() and decoded back with bioCodecDecode(). A case fails if the decoded
+ * counts differ from the ones read. Reports:
+ *
+ * - bytes_per_sample: coded bytes per IR/red sample, keyframes included
+ *
+ * - ratio: 6 bytes (two 24-bit counts, as read from the hub) divided by bytes_per_sample
+ *
+ * - encode_ns_per_sample, decode_ns_per_sample: host CPU time, for information only
+ *
+ * Usage: bench_codec [--key-interval <blocks>] [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "bio_codec.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_CODEC_SAMPLES  8000  //samples coded per case
+
+static const uint16_t codecRates[] = {50, 100, 200, 400, 800, 1000, 1600, 3200}; //MAX30101 SpO2 sample rates
+
+static uint32_t codecIr[BENCH_CODEC_SAMPLES], codecRed[BENCH_CODEC_SAMPLES]; //samples read
+static uint32_t decodedIr[BENCH_CODEC_SAMPLES + BIO_CODEC_BLOCK], decodedRed[BENCH_CODEC_SAMPLES + BIO_CODEC_BLOCK];
+static uint8_t codecOut[BENCH_CODEC_SAMPLES / BIO_CODEC_BLOCK * BIO_CODEC_MAX_BLOCK_SIZE + BIO_CODEC_MAX_BLOCK_SIZE];
+
+
+/**
+ * @brief   Brings the simulated hub up in raw output mode at the given sample rate and reads the samples
+ *
+ * @return  SUCCESS, or the status byte of the failing step
+ */
+static uint8_t codecCollect(uint8_t rateIndex){
+    I2C_Params params;
+    uint8_t status = SUCCESS;
+    uint8_t regVal;
+    uint32_t n = 0;
+    struct bioData body;
+
+    max32664SimInit(NULL);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    if(status != SUCCESS){
+        return status;
+    }
+    status = configMAX32664(SENSOR_DATA, MODE_TWO, 1);
+    if(status != SUCCESS){
+        return status;
+    }
+    regVal = readRegisterMAX30101(CONFIGURATION_REGISTER, &status); //set the sample rate bits
+    if(status != SUCCESS){
+        return status;
+    }
+    status = writeRegisterMAX30101(CONFIGURATION_REGISTER, (regVal & SAMP_MASK) | (rateIndex << 2));
+    if(status != SUCCESS){
+        return status;
+    }
+    sleep(1); //warm-up
+
+    while(n < BENCH_CODEC_SAMPLES){
+        body = readSensorData(&status);
+        if(status == SUCCESS && body.irLed != 0){ //a sample was in the FIFO
+            codecIr[n] = body.irLed;
+            codecRed[n] = body.redLed;
+            n++;
+        }
+        else{
+            usleep(1000);
+        }
+    }
+    return SUCCESS;
+}
+
+
+int main(int argc, char **argv){
+    struct benchTable table;
+    uint8_t colBytes, colRatio, colEnc, colDec;
+    uint16_t keyInterval = 0;
+    size_t r;
+    int i;
+
+    for(i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--key-interval") == 0 && i + 1 < argc){
+            keyInterval = (uint16_t)atoi(argv[++i]);
+        }
+    }
+
+    benchTableInit(&table);
+    colBytes = benchAddColumn(&table, "bytes_per_sample", BENCH_LOWER_IS_BETTER);
+    colRatio = benchAddColumn(&table, "ratio", BENCH_HIGHER_IS_BETTER);
+    colEnc = benchAddColumn(&table, "encode_ns_per_sample", BENCH_INFO);
+    colDec = benchAddColumn(&table, "decode_ns_per_sample", BENCH_INFO);
+
+    for(r = 0; r < sizeof(codecRates) / sizeof(codecRates[0]); r++){
+        char name[BENCH_NAME_LEN];
+        struct benchRow *row;
+        struct bioCodec codec;
+        uint32_t size = 0, pos = 0, decoded = 0, n;
+        uint64_t cpuNs;
+        uint16_t len;
+        uint8_t numSamples;
+
+        snprintf(name, sizeof(name), "raw_%uHz", codecRates[r]);
+        row = benchAddRow(&table, name);
+
+        if(codecCollect((uint8_t)r) != SUCCESS){
+            fprintf(stderr, "bench_codec: %s: bring-up failed\n", name);
+            return 1;
+        }
+
+        bioCodecInit(&codec, keyInterval);
+        cpuNs = benchCpuNs();
+        for(n = 0; n < BENCH_CODEC_SAMPLES; n++){
+            size += bioCodecEncode(&codec, codecIr[n], codecRed[n], &codecOut[size]);
+        }
+        size += bioCodecFlush(&codec, &codecOut[size]);
+        row->value[colEnc] = (double)(benchCpuNs() - cpuNs) / BENCH_CODEC_SAMPLES;
+
+        bioCodecInit(&codec, keyInterval);
+        cpuNs = benchCpuNs();
+        while(pos < size && (len = bioCodecDecode(&codec, &codecOut[pos], (uint16_t)(size - pos > 0xFFFF ? 0xFFFF : size - pos),
+                                                  &decodedIr[decoded], &decodedRed[decoded], &numSamples)) != 0){
+            pos += len;
+            decoded += numSamples;
+        }
+        row->value[colDec] = (double)(benchCpuNs() - cpuNs) / BENCH_CODEC_SAMPLES;
+
+        if(decoded != BENCH_CODEC_SAMPLES || memcmp(decodedIr, codecIr, sizeof(codecIr)) != 0 ||
+           memcmp(decodedRed, codecRed, sizeof(codecRed)) != 0){
+            fprintf(stderr, "bench_codec: %s: decoded samples differ\n", name);
+            return 1;
+        }
+
+        row->value[colBytes] = (double)size / BENCH_CODEC_SAMPLES;
+        row->value[colRatio] = 6.0 / row->value[colBytes];
+    }
+
+    return benchMain(&table, argc, argv);
+}
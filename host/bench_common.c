@@ -0,0 +1,226 @@
+/**
+ * @file bench_common.c
+ *
+ * @brief Result tables, baselines and regression gate shared by the host benchmarks
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench_common.h"
+
+#define BENCH_LINE_LEN 1024 //longest baseline line
+
+
+void benchTableInit(struct benchTable *table){
+    memset(table, 0, sizeof(*table));
+}
+
+
+uint8_t benchAddColumn(struct benchTable *table, const char *name, uint8_t gate){
+    uint8_t col = table->numCols;
+
+    if(col >= BENCH_MAX_COLS){
+        fprintf(stderr, "bench: too many columns\n");
+        exit(1);
+    }
+    strncpy(table->colName[col], name, BENCH_NAME_LEN - 1);
+    table->colGate[col] = gate;
+    table->numCols++;
+    return col;
+}
+
+
+struct benchRow *benchAddRow(struct benchTable *table, const char *name){
+    struct benchRow *row;
+
+    if(table->numRows >= BENCH_MAX_ROWS){
+        return NULL;
+    }
+    row = &table->rows[table->numRows++];
+    memset(row, 0, sizeof(*row));
+    strncpy(row->name, name, BENCH_NAME_LEN - 1);
+    return row;
+}
+
+
+uint64_t benchCpuNs(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts); //not interposed by the simulator
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+void benchStart(struct benchMeasure *measure){
+    max32664SimGetCounters(&measure->counters);
+    measure->simUs = max32664SimNowUs();
+    measure->cpuNs = benchCpuNs();
+}
+
+
+void benchStop(const struct benchMeasure *measure, struct benchCost *cost){
+    struct max32664SimCounters now;
+
+    cost->cpuNs = benchCpuNs() - measure->cpuNs;
+    cost->wallUs = max32664SimNowUs() - measure->simUs;
+    max32664SimGetCounters(&now);
+    cost->sleepUs = now.sleepUs - measure->counters.sleepUs;
+    cost->busUs = now.busUs - measure->counters.busUs;
+    cost->transactions = now.transfers - measure->counters.transfers;
+    cost->bytes = (now.bytesTx + now.bytesRx) - (measure->counters.bytesTx + measure->counters.bytesRx);
+}
+
+
+void benchPrint(const struct benchTable *table, FILE *out){
+    uint16_t r;
+    uint8_t c;
+
+    fprintf(out, "case");
+    for(c = 0; c < table->numCols; c++){
+        fprintf(out, "\t%s", table->colName[c]);
+    }
+    fprintf(out, "\n");
+
+    for(r = 0; r < table->numRows; r++){
+        fprintf(out, "%s", table->rows[r].name);
+        for(c = 0; c < table->numCols; c++){
+            fprintf(out, "\t%.2f", table->rows[r].value[c]);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+
+/**
+ * @brief   Splits a tab separated line in place
+ *
+ * @return  Number of fields
+ */
+static int benchSplit(char *line, char **fields, int maxFields){
+    int n = 0;
+    char *p = line;
+
+    line[strcspn(line, "\r\n")] = '\0';
+    while(n < maxFields){
+        fields[n++] = p;
+        p = strchr(p, '\t');
+        if(!p){
+            break;
+        }
+        *p++ = '\0';
+    }
+    return n;
+}
+
+
+int benchCheck(const struct benchTable *table, const char *baselinePath, double tolerancePct){
+    FILE *in = fopen(baselinePath, "r");
+    char header[BENCH_LINE_LEN];
+    char line[BENCH_LINE_LEN];
+    char *headerFields[BENCH_MAX_COLS + 1];
+    char *fields[BENCH_MAX_COLS + 1];
+    int colMap[BENCH_MAX_COLS + 1]; //baseline column -> table column
+    int numHeader, numFields, i;
+    int regressions = 0;
+    uint8_t c;
+    uint16_t r;
+
+    if(!in || !fgets(header, sizeof(header), in)){
+        fprintf(stderr, "bench: cannot read baseline %s\n", baselinePath);
+        if(in) fclose(in);
+        return -1;
+    }
+
+    numHeader = benchSplit(header, headerFields, BENCH_MAX_COLS + 1);
+    for(i = 1; i < numHeader; i++){
+        colMap[i] = -1;
+        for(c = 0; c < table->numCols; c++){
+            if(strcmp(headerFields[i], table->colName[c]) == 0){
+                colMap[i] = c;
+            }
+        }
+    }
+
+    while(fgets(line, sizeof(line), in)){
+        const struct benchRow *row = NULL;
+
+        numFields = benchSplit(line, fields, BENCH_MAX_COLS + 1);
+        for(r = 0; r < table->numRows; r++){
+            if(strcmp(fields[0], table->rows[r].name) == 0){
+                row = &table->rows[r];
+            }
+        }
+        if(!row){
+            fprintf(stderr, "bench: %s: case missing from this run\n", fields[0]);
+            regressions++;
+            continue;
+        }
+
+        for(i = 1; i < numFields && i < numHeader; i++){
+            double base, now, allowed;
+
+            if(colMap[i] < 0 || table->colGate[colMap[i]] == BENCH_INFO){
+                continue;
+            }
+            base = atof(fields[i]);
+            now = row->value[colMap[i]];
+            allowed = fabs(base) * tolerancePct / 100.0 + 0.005; //rounding of the printed baseline
+
+            if(table->colGate[colMap[i]] == BENCH_LOWER_IS_BETTER ? (now > base + allowed) : (now < base - allowed)){
+                fprintf(stderr, "bench: REGRESSION %s %s: %.2f -> %.2f\n", row->name, headerFields[i], base, now);
+                regressions++;
+            }
+            else if(table->colGate[colMap[i]] == BENCH_LOWER_IS_BETTER ? (now < base - allowed) : (now > base + allowed)){
+                fprintf(stderr, "bench: improved   %s %s: %.2f -> %.2f\n", row->name, headerFields[i], base, now);
+            }
+        }
+    }
+
+    fclose(in);
+    return regressions;
+}
+
+
+int benchMain(const struct benchTable *table, int argc, char **argv){
+    const char *checkPath = NULL;
+    const char *writePath = NULL;
+    double tolerancePct = 0.0;
+    int i;
+
+    for(i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--check") == 0 && i + 1 < argc){
+            checkPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--write-baseline") == 0 && i + 1 < argc){
+            writePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc){
+            tolerancePct = atof(argv[++i]);
+        }
+    }
+
+    benchPrint(table, stdout);
+
+    if(writePath){
+        FILE *out = fopen(writePath, "w");
+        if(!out){
+            fprintf(stderr, "bench: cannot write %s\n", writePath);
+            return 1;
+        }
+        benchPrint(table, out);
+        fclose(out);
+    }
+
+    if(checkPath){
+        int regressions = benchCheck(table, checkPath, tolerancePct);
+        if(regressions != 0){
+            fprintf(stderr, "bench: FAILED against %s (%d)\n", checkPath, regressions);
+            return 1;
+        }
+        fprintf(stderr, "bench: passed against %s\n", checkPath);
+    }
+
+    return 0;
+}
@@ -0,0 +1,160 @@
+/**
+ * @file bench_common.h
+ *
+ * @brief Result tables, baselines and regression gate shared by the host benchmarks
+ *
+ * A benchmark fills a table (one row per case, one column per metric) and hands it to benchMain(), which prints it as
+ * tab separated values and optionally writes it as a baseline or checks it against one. Metrics measured on the
+ * simulated hub are deterministic, so they are gated; host CPU time is reported for information only.
+ */
+
+#ifndef BENCH_COMMON_H_
+#define BENCH_COMMON_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "max32664_sim.h"
+
+#define BENCH_MAX_ROWS    64 ///< Maximum number of cases in a table
+#define BENCH_MAX_COLS    12 ///< Maximum number of metrics in a table
+#define BENCH_NAME_LEN    40 ///< Maximum length of a case or metric name, including the terminator
+
+#define BENCH_LOWER_IS_BETTER  0 ///< Gated metric, regression when it grows past the baseline
+#define BENCH_HIGHER_IS_BETTER 1 ///< Gated metric, regression when it drops below the baseline
+#define BENCH_INFO             2 ///< Reported but never gated (e.g. host CPU time)
+
+
+/**
+ * @brief One benchmark case
+ */
+struct benchRow {
+    char name[BENCH_NAME_LEN];      ///< Case name, first column of the table
+    double value[BENCH_MAX_COLS];   ///< Metric values, in column order
+};
+
+/**
+ * @brief Benchmark result table
+ */
+struct benchTable {
+    uint8_t numCols;                            ///< Number of metric columns
+    char colName[BENCH_MAX_COLS][BENCH_NAME_LEN]; ///< Metric names
+    uint8_t colGate[BENCH_MAX_COLS];            ///< BENCH_LOWER_IS_BETTER, BENCH_HIGHER_IS_BETTER or BENCH_INFO
+    uint16_t numRows;                           ///< Number of cases
+    struct benchRow rows[BENCH_MAX_ROWS];       ///< Cases, in the order they were run
+};
+
+/**
+ * @brief Snapshot taken by benchStart(), consumed by benchStop()
+ */
+struct benchMeasure {
+    uint64_t simUs;                       ///< Simulated time at the start
+    uint64_t cpuNs;                       ///< Host CPU time at the start
+    struct max32664SimCounters counters;  ///< Simulator counters at the start
+};
+
+/**
+ * @brief Cost of the code run between benchStart() and benchStop()
+ */
+struct benchCost {
+    uint64_t wallUs;        ///< Simulated (on target) elapsed time, us
+    uint64_t sleepUs;       ///< Simulated time spent in usleep()/sleep(), us
+    uint64_t busUs;         ///< Simulated time spent clocking bytes on the bus, us
+    uint32_t transactions;  ///< I2C_transfer() calls
+    uint32_t bytes;         ///< Bytes written + read, excluding address bytes
+    uint64_t cpuNs;         ///< Host CPU time, ns
+};
+
+
+/**
+ * @brief   Clears a table
+ *
+ * @param   *table Pointer to table
+ */
+void benchTableInit(struct benchTable *table);
+
+
+/**
+ * @brief   Appends a metric column
+ *
+ * @param   *table Pointer to table
+ * @param   *name  Metric name, used as the column header and to match baselines
+ * @param   gate   BENCH_LOWER_IS_BETTER, BENCH_HIGHER_IS_BETTER or BENCH_INFO
+ *
+ * @return  Column index
+ */
+uint8_t benchAddColumn(struct benchTable *table, const char *name, uint8_t gate);
+
+
+/**
+ * @brief   Appends a case. Its values start at 0
+ *
+ * @param   *table Pointer to table
+ * @param   *name  Case name
+ *
+ * @return  Pointer to the new row, NULL when the table is full
+ */
+struct benchRow *benchAddRow(struct benchTable *table, const char *name);
+
+
+/**
+ * @brief   Reads the host CPU time of the process, for timing host-side processing that does no bus traffic
+ *
+ * @return  CPU time, ns
+ */
+uint64_t benchCpuNs(void);
+
+
+/**
+ * @brief   Starts measuring simulated time, simulator counters and host CPU time
+ *
+ * @param   *measure Pointer to snapshot to fill
+ */
+void benchStart(struct benchMeasure *measure);
+
+
+/**
+ * @brief   Stops measuring
+ *
+ * @param   *measure Pointer to snapshot taken by benchStart()
+ * @param   *cost    Pointer to cost to fill
+ */
+void benchStop(const struct benchMeasure *measure, struct benchCost *cost);
+
+
+/**
+ * @brief   Prints a table as tab separated values with a header line
+ *
+ * @param   *table Pointer to table
+ * @param   *out   Output stream
+ */
+void benchPrint(const struct benchTable *table, FILE *out);
+
+
+/**
+ * @brief   Compares a table against a baseline file written by benchPrint(). Every gated metric of every case found
+ *          in the baseline is checked, regressions beyond the tolerance are reported on stderr
+ *
+ * @param   *table        Pointer to table
+ * @param   *baselinePath Baseline file
+ * @param   tolerancePct  Allowed regression, percent of the baseline value
+ *
+ * @return  Number of regressions, -1 if the baseline could not be read
+ */
+int benchCheck(const struct benchTable *table, const char *baselinePath, double tolerancePct);
+
+
+/**
+ * @brief   Common command line handling for benchmark programs: prints the table to stdout, then
+ *          --write-baseline <file> saves it, --check <file> gates it against a baseline and
+ *          --tolerance <percent> sets the allowed regression (default 0, the simulation is deterministic)
+ *
+ * @param   *table Pointer to filled table
+ * @param   argc   Argument count from main()
+ * @param   **argv Arguments from main()
+ *
+ * @return  Process exit status: 0 on success, 1 on a regression or error
+ */
+int benchMain(const struct benchTable *table, int argc, char **argv);
+
+#endif /* BENCH_COMMON_H_ */
@@ -0,0 +1,212 @@
+/**
+ * @file bench_decim.c
+ *
+ * @brief Noise, aliasing and cost of the decimator (bio_decim.h) against the simpler ways down to a low rate
+ *
+ * Gap-free IR/red streams from max32664SimPpg() at the input rate, in three versions: clean, with 300 counts of
+ * uniform noise, and with a 60Hz mains tone of 200 counts added (which aliases into the band of every output rate
+ * below 120Hz). Each is taken down to the output rate by:
+ *
+ * - pick: every factor-th sample, i.e. sampling at the output rate in the first place
+ *
+ * - boxcar: the mean of each block of factor samples
+ *
+ * - decim: bioDecimProcess() in batches of BENCH_DECIM_BATCH samples, the size of a FIFO drain
+ *
+ * Rows report, over the IR channel after the first second, the noise left (RMS of noisy minus clean output), the
+ * tone left (RMS of toned minus clean output, as a percentage of the tone's RMS), the change in pulse peak to peak
+ * amplitude against the clean input, the host CPU time per input sample and the decimator state. The decimator is
+ * also run one sample per batch and must give the same output.
+ *
+ * Usage: bench_decim [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "bio_sensor.h"
+#include "bio_decim.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_DECIM_SECONDS  20
+#define BENCH_DECIM_MAX_RATE 3200
+#define BENCH_DECIM_BATCH    32
+#define BENCH_DECIM_NOISE    300
+#define BENCH_DECIM_TONE     200.0 //60Hz tone amplitude, counts
+
+#define DECIM_INPUT  (BENCH_DECIM_SECONDS * BENCH_DECIM_MAX_RATE)
+
+enum decimMethod {DECIM_PICK, DECIM_BOXCAR, DECIM_FILTER};
+
+static struct benchTable table;
+static uint8_t colNoise, colTone, colGain, colNs, colState;
+static uint32_t inIr[3][DECIM_INPUT], inRed[3][DECIM_INPUT]; //clean, noisy, toned
+static uint32_t outIr[3][DECIM_INPUT], outRed[3][DECIM_INPUT];
+
+
+/**
+ * @brief   Generates the clean, noisy and toned streams at a rate
+ */
+static void decimGenerate(uint16_t inputRate){
+    struct max32664SimConfig cfg;
+    uint32_t n, numSamples = (uint32_t)BENCH_DECIM_SECONDS * inputRate;
+
+    max32664SimDefaultConfig(&cfg);
+    cfg.noise = 0;
+    max32664SimInit(&cfg);
+    for(n = 0; n < numSamples; n++){
+        int32_t tone = (int32_t)lround(BENCH_DECIM_TONE * sin(2.0 * M_PI * 60.0 * n / inputRate));
+        max32664SimPpg(n, inputRate, &inIr[0][n], &inRed[0][n]);
+        inIr[2][n] = (uint32_t)((int32_t)inIr[0][n] + tone);
+        inRed[2][n] = (uint32_t)((int32_t)inRed[0][n] + tone);
+    }
+
+    cfg.noise = BENCH_DECIM_NOISE;
+    max32664SimInit(&cfg);
+    for(n = 0; n < numSamples; n++){
+        max32664SimPpg(n, inputRate, &inIr[1][n], &inRed[1][n]);
+    }
+}
+
+
+/**
+ * @brief   Takes one stream down by a method
+ *
+ * @return  Output samples, 0 if the decimator failed or depends on the batch size
+ */
+static uint32_t decimStream(enum decimMethod method, uint16_t inputRate, uint16_t outputRate, uint8_t s, uint64_t *cpuNs){
+    static struct bioDecim decim;
+    static uint32_t checkIr[DECIM_INPUT], checkRed[DECIM_INPUT];
+    uint32_t numSamples = (uint32_t)BENCH_DECIM_SECONDS * inputRate;
+    uint32_t factor = inputRate / outputRate;
+    uint32_t numOut = 0, n, k;
+    uint64_t start = benchCpuNs();
+
+    if(method == DECIM_PICK){
+        for(n = factor - 1; n < numSamples; n += factor){
+            outIr[s][numOut] = inIr[s][n];
+            outRed[s][numOut++] = inRed[s][n];
+        }
+    }
+    else if(method == DECIM_BOXCAR){
+        for(n = 0; n + factor <= numSamples; n += factor){
+            uint64_t ir = 0, red = 0;
+            for(k = 0; k < factor; k++){
+                ir += inIr[s][n + k];
+                red += inRed[s][n + k];
+            }
+            outIr[s][numOut] = (uint32_t)((ir + factor / 2) / factor);
+            outRed[s][numOut++] = (uint32_t)((red + factor / 2) / factor);
+        }
+    }
+    else{
+        if(bioDecimInit(&decim, inputRate, outputRate) != SUCCESS){
+            return 0;
+        }
+        for(n = 0; n < numSamples; n += BENCH_DECIM_BATCH){
+            uint16_t batch = numSamples - n < BENCH_DECIM_BATCH ? numSamples - n : BENCH_DECIM_BATCH;
+            numOut += bioDecimProcess(&decim, &inIr[s][n], &inRed[s][n], batch, &outIr[s][numOut], &outRed[s][numOut]);
+        }
+    }
+    *cpuNs += benchCpuNs() - start;
+
+    if(method == DECIM_FILTER){ //one sample at a time must give the same output
+        uint32_t numCheck = 0;
+        bioDecimInit(&decim, inputRate, outputRate);
+        for(n = 0; n < numSamples; n++){
+            numCheck += bioDecimProcess(&decim, &inIr[s][n], &inRed[s][n], 1, &checkIr[numCheck], &checkRed[numCheck]);
+        }
+        if(numCheck != numOut || memcmp(checkIr, outIr[s], numOut * sizeof(uint32_t)) != 0
+                || memcmp(checkRed, outRed[s], numOut * sizeof(uint32_t)) != 0){
+            return 0;
+        }
+    }
+    return numOut;
+}
+
+
+/**
+ * @brief   Runs one method on the three streams and adds its row
+ *
+ * @return  0 on success, 1 on a failure
+ */
+static int decimCase(const char *name, enum decimMethod method, uint16_t inputRate, uint16_t outputRate){
+    struct benchRow *row;
+    double noise = 0.0, tone = 0.0;
+    uint32_t numOut = 0, inMin = UINT32_MAX, inMax = 0, outMin = UINT32_MAX, outMax = 0, n;
+    uint32_t numSamples = (uint32_t)BENCH_DECIM_SECONDS * inputRate;
+    uint64_t cpuNs = 0;
+    uint8_t s;
+
+    for(s = 0; s < 3; s++){
+        numOut = decimStream(method, inputRate, outputRate, s, &cpuNs);
+        if(numOut == 0){
+            fprintf(stderr, "bench_decim: %s failed or depends on the batch size\n", name);
+            return 1;
+        }
+    }
+
+    for(n = outputRate; n < numOut; n++){ //after the first second
+        double dn = (double)outIr[1][n] - outIr[0][n];
+        double dt = (double)outIr[2][n] - outIr[0][n];
+        noise += dn * dn;
+        tone += dt * dt;
+        if(n >= numOut / 2){
+            if(outIr[0][n] < outMin) outMin = outIr[0][n];
+            if(outIr[0][n] > outMax) outMax = outIr[0][n];
+        }
+    }
+    for(n = numSamples / 2; n < numSamples; n++){
+        if(inIr[0][n] < inMin) inMin = inIr[0][n];
+        if(inIr[0][n] > inMax) inMax = inIr[0][n];
+    }
+
+    row = benchAddRow(&table, name);
+    row->value[colNoise] = sqrt(noise / (numOut - outputRate));
+    row->value[colTone] = sqrt(tone / (numOut - outputRate)) / (BENCH_DECIM_TONE / sqrt(2.0)) * 100.0;
+    row->value[colGain] = fabs((double)(outMax - outMin) / (inMax - inMin) - 1.0) * 100.0;
+    row->value[colNs] = (double)cpuNs / (3.0 * numSamples);
+    row->value[colState] = method == DECIM_FILTER ? sizeof(struct bioDecim) : 0;
+    return 0;
+}
+
+
+int main(int argc, char **argv){
+    static const struct {
+        const char *name;
+        enum decimMethod method;
+        uint16_t outputRate;
+    } cases3200[] = {
+        {"3200_to_100_pick", DECIM_PICK, 100},
+        {"3200_to_100_boxcar", DECIM_BOXCAR, 100},
+        {"3200_to_100_decim", DECIM_FILTER, 100},
+        {"3200_to_25_pick", DECIM_PICK, 25},
+        {"3200_to_25_boxcar", DECIM_BOXCAR, 25},
+        {"3200_to_25_decim", DECIM_FILTER, 25},
+    };
+    size_t c;
+
+    benchTableInit(&table);
+    colNoise = benchAddColumn(&table, "noise_rms_counts", BENCH_LOWER_IS_BETTER);
+    colTone = benchAddColumn(&table, "tone_left_pct", BENCH_LOWER_IS_BETTER);
+    colGain = benchAddColumn(&table, "pulse_gain_err_pct", BENCH_LOWER_IS_BETTER);
+    colNs = benchAddColumn(&table, "cpu_ns_per_input", BENCH_INFO);
+    colState = benchAddColumn(&table, "state_bytes", BENCH_INFO);
+
+    decimGenerate(3200);
+    for(c = 0; c < sizeof(cases3200) / sizeof(cases3200[0]); c++){
+        if(decimCase(cases3200[c].name, cases3200[c].method, 3200, cases3200[c].outputRate)){
+            return 1;
+        }
+    }
+
+    decimGenerate(400);
+    if(decimCase("400_to_50_pick", DECIM_PICK, 400, 50) || decimCase("400_to_50_decim", DECIM_FILTER, 400, 50)){
+        return 1;
+    }
+
+    return benchMain(&table, argc, argv);
+}
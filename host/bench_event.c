@@ -0,0 +1,237 @@
+/**
+ * @file bench_event.c
+ *
+ * @brief Detection and output volume of the event detector (bio_event.h)
+ *
+ * The simulated hub streams raw counts and its algorithm output (SENSOR_AND_ALGORITHM, mode 2) at 50Hz through
+ * readSensorData() for BENCH_EVENT_SECONDS, with four episodes to report:
+ *
+ * - SpO2 down to 82% (R 0.9) from 60 to 90 s, against a rule of below 90% for 10 s. A 5 s dip at 130 s is too short
+ *
+ * - heart rate 130bpm from 150 to 170 s, against a band of 50 - 120bpm for 5 s
+ *
+ * - device motion (extStatus -2) from 180 to 182 s, against a hold of 1 s. A 0.5 s burst at 200 s is too short
+ *
+ * - finger off from 215 to 225 s, against a hold of 0.5 s
+ *
+ * The no_hold row runs the same rules with a one sample hold. Detected episodes (start and end records of a rule) are
+ * matched to the expected ones by rule and start time. Rows report the episodes missed and the episodes reported that
+ * were not expected, the largest start and end time errors, the bytes of 16 sample frames (bio_frame.h) of the same
+ * stream over the bytes of the packed records, and the host CPU time per sample. Every record must come back
+ * unchanged through bioEventPack() and bioEventUnpack().
+ *
+ * Usage: bench_event [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "bio_event.h"
+#include "bio_frame.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_EVENT_SECONDS  240
+#define BENCH_EVENT_RATE     50
+#define BENCH_EVENT_MATCH_MS 2000 //largest start time difference of a matched episode
+#define BENCH_EVENT_MAX      64   //episodes kept per row
+
+#define EVENT_SAMPLES  (BENCH_EVENT_SECONDS * BENCH_EVENT_RATE)
+
+/**
+ * @brief Struct of one episode, expected or detected
+ */
+struct eventEpisode {
+    uint8_t rule;
+    uint32_t startMs;
+    uint32_t endMs;
+    bool matched;
+};
+
+static const struct eventEpisode eventExpected[] = { //rule indices in the order eventRun() adds them
+    {0, 60000, 90000, false},
+    {1, 150000, 170000, false},
+    {2, 180000, 182000, false},
+    {3, 215000, 225000, false},
+};
+
+static struct benchTable table;
+static uint8_t colMissed, colFalse, colStart, colEnd, colRatio, colNs;
+static struct bioData eventBody[EVENT_SAMPLES];
+
+
+/**
+ * @brief   Streams the scenario from the simulated hub
+ *
+ * @return  0 on success, 1 on a failure or an output FIFO overflow
+ */
+static int eventCollect(void){
+    struct max32664SimCounters counters;
+    I2C_Params params;
+    uint8_t status = SUCCESS;
+    uint8_t regVal;
+    uint32_t n = 0;
+
+    max32664SimInit(NULL);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    if(status != SUCCESS || configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1) != SUCCESS){
+        return 1;
+    }
+    regVal = readRegisterMAX30101(CONFIGURATION_REGISTER, &status); //50Hz: first entry of the sample rate table
+    if(status != SUCCESS || writeRegisterMAX30101(CONFIGURATION_REGISTER, regVal & SAMP_MASK) != SUCCESS){
+        return 1;
+    }
+    max32664SimResetCounters();
+
+    while(n < EVENT_SAMPLES){
+        uint32_t ms = n * (1000 / BENCH_EVENT_RATE);
+        bool desat = (ms >= 60000 && ms < 90000) || (ms >= 130000 && ms < 135000);
+        bool tachy = ms >= 150000 && ms < 170000;
+        bool motion = (ms >= 180000 && ms < 182000) || (ms >= 200000 && ms < 200500);
+        bool finger = !(ms >= 215000 && ms < 225000);
+
+        max32664SimSetVitals(tachy ? 1300 : 720, desat ? 900 : 500);
+        max32664SimSetExtStatus(motion ? -2 : 0);
+        max32664SimSetFinger(finger);
+        eventBody[n] = readSensorData(&status);
+        if(status == SUCCESS && eventBody[n].irLed != 0){ //a sample was in the FIFO
+            n++;
+        }
+        else{
+            usleep(1000);
+        }
+    }
+    max32664SimGetCounters(&counters);
+    return counters.samplesOverflowed == 0 ? 0 : 1;
+}
+
+
+/**
+ * @brief   Adds the scenario's rules, with their hold times or a one sample hold
+ */
+static void eventRules(struct bioEvent *ev, bool hold){
+    bioEventAdd(ev, BIO_EVENT_DESAT, 90, 0, hold ? 10000 : 0);
+    bioEventAdd(ev, BIO_EVENT_HR_BAND, 50, 120, hold ? 5000 : 0);
+    bioEventAdd(ev, BIO_EVENT_MOTION, 0, 0, hold ? 1000 : 0);
+    bioEventAdd(ev, BIO_EVENT_FINGER_OFF, 0, 0, hold ? 500 : 0);
+}
+
+
+/**
+ * @brief   Runs the rules, with or without their hold times, and adds the row
+ *
+ * @return  0 on success, 1 on a failure
+ */
+static int eventRun(const char *name, bool hold){
+    static struct bioEvent ev;
+    struct eventEpisode detected[BENCH_EVENT_MAX], expected[sizeof(eventExpected) / sizeof(eventExpected[0])];
+    struct benchRow *row;
+    struct bioEventRecord record, unpacked;
+    uint8_t packed[BIO_EVENT_PACKED_SIZE];
+    uint32_t numDetected = 0, records = 0, missed = 0, unexpected = 0, n;
+    double startErr = 0.0, endErr = 0.0;
+    uint64_t cpuNs;
+    size_t e, d;
+
+    bioEventInit(&ev, BENCH_EVENT_RATE);
+    eventRules(&ev, hold);
+    memcpy(expected, eventExpected, sizeof(expected));
+
+    cpuNs = benchCpuNs();
+    for(n = 0; n < EVENT_SAMPLES; n++){
+        bioEventUpdate(&ev, &eventBody[n]);
+    }
+    cpuNs = benchCpuNs() - cpuNs;
+
+    bioEventInit(&ev, BENCH_EVENT_RATE);
+    eventRules(&ev, hold);
+    for(n = 0; n < EVENT_SAMPLES; n++){
+        bioEventUpdate(&ev, &eventBody[n]);
+        while(bioEventPop(&ev, &record)){ //records taken as they come, as a transmit task would
+            bioEventPack(&record, packed);
+            bioEventUnpack(packed, &unpacked);
+            if(memcmp(&record, &unpacked, sizeof(record)) != 0){
+                fprintf(stderr, "bench_event: record changed through pack and unpack\n");
+                return 1;
+            }
+            records++;
+            if(record.start && numDetected < BENCH_EVENT_MAX){
+                detected[numDetected].rule = record.rule;
+                detected[numDetected].startMs = record.timeMs;
+                detected[numDetected].endMs = BENCH_EVENT_SECONDS * 1000; //still running at the end
+                detected[numDetected].matched = false;
+                numDetected++;
+            }
+            else if(!record.start){
+                for(d = numDetected; d-- > 0;){ //the latest start of the rule
+                    if(detected[d].rule == record.rule){
+                        detected[d].endMs = record.timeMs;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    if(ev.dropped != 0){
+        fprintf(stderr, "bench_event: %s dropped records\n", name);
+        return 1;
+    }
+
+    for(d = 0; d < numDetected; d++){
+        for(e = 0; e < sizeof(expected) / sizeof(expected[0]); e++){
+            int32_t startDiff = (int32_t)(detected[d].startMs - expected[e].startMs);
+            int32_t endDiff = (int32_t)(detected[d].endMs - expected[e].endMs);
+            if(!expected[e].matched && expected[e].rule == detected[d].rule && abs(startDiff) <= BENCH_EVENT_MATCH_MS){
+                expected[e].matched = true;
+                detected[d].matched = true;
+                if(abs(startDiff) / 1000.0 > startErr) startErr = abs(startDiff) / 1000.0;
+                if(abs(endDiff) / 1000.0 > endErr) endErr = abs(endDiff) / 1000.0;
+                break;
+            }
+        }
+        if(!detected[d].matched){
+            unexpected++;
+        }
+    }
+    for(e = 0; e < sizeof(expected) / sizeof(expected[0]); e++){
+        if(!expected[e].matched){
+            missed++;
+        }
+    }
+
+    row = benchAddRow(&table, name);
+    row->value[colMissed] = missed;
+    row->value[colFalse] = unexpected;
+    row->value[colStart] = startErr;
+    row->value[colEnd] = endErr;
+    row->value[colRatio] = (double)EVENT_SAMPLES * BIO_FRAME_SIZE(BIO_FRAME_MAX_SAMPLES) / BIO_FRAME_MAX_SAMPLES
+                           / (records * BIO_EVENT_PACKED_SIZE);
+    row->value[colNs] = (double)cpuNs / EVENT_SAMPLES;
+    return 0;
+}
+
+
+int main(int argc, char **argv){
+    benchTableInit(&table);
+    colMissed = benchAddColumn(&table, "missed_episodes", BENCH_LOWER_IS_BETTER);
+    colFalse = benchAddColumn(&table, "false_episodes", BENCH_LOWER_IS_BETTER);
+    colStart = benchAddColumn(&table, "start_err_s", BENCH_LOWER_IS_BETTER);
+    colEnd = benchAddColumn(&table, "end_err_s", BENCH_LOWER_IS_BETTER);
+    colRatio = benchAddColumn(&table, "bytes_ratio", BENCH_INFO);
+    colNs = benchAddColumn(&table, "cpu_ns_per_sample", BENCH_INFO);
+
+    if(eventCollect()){
+        fprintf(stderr, "bench_event: hub stream failed or dropped samples\n");
+        return 1;
+    }
+    if(eventRun("hub_50Hz", true) || eventRun("hub_50Hz_no_hold", false)){
+        return 1;
+    }
+
+    return benchMain(&table, argc, argv);
+}
@@ -0,0 +1,299 @@
+/**
+ * @file bench_flash.c
+ *
+ * @brief Firmware update benchmark: an .msbl image flashed into the simulated MAX32664 bootloader
+ *
+ * A synthetic image of BENCH_FLASH_PAGES pages is built in memory, each page authenticated with
+ * max32664SimPageMac() so the simulated bootloader accepts it. The image is read through a function that charges a
+ * fixed time per page, standing for where the image comes from:
+ *
+ * - ram: already in RAM, no fetch cost
+ *
+ * - spi: external SPI flash, BENCH_FLASH_SPI_US per page
+ *
+ * - uart: received over a 115200 baud UART, BENCH_FLASH_UART_US per page
+ *
+ * Two flashers are timed for each source:
+ *
+ * - naive: fetch a page, send it, sleep for the nominal page write time, read the status (and the same fixed sleep
+ *   after ERASE_FLASH). One page buffer
+ *
+ * - stream: bioFlashMsbl() (bio_flash.h), the next page is fetched while the hub writes the current one and the
+ *   status is polled with a backoff. Two page buffers
+ *
+ * The ram_stream_drop row runs the stream flasher against a bootloader that loses the middle page once
+ * (max32664SimConfig.btlDropPage), so the page is sent again after BIO_FLASH_CMD_TIMEOUT_US.
+ *
+ * Each row reports the simulated time from bootloader entry to application start, the time per page, I2C
+ * transactions, status polls and the RAM used for page buffers. The run fails unless every page was accepted, the
+ * stream flasher's waits and resends all show in bioStats, and an image with a corrupted page is refused.
+ *
+ * Usage: bench_flash [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "bio_flash.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_FLASH_PAGES        24        //pages in the synthetic image (192KB)
+#define BENCH_FLASH_SPI_US       30000     //page read from external SPI flash, us
+#define BENCH_FLASH_UART_US      720000    //8208 bytes at 115200 baud, us
+#define BENCH_FLASH_NAIVE_ERASE_US 1400000 //fixed sleep after ERASE_FLASH, the simulated erase time
+#define BENCH_FLASH_NAIVE_PAGE_US  340000  //fixed sleep after each page, the simulated page write time
+
+#define BENCH_FLASH_PAGE_BYTES   (BIO_FLASH_PAGE_SIZE + BIO_MSBL_PAGE_MAC_SIZE)
+#define BENCH_FLASH_IMAGE_SIZE   (BIO_MSBL_HEADER_SIZE + BENCH_FLASH_PAGES * BENCH_FLASH_PAGE_BYTES + 4)
+
+static struct benchTable table;
+static uint8_t colTotal, colPage, colTrans, colPolls, colRam;
+static uint8_t image[BENCH_FLASH_IMAGE_SIZE];
+static uint8_t work[BIO_FLASH_WORK_SIZE];
+
+
+/**
+ * @brief Struct of an image being read
+ */
+struct flashSource {
+
+  const uint8_t *image; ///< Image bytes
+  uint32_t size; ///< Image size
+  uint32_t pos; ///< Next byte to read
+  uint32_t pageUs; ///< Time charged per page read
+
+};
+
+
+/**
+ * @brief   bioMsblReadFxn over an in-memory image, charging the page fetch time
+ */
+static uint16_t flashRead(void *arg, uint8_t *buf, uint16_t len){
+    struct flashSource *src = (struct flashSource *)arg;
+
+    if(src->pos + len > src->size){
+        len = (uint16_t)(src->size - src->pos);
+    }
+    memcpy(buf, &src->image[src->pos], len);
+    src->pos += len;
+    if(len == BENCH_FLASH_PAGE_BYTES && src->pageUs > 0){
+        usleep(src->pageUs);
+    }
+    return len;
+}
+
+
+/**
+ * @brief   Builds the synthetic .msbl image
+ */
+static void flashBuildImage(void){
+    uint8_t *page;
+    uint32_t seed = 0x2545F491;
+    uint32_t i;
+    uint16_t p;
+
+    memset(image, 0, sizeof(image));
+    memcpy(image, "msbl", 4);
+    image[0x04] = 1; //format version
+    memcpy(&image[0x08], "MAX32664", 8); //target
+    memcpy(&image[0x18], "aes", 3); //encryption type
+    for(i = 0; i < BIO_MSBL_IV_SIZE; i++) image[BIO_MSBL_IV_OFFSET + i] = (uint8_t)(0xA0 + i);
+    for(i = 0; i < BIO_MSBL_AUTH_SIZE; i++) image[BIO_MSBL_AUTH_OFFSET + i] = (uint8_t)(0x50 + i);
+    image[BIO_MSBL_NUM_PAGES_OFFSET] = (uint8_t)BENCH_FLASH_PAGES;
+    image[BIO_MSBL_NUM_PAGES_OFFSET + 1] = (uint8_t)(BENCH_FLASH_PAGES >> 8);
+    image[BIO_MSBL_PAGE_SIZE_OFFSET] = (uint8_t)BIO_FLASH_PAGE_SIZE;
+    image[BIO_MSBL_PAGE_SIZE_OFFSET + 1] = (uint8_t)(BIO_FLASH_PAGE_SIZE >> 8);
+
+    for(p = 0; p < BENCH_FLASH_PAGES; p++){
+        page = &image[BIO_MSBL_HEADER_SIZE + p * BENCH_FLASH_PAGE_BYTES];
+        for(i = 0; i < BIO_FLASH_PAGE_SIZE; i++){ //xorshift filler
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            page[i] = (uint8_t)seed;
+        }
+        max32664SimPageMac(p, page, BIO_FLASH_PAGE_SIZE, &page[BIO_FLASH_PAGE_SIZE]);
+    }
+}
+
+
+/**
+ * @brief   Simulated hub running its application, I2C open. dropPage is the simulator's btlDropPage
+ */
+static int flashBringUp(uint16_t dropPage){
+    struct max32664SimConfig cfg;
+    I2C_Params params;
+    uint8_t status;
+
+    max32664SimDefaultConfig(&cfg);
+    cfg.btlDropPage = dropPage;
+    max32664SimInit(&cfg);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    return status != SUCCESS;
+}
+
+
+/**
+ * @brief   Sends a bootloader command, sleeps for a fixed time and reads its status
+ */
+static uint8_t flashNaiveCommand(uint8_t *command, uint16_t length, uint32_t sleepUs){
+    if(I2CWriteCommand(command, length) != SUCCESS){
+        return ERR_UNKNOWN;
+    }
+    usleep(sleepUs + CMD_DELAY * 1000);
+    return I2CReadStatusByte();
+}
+
+
+/**
+ * @brief   Fixed-sleep flasher: one page buffer, fetch and hub write one after the other
+ */
+static uint8_t flashNaive(struct flashSource *src, uint32_t *polls){
+    uint8_t header[BIO_MSBL_HEADER_SIZE];
+    uint8_t command[2 + BIO_MSBL_AUTH_SIZE];
+    uint8_t status;
+    uint16_t numPages;
+    uint16_t p;
+
+    flashRead(src, header, sizeof(header));
+    numPages = (uint16_t)(header[BIO_MSBL_NUM_PAGES_OFFSET] | (header[BIO_MSBL_NUM_PAGES_OFFSET + 1] << 8));
+    *polls = 0;
+
+    if(setDeviceMode(ENTER_BOOTLOADER, &status) != ENTER_BOOTLOADER){
+        return ERR_UNKNOWN;
+    }
+    command[0] = BOOTLOADER_FLASH;
+    command[1] = SET_NUM_PAGES;
+    command[2] = (uint8_t)(numPages >> 8);
+    command[3] = (uint8_t)numPages;
+    status = flashNaiveCommand(command, 4, 0);
+    command[1] = SET_INIT_VECTOR_BYTES;
+    memcpy(&command[2], &header[BIO_MSBL_IV_OFFSET], BIO_MSBL_IV_SIZE);
+    if(status == SUCCESS) status = flashNaiveCommand(command, 2 + BIO_MSBL_IV_SIZE, 0);
+    command[1] = SET_AUTH_BYTES;
+    memcpy(&command[2], &header[BIO_MSBL_AUTH_OFFSET], BIO_MSBL_AUTH_SIZE);
+    if(status == SUCCESS) status = flashNaiveCommand(command, 2 + BIO_MSBL_AUTH_SIZE, 0);
+    command[1] = ERASE_FLASH;
+    if(status == SUCCESS) status = flashNaiveCommand(command, 2, BENCH_FLASH_NAIVE_ERASE_US);
+    *polls += 4;
+
+    for(p = 0; p < numPages && status == SUCCESS; p++){
+        work[0] = BOOTLOADER_FLASH;
+        work[1] = SEND_PAGE_VALUE;
+        flashRead(src, &work[2], BENCH_FLASH_PAGE_BYTES);
+        status = flashNaiveCommand(work, BIO_FLASH_PAGE_BUFFER, BENCH_FLASH_NAIVE_PAGE_US);
+        (*polls)++;
+    }
+    if(status != SUCCESS){
+        return status;
+    }
+    return setDeviceMode(EXIT_BOOTLOADER, &status) == EXIT_BOOTLOADER ? SUCCESS : ERR_BTLDR_INVALID_APP;
+}
+
+
+/**
+ * @brief   Flashes the image from one source with one flasher and adds its row. With dropPage the bootloader loses
+ *          that page once (stream flasher only), which must cost exactly one resend
+ *
+ * @return  0 on success, 1 if the update failed or a page was not written
+ */
+static int flashCase(const char *sourceName, uint32_t pageUs, bool stream, uint16_t dropPage){
+    char name[BENCH_NAME_LEN];
+    struct flashSource src = {image, sizeof(image), 0, pageUs};
+    struct bioFlashStats stats;
+    struct benchMeasure measure;
+    struct benchCost cost;
+    struct benchRow *row;
+    struct max32664SimCounters counters;
+    struct bioStats libStats;
+    uint32_t polls;
+    uint8_t status;
+
+    if(flashBringUp(dropPage)){
+        return 1;
+    }
+    bioResetStats();
+    benchStart(&measure);
+    if(stream){
+        status = bioFlashMsbl(flashRead, &src, work, &stats);
+        polls = stats.statusPolls;
+    }
+    else{
+        status = flashNaive(&src, &polls);
+    }
+    benchStop(&measure, &cost);
+    max32664SimGetCounters(&counters);
+    if(status != SUCCESS || counters.pagesFlashed != BENCH_FLASH_PAGES){
+        fprintf(stderr, "bench_flash: %s %s failed, status 0x%02X\n", sourceName, stream ? "stream" : "naive", status);
+        return 1;
+    }
+    bioGetStats(&libStats);
+    if(stream && (stats.resends != (dropPage ? 1u : 0u) || libStats.retries != stats.resends
+            || libStats.sleepUs + (uint64_t)BENCH_FLASH_PAGES * pageUs != cost.sleepUs)){ //fetch time is the source's
+        fprintf(stderr, "bench_flash: %s waits or resends missing from bioStats\n", sourceName);
+        return 1;
+    }
+
+    snprintf(name, sizeof(name), "%s_%s%s", sourceName, stream ? "stream" : "naive", dropPage ? "_drop" : "");
+    row = benchAddRow(&table, name);
+    row->value[colTotal] = cost.wallUs / 1e6;
+    row->value[colPage] = cost.wallUs / 1000.0 / BENCH_FLASH_PAGES;
+    row->value[colTrans] = cost.transactions;
+    row->value[colPolls] = polls;
+    row->value[colRam] = stream ? BIO_FLASH_WORK_SIZE : BIO_FLASH_PAGE_BUFFER;
+    return 0;
+}
+
+
+/**
+ * @brief   An image with one corrupted page must be refused with ERR_BTLDR_CHECKSUM
+ *
+ * @return  0 if it was
+ */
+static int flashCorrupt(void){
+    struct flashSource src = {image, sizeof(image), 0, 0};
+    uint32_t at = BIO_MSBL_HEADER_SIZE + (BENCH_FLASH_PAGES / 2) * BENCH_FLASH_PAGE_BYTES + 100;
+    struct max32664SimCounters counters;
+    uint8_t status;
+
+    if(flashBringUp(0)){
+        return 1;
+    }
+    image[at] ^= 0x01;
+    status = bioFlashMsbl(flashRead, &src, work, NULL);
+    image[at] ^= 0x01;
+    max32664SimGetCounters(&counters);
+    if(status != ERR_BTLDR_CHECKSUM || counters.pagesFlashed != BENCH_FLASH_PAGES / 2){
+        fprintf(stderr, "bench_flash: corrupted image not refused, status 0x%02X\n", status);
+        return 1;
+    }
+    return 0;
+}
+
+
+int main(int argc, char **argv){
+    benchTableInit(&table);
+    colTotal = benchAddColumn(&table, "total_s", BENCH_LOWER_IS_BETTER);
+    colPage = benchAddColumn(&table, "per_page_ms", BENCH_LOWER_IS_BETTER);
+    colTrans = benchAddColumn(&table, "transactions", BENCH_LOWER_IS_BETTER);
+    colPolls = benchAddColumn(&table, "status_polls", BENCH_INFO);
+    colRam = benchAddColumn(&table, "buffer_bytes", BENCH_INFO);
+
+    flashBuildImage();
+
+    if(flashCase("ram", 0, false, 0) || flashCase("ram", 0, true, 0)
+            || flashCase("spi", BENCH_FLASH_SPI_US, false, 0) || flashCase("spi", BENCH_FLASH_SPI_US, true, 0)
+            || flashCase("uart", BENCH_FLASH_UART_US, false, 0) || flashCase("uart", BENCH_FLASH_UART_US, true, 0)
+            || flashCase("ram", 0, true, BENCH_FLASH_PAGES / 2)
+            || flashCorrupt()){
+        return 1;
+    }
+
+    return benchMain(&table, argc, argv);
+}
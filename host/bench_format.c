@@ -0,0 +1,136 @@
+/**
+ * @file bench_format.c
+ *
+ * @brief CSV formatting benchmark: bioFormatCsv() against the snprintf() line of bio_sensor_library_test.c
+ *
+ * First checks that bioFormatCsv() writes exactly the text of
+ * snprintf("%02u,%02u,%02u,%02u,%02u,%02u,%02d,%02.2f") for every R value readRawAndAlgoData() can produce
+ * (0.0 - 6553.5), every extStatus and a sweep of counts, and fails if any line differs. Then times both on samples
+ * streamed from the simulated hub and reports:
+ *
+ * - bytes_per_line: characters per CSV line, for information only
+ *
+ * - snprintf_ns_per_line, format_ns_per_line: host CPU time per line, for information only
+ *
+ * Usage: bench_format [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "bio_format.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_FORMAT_LINES  200000 //lines timed per case
+
+
+static int formatPrintf(char *out, const struct bioData *body){
+    return snprintf(out, BIO_FORMAT_CSV_MAX, "%02u,%02u,%02u,%02u,%02u,%02u,%02d,%02.2f",
+                    body->irLed, body->redLed, body->heartRate, body->confidence, body->oxygen, body->status,
+                    body->extStatus, body->rValue);
+}
+
+
+/**
+ * @brief   Compares both formatters on one sample
+ *
+ * @return  0 if the lines match
+ */
+static int formatCompare(const struct bioData *body){
+    char expected[BIO_FORMAT_CSV_MAX], got[BIO_FORMAT_CSV_MAX];
+    int len = formatPrintf(expected, body);
+
+    if(bioFormatCsv(got, body, NULL) != len || strcmp(expected, got) != 0){
+        fprintf(stderr, "bench_format: \"%s\" formatted as \"%s\"\n", expected, got);
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief   R values as readRawAndAlgoData() computes them, every extStatus, counts from 0 to 24 bits
+ */
+static int formatSweep(void){
+    struct bioData body;
+    uint32_t n;
+
+    memset(&body, 0, sizeof(body));
+    for(n = 0; n <= 0xFFFF; n++){
+        uint16_t tempVal = (uint16_t)n;
+
+        body.rValue = tempVal; //convert the integer to float
+        body.rValue /= 10.0; //divide by 10 to get the rValue
+        body.extStatus = (int8_t)(n % 256);
+        body.irLed = (n * 257) & 0xFFFFFF;
+        body.redLed = n % 100;
+        body.heartRate = (uint16_t)(n % 300);
+        body.confidence = (uint8_t)(n % 101);
+        body.oxygen = (uint16_t)(n % 1001);
+        body.status = (uint8_t)(n % 4);
+        if(formatCompare(&body)){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+int main(int argc, char **argv){
+    struct benchTable table;
+    struct benchRow *row;
+    struct bioData samples[256];
+    char line[BIO_FORMAT_CSV_MAX];
+    I2C_Params params;
+    uint8_t colBytes, colPrintf, colFormat;
+    uint8_t status = SUCCESS;
+    uint64_t cpuNs, bytes = 0;
+    uint32_t n = 0, i;
+
+    if(formatSweep()){
+        return 1;
+    }
+
+    max32664SimInit(NULL); //realistic lines: raw + algorithm samples from the simulated hub
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    if(status != SUCCESS || configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1) != SUCCESS){
+        fprintf(stderr, "bench_format: bring-up failed\n");
+        return 1;
+    }
+    sleep(10); //let the algorithm output settle
+    while(n < sizeof(samples) / sizeof(samples[0])){
+        samples[n] = readSensorData(&status);
+        if(status == SUCCESS && samples[n].irLed != 0){
+            if(formatCompare(&samples[n])){
+                return 1;
+            }
+            n++;
+        }
+        usleep(10000);
+    }
+
+    benchTableInit(&table);
+    colBytes = benchAddColumn(&table, "bytes_per_line", BENCH_INFO);
+    colPrintf = benchAddColumn(&table, "snprintf_ns_per_line", BENCH_INFO);
+    colFormat = benchAddColumn(&table, "format_ns_per_line", BENCH_INFO);
+    row = benchAddRow(&table, "raw_algo_csv");
+
+    cpuNs = benchCpuNs();
+    for(i = 0; i < BENCH_FORMAT_LINES; i++){
+        bytes += formatPrintf(line, &samples[i % n]);
+    }
+    row->value[colPrintf] = (double)(benchCpuNs() - cpuNs) / BENCH_FORMAT_LINES;
+
+    cpuNs = benchCpuNs();
+    for(i = 0; i < BENCH_FORMAT_LINES; i++){
+        bioFormatCsv(line, &samples[i % n], NULL);
+    }
+    row->value[colFormat] = (double)(benchCpuNs() - cpuNs) / BENCH_FORMAT_LINES;
+    row->value[colBytes] = (double)bytes / BENCH_FORMAT_LINES;
+
+    return benchMain(&table, argc, argv);
+}
@@ -0,0 +1,174 @@
+/**
+ * @file bench_hr.c
+ *
+ * @brief Accuracy and cost of the host heart rate engine (bio_hr.h)
+ *
+ * Two kinds of cases:
+ *
+ * - hub_50Hz: the simulated hub streams raw counts and its own algorithm output (SENSOR_AND_ALGORITHM, mode 2) at
+ *   50Hz through readSensorData(). The engine runs on the IR counts of the same samples and is compared with the
+ *   hub's heartRate once the hub reports 100% confidence
+ *
+ * - gen_<rate>Hz_<bpm>bpm: gap-free streams from max32664SimPpg() at rates the I2C transport cannot drain one
+ *   sample at a time, compared with the simulated heart rate (what the hub reports, without its slow drift).
+ *   The _noisy case raises the noise from 40 to 300 counts peak (a quarter of the pulse amplitude)
+ *
+ * Each case runs BENCH_HR_SECONDS. Rows report the mean and largest heart rate error once the engine has a value,
+ * the time until it first has one, the beats detected per minute and the host CPU time per sample.
+ *
+ * Usage: bench_hr [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "bio_hr.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_HR_SECONDS  60
+#define BENCH_HR_MAX_RATE 400
+
+static struct benchTable table;
+static uint8_t colMae, colMax, colSettle, colBeats, colNs;
+static uint32_t hrIr[BENCH_HR_SECONDS * BENCH_HR_MAX_RATE];
+static uint16_t hrRef[BENCH_HR_SECONDS * BENCH_HR_MAX_RATE]; //reference heart rate per sample, LSB = 0.1bpm, 0 = none
+
+
+/**
+ * @brief   Runs the engine over the collected samples and adds the row
+ */
+static void hrRun(const char *name, uint16_t sampleRate, uint32_t numSamples){
+    static struct bioHr hr;
+    struct benchRow *row;
+    double errSum = 0.0, errMax = 0.0;
+    uint32_t compared = 0, settle = 0, n;
+    uint64_t cpuNs;
+
+    bioHrInit(&hr, sampleRate);
+    cpuNs = benchCpuNs();
+    for(n = 0; n < numSamples; n++){
+        bioHrUpdate(&hr, hrIr[n]);
+        if(hr.heartRate != 0 && settle == 0){
+            settle = n;
+        }
+        if(hr.heartRate != 0 && hrRef[n] != 0){
+            double err = hr.heartRate > hrRef[n] ? (hr.heartRate - hrRef[n]) / 10.0 : (hrRef[n] - hr.heartRate) / 10.0;
+            errSum += err;
+            if(err > errMax) errMax = err;
+            compared++;
+        }
+    }
+    cpuNs = benchCpuNs() - cpuNs;
+
+    row = benchAddRow(&table, name);
+    row->value[colMae] = compared ? errSum / compared : 999.0;
+    row->value[colMax] = compared ? errMax : 999.0;
+    row->value[colSettle] = (double)settle / sampleRate;
+    row->value[colBeats] = hr.beats * 60.0 / BENCH_HR_SECONDS;
+    row->value[colNs] = (double)cpuNs / numSamples;
+}
+
+
+/**
+ * @brief   Streams raw and algorithm output at 50Hz from the simulated hub
+ *
+ * @return  Number of samples collected, 0 on a failure or an output FIFO overflow (the engine needs every sample)
+ */
+static uint32_t hrCollectHub(void){
+    struct max32664SimCounters counters;
+    struct bioData body;
+    I2C_Params params;
+    uint8_t status = SUCCESS;
+    uint8_t regVal;
+    uint32_t n = 0;
+
+    max32664SimInit(NULL);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    if(status != SUCCESS || configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1) != SUCCESS){
+        return 0;
+    }
+    regVal = readRegisterMAX30101(CONFIGURATION_REGISTER, &status); //50Hz: first entry of the sample rate table
+    if(status != SUCCESS || writeRegisterMAX30101(CONFIGURATION_REGISTER, regVal & SAMP_MASK) != SUCCESS){
+        return 0;
+    }
+    max32664SimResetCounters();
+
+    while(n < BENCH_HR_SECONDS * 50){
+        body = readSensorData(&status);
+        if(status == SUCCESS && body.irLed != 0){ //a sample was in the FIFO
+            hrIr[n] = body.irLed;
+            hrRef[n] = body.confidence == 100 ? body.heartRate * 10 : 0; //the library reports whole bpm
+            n++;
+        }
+        else{
+            usleep(1000);
+        }
+    }
+    max32664SimGetCounters(&counters);
+    return counters.samplesOverflowed == 0 ? n : 0;
+}
+
+
+/**
+ * @brief   Generates a gap-free stream
+ */
+static uint32_t hrCollectGen(uint16_t sampleRate, uint16_t heartRateX10, uint16_t noise){
+    struct max32664SimConfig cfg;
+    uint32_t red, n;
+
+    max32664SimDefaultConfig(&cfg);
+    cfg.heartRateX10 = heartRateX10;
+    cfg.noise = noise;
+    max32664SimInit(&cfg);
+
+    for(n = 0; n < (uint32_t)BENCH_HR_SECONDS * sampleRate; n++){
+        max32664SimPpg(n, sampleRate, &hrIr[n], &red);
+        hrRef[n] = heartRateX10;
+    }
+    return n;
+}
+
+
+int main(int argc, char **argv){
+    static const struct {
+        const char *name;
+        uint16_t sampleRate;
+        uint16_t heartRateX10;
+        uint16_t noise;
+    } genCases[] = {
+        {"gen_100Hz_72bpm", 100, 720, 40},
+        {"gen_400Hz_45bpm", 400, 450, 40},
+        {"gen_400Hz_72bpm", 400, 720, 40},
+        {"gen_400Hz_150bpm", 400, 1500, 40},
+        {"gen_400Hz_72bpm_noisy", 400, 720, 300},
+    };
+    uint32_t numSamples;
+    size_t c;
+
+    benchTableInit(&table);
+    colMae = benchAddColumn(&table, "mean_err_bpm", BENCH_LOWER_IS_BETTER);
+    colMax = benchAddColumn(&table, "max_err_bpm", BENCH_LOWER_IS_BETTER);
+    colSettle = benchAddColumn(&table, "settle_s", BENCH_LOWER_IS_BETTER);
+    colBeats = benchAddColumn(&table, "beats_per_min", BENCH_INFO);
+    colNs = benchAddColumn(&table, "cpu_ns_per_sample", BENCH_INFO);
+
+    numSamples = hrCollectHub();
+    if(numSamples == 0){
+        fprintf(stderr, "bench_hr: hub stream failed or dropped samples\n");
+        return 1;
+    }
+    hrRun("hub_50Hz", 50, numSamples);
+
+    for(c = 0; c < sizeof(genCases) / sizeof(genCases[0]); c++){
+        numSamples = hrCollectGen(genCases[c].sampleRate, genCases[c].heartRateX10, genCases[c].noise);
+        hrRun(genCases[c].name, genCases[c].sampleRate, numSamples);
+    }
+
+    return benchMain(&table, argc, argv);
+}
@@ -0,0 +1,189 @@
+/**
+ * @file bench_hrv.c
+ *
+ * @brief Accuracy and cost of the beat to beat interval stream (bio_hrv.h)
+ *
+ * Gap-free IR streams from max32664SimPpg() with respiratory sinus arrhythmia: the heart rate of 72bpm swings by
+ * rsaX10 with each breath (15 per minute), so consecutive intervals differ by tens of ms. The reference beat k is
+ * where max32664SimCardiacCycles() reaches k plus the average phase at which the engine places its beats, so the
+ * constant detection delay is not counted as an error. Cases gen_<rate>Hz_rsa<swing in bpm>, plus a steady rhythm
+ * (no swing, where all of the variability measured is detector jitter) and a _noisy case with 300 counts of noise.
+ *
+ * Each case runs BENCH_HRV_SECONDS. Rows report the mean and largest interval error, the mean RMSSD and SDNN errors
+ * against the same metrics over the reference intervals of the same window (full windows only), the beats missed or
+ * added, the artifacts flagged, the host CPU time per sample and how much smaller the event stream is than the
+ * 3 byte IR sample stream it replaces.
+ *
+ * Usage: bench_hrv [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "bio_hrv.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_HRV_SECONDS   120
+#define BENCH_HRV_MAX_RATE  400
+#define BENCH_HRV_MAX_BEATS (BENCH_HRV_SECONDS * 4) //up to 240bpm
+
+static struct benchTable table;
+static uint8_t colIbi, colIbiMax, colRmssd, colSdnn, colBeats, colArtifacts, colNs, colReduction;
+static uint32_t hrvIr[BENCH_HRV_SECONDS * BENCH_HRV_MAX_RATE];
+static double beatTime[BENCH_HRV_MAX_BEATS]; //detected beats, s
+static struct bioHrvBeat beatEvent[BENCH_HRV_MAX_BEATS];
+static double beatIbi[BENCH_HRV_MAX_BEATS]; //detected intervals, s
+static double refWindow[BENCH_HRV_MAX_BEATS]; //reference intervals entered in the engine window, s
+
+
+/**
+ * @brief   Time (s) at which the simulated cardiac cycles reach a value, by bisection around a guess
+ */
+static double hrvReferenceTime(double cycles, double guess){
+    double lo = guess - 1.0, hi = guess + 1.0;
+    int i;
+
+    for(i = 0; i < 50; i++){
+        double mid = (lo + hi) / 2.0;
+        if(max32664SimCardiacCycles(mid) < cycles){
+            lo = mid;
+        }
+        else{
+            hi = mid;
+        }
+    }
+    return (lo + hi) / 2.0;
+}
+
+
+/**
+ * @brief   RMSSD and SDNN (ms) of the last count reference intervals
+ */
+static void hrvReferenceMetrics(uint32_t end, uint32_t count, double *rmssd, double *sdnn){
+    double sum = 0.0, sumSquares = 0.0, diffSquares = 0.0, mean;
+    uint32_t i;
+
+    for(i = end - count; i < end; i++){
+        sum += refWindow[i];
+        if(i > end - count){
+            diffSquares += (refWindow[i] - refWindow[i - 1]) * (refWindow[i] - refWindow[i - 1]);
+        }
+    }
+    mean = sum / count;
+    for(i = end - count; i < end; i++){
+        sumSquares += (refWindow[i] - mean) * (refWindow[i] - mean);
+    }
+    *rmssd = sqrt(diffSquares / (count - 1)) * 1000.0;
+    *sdnn = sqrt(sumSquares / (count - 1)) * 1000.0;
+}
+
+
+/**
+ * @brief   Generates a stream, runs the engine over it and adds the row
+ */
+static void hrvCase(const char *name, uint16_t sampleRate, uint16_t rsaX10, uint16_t noise){
+    static struct bioHrv hrv;
+    struct max32664SimConfig cfg;
+    struct benchRow *row;
+    double sinSum = 0.0, cosSum = 0.0, phase, ibiSum = 0.0, ibiMax = 0.0, rmssdSum = 0.0, sdnnSum = 0.0;
+    double previousRef = 0.0;
+    uint32_t numSamples = (uint32_t)BENCH_HRV_SECONDS * sampleRate;
+    uint32_t beats = 0, compared = 0, windows = 0, refCount = 0, n, j;
+    int64_t previousK = 0, firstK = 0, lastK = 0;
+    uint64_t cpuNs;
+
+    max32664SimDefaultConfig(&cfg);
+    cfg.rsaX10 = rsaX10;
+    cfg.noise = noise;
+    max32664SimInit(&cfg);
+    for(n = 0; n < numSamples; n++){
+        uint32_t red;
+        max32664SimPpg(n, sampleRate, &hrvIr[n], &red);
+    }
+
+    bioHrvInit(&hrv, sampleRate);
+    cpuNs = benchCpuNs();
+    for(n = 0; n < numSamples; n++){
+        if(bioHrvUpdate(&hrv, hrvIr[n], &beatEvent[beats]) && beats < BENCH_HRV_MAX_BEATS){
+            beatTime[beats] = hrv.hr.lastBeatQ8 / 256.0 / sampleRate;
+            beatIbi[beats] = hrv.hr.lastRrQ8 / 256.0 / sampleRate;
+            beats++;
+        }
+    }
+    cpuNs = benchCpuNs() - cpuNs;
+
+    for(j = 0; j < beats; j++){ //average phase of the detected beats within a cycle
+        double c = max32664SimCardiacCycles(beatTime[j]);
+        sinSum += sin(2.0 * M_PI * c);
+        cosSum += cos(2.0 * M_PI * c);
+    }
+    phase = atan2(sinSum, cosSum) / (2.0 * M_PI);
+
+    for(j = 0; j < beats; j++){
+        int64_t k = (int64_t)floor(max32664SimCardiacCycles(beatTime[j]) - phase + 0.5);
+        double ref = hrvReferenceTime(k + phase, beatTime[j]);
+        double refIbi = ref - previousRef;
+        bool consecutive = j > 0 && k == previousK + 1;
+
+        if(j == 0) firstK = k;
+        lastK = k;
+
+        if(beatEvent[j].ibiMs != 0 && consecutive){
+            double err = fabs(beatIbi[j] - refIbi) * 1000.0;
+            ibiSum += err;
+            if(err > ibiMax) ibiMax = err;
+            compared++;
+        }
+
+        if(beatEvent[j].ibiMs == 0 || (beatEvent[j].artifact && beatEvent[j].intervals == 1)){ //window cleared
+            refCount = 0;
+        }
+        if(beatEvent[j].ibiMs != 0 && (!beatEvent[j].artifact || beatEvent[j].intervals == 1)){ //entered the window
+            refWindow[refCount++] = refIbi;
+        }
+        if(beatEvent[j].intervals == BIO_HRV_WINDOW && refCount >= BIO_HRV_WINDOW){
+            double rmssd, sdnn;
+            hrvReferenceMetrics(refCount, BIO_HRV_WINDOW, &rmssd, &sdnn);
+            rmssdSum += fabs(beatEvent[j].rmssdX10 / 10.0 - rmssd);
+            sdnnSum += fabs(beatEvent[j].sdnnX10 / 10.0 - sdnn);
+            windows++;
+        }
+
+        previousRef = ref;
+        previousK = k;
+    }
+
+    row = benchAddRow(&table, name);
+    row->value[colIbi] = compared ? ibiSum / compared : 999.0;
+    row->value[colIbiMax] = compared ? ibiMax : 999.0;
+    row->value[colRmssd] = windows ? rmssdSum / windows : 999.0;
+    row->value[colSdnn] = windows ? sdnnSum / windows : 999.0;
+    row->value[colBeats] = beats ? fabs((double)(lastK - firstK + 1) - beats) : 999.0;
+    row->value[colArtifacts] = hrv.artifacts;
+    row->value[colNs] = (double)cpuNs / numSamples;
+    row->value[colReduction] = beats ? (3.0 * numSamples) / ((double)sizeof(struct bioHrvBeat) * beats) : 0.0;
+}
+
+
+int main(int argc, char **argv){
+    benchTableInit(&table);
+    colIbi = benchAddColumn(&table, "mean_ibi_err_ms", BENCH_LOWER_IS_BETTER);
+    colIbiMax = benchAddColumn(&table, "max_ibi_err_ms", BENCH_LOWER_IS_BETTER);
+    colRmssd = benchAddColumn(&table, "rmssd_err_ms", BENCH_LOWER_IS_BETTER);
+    colSdnn = benchAddColumn(&table, "sdnn_err_ms", BENCH_LOWER_IS_BETTER);
+    colBeats = benchAddColumn(&table, "beats_missed_or_added", BENCH_LOWER_IS_BETTER);
+    colArtifacts = benchAddColumn(&table, "artifacts", BENCH_LOWER_IS_BETTER);
+    colNs = benchAddColumn(&table, "cpu_ns_per_sample", BENCH_INFO);
+    colReduction = benchAddColumn(&table, "stream_reduction", BENCH_INFO);
+
+    hrvCase("gen_50Hz_rsa6", 50, 60, 40);
+    hrvCase("gen_100Hz_rsa6", 100, 60, 40);
+    hrvCase("gen_400Hz_rsa6", 400, 60, 40);
+    hrvCase("gen_400Hz_steady", 400, 0, 40);
+    hrvCase("gen_400Hz_rsa6_noisy", 400, 60, 300);
+
+    return benchMain(&table, argc, argv);
+}
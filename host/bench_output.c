@@ -0,0 +1,197 @@
+/**
+ * @file bench_output.c
+ *
+ * @brief Streaming output benchmark: blocking UART writes against the double-buffered output stage (bio_uart_out.h)
+ *
+ * Replays the dataStream loop of bio_sensor_library_test.c (raw + algorithm data, mode 2) with every delivered sample
+ * sent on the simulated UART, either as the CSV line of the test program or as a bio_frame.h frame, and either with
+ * a blocking UART_write() (what Display_printf() does) or through bioUartOutReserve()/bioUartOutCommit(). Each case
+ * runs for BENCH_OUTPUT_SECONDS of simulated time after a one second warm-up and reports:
+ *
+ * - samples_per_s: samples read from the hub per second
+ *
+ * - fifo_dropped_per_s: samples lost to output FIFO overflow per second (acquisition fell behind)
+ *
+ * - sent_per_s: records handed to the UART per second
+ *
+ * - out_dropped_per_s: records dropped by the output stage per second (UART fell behind, backpressure)
+ *
+ * - uart_busy_pct: share of the time the UART was sending, for information only
+ *
+ * Usage: bench_output [--baud <rate>] [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ti/drivers/UART.h>
+
+#include "bio_sensor.h"
+#include "bio_frame.h"
+#include "bio_uart_out.h"
+#include "bio_format.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_OUTPUT_SECONDS   10  //measured simulated time per case
+#define BENCH_OUTPUT_CSV_LINE  BIO_FORMAT_CSV_MAX  //longest CSV line
+
+static const uint16_t outputRates[] = {50, 100, 200, 400}; //first MAX30101 sample rates, 400Hz is past what 115200 baud carries as CSV
+
+
+/**
+ * @brief   Brings the simulated hub up in raw + algorithm mode at the given sample rate
+ *
+ * @return  SUCCESS, or the status byte of the failing step
+ */
+static uint8_t outputBringUp(uint8_t rateIndex){
+    I2C_Params params;
+    uint8_t status = SUCCESS;
+    uint8_t regVal;
+
+    max32664SimInit(NULL);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    if(status != SUCCESS){
+        return status;
+    }
+    status = configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1);
+    if(status != SUCCESS){
+        return status;
+    }
+    regVal = readRegisterMAX30101(CONFIGURATION_REGISTER, &status); //set the sample rate bits
+    if(status != SUCCESS){
+        return status;
+    }
+    return writeRegisterMAX30101(CONFIGURATION_REGISTER, (regVal & SAMP_MASK) | (rateIndex << 2));
+}
+
+
+/**
+ * @brief   Formats a sample as the test program does, CSV line (bioFormatCsv()) or frame
+ *
+ * @return  Record size, bytes
+ */
+static uint16_t outputFormat(uint8_t *out, uint8_t frame, const struct bioData *body, uint16_t sequence){
+    if(frame){
+        return bioFrameEncode(out, sequence, body, 1);
+    }
+    return bioFormatCsv((char *)out, body, "\r\n");
+}
+
+
+int main(int argc, char **argv){
+    struct benchTable table;
+    uint8_t colRate, colFifo, colSent, colDrop, colBusy;
+    uint32_t baud = 115200;
+    uint8_t frame, buffered;
+    size_t r;
+    int i;
+
+    for(i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--baud") == 0 && i + 1 < argc){
+            baud = (uint32_t)atoi(argv[++i]);
+        }
+    }
+
+    benchTableInit(&table);
+    colRate = benchAddColumn(&table, "samples_per_s", BENCH_HIGHER_IS_BETTER);
+    colFifo = benchAddColumn(&table, "fifo_dropped_per_s", BENCH_LOWER_IS_BETTER);
+    colSent = benchAddColumn(&table, "sent_per_s", BENCH_HIGHER_IS_BETTER);
+    colDrop = benchAddColumn(&table, "out_dropped_per_s", BENCH_LOWER_IS_BETTER);
+    colBusy = benchAddColumn(&table, "uart_busy_pct", BENCH_INFO);
+
+    for(frame = 0; frame < 2; frame++){
+        for(buffered = 0; buffered < 2; buffered++){
+            for(r = 0; r < sizeof(outputRates) / sizeof(outputRates[0]); r++){
+                char name[BENCH_NAME_LEN];
+                struct benchRow *row;
+                struct max32664SimCounters start, end;
+                struct bioUartOutStats outStats;
+                UART_Handle uart;
+                UART_Params uartParams;
+                uint8_t record[BENCH_OUTPUT_CSV_LINE > BIO_FRAME_MAX_SIZE ? BENCH_OUTPUT_CSV_LINE : BIO_FRAME_MAX_SIZE];
+                uint32_t delivered = 0, sent = 0;
+                uint16_t sequence = 0;
+                uint64_t startUs, stopUs;
+                uint8_t status;
+
+                snprintf(name, sizeof(name), "%s_%s_%uHz", frame ? "frame" : "csv", buffered ? "buffered" : "blocking", outputRates[r]);
+                row = benchAddRow(&table, name);
+
+                if(outputBringUp((uint8_t)r) != SUCCESS){ //rates are the first entries of the MAX30101 rate table
+                    fprintf(stderr, "bench_output: %s: bring-up failed\n", name);
+                    return 1;
+                }
+
+                if(buffered){
+                    uart = bioUartOutOpen(CONFIG_UART_0, baud);
+                }
+                else{
+                    UART_init();
+                    UART_Params_init(&uartParams);
+                    uartParams.writeDataMode = UART_DATA_BINARY;
+                    uartParams.baudRate = baud;
+                    uart = UART_open(CONFIG_UART_0, &uartParams);
+                }
+                if(uart == NULL){
+                    fprintf(stderr, "bench_output: %s: UART open failed\n", name);
+                    return 1;
+                }
+                sleep(1); //warm-up: let the FIFO fill and the algorithm start
+
+                max32664SimGetCounters(&start);
+                bioUartOutResetStats();
+                startUs = max32664SimNowUs();
+                stopUs = startUs + BENCH_OUTPUT_SECONDS * 1000000ULL;
+
+                while(max32664SimNowUs() < stopUs){
+                    struct max32664SimCounters now;
+                    struct bioData body;
+                    uint32_t before;
+
+                    max32664SimGetCounters(&now);
+                    before = now.samplesRead;
+                    body = readSensorData(&status);
+                    max32664SimGetCounters(&now);
+                    if(status != SUCCESS || now.samplesRead == before){ //no sample delivered
+                        continue;
+                    }
+                    delivered++;
+
+                    if(buffered){ //format in place, the UART sends the other buffer meanwhile
+                        uint8_t *out = bioUartOutReserve(sizeof(record));
+                        if(out){
+                            bioUartOutCommit(outputFormat(out, frame, &body, sequence));
+                        }
+                    }
+                    else{
+                        UART_write(uart, record, outputFormat(record, frame, &body, sequence));
+                        sent++;
+                    }
+                    sequence++;
+                }
+
+                max32664SimGetCounters(&end);
+                bioUartOutGetStats(&outStats);
+                if(buffered){
+                    sent = outStats.recordsQueued;
+                    bioUartOutClose();
+                }
+                else{
+                    UART_close(uart);
+                }
+
+                row->value[colRate] = delivered * 1000000.0 / (stopUs - startUs);
+                row->value[colFifo] = (end.samplesOverflowed - start.samplesOverflowed) * 1000000.0 / (stopUs - startUs);
+                row->value[colSent] = sent * 1000000.0 / (stopUs - startUs);
+                row->value[colDrop] = buffered ? outStats.recordsDropped * 1000000.0 / (stopUs - startUs) : 0.0;
+                row->value[colBusy] = (end.uartBusyUs - start.uartBusyUs) * 100.0 / (stopUs - startUs);
+            }
+        }
+    }
+
+    return benchMain(&table, argc, argv);
+}
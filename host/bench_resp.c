@@ -0,0 +1,116 @@
+/**
+ * @file bench_resp.c
+ *
+ * @brief Accuracy and cost of the respiratory rate estimator (bio_resp.h)
+ *
+ * Gap-free IR streams from max32664SimPpg(), whose respiration moves the baseline by 0.3% and the pulse amplitude
+ * by 15% at respRateX10. Cases gen_<rate>Hz_resp<breaths/min> at a heart rate of 72bpm, a _noisy case with 300
+ * counts of noise and a case with a slow heart rate of 50bpm, whose pulse is close to the respiratory band.
+ *
+ * Each case runs BENCH_RESP_SECONDS. Rows report the mean and largest error of the fused rate over the updates
+ * that have one, the mean error of the baseline (BM) and amplitude (AM) modulation rates on their own, the time
+ * until the first rate and the host CPU time per sample.
+ *
+ * Usage: bench_resp [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio_resp.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_RESP_SECONDS  180
+#define BENCH_RESP_MAX_RATE 400
+
+static struct benchTable table;
+static uint8_t colMae, colMax, colBm, colAm, colSettle, colNs;
+static uint32_t respIr[BENCH_RESP_SECONDS * BENCH_RESP_MAX_RATE];
+
+
+/**
+ * @brief   Absolute difference of two rates, breaths/min
+ */
+static double respError(uint16_t rateX10, uint16_t referenceX10){
+    return (rateX10 > referenceX10 ? rateX10 - referenceX10 : referenceX10 - rateX10) / 10.0;
+}
+
+
+/**
+ * @brief   Generates a stream, runs the estimator over it and adds the row
+ */
+static void respCase(const char *name, uint16_t sampleRate, uint16_t respRateX10, uint16_t heartRateX10, uint16_t noise){
+    static struct bioResp resp;
+    struct max32664SimConfig cfg;
+    struct benchRow *row;
+    double errSum = 0.0, errMax = 0.0, bmSum = 0.0, amSum = 0.0;
+    uint32_t numSamples = (uint32_t)BENCH_RESP_SECONDS * sampleRate;
+    uint32_t compared = 0, bmCompared = 0, amCompared = 0, settle = 0, n;
+    uint64_t cpuNs;
+
+    max32664SimDefaultConfig(&cfg);
+    cfg.respRateX10 = respRateX10;
+    cfg.heartRateX10 = heartRateX10;
+    cfg.noise = noise;
+    max32664SimInit(&cfg);
+    for(n = 0; n < numSamples; n++){
+        uint32_t red;
+        max32664SimPpg(n, sampleRate, &respIr[n], &red);
+    }
+
+    bioRespInit(&resp, sampleRate);
+    cpuNs = benchCpuNs();
+    for(n = 0; n < numSamples; n++){
+        if(bioRespUpdate(&resp, respIr[n])){
+            if(resp.rateX10 != 0){
+                double err = respError(resp.rateX10, respRateX10);
+                if(compared == 0){
+                    settle = n;
+                }
+                errSum += err;
+                if(err > errMax) errMax = err;
+                compared++;
+            }
+            if(resp.bm.rateX10 != 0){
+                bmSum += respError(resp.bm.rateX10, respRateX10);
+                bmCompared++;
+            }
+            if(resp.am.rateX10 != 0){
+                amSum += respError(resp.am.rateX10, respRateX10);
+                amCompared++;
+            }
+        }
+    }
+    cpuNs = benchCpuNs() - cpuNs;
+
+    row = benchAddRow(&table, name);
+    row->value[colMae] = compared ? errSum / compared : 999.0;
+    row->value[colMax] = compared ? errMax : 999.0;
+    row->value[colBm] = bmCompared ? bmSum / bmCompared : 999.0;
+    row->value[colAm] = amCompared ? amSum / amCompared : 999.0;
+    row->value[colSettle] = (double)settle / sampleRate;
+    row->value[colNs] = (double)cpuNs / numSamples;
+}
+
+
+int main(int argc, char **argv){
+    benchTableInit(&table);
+    colMae = benchAddColumn(&table, "mean_err_brpm", BENCH_LOWER_IS_BETTER);
+    colMax = benchAddColumn(&table, "max_err_brpm", BENCH_LOWER_IS_BETTER);
+    colBm = benchAddColumn(&table, "bm_err_brpm", BENCH_LOWER_IS_BETTER);
+    colAm = benchAddColumn(&table, "am_err_brpm", BENCH_LOWER_IS_BETTER);
+    colSettle = benchAddColumn(&table, "settle_s", BENCH_LOWER_IS_BETTER);
+    colNs = benchAddColumn(&table, "cpu_ns_per_sample", BENCH_INFO);
+
+    respCase("gen_50Hz_resp15", 50, 150, 720, 40);
+    respCase("gen_100Hz_resp6", 100, 60, 720, 40);
+    respCase("gen_100Hz_resp24", 100, 240, 720, 40);
+    respCase("gen_400Hz_resp15", 400, 150, 720, 40);
+    respCase("gen_400Hz_resp30", 400, 300, 720, 40);
+    respCase("gen_400Hz_resp15_noisy", 400, 150, 720, 300);
+    respCase("gen_400Hz_resp15_hr50", 400, 150, 500, 40);
+
+    return benchMain(&table, argc, argv);
+}
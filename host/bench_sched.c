@@ -0,0 +1,240 @@
+/**
+ * @file bench_sched.c
+ *
+ * @brief Telemetry scheduling benchmark: the per-iteration query loop of the test program against bio_sched.h
+ *
+ * Streams raw + algorithm data (mode 2) from the simulated hub while also keeping the identity and configuration
+ * telemetry of bio_sensor_library_test.c fresh (versions, MCU type, ADC rate and range, pulse width, LED currents,
+ * MAX30101 mode, algorithm parameters). Cases:
+ *
+ * - drain_only: readSensorData() in a loop, no telemetry (reference)
+ *
+ * - query_loop: every query after every readSensorData(), as the test program loop does
+ *
+ * - sched_gap: bioSchedStep() with the queries once a second, run only in free gaps between drains (slack 0)
+ *
+ * - sched_slack: as sched_gap, but a query may make a drain up to BENCH_SCHED_SLACK_PERIODS sample periods late
+ *   (the output FIFO holds 64)
+ *
+ * - sched_batch: as sched_slack, but each drain is a readSensorDataBatch() of the whole output FIFO, every
+ *   BENCH_SCHED_BATCH_PERIODS sample periods
+ *
+ * The cases run at 50Hz, sched_slack and sched_batch also at the default 100Hz, where one readSensorData() per
+ * sample period cannot keep up. Each runs for BENCH_SCHED_SECONDS of simulated time after a warm-up of
+ * BENCH_SCHED_WARMUP_SAMPLES sample periods and reports:
+ *
+ * - samples_per_s: samples read from the hub per second
+ *
+ * - fifo_dropped_per_s: samples lost to output FIFO overflow per second
+ *
+ * - queries_per_s: telemetry queries run per second, for information only
+ *
+ * - telemetry_age_ms: oldest any telemetry value got during the run (0 when never refreshed after the start)
+ *
+ * Usage: bench_sched [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "bio_sched.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_SCHED_SECONDS         10  //measured simulated time per case
+#define BENCH_SCHED_WARMUP_SAMPLES  50  //samples in the FIFO at the start, short of overflowing its 64
+#define BENCH_SCHED_BATCH_PERIODS   8   //sample periods between batch drains
+#define BENCH_SCHED_BATCH_SIZE      16  //most samples a batch drain reads
+#define BENCH_SCHED_QUERY_MS        1000 //telemetry period of the scheduled cases
+#define BENCH_SCHED_SLACK_PERIODS   8   //drain lateness allowed in the sched_slack case, sample periods
+#define BENCH_SCHED_NUM_QUERIES     (sizeof(schedQueries) / sizeof(schedQueries[0]))
+
+static uint32_t schedLastRunUs[16]; //last refresh of each query
+static uint32_t schedMaxAgeUs; //oldest a value got
+static uint32_t schedQueryRuns;
+static uint32_t schedDrained; //samples read
+
+
+/**
+ * @brief   Records a query refresh and the age of the value it replaced
+ */
+static uint8_t schedRefreshed(uint8_t index, uint8_t status){
+    uint32_t now = bioGetTimeUs();
+
+    if(now - schedLastRunUs[index] > schedMaxAgeUs){
+        schedMaxAgeUs = now - schedLastRunUs[index];
+    }
+    schedLastRunUs[index] = now;
+    schedQueryRuns++;
+    return status;
+}
+
+static uint8_t schedHubVersion(void *arg){ uint8_t s; (void)arg; readSensorHubVersion(&s); return schedRefreshed(0, s); }
+static uint8_t schedAlgoVersion(void *arg){ uint8_t s; (void)arg; readAlgorithmVersion(&s); return schedRefreshed(1, s); }
+static uint8_t schedBootVersion(void *arg){ uint8_t s; (void)arg; readBootloaderVersion(&s); return schedRefreshed(2, s); }
+static uint8_t schedMcuType(void *arg){ uint8_t s; (void)arg; getMcuType(&s); return schedRefreshed(3, s); }
+static uint8_t schedAdcRate(void *arg){ uint8_t s; (void)arg; readADCSampleRate(&s); return schedRefreshed(4, s); }
+static uint8_t schedAdcRange(void *arg){ uint8_t s; (void)arg; readADCRange(&s); return schedRefreshed(5, s); }
+static uint8_t schedPulseWidth(void *arg){ uint8_t s; (void)arg; readPulseWidth(&s); return schedRefreshed(6, s); }
+static uint8_t schedPulseAmp(void *arg){ uint8_t s, led[4]; (void)arg; readPulseAmp(led, &s); return schedRefreshed(7, s); }
+static uint8_t schedMax30101Mode(void *arg){ uint8_t s; (void)arg; readMAX30101Mode(&s); return schedRefreshed(8, s); }
+static uint8_t schedAlgoRange(void *arg){ uint8_t s; (void)arg; readAlgoRange(&s); return schedRefreshed(9, s); }
+static uint8_t schedAlgoStep(void *arg){ uint8_t s; (void)arg; readAlgoStepSize(&s); return schedRefreshed(10, s); }
+static uint8_t schedAlgoSensitivity(void *arg){ uint8_t s; (void)arg; readAlgoSensitivity(&s); return schedRefreshed(11, s); }
+static uint8_t schedAlgoRate(void *arg){ uint8_t s; (void)arg; readAlgoSampleRate(&s); return schedRefreshed(12, s); }
+
+static const bioSchedFxn schedQueries[] = {schedHubVersion, schedAlgoVersion, schedBootVersion, schedMcuType,
+        schedAdcRate, schedAdcRange, schedPulseWidth, schedPulseAmp, schedMax30101Mode, schedAlgoRange, schedAlgoStep,
+        schedAlgoSensitivity, schedAlgoRate};
+
+
+/**
+ * @brief   Drain: one readSensorData()
+ */
+static uint8_t schedDrain(void *arg){
+    struct max32664SimCounters before, after;
+    uint8_t status;
+
+    (void)arg;
+    max32664SimGetCounters(&before);
+    readSensorData(&status);
+    max32664SimGetCounters(&after);
+    schedDrained += after.samplesRead - before.samplesRead;
+    return status;
+}
+
+
+/**
+ * @brief   Drain: one readSensorDataBatch() of the whole output FIFO
+ */
+static uint8_t schedDrainBatch(void *arg){
+    static struct bioData body[BENCH_SCHED_BATCH_SIZE];
+    uint8_t status;
+
+    (void)arg;
+    schedDrained += readSensorDataBatch(body, BENCH_SCHED_BATCH_SIZE, &status);
+    return status;
+}
+
+
+/**
+ * @brief   Brings the simulated hub up in raw + algorithm mode
+ *
+ * @param   rateIndex Sample rate, index in the MAX30101 sample rate table (0: 50Hz, 1: 100Hz)
+ *
+ * @return  SUCCESS, or the status byte of the failing step
+ */
+static uint8_t schedBringUp(uint8_t rateIndex){
+    I2C_Params params;
+    uint8_t status = SUCCESS;
+    uint8_t regVal;
+
+    max32664SimInit(NULL);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    if(status != SUCCESS){
+        return status;
+    }
+    status = configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1);
+    if(status != SUCCESS){
+        return status;
+    }
+    regVal = readRegisterMAX30101(CONFIGURATION_REGISTER, &status);
+    if(status != SUCCESS){
+        return status;
+    }
+    return writeRegisterMAX30101(CONFIGURATION_REGISTER, (regVal & SAMP_MASK) | (rateIndex << 2));
+}
+
+
+int main(int argc, char **argv){
+    static const struct {
+        const char *name;
+        uint8_t mode; //0 drain_only, 1 query_loop, 2 sched_gap, 3 sched_slack, 4 sched_batch
+        uint8_t rateIndex;
+        uint16_t rateHz;
+    } cases[] = {
+        {"drain_only", 0, 0, 50}, {"query_loop", 1, 0, 50}, {"sched_gap", 2, 0, 50}, {"sched_slack", 3, 0, 50},
+        {"sched_batch", 4, 0, 50}, {"sched_slack", 3, 1, 100}, {"sched_batch", 4, 1, 100},
+    };
+    struct benchTable table;
+    uint8_t colRate, colFifo, colQueries, colAge;
+    uint8_t c;
+
+    benchTableInit(&table);
+    colRate = benchAddColumn(&table, "samples_per_s", BENCH_HIGHER_IS_BETTER);
+    colFifo = benchAddColumn(&table, "fifo_dropped_per_s", BENCH_LOWER_IS_BETTER);
+    colQueries = benchAddColumn(&table, "queries_per_s", BENCH_INFO);
+    colAge = benchAddColumn(&table, "telemetry_age_ms", BENCH_LOWER_IS_BETTER);
+
+    for(c = 0; c < sizeof(cases) / sizeof(cases[0]); c++){
+        char name[BENCH_NAME_LEN];
+        struct benchRow *row;
+        struct max32664SimCounters start, end;
+        struct bioSched sched;
+        uint32_t periodUs = 1000000UL / cases[c].rateHz;
+        uint8_t mode = cases[c].mode;
+        uint64_t startUs, stopUs;
+        uint8_t q;
+
+        snprintf(name, sizeof(name), "%s_%uHz", cases[c].name, cases[c].rateHz);
+        row = benchAddRow(&table, name);
+
+        if(schedBringUp(cases[c].rateIndex) != SUCCESS){
+            fprintf(stderr, "bench_sched: %s: bring-up failed\n", name);
+            return 1;
+        }
+        usleep(BENCH_SCHED_WARMUP_SAMPLES * periodUs); //warm-up: let the FIFO fill and the algorithm start
+
+        if(mode == 4){
+            bioSchedInit(&sched, schedDrainBatch, NULL, BENCH_SCHED_BATCH_PERIODS * periodUs, BENCH_SCHED_SLACK_PERIODS * periodUs);
+        }
+        else{
+            bioSchedInit(&sched, schedDrain, NULL, periodUs, mode == 3 ? BENCH_SCHED_SLACK_PERIODS * periodUs : 0);
+        }
+        if(mode >= 2){
+            for(q = 0; q < BENCH_SCHED_NUM_QUERIES; q++){
+                bioSchedAdd(&sched, schedQueries[q], NULL, BENCH_SCHED_QUERY_MS, 0);
+            }
+        }
+
+        max32664SimGetCounters(&start);
+        startUs = max32664SimNowUs();
+        stopUs = startUs + BENCH_SCHED_SECONDS * 1000000ULL;
+        for(q = 0; q < BENCH_SCHED_NUM_QUERIES; q++){
+            schedLastRunUs[q] = bioGetTimeUs();
+        }
+        schedMaxAgeUs = 0;
+        schedQueryRuns = 0;
+        schedDrained = 0;
+
+        while(max32664SimNowUs() < stopUs){
+            if(mode >= 2){
+                bioSchedStep(&sched);
+                continue;
+            }
+            schedDrain(NULL);
+            if(mode == 1){
+                for(q = 0; q < BENCH_SCHED_NUM_QUERIES; q++){
+                    schedQueries[q](NULL);
+                }
+            }
+        }
+
+        for(q = 0; q < BENCH_SCHED_NUM_QUERIES; q++){ //values never refreshed age until the end
+            schedRefreshed(q, SUCCESS);
+        }
+        max32664SimGetCounters(&end);
+
+        row->value[colRate] = schedDrained * 1000000.0 / (stopUs - startUs);
+        row->value[colFifo] = (end.samplesOverflowed - start.samplesOverflowed) * 1000000.0 / (stopUs - startUs);
+        row->value[colQueries] = (schedQueryRuns - BENCH_SCHED_NUM_QUERIES) * 1000000.0 / (stopUs - startUs);
+        row->value[colAge] = mode == 0 ? 0.0 : schedMaxAgeUs / 1000.0;
+    }
+
+    return benchMain(&table, argc, argv);
+}
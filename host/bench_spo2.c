@@ -0,0 +1,226 @@
+/**
+ * @file bench_spo2.c
+ *
+ * @brief Accuracy and cost of the host SpO2 engine (bio_spo2.h)
+ *
+ * The calibration is read from the simulated hub with readMaximFastCoef(), and the reference SpO2 is that
+ * calibration applied to the simulated ratio of ratios. Cases:
+ *
+ * - hub_whrm_50Hz: the hub's own SpO2 and R value (SENSOR_AND_ALGORITHM, mode 2) read through readSensorData() at
+ *   50Hz, once the hub reports 100% confidence. The library reports SpO2 in whole percent and R in steps of 0.1
+ *
+ * - engine_50Hz: the engine on the IR and red counts of the same samples
+ *
+ * - gen_<rate>Hz_r<R * 1000>: the engine on gap-free streams from max32664SimPpg() at rates the I2C transport
+ *   cannot drain one sample at a time. The _noisy case raises the noise from 40 to 300 counts peak
+ *
+ * Each case runs BENCH_SPO2_SECONDS. Rows report the mean and largest SpO2 error and the mean R error over the
+ * values output, the time until the first value and the host CPU time per sample.
+ *
+ * Usage: bench_spo2 [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "bio_spo2.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_SPO2_SECONDS  60
+#define BENCH_SPO2_MAX_RATE 400
+
+static struct benchTable table;
+static uint8_t colMae, colMax, colR, colSettle, colNs;
+static int32_t coef[NUM_MAXIM_FAST_COEF];
+static uint32_t spo2Ir[BENCH_SPO2_SECONDS * BENCH_SPO2_MAX_RATE];
+static uint32_t spo2Red[BENCH_SPO2_SECONDS * BENCH_SPO2_MAX_RATE];
+
+
+/**
+ * @brief   Reference SpO2 (%) of a ratio of ratios with the hub's calibration
+ */
+static double spo2Reference(uint16_t rValueX1000){
+    double r = rValueX1000 / 1000.0;
+
+    return (coef[0] * r * r + coef[1] * r + coef[2]) / 100000.0;
+}
+
+
+/**
+ * @brief   Accumulates the error of one value
+ */
+static void spo2Error(double oxygen, double r, uint16_t rValueX1000, double *errSum, double *errMax, double *rSum){
+    double err = oxygen - spo2Reference(rValueX1000);
+    double rErr = r * 1000.0 - rValueX1000;
+
+    if(err < 0) err = -err;
+    if(rErr < 0) rErr = -rErr;
+    *errSum += err;
+    *rSum += rErr;
+    if(err > *errMax) *errMax = err;
+}
+
+
+/**
+ * @brief   Adds a row
+ */
+static void spo2Row(const char *name, uint32_t compared, double errSum, double errMax, double rSum, double settle,
+                    double nsPerSample){
+    struct benchRow *row = benchAddRow(&table, name);
+
+    row->value[colMae] = compared ? errSum / compared : 999.0;
+    row->value[colMax] = compared ? errMax : 999.0;
+    row->value[colR] = compared ? rSum / compared : 999.0;
+    row->value[colSettle] = settle;
+    row->value[colNs] = nsPerSample;
+}
+
+
+/**
+ * @brief   Runs the engine over the collected samples and adds the row
+ */
+static void spo2Run(const char *name, uint16_t sampleRate, uint16_t rValueX1000, uint32_t numSamples){
+    static struct bioSpo2 spo2;
+    double errSum = 0.0, errMax = 0.0, rSum = 0.0;
+    uint32_t compared = 0, settle = 0, n;
+    uint64_t cpuNs;
+
+    bioSpo2Init(&spo2, sampleRate, coef);
+    cpuNs = benchCpuNs();
+    for(n = 0; n < numSamples; n++){
+        if(bioSpo2Update(&spo2, spo2Ir[n], spo2Red[n]) && spo2.oxygen != 0){
+            if(compared == 0){
+                settle = n;
+            }
+            spo2Error(spo2.oxygen / 10.0, spo2.rValue / 65536.0, rValueX1000, &errSum, &errMax, &rSum);
+            compared++;
+        }
+    }
+    cpuNs = benchCpuNs() - cpuNs;
+
+    spo2Row(name, compared, errSum, errMax, rSum, (double)settle / sampleRate, (double)cpuNs / numSamples);
+}
+
+
+/**
+ * @brief   Reads the calibration and streams raw and algorithm output at 50Hz from the simulated hub. Adds the row of
+ *          the hub's own output
+ *
+ * @return  Number of samples collected, 0 on a failure or an output FIFO overflow (the engine needs every sample)
+ */
+static uint32_t spo2CollectHub(void){
+    struct max32664SimConfig cfg;
+    struct max32664SimCounters counters;
+    struct bioData body;
+    I2C_Params params;
+    double errSum = 0.0, errMax = 0.0, rSum = 0.0;
+    uint32_t compared = 0, settle = 0;
+    uint8_t status = SUCCESS;
+    uint8_t regVal;
+    uint32_t n = 0;
+
+    max32664SimDefaultConfig(&cfg);
+    max32664SimInit(&cfg);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    if(status != SUCCESS || readMaximFastCoef(coef) != SUCCESS
+            || configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1) != SUCCESS){
+        return 0;
+    }
+    regVal = readRegisterMAX30101(CONFIGURATION_REGISTER, &status); //50Hz: first entry of the sample rate table
+    if(status != SUCCESS || writeRegisterMAX30101(CONFIGURATION_REGISTER, regVal & SAMP_MASK) != SUCCESS){
+        return 0;
+    }
+    max32664SimResetCounters();
+
+    while(n < BENCH_SPO2_SECONDS * 50){
+        body = readSensorData(&status);
+        if(status == SUCCESS && body.irLed != 0){ //a sample was in the FIFO
+            spo2Ir[n] = body.irLed;
+            spo2Red[n] = body.redLed;
+            if(body.confidence == 100){
+                if(compared == 0){
+                    settle = n;
+                }
+                spo2Error(body.oxygen, body.rValue, cfg.rValueX1000, &errSum, &errMax, &rSum);
+                compared++;
+            }
+            n++;
+        }
+        else{
+            usleep(1000);
+        }
+    }
+    max32664SimGetCounters(&counters);
+    if(counters.samplesOverflowed != 0){
+        return 0;
+    }
+
+    spo2Row("hub_whrm_50Hz", compared, errSum, errMax, rSum, settle / 50.0, 0.0);
+    return n;
+}
+
+
+/**
+ * @brief   Generates a gap-free stream
+ */
+static uint32_t spo2CollectGen(uint16_t sampleRate, uint16_t rValueX1000, uint16_t noise){
+    struct max32664SimConfig cfg;
+    uint32_t n;
+
+    max32664SimDefaultConfig(&cfg);
+    cfg.rValueX1000 = rValueX1000;
+    cfg.noise = noise;
+    max32664SimInit(&cfg);
+
+    for(n = 0; n < (uint32_t)BENCH_SPO2_SECONDS * sampleRate; n++){
+        max32664SimPpg(n, sampleRate, &spo2Ir[n], &spo2Red[n]);
+    }
+    return n;
+}
+
+
+int main(int argc, char **argv){
+    static const struct {
+        const char *name;
+        uint16_t sampleRate;
+        uint16_t rValueX1000;
+        uint16_t noise;
+    } genCases[] = {
+        {"gen_100Hz_r500", 100, 500, 40},
+        {"gen_400Hz_r400", 400, 400, 40},
+        {"gen_400Hz_r500", 400, 500, 40},
+        {"gen_400Hz_r700", 400, 700, 40},
+        {"gen_400Hz_r500_noisy", 400, 500, 300},
+    };
+    struct max32664SimConfig cfg;
+    uint32_t numSamples;
+    size_t c;
+
+    benchTableInit(&table);
+    colMae = benchAddColumn(&table, "mean_err_pct", BENCH_LOWER_IS_BETTER);
+    colMax = benchAddColumn(&table, "max_err_pct", BENCH_LOWER_IS_BETTER);
+    colR = benchAddColumn(&table, "mean_r_err_x1000", BENCH_LOWER_IS_BETTER);
+    colSettle = benchAddColumn(&table, "settle_s", BENCH_LOWER_IS_BETTER);
+    colNs = benchAddColumn(&table, "cpu_ns_per_sample", BENCH_INFO);
+
+    numSamples = spo2CollectHub();
+    if(numSamples == 0){
+        fprintf(stderr, "bench_spo2: hub stream failed or dropped samples\n");
+        return 1;
+    }
+    max32664SimDefaultConfig(&cfg);
+    spo2Run("engine_50Hz", 50, cfg.rValueX1000, numSamples);
+
+    for(c = 0; c < sizeof(genCases) / sizeof(genCases[0]); c++){
+        numSamples = spo2CollectGen(genCases[c].sampleRate, genCases[c].rValueX1000, genCases[c].noise);
+        spo2Run(genCases[c].name, genCases[c].sampleRate, genCases[c].rValueX1000, numSamples);
+    }
+
+    return benchMain(&table, argc, argv);
+}
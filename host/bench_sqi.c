@@ -0,0 +1,237 @@
+/**
+ * @file bench_sqi.c
+ *
+ * @brief Classification and cost of the signal quality index (bio_sqi.h)
+ *
+ * Each case runs BENCH_SQI_SECONDS and is either usable throughout or garbage throughout:
+ *
+ * - gen_<rate>Hz_<kind>: gap-free streams from max32664SimPpg(). clean and noisy (300 counts peak, a quarter of the
+ *   pulse amplitude) are usable. buried (noise at 2.5 times the pulse amplitude), low_perfusion (a 0.05% pulse),
+ *   clipped (the DC at 99.5% of full scale), motion (1500 count swings at 0.9 and 2.3Hz), pressure (the DC wandering
+ *   by 6000 counts at 0.2Hz) and no_finger (ambient light only) are garbage
+ *
+ * - hub_50Hz_gated / _ungated: the simulated hub streams raw counts and its algorithm output (SENSOR_AND_ALGORITHM,
+ *   mode 2) at 50Hz through readSensorData(), with the ADC range read by readADCRange(). The hub reports device
+ *   motion (extStatus -2) from 20 to 40 s without any change to the counts, so those windows are garbage and only
+ *   bioSqiHubStatus() can tell. The ungated row leaves it out
+ *
+ * Rows report the windows put on the wrong side of BIO_SQI_USABLE after the first BENCH_SQI_SETTLE_S, the windows
+ * usable, the mean score, the time to the first usable window, the host CPU time per sample and the state size.
+ *
+ * Usage: bench_sqi [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "bio_sensor.h"
+#include "bio_sqi.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_SQI_SECONDS   60
+#define BENCH_SQI_MAX_RATE  400
+#define BENCH_SQI_SETTLE_S  6     //windows ending before this are not classified (detector and template warm up)
+#define BENCH_SQI_ADC_RANGE 16384 //the simulator's default configuration register, nA
+#define BENCH_SQI_MOTION_S  20    //hub motion from, s
+#define BENCH_SQI_MOTION_E  40    //hub motion to, s
+
+#define SQI_SAMPLES  (BENCH_SQI_SECONDS * BENCH_SQI_MAX_RATE)
+
+enum sqiKind {SQI_CLEAN, SQI_NOISY, SQI_BURIED, SQI_LOW_PERFUSION, SQI_CLIPPED, SQI_MOTION, SQI_PRESSURE, SQI_NO_FINGER};
+
+static struct benchTable table;
+static uint8_t colWrong, colUsable, colScore, colFirst, colNs, colState;
+static uint32_t sqiIr[SQI_SAMPLES], sqiRed[SQI_SAMPLES];
+static uint8_t sqiStatus[SQI_SAMPLES];
+static int8_t sqiExt[SQI_SAMPLES];
+static bool sqiGarbage[SQI_SAMPLES]; //expected class of the sample
+
+
+static uint32_t sqiClip(double v){
+    if(v < 0.0) return 0;
+    if(v > 0x3FFFF) return 0x3FFFF;
+    return (uint32_t)v;
+}
+
+
+/**
+ * @brief   Runs the engine over the collected samples and adds the row
+ */
+static void sqiRun(const char *name, uint16_t sampleRate, uint32_t numSamples, bool gated){
+    static struct bioSqi sqi;
+    struct benchRow *row;
+    uint32_t windows = 0, classified = 0, wrong = 0, usable = 0, scoreSum = 0, first = 0, n;
+    bool garbage = false;
+    uint64_t cpuNs;
+
+    bioSqiInit(&sqi, sampleRate, BENCH_SQI_ADC_RANGE);
+    cpuNs = benchCpuNs();
+    for(n = 0; n < numSamples; n++){
+        garbage |= sqiGarbage[n];
+        if(gated){
+            bioSqiHubStatus(&sqi, sqiStatus[n], sqiExt[n]);
+        }
+        if(bioSqiUpdate(&sqi, sqiIr[n], sqiRed[n])){
+            bool isUsable = sqi.window.score >= BIO_SQI_USABLE;
+            windows++;
+            scoreSum += sqi.window.score;
+            if(isUsable){
+                usable++;
+                if(first == 0){
+                    first = n + 1;
+                }
+            }
+            if(n + 1 >= (uint32_t)BENCH_SQI_SETTLE_S * sampleRate){
+                classified++;
+                if(isUsable == garbage){
+                    wrong++;
+                }
+            }
+            garbage = false;
+        }
+    }
+    cpuNs = benchCpuNs() - cpuNs;
+
+    row = benchAddRow(&table, name);
+    row->value[colWrong] = classified ? 100.0 * wrong / classified : 100.0;
+    row->value[colUsable] = windows ? 100.0 * usable / windows : 0.0;
+    row->value[colScore] = windows ? (double)scoreSum / windows : 0.0;
+    row->value[colFirst] = first ? (double)first / sampleRate : 0.0;
+    row->value[colNs] = (double)cpuNs / numSamples;
+    row->value[colState] = sizeof(sqi);
+}
+
+
+/**
+ * @brief   Generates a gap-free stream of a kind
+ */
+static uint32_t sqiCollectGen(uint16_t sampleRate, enum sqiKind kind){
+    struct max32664SimConfig cfg;
+    uint32_t n, numSamples = (uint32_t)BENCH_SQI_SECONDS * sampleRate;
+
+    max32664SimDefaultConfig(&cfg);
+    if(kind == SQI_NOISY) cfg.noise = 300;
+    if(kind == SQI_BURIED) cfg.noise = 3000;
+    if(kind == SQI_LOW_PERFUSION) cfg.irAc = 60;
+    if(kind == SQI_CLIPPED) cfg.irDc = 0x3FFFF * 995 / 1000;
+    max32664SimInit(&cfg);
+    max32664SimSetFinger(kind != SQI_NO_FINGER);
+
+    for(n = 0; n < numSamples; n++){
+        double t = (double)n / sampleRate;
+        double offset = 0.0;
+
+        max32664SimPpg(n, sampleRate, &sqiIr[n], &sqiRed[n]);
+        if(kind == SQI_MOTION){
+            offset = 1500.0 * sin(2.0 * M_PI * 0.9 * t) + 1500.0 * sin(2.0 * M_PI * 2.3 * t + 1.0);
+        }
+        else if(kind == SQI_PRESSURE){
+            offset = 6000.0 * sin(2.0 * M_PI * 0.2 * t);
+        }
+        sqiIr[n] = sqiClip(sqiIr[n] + offset);
+        sqiRed[n] = sqiClip(sqiRed[n] + offset * 0.8);
+        sqiStatus[n] = 3;
+        sqiExt[n] = 0;
+        sqiGarbage[n] = kind != SQI_CLEAN && kind != SQI_NOISY;
+    }
+    return numSamples;
+}
+
+
+/**
+ * @brief   Streams raw and algorithm output at 50Hz from the simulated hub, with device motion reported from
+ *          BENCH_SQI_MOTION_S to BENCH_SQI_MOTION_E
+ *
+ * @return  Number of samples collected, 0 on a failure or an output FIFO overflow
+ */
+static uint32_t sqiCollectHub(void){
+    struct max32664SimCounters counters;
+    struct bioData body;
+    I2C_Params params;
+    uint8_t status = SUCCESS;
+    uint8_t regVal;
+    uint32_t n = 0;
+
+    max32664SimInit(NULL);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    if(status != SUCCESS || configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1) != SUCCESS){
+        return 0;
+    }
+    regVal = readRegisterMAX30101(CONFIGURATION_REGISTER, &status); //50Hz: first entry of the sample rate table
+    if(status != SUCCESS || writeRegisterMAX30101(CONFIGURATION_REGISTER, regVal & SAMP_MASK) != SUCCESS){
+        return 0;
+    }
+    if(readADCRange(&status) != BENCH_SQI_ADC_RANGE || status != SUCCESS){
+        return 0;
+    }
+    max32664SimResetCounters();
+
+    while(n < BENCH_SQI_SECONDS * 50){
+        bool motion = n >= BENCH_SQI_MOTION_S * 50 && n < BENCH_SQI_MOTION_E * 50;
+        max32664SimSetExtStatus(motion ? -2 : 0);
+        body = readSensorData(&status);
+        if(status == SUCCESS && body.irLed != 0){ //a sample was in the FIFO
+            sqiIr[n] = body.irLed;
+            sqiRed[n] = body.redLed;
+            sqiStatus[n] = body.status;
+            sqiExt[n] = body.extStatus;
+            sqiGarbage[n] = motion;
+            n++;
+        }
+        else{
+            usleep(1000);
+        }
+    }
+    max32664SimGetCounters(&counters);
+    return counters.samplesOverflowed == 0 ? n : 0;
+}
+
+
+int main(int argc, char **argv){
+    static const struct {
+        const char *name;
+        uint16_t sampleRate;
+        enum sqiKind kind;
+    } cases[] = {
+        {"gen_100Hz_clean", 100, SQI_CLEAN},
+        {"gen_400Hz_clean", 400, SQI_CLEAN},
+        {"gen_100Hz_noisy", 100, SQI_NOISY},
+        {"gen_100Hz_buried", 100, SQI_BURIED},
+        {"gen_100Hz_low_perfusion", 100, SQI_LOW_PERFUSION},
+        {"gen_100Hz_clipped", 100, SQI_CLIPPED},
+        {"gen_100Hz_motion", 100, SQI_MOTION},
+        {"gen_100Hz_pressure", 100, SQI_PRESSURE},
+        {"gen_100Hz_no_finger", 100, SQI_NO_FINGER},
+    };
+    uint32_t numSamples;
+    size_t c;
+
+    benchTableInit(&table);
+    colWrong = benchAddColumn(&table, "misclassified_pct", BENCH_LOWER_IS_BETTER);
+    colUsable = benchAddColumn(&table, "usable_pct", BENCH_INFO);
+    colScore = benchAddColumn(&table, "mean_score", BENCH_INFO);
+    colFirst = benchAddColumn(&table, "first_usable_s", BENCH_INFO);
+    colNs = benchAddColumn(&table, "cpu_ns_per_sample", BENCH_INFO);
+    colState = benchAddColumn(&table, "state_bytes", BENCH_INFO);
+
+    numSamples = sqiCollectHub();
+    if(numSamples == 0){
+        fprintf(stderr, "bench_sqi: hub stream failed or dropped samples\n");
+        return 1;
+    }
+    sqiRun("hub_50Hz_gated", 50, numSamples, true);
+    sqiRun("hub_50Hz_ungated", 50, numSamples, false);
+
+    for(c = 0; c < sizeof(cases) / sizeof(cases[0]); c++){
+        numSamples = sqiCollectGen(cases[c].sampleRate, cases[c].kind);
+        sqiRun(cases[c].name, cases[c].sampleRate, numSamples, false);
+    }
+
+    return benchMain(&table, argc, argv);
+}
@@ -0,0 +1,294 @@
+/**
+ * @file bench_startup.c
+ *
+ * @brief Startup-time benchmark, from reset pin to first valid sample, against the simulated MAX32664
+ *
+ * Two bring-up scenarios are timed phase by phase:
+ *
+ * - test: the sequence of mainThread() in bio_sensor_library_test.c with its fixed sleep() calls
+ *   (reset pulse, sleep(1) twice, LED blink sleep(1), beginI2C(), configMAX32664(), sleep(4))
+ *
+ * - polled: the same reset pulse, then beginI2C() and configMAX32664() retried every
+ *   BENCH_STARTUP_POLL_US until they succeed, with no fixed sleeps. This is the time the hub actually needs
+ *
+ * Both then poll readSensorData() every BENCH_STARTUP_POLL_US until the first valid sample (SUCCESS with a non-zero
+ * IR count) and until the algorithm confidence reaches the threshold. Each phase reports its simulated wall time,
+ * the part spent in usleep()/sleep(), I2C transactions and the time since the reset pulse started.
+ *
+ * Two more scenarios time the hub discovery done before streaming (bio_nvs.h), after the polled bring-up:
+ *
+ * - cold: blank NVS region, bioSnapshotRestore() queries the hub and stores the snapshot
+ *
+ * - warm: the snapshot stored by the cold run, bioSnapshotRestore() only checks the sensor hub version
+ *
+ * Usage: bench_startup [--confidence <percent>] [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "bio_nvs.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_STARTUP_POLL_US     10000     //retry/poll period of the polled scenario and of the sample polling
+#define BENCH_STARTUP_TIMEOUT_US  60000000  //give up on a phase after 60s of simulated time
+
+static struct benchTable table;
+static uint8_t colWall, colSleep, colTrans, colTotal;
+static struct benchMeasure phaseMeasure; //start of the current phase
+static uint64_t scenarioStartUs;         //start of the current scenario
+
+
+/**
+ * @brief   Closes the current phase, adds its row and starts the next one
+ *
+ * @param   *scenario Scenario name
+ * @param   *phase    Name of the phase that just ended
+ */
+static void startupPhase(const char *scenario, const char *phase){
+    char name[BENCH_NAME_LEN];
+    struct benchCost cost;
+    struct benchRow *row;
+
+    benchStop(&phaseMeasure, &cost);
+    snprintf(name, sizeof(name), "%s_%s", scenario, phase);
+    row = benchAddRow(&table, name);
+    row->value[colWall] = cost.wallUs / 1000.0;
+    row->value[colSleep] = cost.sleepUs / 1000.0;
+    row->value[colTrans] = cost.transactions;
+    row->value[colTotal] = (max32664SimNowUs() - scenarioStartUs) / 1000.0;
+    benchStart(&phaseMeasure);
+}
+
+
+/**
+ * @brief   Reset pin sequence of mainThread(): MFIO and reset pins high, reset pulled low for 10ms then released
+ */
+static void startupResetPulse(void){
+    GPIO_init();
+    I2C_init();
+    GPIO_setConfig(Board_GPIO_DIO1_MFIO, GPIO_CFG_OUT_STD | GPIO_CFG_OUT_HIGH); //mfio pin, pull high
+    GPIO_setConfig(Board_GPIO_DIO0_RESET, GPIO_CFG_OUT_STD | GPIO_CFG_OUT_HIGH); //reset pin
+    GPIO_write(Board_GPIO_DIO0_RESET, 0x0); //pull reset low
+    usleep(10000); //sleep for 10 ms
+    GPIO_write(Board_GPIO_DIO0_RESET, 0x1); //set the reset pin high
+}
+
+
+static I2C_Handle startupOpen(void){
+    I2C_Params params;
+
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    return I2C_open(CONFIG_I2C_0, &params);
+}
+
+
+/**
+ * @brief   Polls readSensorData() until the first valid sample, then until the confidence threshold
+ *
+ * @return  0 on success, 1 on timeout
+ */
+static int startupSamples(const char *scenario, uint8_t confidence){
+    struct bioData body;
+    uint8_t status;
+    uint64_t timeoutUs = max32664SimNowUs() + BENCH_STARTUP_TIMEOUT_US;
+
+    do{ //first valid sample
+        body = readSensorData(&status);
+        if(status == SUCCESS && body.irLed != 0){
+            break;
+        }
+        usleep(BENCH_STARTUP_POLL_US);
+    } while(max32664SimNowUs() < timeoutUs);
+    if(max32664SimNowUs() >= timeoutUs){
+        return 1;
+    }
+    startupPhase(scenario, "first_sample");
+
+    while(status != SUCCESS || body.confidence < confidence){ //algorithm confident
+        if(max32664SimNowUs() >= timeoutUs){
+            return 1;
+        }
+        usleep(BENCH_STARTUP_POLL_US);
+        body = readSensorData(&status);
+    }
+    startupPhase(scenario, "confident");
+    return 0;
+}
+
+
+/**
+ * @brief   mainThread() bring-up with its fixed sleeps
+ */
+static int startupTest(uint8_t confidence){
+    uint8_t status;
+
+    max32664SimInit(NULL);
+    scenarioStartUs = max32664SimNowUs();
+    benchStart(&phaseMeasure);
+
+    startupResetPulse();
+    startupPhase("test", "reset_pulse");
+
+    sleep(1); //sleep for 1 second
+    GPIO_setConfig(Board_GPIO_DIO1_MFIO, GPIO_CFG_IN_PU); //setup the MFIO as an input so MAX32664 can use it
+    sleep(1);
+    startupPhase("test", "reset_sleeps");
+
+    sleep(1); //LED blink before opening I2C
+    startupPhase("test", "led_blink");
+
+    beginI2C(startupOpen(), &status);
+    if(status != SUCCESS){
+        return 1;
+    }
+    startupPhase("test", "beginI2C");
+
+    if(configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1) != SUCCESS){
+        return 1;
+    }
+    startupPhase("test", "configMAX32664");
+
+    sleep(4); //delay before the sample loop
+    startupPhase("test", "config_sleep");
+
+    return startupSamples("test", confidence);
+}
+
+
+/**
+ * @brief   Bring-up that retries each step instead of sleeping for a fixed time
+ */
+static int startupPolled(uint8_t confidence){
+    I2C_Handle handle;
+    uint8_t status;
+    uint64_t timeoutUs;
+
+    max32664SimInit(NULL);
+    scenarioStartUs = max32664SimNowUs();
+    benchStart(&phaseMeasure);
+
+    startupResetPulse();
+    GPIO_setConfig(Board_GPIO_DIO1_MFIO, GPIO_CFG_IN_PU);
+    startupPhase("polled", "reset_pulse");
+
+    handle = startupOpen();
+    timeoutUs = max32664SimNowUs() + BENCH_STARTUP_TIMEOUT_US;
+    while(beginI2C(handle, &status), status != SUCCESS){ //hub ACKs once booted
+        if(max32664SimNowUs() >= timeoutUs){
+            return 1;
+        }
+        usleep(BENCH_STARTUP_POLL_US);
+    }
+    startupPhase("polled", "beginI2C");
+
+    while(configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1) != SUCCESS){ //application answers once initialized
+        if(max32664SimNowUs() >= timeoutUs){
+            return 1;
+        }
+        usleep(BENCH_STARTUP_POLL_US);
+    }
+    startupPhase("polled", "configMAX32664");
+
+    return startupSamples("polled", confidence);
+}
+
+
+/**
+ * @brief   Polled bring-up, then hub discovery through bioSnapshotRestore() on the simulated NVS region
+ *
+ * @param   *scenario   Scenario name
+ * @param   blank       Erase the NVS region first (cold boot)
+ *
+ * @return  0 on success, 1 on a failure or if the snapshot was (not) used when it should (not) have been
+ */
+static int startupDiscovery(const char *scenario, bool blank){
+    NVS_Params nvsParams;
+    NVS_Attrs nvsAttrs;
+    NVS_Handle nvsHandle;
+    struct bioNvsBackend nvs;
+    struct bioSnapshot snap;
+    I2C_Handle handle;
+    uint8_t status;
+    uint64_t timeoutUs;
+    bool warm;
+
+    max32664SimInit(NULL);
+    NVS_init();
+    NVS_Params_init(&nvsParams);
+    nvsHandle = NVS_open(CONFIG_NVSINTERNAL, &nvsParams);
+    if(nvsHandle == NULL){
+        return 1;
+    }
+    if(blank){
+        NVS_getAttrs(nvsHandle, &nvsAttrs);
+        NVS_erase(nvsHandle, 0, nvsAttrs.sectorSize);
+    }
+    bioNvsUseDriver(&nvs, nvsHandle);
+
+    scenarioStartUs = max32664SimNowUs();
+    benchStart(&phaseMeasure);
+
+    startupResetPulse();
+    GPIO_setConfig(Board_GPIO_DIO1_MFIO, GPIO_CFG_IN_PU);
+    handle = startupOpen();
+    timeoutUs = max32664SimNowUs() + BENCH_STARTUP_TIMEOUT_US;
+    while(beginI2C(handle, &status), status != SUCCESS){
+        if(max32664SimNowUs() >= timeoutUs){
+            return 1;
+        }
+        usleep(BENCH_STARTUP_POLL_US);
+    }
+    while(configMAX32664(SENSOR_AND_ALGORITHM, MODE_TWO, 1) != SUCCESS){
+        if(max32664SimNowUs() >= timeoutUs){
+            return 1;
+        }
+        usleep(BENCH_STARTUP_POLL_US);
+    }
+    startupPhase(scenario, "bring_up");
+
+    if(bioSnapshotRestore(&nvs, &snap, &warm) != SUCCESS || warm == blank){
+        return 1;
+    }
+    startupPhase(scenario, "discovery");
+
+    NVS_close(nvsHandle);
+    return 0;
+}
+
+
+int main(int argc, char **argv){
+    uint8_t confidence = 90;
+    int i;
+
+    for(i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--confidence") == 0 && i + 1 < argc){
+            confidence = (uint8_t)atoi(argv[++i]);
+        }
+    }
+
+    benchTableInit(&table);
+    colWall = benchAddColumn(&table, "wall_ms", BENCH_LOWER_IS_BETTER);
+    colSleep = benchAddColumn(&table, "sleep_ms", BENCH_LOWER_IS_BETTER);
+    colTrans = benchAddColumn(&table, "transactions", BENCH_LOWER_IS_BETTER);
+    colTotal = benchAddColumn(&table, "since_start_ms", BENCH_LOWER_IS_BETTER);
+
+    if(startupTest(confidence)){
+        fprintf(stderr, "bench_startup: test scenario failed\n");
+        return 1;
+    }
+    if(startupPolled(confidence)){
+        fprintf(stderr, "bench_startup: polled scenario failed\n");
+        return 1;
+    }
+    if(startupDiscovery("cold", true) || startupDiscovery("warm", false)){
+        fprintf(stderr, "bench_startup: discovery scenario failed\n");
+        return 1;
+    }
+
+    return benchMain(&table, argc, argv);
+}
@@ -0,0 +1,287 @@
+/**
+ * @file bench_stream.c
+ *
+ * @brief End-to-end streaming throughput benchmark against the simulated MAX32664
+ *
+ * Replays the dataStream loop of bio_sensor_library_test.c (readSensorData() called in a loop after
+ * configMAX32664()) for every output mode and every MAX30101 sample rate (50 - 3200Hz, as reported by
+ * readADCSampleRate()). Each case runs for BENCH_STREAM_SECONDS of simulated time after a one second warm-up and
+ * reports:
+ *
+ * - samples_per_s: samples delivered to the application per second
+ *
+ * - dropped_per_s: samples lost to output FIFO overflow per second
+ *
+ * - lat_p50_ms, lat_p95_ms, lat_p99_ms: drain latency, from the end of a sample's period on the MAX30101 to
+ *   readSensorData() returning it
+ *
+ * - cpu_ns_per_sample: host CPU time per delivered sample, for information only
+ *
+ * Every case also checks the library's transport counters (bioGetStats()) against the simulator's own: transactions,
+ * bytes, I2C failures, ERR_TRY_AGAIN status bytes, sleep time and samples drained must match, and fifoOverflows must
+ * be non-zero exactly when the simulated FIFO overflowed. Latency tracking (bioLatencyEnable()) is on, the bench pops
+ * every sample it gets, and the p50 and p99 capture to drain estimates must agree with the simulated FIFO depth.
+ *
+ * Usage: bench_stream [--period-us <us>] [--check <baseline>] [--write-baseline <file>] [--tolerance <percent>]
+ *
+ * --period-us adds a usleep() after every readSensorData() call (the test program sleeps 100000us), the default
+ * of 0 drains as fast as the library allows. Baselines are recorded with the default.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bio_sensor.h"
+#include "max32664_sim.h"
+#include "bench_common.h"
+
+#define BENCH_STREAM_SECONDS    10      //measured simulated time per case
+#define BENCH_STREAM_MAX_LAT    20000   //latency samples kept per case
+
+static const uint16_t streamRates[] = {50, 100, 200, 400, 800, 1000, 1600, 3200}; //MAX30101 SpO2 sample rates
+static const struct {
+    const char *name;
+    uint8_t mode;
+} streamModes[] = {
+    {"raw", SENSOR_DATA},
+    {"algo", ALGO_DATA},
+    {"raw_algo", SENSOR_AND_ALGORITHM},
+};
+
+static uint32_t streamLatUs[BENCH_STREAM_MAX_LAT]; //drain latency of each delivered sample
+
+
+static int streamCompare(const void *a, const void *b){
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+
+/**
+ * @brief   Percentile of the sorted latencies, in ms
+ */
+static double streamPercentileMs(uint32_t count, uint32_t pct){
+    if(count == 0){
+        return 0.0;
+    }
+    return streamLatUs[(uint64_t)(count - 1) * pct / 100] / 1000.0;
+}
+
+
+/**
+ * @brief   Checks the library's transport counters against the simulator counters over the same interval
+ *
+ * @param   *name   Case name, for the error message
+ * @param   *stats  Library counters, cleared at the start of the interval
+ * @param   *start  Simulator counters at the start of the interval
+ * @param   *end    Simulator counters at the end of the interval
+ * @param   benchUs Time the bench itself slept in the interval, us
+ *
+ * @return  0 when they match, 1 otherwise
+ */
+static int streamCheckStats(const char *name, const struct bioStats *stats, const struct max32664SimCounters *start,
+                            const struct max32664SimCounters *end, uint64_t benchUs){
+    uint32_t i2cErrors = 0;
+    uint8_t e;
+
+    for(e = 0; e < BIO_STATS_I2C_ERRORS; e++){
+        i2cErrors += stats->i2cErrors[e];
+    }
+    if(stats->transactions != end->transfers - start->transfers || stats->bytesTx != end->bytesTx - start->bytesTx ||
+       stats->bytesRx != end->bytesRx - start->bytesRx || i2cErrors != end->nacks - start->nacks ||
+       stats->errTryAgain != end->tryAgain - start->tryAgain ||
+       stats->sleepUs + benchUs != end->sleepUs - start->sleepUs ||
+       stats->samplesDrained != end->samplesRead - start->samplesRead ||
+       (stats->fifoOverflows != 0) != (end->samplesOverflowed != start->samplesOverflowed)){
+        fprintf(stderr, "bench_stream: %s: bioGetStats() does not match the simulator counters\n", name);
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief   Checks the latency histograms against the simulated output FIFO depth. The library estimates a sample's
+ *          capture to drain latency as (depth - 1/2) sample periods from the depth the hub reported before the read,
+ *          which lies between the simulator's depth before the call and its depth after it plus the sample read
+ *
+ * @param   *name           Case name, for the error message
+ * @param   delivered       Samples delivered, each popped once by the bench
+ * @param   *captureToDrain Library capture to drain histogram
+ * @param   *drainToPop     Library drain to consumer histogram
+ * @param   *fifoLow        Estimates from the simulator's depth before each call
+ * @param   *fifoHigh       Estimates from the simulator's depth after each call, plus one
+ *
+ * @return  0 when the p50 and p99 latencies are within the bounds, 1 otherwise
+ */
+static int streamCheckLatency(const char *name, uint32_t delivered, const struct bioLatencyHist *captureToDrain,
+                              const struct bioLatencyHist *drainToPop, const struct bioLatencyHist *fifoLow,
+                              const struct bioLatencyHist *fifoHigh){
+    static const uint8_t percents[] = {50, 99};
+    size_t p;
+
+    if(captureToDrain->count != delivered || drainToPop->count != delivered || captureToDrain->minUs < fifoLow->minUs ||
+       captureToDrain->minUs > fifoHigh->minUs){
+        fprintf(stderr, "bench_stream: %s: latency histograms do not cover the samples delivered\n", name);
+        return 1;
+    }
+    for(p = 0; p < sizeof(percents) / sizeof(percents[0]); p++){
+        uint32_t latencyUs = bioLatencyPercentileUs(captureToDrain, percents[p]);
+        if(latencyUs < bioLatencyPercentileUs(fifoLow, percents[p]) ||
+           latencyUs > bioLatencyPercentileUs(fifoHigh, percents[p])){
+            fprintf(stderr, "bench_stream: %s: p%u capture to drain latency does not match the FIFO depth\n", name,
+                    percents[p]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * @brief   Brings the simulated hub up in the given output mode and sets the MAX30101 sample rate
+ *
+ * @return  SUCCESS, or the status byte of the failing step
+ */
+static uint8_t streamBringUp(uint8_t outputMode, uint8_t rateIndex){
+    I2C_Params params;
+    uint8_t status = SUCCESS;
+    uint8_t regVal;
+
+    max32664SimInit(NULL);
+    I2C_init();
+    I2C_Params_init(&params);
+    params.bitRate = I2C_400kHz;
+    beginI2C(I2C_open(CONFIG_I2C_0, &params), &status);
+    if(status != SUCCESS){
+        return status;
+    }
+
+    status = configMAX32664(outputMode, MODE_TWO, 1);
+    if(status != SUCCESS){
+        return status;
+    }
+
+    regVal = readRegisterMAX30101(CONFIGURATION_REGISTER, &status); //set the sample rate bits, keep ADC range and pulse width
+    if(status != SUCCESS){
+        return status;
+    }
+    return writeRegisterMAX30101(CONFIGURATION_REGISTER, (regVal & SAMP_MASK) | (rateIndex << 2));
+}
+
+
+int main(int argc, char **argv){
+    struct benchTable table;
+    uint8_t colRate, colDrop, colP50, colP95, colP99, colCpu;
+    uint32_t periodUs = 0;
+    size_t m, r;
+    int i;
+
+    for(i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--period-us") == 0 && i + 1 < argc){
+            periodUs = (uint32_t)atoi(argv[++i]);
+        }
+    }
+
+    benchTableInit(&table);
+    colRate = benchAddColumn(&table, "samples_per_s", BENCH_HIGHER_IS_BETTER);
+    colDrop = benchAddColumn(&table, "dropped_per_s", BENCH_LOWER_IS_BETTER);
+    colP50 = benchAddColumn(&table, "lat_p50_ms", BENCH_LOWER_IS_BETTER);
+    colP95 = benchAddColumn(&table, "lat_p95_ms", BENCH_LOWER_IS_BETTER);
+    colP99 = benchAddColumn(&table, "lat_p99_ms", BENCH_LOWER_IS_BETTER);
+    colCpu = benchAddColumn(&table, "cpu_ns_per_sample", BENCH_INFO);
+
+    for(m = 0; m < sizeof(streamModes) / sizeof(streamModes[0]); m++){
+        for(r = 0; r < sizeof(streamRates) / sizeof(streamRates[0]); r++){
+            char name[BENCH_NAME_LEN];
+            struct benchRow *row;
+            struct benchMeasure measure;
+            struct benchCost cost;
+            struct max32664SimCounters start, end;
+            struct bioStats stats;
+            struct bioLatencyHist captureToDrain, drainToPop, fifoLow, fifoHigh;
+            uint32_t samplePeriodUs = 1000000 / streamRates[r];
+            uint64_t benchUs = 0;
+            uint32_t delivered = 0;
+            uint32_t numLat = 0;
+            uint64_t stopUs;
+            uint8_t status;
+
+            snprintf(name, sizeof(name), "%s_%uHz", streamModes[m].name, streamRates[r]);
+            row = benchAddRow(&table, name);
+
+            if(streamBringUp(streamModes[m].mode, (uint8_t)r) != SUCCESS){
+                fprintf(stderr, "bench_stream: %s: bring-up failed\n", name);
+                return 1;
+            }
+            if(readADCSampleRate(&status) != streamRates[r]){
+                fprintf(stderr, "bench_stream: %s: sample rate not applied\n", name);
+                return 1;
+            }
+            sleep(1); //warm-up: let the FIFO fill and the algorithm start
+
+            if(bioLatencyEnable(streamRates[r]) != SUCCESS){
+                fprintf(stderr, "bench_stream: %s: latency tracking failed\n", name);
+                return 1;
+            }
+            bioLatencyHistInit(&fifoLow);
+            bioLatencyHistInit(&fifoHigh);
+            bioResetStats();
+            max32664SimGetCounters(&start);
+            benchStart(&measure);
+            stopUs = max32664SimNowUs() + BENCH_STREAM_SECONDS * 1000000ULL;
+
+            while(max32664SimNowUs() < stopUs){
+                uint32_t before = 0;
+                uint32_t depth;
+                struct max32664SimCounters now;
+
+                max32664SimGetCounters(&now);
+                before = now.samplesRead;
+                depth = max32664SimFifoCount();
+
+                readSensorData(&status);
+
+                max32664SimGetCounters(&now);
+                if(status == SUCCESS && now.samplesRead != before){ //a sample reached the application
+                    delivered += now.samplesRead - before;
+                    bioLatencyPop(bioGetDrainTimeUs()); //the bench is the consumer
+                    bioLatencyHistAdd(&fifoLow, depth * samplePeriodUs - samplePeriodUs / 2);
+                    bioLatencyHistAdd(&fifoHigh, (max32664SimFifoCount() + 1) * samplePeriodUs - samplePeriodUs / 2);
+                    if(numLat < BENCH_STREAM_MAX_LAT){
+                        streamLatUs[numLat++] = (uint32_t)(max32664SimNowUs() - max32664SimLastReadSampleUs());
+                    }
+                }
+
+                if(periodUs){
+                    usleep(periodUs);
+                    benchUs += periodUs;
+                }
+            }
+
+            benchStop(&measure, &cost);
+            max32664SimGetCounters(&end);
+            bioGetStats(&stats);
+            if(streamCheckStats(name, &stats, &start, &end, benchUs)){
+                return 1;
+            }
+
+            qsort(streamLatUs, numLat, sizeof(streamLatUs[0]), streamCompare);
+            bioLatencyDisable();
+            bioGetLatency(&captureToDrain, &drainToPop);
+            if(streamCheckLatency(name, delivered, &captureToDrain, &drainToPop, &fifoLow, &fifoHigh)){
+                return 1;
+            }
+            row->value[colRate] = delivered * 1000000.0 / cost.wallUs;
+            row->value[colDrop] = (end.samplesOverflowed - start.samplesOverflowed) * 1000000.0 / cost.wallUs;
+            row->value[colP50] = streamPercentileMs(numLat, 50);
+            row->value[colP95] = streamPercentileMs(numLat, 95);
+            row->value[colP99] = streamPercentileMs(numLat, 99);
+            row->value[colCpu] = delivered ? (double)cost.cpuNs / delivered : 0.0;
+        }
+    }
+
+    return benchMain(&table, argc, argv);
+}
@@ -0,0 +1,477 @@
+/**
+ * @file bio_record.c
+ *
+ * @brief Decoder and recorder for the binary sample stream (bio_frame.h frames)
+ *
+ * Reads frames from a serial device, a capture file or stdin, checks their CRC and the sample sequence, and writes
+ * the samples to a columnar session file and/or CSV. The frames are parsed by bio_frame.c, the code that encodes
+ * them on target, and -v re-encodes every frame and compares it byte for byte with the one received.
+ *
+ * Usage: bio_record [-d <device> [-b <baud>] | -i <capture>] [-o <session>] [-c <csv|->] [-r <raw capture>]
+ *                   [-n <samples>] [-v]
+ *        bio_record -g <samples> [-k <samples per frame>]   (writes synthetic frames to stdout, e.g. into a pty)
+ *
+ * Without -d or -i the stream is read from stdin. A serial device is recorded until -n samples or Ctrl-C.
+ * A summary (frames, CRC/header errors, skipped bytes, samples lost, samples/s) is printed on stderr.
+ *
+ * Session file (little endian):
+ *
+ * - header: magic "BIOS", uint16 version (1), uint16 number of columns, then per column a 14 byte NUL padded name,
+ *   uint8 width in bytes and uint8 signed flag
+ * - blocks: uint32 number of samples N (1 to BIO_RECORD_BLOCK), then each column as N values of its width
+ * - trailer: uint32 0, then uint32 frames, bad CRC, bad header, bytes skipped, samples lost
+ *
+ * Columns: sequence (32-bit, unwrapped from the 16-bit frame sequence), irLed, redLed, heartRate, confidence, oxygen,
+ * status, extStatus, rValue (x10, as sent by the hub)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include "bio_frame.h"
+
+#define BIO_RECORD_BLOCK    4096  //samples per session file block
+#define BIO_RECORD_COLUMNS  9
+#define BIO_RECORD_CSV_LINE 96    //longest CSV line
+
+
+/**
+ * @brief Session file columns, in file order
+ */
+static const struct {
+    char name[14];
+    uint8_t width;
+    uint8_t isSigned;
+} recordColumns[BIO_RECORD_COLUMNS] = {
+    {"sequence", 4, 0}, {"irLed", 4, 0}, {"redLed", 4, 0}, {"heartRate", 2, 0}, {"confidence", 1, 0},
+    {"oxygen", 2, 0}, {"status", 1, 0}, {"extStatus", 1, 1}, {"rValue", 2, 0}
+};
+
+/**
+ * @brief One block of samples, column by column
+ */
+static struct {
+    uint32_t count;
+    uint32_t sequence[BIO_RECORD_BLOCK];
+    uint32_t irLed[BIO_RECORD_BLOCK];
+    uint32_t redLed[BIO_RECORD_BLOCK];
+    uint16_t heartRate[BIO_RECORD_BLOCK];
+    uint8_t confidence[BIO_RECORD_BLOCK];
+    uint16_t oxygen[BIO_RECORD_BLOCK];
+    uint8_t status[BIO_RECORD_BLOCK];
+    int8_t extStatus[BIO_RECORD_BLOCK];
+    uint16_t rValue[BIO_RECORD_BLOCK];
+} block;
+
+/**
+ * @brief Stream counters
+ */
+static struct {
+    uint32_t frames;
+    uint64_t samples;
+    uint32_t badCrc;
+    uint32_t badHeader;
+    uint32_t lost;
+    uint32_t mismatched;
+} counts;
+
+static volatile sig_atomic_t stopRequested; //set by Ctrl-C
+
+
+static void recordStop(int sig){
+    (void)sig;
+    stopRequested = 1;
+}
+
+
+/**
+ * @brief   Writes little endian values of the given width
+ */
+static void recordPut(FILE *out, const void *values, uint8_t width, uint32_t count){
+    uint8_t buf[4 * BIO_RECORD_BLOCK];
+    const uint8_t *in = values;
+    uint32_t i;
+    uint8_t b;
+
+    for(i = 0; i < count; i++){ //values are host order, written little endian whatever the host
+        uint32_t v = width == 4 ? ((const uint32_t *)values)[i] : width == 2 ? ((const uint16_t *)values)[i] : in[i];
+        for(b = 0; b < width; b++){
+            buf[i * width + b] = (uint8_t)(v >> (8 * b));
+        }
+    }
+    fwrite(buf, width, count, out);
+}
+
+
+static void recordPut32(FILE *out, uint32_t value){
+    recordPut(out, &value, 4, 1);
+}
+
+
+static void recordHeader(FILE *out){
+    uint16_t header[2] = {1, BIO_RECORD_COLUMNS};
+    uint8_t i;
+
+    fwrite("BIOS", 1, 4, out);
+    recordPut(out, header, 2, 2);
+    for(i = 0; i < BIO_RECORD_COLUMNS; i++){
+        fwrite(recordColumns[i].name, 1, sizeof(recordColumns[i].name), out);
+        fwrite(&recordColumns[i].width, 1, 1, out);
+        fwrite(&recordColumns[i].isSigned, 1, 1, out);
+    }
+}
+
+
+static void recordFlush(FILE *out){
+    if(out == NULL || block.count == 0){
+        block.count = 0;
+        return;
+    }
+
+    recordPut32(out, block.count);
+    recordPut(out, block.sequence, 4, block.count);
+    recordPut(out, block.irLed, 4, block.count);
+    recordPut(out, block.redLed, 4, block.count);
+    recordPut(out, block.heartRate, 2, block.count);
+    recordPut(out, block.confidence, 1, block.count);
+    recordPut(out, block.oxygen, 2, block.count);
+    recordPut(out, block.status, 1, block.count);
+    recordPut(out, block.extStatus, 1, block.count);
+    recordPut(out, block.rValue, 2, block.count);
+    block.count = 0;
+}
+
+
+static void recordTrailer(FILE *out){
+    recordPut32(out, 0);
+    recordPut32(out, counts.frames);
+    recordPut32(out, counts.badCrc);
+    recordPut32(out, counts.badHeader);
+    recordPut32(out, 0); //bytes skipped, patched by the caller
+    recordPut32(out, counts.lost);
+}
+
+
+/**
+ * @brief   Appends an unsigned/signed decimal number
+ *
+ * @return  Pointer past the last character written
+ */
+static char *recordUtoa(char *out, uint32_t value){
+    char digits[10];
+    uint8_t n = 0;
+
+    do{
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while(value);
+    while(n){
+        *out++ = digits[--n];
+    }
+    return out;
+}
+
+
+static char *recordItoa(char *out, int32_t value){
+    if(value < 0){
+        *out++ = '-';
+        return recordUtoa(out, (uint32_t)-value);
+    }
+    return recordUtoa(out, (uint32_t)value);
+}
+
+
+/**
+ * @brief   Formats a CSV line, same text as printf("%u,...,%d,%.2f") of the decoded sample
+ *
+ * @return  Line length
+ */
+static size_t recordCsvLine(char *line, uint32_t sequence, uint32_t irLed, uint32_t redLed, uint16_t heartRate,
+                            uint8_t confidence, uint16_t oxygen, uint8_t status, int8_t extStatus, uint16_t rValue){
+    char *p = line;
+
+    p = recordUtoa(p, sequence); *p++ = ',';
+    p = recordUtoa(p, irLed); *p++ = ',';
+    p = recordUtoa(p, redLed); *p++ = ',';
+    p = recordUtoa(p, heartRate); *p++ = ',';
+    p = recordUtoa(p, confidence); *p++ = ',';
+    p = recordUtoa(p, oxygen); *p++ = ',';
+    p = recordUtoa(p, status); *p++ = ',';
+    p = recordItoa(p, extStatus); *p++ = ',';
+    p = recordUtoa(p, rValue / 10); *p++ = '.'; //rValue has one decimal, printed with two
+    *p++ = (char)('0' + rValue % 10);
+    *p++ = '0';
+    *p++ = '\n';
+    return (size_t)(p - line);
+}
+
+
+/**
+ * @brief   Handles a frame that passed its CRC: sequence check, optional re-encode check, session block and CSV
+ */
+static void recordFrame(const struct bioFrameParser *parser, FILE *session, FILE *csv, int verify){
+    static uint32_t nextSequence; //unwrapped sequence expected next
+    struct bioData samples[BIO_FRAME_MAX_SAMPLES];
+    uint8_t numSamples = bioFrameNumSamples(parser);
+    uint16_t sequence = bioFrameSequence(parser);
+    uint32_t first = nextSequence + (uint16_t)(sequence - (uint16_t)nextSequence); //unwrap against the expected value
+    uint8_t i;
+
+    if(counts.frames == 0){ //first frame sets the origin
+        first = sequence;
+    }
+    else if(first != nextSequence){ //samples missing since the last frame
+        counts.lost += first - nextSequence;
+    }
+    nextSequence = first + numSamples;
+    counts.frames++;
+    counts.samples += numSamples;
+
+    for(i = 0; i < numSamples; i++){
+        uint32_t n = block.count;
+        const uint8_t *in = &parser->frame[BIO_FRAME_HEADER_SIZE + i * BIO_FRAME_SAMPLE_SIZE];
+
+        bioFrameUnpackSample(in, &samples[i]);
+        block.sequence[n] = first + i;
+        block.irLed[n] = samples[i].irLed;
+        block.redLed[n] = samples[i].redLed;
+        block.heartRate[n] = samples[i].heartRate;
+        block.confidence[n] = samples[i].confidence;
+        block.oxygen[n] = samples[i].oxygen;
+        block.status[n] = samples[i].status;
+        block.extStatus[n] = samples[i].extStatus;
+        block.rValue[n] = (uint16_t)(in[13] | (in[14] << 8)); //as sent, no float round trip
+
+        if(csv){
+            char line[BIO_RECORD_CSV_LINE];
+            fwrite(line, 1, recordCsvLine(line, block.sequence[n], block.irLed[n], block.redLed[n], block.heartRate[n],
+                                          block.confidence[n], block.oxygen[n], block.status[n], block.extStatus[n],
+                                          block.rValue[n]), csv);
+        }
+
+        if(++block.count == BIO_RECORD_BLOCK){
+            recordFlush(session);
+        }
+    }
+
+    if(verify){ //the target encoder must produce the exact frame from the decoded samples
+        uint8_t frame[BIO_FRAME_MAX_SIZE];
+        uint16_t len = bioFrameEncode(frame, sequence, samples, numSamples);
+
+        if(len != BIO_FRAME_SIZE(numSamples) || memcmp(frame, parser->frame, len) != 0){
+            counts.mismatched++;
+        }
+    }
+}
+
+
+/**
+ * @brief   Opens a serial device in raw mode
+ *
+ * @return  File descriptor, -1 on error
+ */
+static int recordOpenSerial(const char *device, long baud){
+    static const struct { long baud; speed_t speed; } speeds[] = {
+        {9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600}, {115200, B115200},
+        {230400, B230400}, {460800, B460800}, {921600, B921600}, {1000000, B1000000}, {2000000, B2000000}
+    };
+    struct termios tio;
+    size_t i;
+    int fd = open(device, O_RDONLY | O_NOCTTY);
+
+    if(fd < 0){
+        return -1;
+    }
+    if(tcgetattr(fd, &tio) == 0){ //a tty: raw mode at the requested baud. Anything else (e.g. a fifo) is read as is
+        cfmakeraw(&tio);
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        for(i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++){
+            if(speeds[i].baud == baud){
+                cfsetispeed(&tio, speeds[i].speed);
+                cfsetospeed(&tio, speeds[i].speed);
+            }
+        }
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    return fd;
+}
+
+
+/**
+ * @brief   Writes synthetic frames to stdout: a PPG-like waveform and plausible algorithm output
+ */
+static int recordGenerate(uint64_t numSamples, uint8_t perFrame){
+    struct bioData samples[BIO_FRAME_MAX_SAMPLES];
+    uint8_t frame[BIO_FRAME_MAX_SIZE];
+    uint32_t seed = 1;
+    uint64_t n = 0;
+    uint16_t sequence = 0;
+    uint8_t i;
+
+    if(perFrame == 0 || perFrame > BIO_FRAME_MAX_SAMPLES){
+        fprintf(stderr, "bio_record: -k must be 1 to %u\n", BIO_FRAME_MAX_SAMPLES);
+        return 1;
+    }
+
+    while(n < numSamples){
+        uint8_t count = (numSamples - n < perFrame) ? (uint8_t)(numSamples - n) : perFrame;
+
+        for(i = 0; i < count; i++, n++){
+            seed = seed * 1103515245 + 12345;
+            memset(&samples[i], 0, sizeof(samples[i]));
+            samples[i].irLed = 100000 + (uint32_t)((n * 37) % 2000) + (seed >> 24);
+            samples[i].redLed = 80000 + (uint32_t)((n * 29) % 1500) + (seed >> 25);
+            samples[i].heartRate = 60 + (uint16_t)((n / 100) % 40);
+            samples[i].confidence = (uint8_t)(n % 101);
+            samples[i].oxygen = 95 + (uint16_t)((n / 500) % 5);
+            samples[i].status = 3;
+            samples[i].extStatus = (int8_t)((seed >> 16) % 8) - 6;
+            samples[i].rValue = (float)((seed >> 8) % 1000) / 10.0f;
+        }
+        fwrite(frame, 1, bioFrameEncode(frame, sequence, samples, count), stdout);
+        sequence += count;
+    }
+    return fflush(stdout) != 0;
+}
+
+
+int main(int argc, char **argv){
+    const char *device = NULL, *inPath = NULL, *sessionPath = NULL, *csvPath = NULL, *rawPath = NULL;
+    long baud = 115200;
+    uint64_t maxSamples = 0, generate = 0;
+    uint8_t perFrame = 1;
+    int verify = 0, fd = STDIN_FILENO, opt;
+    FILE *session = NULL, *csv = NULL, *raw = NULL;
+    static uint8_t buf[1 << 16];
+    static char csvBuf[1 << 20];
+    struct bioFrameParser parser;
+    struct timespec start, end;
+    double seconds;
+    ssize_t len, n;
+
+    while((opt = getopt(argc, argv, "d:b:i:o:c:r:n:g:k:v")) != -1){
+        switch(opt){
+        case 'd': device = optarg; break;
+        case 'b': baud = atol(optarg); break;
+        case 'i': inPath = optarg; break;
+        case 'o': sessionPath = optarg; break;
+        case 'c': csvPath = optarg; break;
+        case 'r': rawPath = optarg; break;
+        case 'n': maxSamples = strtoull(optarg, NULL, 0); break;
+        case 'g': generate = strtoull(optarg, NULL, 0); break;
+        case 'k': perFrame = (uint8_t)atoi(optarg); break;
+        case 'v': verify = 1; break;
+        default:
+            fprintf(stderr, "usage: bio_record [-d <device> [-b <baud>] | -i <capture>] [-o <session>] [-c <csv|->] "
+                            "[-r <raw>] [-n <samples>] [-v]\n       bio_record -g <samples> [-k <samples per frame>]\n");
+            return 2;
+        }
+    }
+
+    if(generate){
+        return recordGenerate(generate, perFrame);
+    }
+
+    if(device && (fd = recordOpenSerial(device, baud)) < 0){
+        fprintf(stderr, "bio_record: cannot open %s\n", device);
+        return 1;
+    }
+    if(inPath && (fd = open(inPath, O_RDONLY)) < 0){
+        fprintf(stderr, "bio_record: cannot open %s\n", inPath);
+        return 1;
+    }
+    if(sessionPath && !(session = fopen(sessionPath, "wb"))){
+        fprintf(stderr, "bio_record: cannot create %s\n", sessionPath);
+        return 1;
+    }
+    if(csvPath && !(csv = strcmp(csvPath, "-") ? fopen(csvPath, "w") : stdout)){
+        fprintf(stderr, "bio_record: cannot create %s\n", csvPath);
+        return 1;
+    }
+    if(rawPath && !(raw = fopen(rawPath, "wb"))){
+        fprintf(stderr, "bio_record: cannot create %s\n", rawPath);
+        return 1;
+    }
+
+    if(session){
+        recordHeader(session);
+    }
+    if(csv){
+        setvbuf(csv, csvBuf, _IOFBF, sizeof(csvBuf));
+        fputs("sequence,irLed,redLed,heartRate,confidence,oxygen,status,extStatus,rValue\n", csv);
+    }
+
+    signal(SIGINT, recordStop);
+    signal(SIGTERM, recordStop);
+    bioFrameParserInit(&parser);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    while(!stopRequested && (len = read(fd, buf, sizeof(buf))) > 0){
+        if(raw){
+            fwrite(buf, 1, (size_t)len, raw);
+        }
+        for(n = 0; n < len; n++){
+            uint8_t result = bioFrameParse(&parser, buf[n]);
+
+            while(result != BIO_FRAME_MORE){ //a resync can leave complete frames in the parser
+                switch(result){
+                case BIO_FRAME_OK:
+                    recordFrame(&parser, session, csv, verify);
+                    break;
+                case BIO_FRAME_BAD_CRC:
+                    counts.badCrc++;
+                    break;
+                case BIO_FRAME_BAD_HEADER:
+                    counts.badHeader++;
+                    break;
+                default:
+                    break;
+                }
+                result = bioFrameParseNext(&parser);
+            }
+        }
+        if(maxSamples && counts.samples >= maxSamples){
+            break;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    if(session){
+        long skippedAt;
+
+        recordFlush(session);
+        recordTrailer(session);
+        skippedAt = ftell(session) - 8; //bytes skipped field of the trailer
+        fseek(session, skippedAt, SEEK_SET);
+        recordPut32(session, parser.skipped);
+        fclose(session);
+    }
+    if(csv){
+        fflush(csv);
+        if(csv != stdout){
+            fclose(csv);
+        }
+    }
+    if(raw){
+        fclose(raw);
+    }
+
+    fprintf(stderr, "bio_record: %u frames, %llu samples, %u bad CRC, %u bad header, %u bytes skipped, %u samples lost",
+            counts.frames, (unsigned long long)counts.samples, counts.badCrc, counts.badHeader, parser.skipped, counts.lost);
+    if(verify){
+        fprintf(stderr, ", %u frames re-encoded differently", counts.mismatched);
+    }
+    fprintf(stderr, ", %.3fs (%.2f Msamples/s)\n", seconds, seconds > 0 ? counts.samples / seconds / 1e6 : 0.0);
+
+    return (verify && counts.mismatched) ? 1 : 0;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file codec_decode.c
+ *
+ * @brief Decodes a raw PPG codec stream (bio_codec.h blocks) to CSV, or encodes CSV to a codec stream
+ *
+ * Usage: codec_decode [coded file]                     (reads stdin without a file)
+ *        codec_decode -e [-k <key interval>] [csv file]  (irLed,redLed lines, header line optional)
+ *
+ * Decoding prints "irLed,redLed" per sample and reports blocks skipped before the first keyframe on stderr.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "bio_codec.h"
+
+
+static int codecEncodeCsv(FILE *in, uint16_t keyInterval){
+    struct bioCodec codec;
+    uint8_t out[BIO_CODEC_MAX_BLOCK_SIZE];
+    char line[128];
+    unsigned long irLed, redLed;
+    uint64_t samples = 0, bytes = 0;
+    uint16_t len;
+
+    bioCodecInit(&codec, keyInterval);
+    while(fgets(line, sizeof(line), in)){
+        if(sscanf(line, "%lu,%lu", &irLed, &redLed) != 2){ //header or blank line
+            continue;
+        }
+        len = bioCodecEncode(&codec, (uint32_t)irLed, (uint32_t)redLed, out);
+        fwrite(out, 1, len, stdout);
+        bytes += len;
+        samples++;
+    }
+    len = bioCodecFlush(&codec, out);
+    fwrite(out, 1, len, stdout);
+    bytes += len;
+
+    fprintf(stderr, "codec_decode: %llu samples, %llu bytes (%.2f bytes/sample)\n", (unsigned long long)samples,
+            (unsigned long long)bytes, samples ? (double)bytes / samples : 0.0);
+    return 0;
+}
+
+
+static int codecDecode(FILE *in){
+    struct bioCodec codec;
+    static uint8_t buf[1 << 16];
+    uint32_t irLed[BIO_CODEC_BLOCK], redLed[BIO_CODEC_BLOCK];
+    size_t have = 0, pos, got;
+    uint64_t samples = 0, skipped = 0;
+    uint16_t len;
+    uint8_t numSamples, i;
+
+    bioCodecInit(&codec, 0);
+    printf("irLed,redLed\n");
+
+    while((got = fread(&buf[have], 1, sizeof(buf) - have, in)) > 0){
+        have += got;
+        pos = 0;
+        while((len = bioCodecDecode(&codec, &buf[pos], (uint16_t)(have - pos > 0xFFFF ? 0xFFFF : have - pos),
+                                    irLed, redLed, &numSamples)) != 0){
+            for(i = 0; i < numSamples; i++){
+                printf("%u,%u\n", irLed[i], redLed[i]);
+            }
+            skipped += (numSamples == 0);
+            samples += numSamples;
+            pos += len;
+        }
+        memmove(buf, &buf[pos], have - pos); //keep the partial block
+        have -= pos;
+    }
+
+    if(have){
+        fprintf(stderr, "codec_decode: %u trailing bytes do not form a block\n", (unsigned)have);
+    }
+    fprintf(stderr, "codec_decode: %llu samples, %llu blocks skipped before the first keyframe\n",
+            (unsigned long long)samples, (unsigned long long)skipped);
+    return 0;
+}
+
+
+int main(int argc, char **argv){
+    FILE *in = stdin;
+    int encode = 0;
+    uint16_t keyInterval = 0;
+    int i;
+
+    for(i = 1; i < argc; i++){
+        if(strcmp(argv[i], "-e") == 0){
+            encode = 1;
+        }
+        else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc){
+            keyInterval = (uint16_t)atoi(argv[++i]);
+        }
+        else if(!(in = fopen(argv[i], encode ? "r" : "rb"))){
+            fprintf(stderr, "codec_decode: cannot open %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    return encode ? codecEncodeCsv(in, keyInterval) : codecDecode(in);
+}
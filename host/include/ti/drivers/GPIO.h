@@ -0,0 +1,34 @@
+/**
+ * @file GPIO.h
+ *
+ * @brief Host (Linux) stand-in for the TI-Drivers GPIO interface
+ *
+ * Only the subset of the SimpleLink SDK GPIO API that is used by the library and the test program is declared here.
+ * The functions are implemented by the MAX32664 simulator (host/max32664_sim.c), which watches the reset pin.
+ */
+
+#ifndef HOST_TI_DRIVERS_GPIO_H_
+#define HOST_TI_DRIVERS_GPIO_H_
+
+#include <stdint.h>
+
+typedef uint32_t GPIO_PinConfig; ///< GPIO pin configuration flags
+
+#define GPIO_CFG_OUTPUT        0x00000000
+#define GPIO_CFG_OUT_STD       0x00000000
+#define GPIO_CFG_OUT_OD_NOPULL 0x00020000
+#define GPIO_CFG_OUT_HIGH      0x00010000
+#define GPIO_CFG_OUT_LOW       0x00000000
+#define GPIO_CFG_INPUT         0x01000000
+#define GPIO_CFG_IN_NOPULL     0x01000000
+#define GPIO_CFG_IN_PU         0x01020000
+#define GPIO_CFG_IN_PD         0x01040000
+#define GPIO_CFG_IN_INT_FALLING 0x00200000
+#define GPIO_CFG_IN_INT_RISING 0x00300000
+
+void GPIO_init(void);
+int_fast16_t GPIO_setConfig(uint_least8_t index, GPIO_PinConfig pinConfig);
+void GPIO_write(uint_least8_t index, unsigned int value);
+uint_fast8_t GPIO_read(uint_least8_t index);
+
+#endif /* HOST_TI_DRIVERS_GPIO_H_ */
@@ -0,0 +1,82 @@
+/**
+ * @file I2C.h
+ *
+ * @brief Host (Linux) stand-in for the TI-Drivers I2C interface
+ *
+ * Only the subset of the SimpleLink SDK I2C API that is used by bio_sensor.c and the test program is declared here.
+ * Types, field names and status codes match the SDK so the library sources compile unchanged. The functions are
+ * implemented by the MAX32664 simulator (host/max32664_sim.c).
+ */
+
+#ifndef HOST_TI_DRIVERS_I2C_H_
+#define HOST_TI_DRIVERS_I2C_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define I2C_STATUS_SUCCESS         (0)   ///< Successful status code returned by I2C API
+#define I2C_STATUS_ERROR           (-1)  ///< Generic error status code returned by I2C API
+#define I2C_STATUS_UNDEFINEDCMD    (-2)  ///< Undefined command
+#define I2C_STATUS_TIMEOUT         (-3)  ///< I2C transaction timed out
+#define I2C_STATUS_CLOCK_TIMEOUT   (-4)  ///< I2C serial clock line timeout
+#define I2C_STATUS_ADDR_NACK       (-5)  ///< I2C slave address not acknowledged
+#define I2C_STATUS_DATA_NACK       (-6)  ///< I2C data byte not acknowledged
+#define I2C_STATUS_ARB_LOST        (-7)  ///< I2C arbitration lost to another master
+#define I2C_STATUS_INCOMPLETE      (-8)  ///< I2C transaction returned before completion
+#define I2C_STATUS_BUS_BUSY        (-9)  ///< I2C bus already in use
+#define I2C_STATUS_CANCEL          (-10) ///< I2C transaction cancelled
+#define I2C_STATUS_INVALID_TRANS   (-11) ///< I2C transaction invalid
+
+/**
+ * @brief I2C bit rates (same ordering as the SDK)
+ */
+typedef enum {
+    I2C_100kHz = 0,
+    I2C_400kHz = 1,
+    I2C_1000kHz = 2,
+    I2C_3330kHz = 3,
+    I2C_3400kHz = 3
+} I2C_BitRate;
+
+/**
+ * @brief I2C transfer modes (only blocking mode is simulated)
+ */
+typedef enum {
+    I2C_MODE_BLOCKING,
+    I2C_MODE_CALLBACK
+} I2C_TransferMode;
+
+typedef struct I2C_Config_ *I2C_Handle; ///< Handle returned by I2C_open()
+
+/**
+ * @brief Description of a single I2C transaction
+ */
+typedef struct {
+    void               *writeBuf;     ///< Buffer containing data to be written
+    size_t              writeCount;   ///< Number of bytes to be written
+    void               *readBuf;      ///< Buffer to which data is to be read into
+    size_t              readCount;    ///< Number of bytes to be read
+    volatile int_fast16_t status;     ///< Status of the transaction (I2C_STATUS_*)
+    void               *nextPtr;      ///< Internal use by the driver
+    void               *arg;          ///< Argument for the user callback
+    uint_least8_t       slaveAddress; ///< 7-bit peripheral address
+} I2C_Transaction;
+
+/**
+ * @brief I2C parameters passed to I2C_open()
+ */
+typedef struct {
+    I2C_TransferMode transferMode; ///< Blocking or callback mode
+    void            *transferCallbackFxn; ///< Unused on the host
+    I2C_BitRate      bitRate;      ///< I2C bus bit rate
+    void            *custom;       ///< Unused on the host
+} I2C_Params;
+
+void I2C_init(void);
+void I2C_Params_init(I2C_Params *params);
+I2C_Handle I2C_open(uint_least8_t index, I2C_Params *params);
+void I2C_close(I2C_Handle handle);
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction);
+
+#endif /* HOST_TI_DRIVERS_I2C_H_ */
@@ -0,0 +1,54 @@
+/**
+ * @file NVS.h
+ *
+ * @brief Host (Linux) stand-in for the TI-Drivers NVS (non-volatile storage) interface
+ *
+ * Only the subset of the SimpleLink SDK NVS API used by bio_nvs.c is declared here, with the SDK names and values.
+ * The region is implemented by the MAX32664 simulator (host/max32664_sim.c) as RAM that behaves like internal flash:
+ * erased bytes read 0xFF, writes without NVS_WRITE_ERASE can only clear bits, and the contents survive
+ * max32664SimInit() like flash survives a reset.
+ */
+
+#ifndef HOST_TI_DRIVERS_NVS_H_
+#define HOST_TI_DRIVERS_NVS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define NVS_STATUS_SUCCESS      (0)   ///< Successful status code
+#define NVS_STATUS_ERROR        (-1)  ///< Generic error status code
+#define NVS_STATUS_INV_OFFSET   (-3)  ///< Offset or size outside the region
+#define NVS_STATUS_INV_WRITE    (-5)  ///< Post-verify found different data than written
+
+#define NVS_WRITE_ERASE         (0x1) ///< Erase the sectors covered before writing
+#define NVS_WRITE_PRE_VERIFY    (0x2) ///< Check that the bytes to write are erased first
+#define NVS_WRITE_POST_VERIFY   (0x4) ///< Read back and compare after writing
+
+typedef struct NVS_Config_ *NVS_Handle; ///< Handle returned by NVS_open()
+
+/**
+ * @brief NVS parameters (no fields are used by the stand-in)
+ */
+typedef struct {
+    void *custom;
+} NVS_Params;
+
+/**
+ * @brief NVS region attributes
+ */
+typedef struct {
+    void *regionBase;
+    size_t regionSize;
+    size_t sectorSize;
+} NVS_Attrs;
+
+void NVS_init(void);
+void NVS_Params_init(NVS_Params *params);
+NVS_Handle NVS_open(uint_least8_t index, NVS_Params *params);
+void NVS_close(NVS_Handle handle);
+void NVS_getAttrs(NVS_Handle handle, NVS_Attrs *attrs);
+int_fast16_t NVS_read(NVS_Handle handle, size_t offset, void *buffer, size_t bufferSize);
+int_fast16_t NVS_write(NVS_Handle handle, size_t offset, void *buffer, size_t bufferSize, uint_fast16_t flags);
+int_fast16_t NVS_erase(NVS_Handle handle, size_t offset, size_t size);
+
+#endif /* HOST_TI_DRIVERS_NVS_H_ */
@@ -0,0 +1,98 @@
+/**
+ * @file UART.h
+ *
+ * @brief Host (Linux) stand-in for the TI-Drivers UART interface
+ *
+ * Only the subset of the SimpleLink SDK UART API used by the library output stage and the test program is declared
+ * here, with the SDK names and values. Writes are implemented by the MAX32664 simulator (host/max32664_sim.c) on its
+ * virtual clock: a blocking write advances the clock by the time needed to send the bytes, a callback mode write
+ * completes (and calls the write callback) once that time has elapsed.
+ */
+
+#ifndef HOST_TI_DRIVERS_UART_H_
+#define HOST_TI_DRIVERS_UART_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define UART_STATUS_SUCCESS     (0)   ///< Successful status code returned by UART_control()
+#define UART_STATUS_ERROR       (-1)  ///< Generic error status code returned by UART_control()
+#define UART_ERROR              (-1)  ///< Error return of UART_read()/UART_write()
+#define UART_WAIT_FOREVER       (~(0U)) ///< Wait forever timeout
+
+typedef struct UART_Config_ *UART_Handle; ///< Handle returned by UART_open()
+
+typedef void (*UART_Callback)(UART_Handle handle, void *buf, size_t count); ///< Read/write completion callback
+
+/**
+ * @brief UART read/write modes
+ */
+typedef enum {
+    UART_MODE_BLOCKING,
+    UART_MODE_CALLBACK
+} UART_Mode;
+
+typedef enum {
+    UART_RETURN_PARTIAL,
+    UART_RETURN_FULL
+} UART_ReturnMode;
+
+typedef enum {
+    UART_DATA_BINARY = 0,
+    UART_DATA_TEXT = 1
+} UART_DataMode;
+
+typedef enum {
+    UART_ECHO_OFF = 0,
+    UART_ECHO_ON = 1
+} UART_Echo;
+
+typedef enum {
+    UART_LEN_5 = 0,
+    UART_LEN_6 = 1,
+    UART_LEN_7 = 2,
+    UART_LEN_8 = 3
+} UART_LEN;
+
+typedef enum {
+    UART_STOP_ONE = 0,
+    UART_STOP_TWO = 1
+} UART_STOP;
+
+typedef enum {
+    UART_PAR_NONE = 0,
+    UART_PAR_EVEN = 1,
+    UART_PAR_ODD  = 2,
+    UART_PAR_ZERO = 3,
+    UART_PAR_ONE  = 4
+} UART_PAR;
+
+/**
+ * @brief UART parameters
+ */
+typedef struct {
+    UART_Mode       readMode;       ///< Mode for all read calls
+    UART_Mode       writeMode;      ///< Mode for all write calls
+    uint32_t        readTimeout;    ///< Timeout for read calls in blocking mode
+    uint32_t        writeTimeout;   ///< Timeout for write calls in blocking mode
+    UART_Callback   readCallback;   ///< Pointer to read callback function for callback mode
+    UART_Callback   writeCallback;  ///< Pointer to write callback function for callback mode
+    UART_ReturnMode readReturnMode; ///< Receive return mode
+    UART_DataMode   readDataMode;   ///< Type of data being read
+    UART_DataMode   writeDataMode;  ///< Type of data being written
+    UART_Echo       readEcho;       ///< Echo received data back
+    uint32_t        baudRate;       ///< Baud rate for UART
+    UART_LEN        dataLength;     ///< Data length for UART
+    UART_STOP       stopBits;       ///< Stop bits for UART
+    UART_PAR        parityType;     ///< Parity bit type for UART
+    void           *custom;         ///< Custom argument used by driver implementation
+} UART_Params;
+
+void UART_init(void);
+void UART_Params_init(UART_Params *params);
+UART_Handle UART_open(uint_least8_t index, UART_Params *params);
+void UART_close(UART_Handle handle);
+int_fast32_t UART_write(UART_Handle handle, const void *buffer, size_t size);
+void UART_writeCancel(UART_Handle handle);
+
+#endif /* HOST_TI_DRIVERS_UART_H_ */
@@ -0,0 +1,23 @@
+/**
+ * @file HwiP.h
+ *
+ * @brief Host (Linux) stand-in for the TI-Drivers hardware interrupt porting layer
+ *
+ * Simulated driver callbacks only run from inside the simulator calls made by the task (usleep(), I2C_transfer(),
+ * UART_write(), ...), never asynchronously, so disabling interrupts is a no-op on the host.
+ */
+
+#ifndef HOST_TI_DRIVERS_DPL_HWIP_H_
+#define HOST_TI_DRIVERS_DPL_HWIP_H_
+
+#include <stdint.h>
+
+static inline uintptr_t HwiP_disable(void){
+    return 0;
+}
+
+static inline void HwiP_restore(uintptr_t key){
+    (void)key;
+}
+
+#endif /* HOST_TI_DRIVERS_DPL_HWIP_H_ */
@@ -0,0 +1,35 @@
+/**
+ * @file ti_drivers_config.h
+ *
+ * @brief Host (Linux) stand-in for the SysConfig generated driver configuration
+ *
+ * Mirrors the resource names and indexes generated from bio_sensor_library_test.syscfg so the library
+ * and host programs can refer to the same pins and peripherals as the LaunchPad build.
+ */
+
+#ifndef ti_drivers_config_h
+#define ti_drivers_config_h
+
+#include <ti/drivers/GPIO.h>
+#include <ti/drivers/I2C.h>
+
+#define Board_GPIO_LED0                 0
+#define Board_GPIO_DIO0_RESET           1
+#define Board_GPIO_DIO1_MFIO            2
+#define Board_GPIO_LED1                 3
+#define CONFIG_TI_DRIVERS_GPIO_COUNT    4
+
+#define CONFIG_GPIO_LED_ON  (1)
+#define CONFIG_GPIO_LED_OFF (0)
+
+#define CONFIG_I2C_0                    0
+#define CONFIG_TI_DRIVERS_I2C_COUNT     1
+#define CONFIG_I2C_0_MAXSPEED   (400U) /* Kbps */
+
+#define CONFIG_UART_0                   0
+#define CONFIG_TI_DRIVERS_UART_COUNT    1
+
+#define CONFIG_NVSINTERNAL              0
+#define CONFIG_TI_DRIVERS_NVS_COUNT     1
+
+#endif /* ti_drivers_config_h */
@@ -0,0 +1,1380 @@
+/**
+ * @file max32664_sim.c
+ *
+ * @brief Host (Linux) simulator of the MAX32664 Biometric Sensor Hub and its MAX30101 pulse oximeter
+ *
+ * See max32664_sim.h for the model. The command handling follows the MAX32664 User's Guide
+ * (https://pdfserv.maximintegrated.com/en/an/user-guide-6806-max32664.pdf) for the family/index bytes used by bio_sensor.c.
+ */
+
+#define _GNU_SOURCE
+
+#include <math.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <ti/drivers/UART.h>
+#include <ti/drivers/NVS.h>
+
+#include "bio_sensor.h"
+#include "max32664_sim.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define SIM_I2C_ADDRESS        0x55 //7-bit address of the MAX32664
+#define SIM_MAX_COMMAND        32   //largest host command (family, index, write bytes) kept by the simulator
+#define SIM_MAX_RESPONSE       32   //largest non-FIFO response (status byte not included)
+#define SIM_RAW_BYTES          MAX30101_LED_ARRAY //4 x 24-bit LED values per raw sample
+#define SIM_ACCEL_BYTES        6    //host accelerometer sample: x, y, z 16-bit
+#define SIM_COUNTER_BYTES      1    //sample counter prepended in the *_COUNTER_BYTE output modes
+#define SIM_ADC_MAX            0x3FFFF //MAX30101 ADC is 18-bit
+#define SIM_PAGE_SIZE          8192 //bootloader flash page size
+#define SIM_PAGE_MAC_SIZE      16   //authentication bytes after each .msbl page
+#define SIM_IV_SIZE            11   //SET_INIT_VECTOR_BYTES payload
+#define SIM_AUTH_SIZE          16   //SET_AUTH_BYTES payload
+#define SIM_NVS_SECTOR_SIZE    8192 //CC26x2 internal flash sector
+#define SIM_NVS_REGION_SIZE    (2 * SIM_NVS_SECTOR_SIZE) //NVS region of the host stand-in
+#define SIM_NVS_ERASE_US       8000 //time to erase a sector, us
+#define SIM_NVS_WRITE_US       10   //time to program 4 bytes, us
+
+#define SIM_HUB_STATUS_DATA_RDY  0x08 //Hub status DataRdyInt bit
+#define SIM_HUB_STATUS_OUT_OVR   0x10 //Hub status FifoOutOvrInt bit
+#define SIM_HUB_STATUS_IN_OVR    0x20 //Hub status FifoInOverflow bit
+#define SIM_HUB_STATUS_DEV_BUSY  0x40 //Hub status DevBusy bit
+
+#define SIM_DEFAULT_CONFIG_REG 0x67 //ADC range 16384nA, 100Hz, 411us pulse width
+#define SIM_DEFAULT_MODE_REG   0x03 //SpO2 mode, red + IR
+#define SIM_DEFAULT_LED_AMP    0x24 //7.2mA
+
+static const uint16_t simSampleRates[8] = {50, 100, 200, 400, 800, 1000, 1600, 3200}; //MAX30101 SpO2 sample rate control
+
+static const int32_t simDefaultCoef[NUM_MAXIM_FAST_COEF] = {159584, -3465966, 11268987}; //MaximFast SpO2 coefficients * 100,000
+
+static const uint8_t simHubVersion[3] = {10, 1, 0};
+static const uint8_t simBootVersion[3] = {3, 4, 2};
+
+
+/**
+ * @brief Complete simulator state
+ */
+static struct {
+    struct max32664SimConfig cfg;
+    struct max32664SimCounters counters;
+    uint64_t nowUs;             //simulated clock
+    uint32_t rng;               //fault injection generator state
+
+    bool resetHeld;             //reset pin driven low
+    uint64_t nackUntilUs;       //hub does not ACK before this time (booting)
+    uint64_t busyUntilUs;       //application commands get ERR_TRY_AGAIN before this time
+
+    uint8_t deviceMode;         //APP_MODE, RESET or BOOTLOADER_MODE
+    uint8_t outputMode;         //OUTPUT_MODE_WRITE_BYTE
+    uint8_t fifoThresh;         //output FIFO interrupt threshold
+    uint8_t agcEnable;
+    uint8_t sensorEnable;       //MAX30101 enabled
+    uint8_t hubAccelEnable;
+    uint8_t hostAccelEnable;
+    uint8_t whrmMode;           //0 disabled, MODE_ONE or MODE_TWO
+    uint8_t agcConfig[4];       //target %, step size, sensitivity, samples averaged
+    int32_t coef[NUM_MAXIM_FAST_COEF];
+    uint8_t regs[256];          //MAX30101 registers
+
+    uint8_t cmd[SIM_MAX_COMMAND]; //last host command
+    size_t cmdLen;
+    bool cmdPending;            //a command was written and its response not yet discarded
+    uint64_t cmdReadyUs;        //response valid from this time
+    uint8_t respStatus;         //status byte of the response
+    uint8_t resp[SIM_MAX_RESPONSE]; //response data bytes
+    size_t respLen;
+
+    uint64_t rateBaseUs;        //time the current sample rate took effect
+    uint64_t rateBaseSamples;   //samples produced before the current sample rate took effect
+    uint64_t samplesProduced;   //total samples produced since the sensor was enabled
+    uint64_t fifoHead;          //sample number of the oldest sample in the output FIFO
+    uint32_t fifoCount;         //samples in the output FIFO
+    bool fifoOverflowed;        //latched until the hub status is read
+    uint64_t whrmStartUs;       //time the WHRM algorithm was enabled
+    uint64_t lastReadSampleUs;  //time the last sample popped by the host was produced
+
+    uint32_t inputCount;        //samples in the external input FIFO
+    bool inputOverflowed;       //host wrote more than the input FIFO had room for
+
+    bool finger;
+    int8_t extStatus;
+
+    uint16_t btlNumPages;       //SET_NUM_PAGES
+    bool btlIvSet;              //SET_INIT_VECTOR_BYTES received
+    bool btlAuthSet;            //SET_AUTH_BYTES received
+    bool btlErased;             //ERASE_FLASH done, application invalid until every page is written
+    uint16_t btlPages;          //pages written since the erase
+    uint64_t btlBusyUntilUs;    //erase or page write in progress
+    bool btlDropped;            //btlDropPage was lost already
+} sim;
+
+
+/**
+ * @brief   xorshift32 step of the fault injection generator
+ */
+static uint32_t simRandom(void){
+    uint32_t x = sim.rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    sim.rng = x;
+    return x;
+}
+
+
+/**
+ * @brief   Stateless hash used for per-sample noise, so re-reading a sample always returns the same value
+ */
+static uint32_t simHash(uint64_t n, uint32_t salt){
+    uint64_t x = n * 0x9E3779B97F4A7C15ULL + salt + sim.cfg.seed;
+    x ^= x >> 31;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    return (uint32_t)x;
+}
+
+
+static bool simChance(uint16_t perMille){
+    if(perMille == 0){
+        return false;
+    }
+    return (simRandom() % 1000) < perMille;
+}
+
+
+/**
+ * @brief   Current output sample rate, from the SpO2 sample rate bits of the MAX30101 configuration register
+ */
+static uint32_t simSampleRate(void){
+    return simSampleRates[(sim.regs[CONFIGURATION_REGISTER] & READ_SAMP_MASK) >> 2];
+}
+
+
+static bool simStreaming(void){
+    return sim.sensorEnable && sim.outputMode != PAUSE && sim.outputMode != PAUSE_TWO && sim.deviceMode == APP_MODE;
+}
+
+
+/**
+ * @brief   Moves samples produced since the last call into the output FIFO, dropping the oldest ones on overflow
+ */
+static void simUpdateFifo(void){
+    if(!simStreaming()){
+        return;
+    }
+
+    uint64_t produced = sim.rateBaseSamples + (sim.nowUs - sim.rateBaseUs) * simSampleRate() / 1000000ULL;
+    uint64_t newSamples = produced - sim.samplesProduced;
+
+    sim.samplesProduced = produced;
+    sim.counters.samplesProduced += (uint32_t)newSamples;
+
+    if(sim.hostAccelEnable){ //each sample is paired with a host accelerometer sample from the input FIFO
+        uint64_t used = newSamples < sim.inputCount ? newSamples : sim.inputCount;
+        sim.inputCount -= (uint32_t)used;
+        sim.counters.accelUnderflows += (uint32_t)(newSamples - used);
+    }
+
+    if(sim.fifoCount + newSamples > SIM_OUTPUT_FIFO_DEPTH){ //FIFO overflow, oldest samples are lost
+        uint64_t lost = sim.fifoCount + newSamples - SIM_OUTPUT_FIFO_DEPTH;
+        sim.fifoHead += lost;
+        sim.fifoCount = SIM_OUTPUT_FIFO_DEPTH;
+        sim.counters.samplesOverflowed += (uint32_t)lost;
+        sim.fifoOverflowed = true;
+    }
+    else{
+        sim.fifoCount += (uint32_t)newSamples;
+    }
+}
+
+
+/**
+ * @brief   Rebases sample production (sample rate change, sensor/output enable)
+ */
+static void simRebase(void){
+    simUpdateFifo();
+    sim.rateBaseUs = sim.nowUs;
+    sim.rateBaseSamples = sim.samplesProduced;
+}
+
+
+/**
+ * @brief State of the simulated UART (see the TI-Drivers entry points below)
+ */
+static struct UART_Config_ {
+    uint32_t baudRate;
+    UART_Mode writeMode;
+    UART_Callback writeCallback;
+    const void *txBuf;          //callback mode write in progress
+    size_t txCount;
+    uint64_t txStartUs;
+    uint64_t txDoneUs;          //time the last byte of the write is out
+    bool txBusy;
+} simUartObject;
+
+
+/**
+ * @brief   Advances the simulated clock, completing a callback mode UART write on the way
+ */
+static void simAdvance(uint64_t us){
+    uint64_t targetUs = sim.nowUs + us;
+
+    while(simUartObject.txBusy && simUartObject.txDoneUs <= targetUs){ //the write callback may start the next write
+        if(simUartObject.txDoneUs > sim.nowUs){
+            sim.nowUs = simUartObject.txDoneUs;
+        }
+        simUartObject.txBusy = false;
+        if(simUartObject.writeCallback){
+            simUartObject.writeCallback(&simUartObject, (void *)simUartObject.txBuf, simUartObject.txCount);
+        }
+    }
+    sim.nowUs = targetUs;
+}
+
+
+/**
+ * @brief   Time of the given sample, us
+ */
+static double simSampleTimeUs(uint64_t n){
+    return (double)sim.rateBaseUs + (double)((int64_t)n - (int64_t)sim.rateBaseSamples) * 1000000.0 / (double)simSampleRate();
+}
+
+
+/**
+ * @brief   PPG pulse shape over one cardiac cycle, 0..1 (systolic peak with dicrotic notch)
+ */
+static double simPulseShape(double phase){
+    double v = 0.5 - 0.5 * cos(2.0 * M_PI * phase) + 0.25 * sin(4.0 * M_PI * phase + 0.8);
+    return v / 1.25;
+}
+
+
+static uint32_t simClip(double v){
+    if(v < 0.0) return 0;
+    if(v > SIM_ADC_MAX) return SIM_ADC_MAX;
+    return (uint32_t)v;
+}
+
+
+/**
+ * @brief   Cardiac cycles at time t (s): the integral of heart rate + rsaX10 * sin(respiration)
+ */
+static double simCardiacCycles(double t){
+    double heart = sim.cfg.heartRateX10 / 600.0; //Hz
+    double resp = sim.cfg.respRateX10 / 600.0; //Hz
+    double swing = sim.cfg.rsaX10 / 600.0; //Hz
+
+    if(swing == 0.0 || resp == 0.0){
+        return t * heart;
+    }
+    return t * heart + swing * (1.0 - cos(2.0 * M_PI * resp * t)) / (2.0 * M_PI * resp);
+}
+
+
+/**
+ * @brief   Generates the IR and red ADC counts of sample n, taken at time t (s)
+ */
+static void simPpgAt(uint64_t n, double t, uint32_t *ir, uint32_t *red){
+    double noiseIr = sim.cfg.noise ? (double)(simHash(n, 1) % (2U * sim.cfg.noise + 1U)) - sim.cfg.noise : 0.0;
+    double noiseRed = sim.cfg.noise ? (double)(simHash(n, 2) % (2U * sim.cfg.noise + 1U)) - sim.cfg.noise : 0.0;
+
+    if(!sim.finger){ //ambient light only
+        *ir = simClip(2000.0 + noiseIr);
+        *red = simClip(1500.0 + noiseRed);
+        return;
+    }
+
+    double cardiac = simPulseShape(fmod(simCardiacCycles(t), 1.0));
+    double resp = sin(2.0 * M_PI * t * sim.cfg.respRateX10 / 600.0);
+    double amp = 1.0 + 0.15 * resp; //respiratory amplitude modulation
+    double baseline = 1.0 + 0.003 * resp; //respiratory baseline modulation
+    double redAc = (double)sim.cfg.irAc * (double)sim.cfg.redDc / (double)sim.cfg.irDc * sim.cfg.rValueX1000 / 1000.0;
+
+    //absorption rises with blood volume, so the counts dip at the systolic peak
+    *ir = simClip(sim.cfg.irDc * baseline - sim.cfg.irAc * cardiac * amp + noiseIr);
+    *red = simClip(sim.cfg.redDc * baseline - redAc * cardiac * amp + noiseRed);
+}
+
+
+/**
+ * @brief   Generates the IR and red ADC counts of output FIFO sample n
+ */
+static void simPpg(uint64_t n, uint32_t *ir, uint32_t *red){
+    simPpgAt(n, simSampleTimeUs(n) / 1000000.0, ir, red);
+}
+
+
+/**
+ * @brief   Number of bytes of one sample in the current output mode
+ */
+static size_t simSampleSize(void){
+    size_t size = 0;
+    uint8_t mode = sim.outputMode;
+
+    if(mode >= SENSOR_COUNTER_BYTE){ //counter byte modes
+        size += SIM_COUNTER_BYTES;
+    }
+    if(mode == SENSOR_DATA || mode == SENSOR_AND_ALGORITHM || mode == SENSOR_COUNTER_BYTE || mode == SENSOR_ALGO_COUNTER){
+        size += SIM_RAW_BYTES;
+    }
+    if(mode == ALGO_DATA || mode == SENSOR_AND_ALGORITHM || mode == ALGO_COUNTER_BYTE || mode == SENSOR_ALGO_COUNTER){
+        size += (sim.whrmMode == MODE_TWO) ? MAXFAST_ARRAY_SIZE + MAXFAST_EXTENDED_DATA : MAXFAST_ARRAY_SIZE;
+    }
+    return size;
+}
+
+
+static void simPut24(uint8_t *buf, uint32_t v){
+    buf[0] = (uint8_t)(v >> 16);
+    buf[1] = (uint8_t)(v >> 8);
+    buf[2] = (uint8_t)v;
+}
+
+
+static void simPut16(uint8_t *buf, uint16_t v){
+    buf[0] = (uint8_t)(v >> 8);
+    buf[1] = (uint8_t)v;
+}
+
+
+/**
+ * @brief   Serializes sample n in the current output mode, returns the number of bytes written
+ */
+static size_t simEncodeSample(uint64_t n, uint8_t *buf){
+    size_t pos = 0;
+    uint8_t mode = sim.outputMode;
+    uint32_t ir, red;
+
+    simPpg(n, &ir, &red);
+
+    if(mode >= SENSOR_COUNTER_BYTE){
+        buf[pos++] = (uint8_t)n;
+    }
+
+    if(mode == SENSOR_DATA || mode == SENSOR_AND_ALGORITHM || mode == SENSOR_COUNTER_BYTE || mode == SENSOR_ALGO_COUNTER){
+        memset(&buf[pos], 0, SIM_RAW_BYTES);
+        simPut24(&buf[pos], ir);
+        simPut24(&buf[pos + 3], red);
+        pos += SIM_RAW_BYTES;
+    }
+
+    if(mode == ALGO_DATA || mode == SENSOR_AND_ALGORITHM || mode == ALGO_COUNTER_BYTE || mode == SENSOR_ALGO_COUNTER){
+        size_t algoSize = (sim.whrmMode == MODE_TWO) ? MAXFAST_ARRAY_SIZE + MAXFAST_EXTENDED_DATA : MAXFAST_ARRAY_SIZE;
+        memset(&buf[pos], 0, algoSize);
+
+        if(sim.whrmMode != DISABLE){
+            double t = simSampleTimeUs(n);
+            double elapsed = t - (double)sim.whrmStartUs;
+            uint8_t confidence = 0;
+            uint16_t heartRate = 0;
+            uint16_t oxygen = 0;
+            uint8_t state = 0;
+            int8_t ext = -3; //no object
+
+            if(sim.finger){
+                double r = sim.cfg.rValueX1000 / 1000.0;
+                double spo2 = (sim.coef[0] * r * r + sim.coef[1] * r + sim.coef[2]) / 100000.0;
+
+                confidence = (elapsed >= sim.cfg.confidenceRampUs) ? 100 : (uint8_t)(elapsed * 100.0 / sim.cfg.confidenceRampUs);
+                heartRate = (uint16_t)(sim.cfg.heartRateX10 + 10.0 * sin(2.0 * M_PI * t / 20000000.0)); //slow +-1bpm drift
+                oxygen = (uint16_t)(spo2 * 10.0 + 0.5);
+                state = 3; //finger detected
+                ext = (confidence < 100) ? 1 : sim.extStatus; //not ready until the algorithm has settled
+                if(sim.extStatus != 0){
+                    ext = sim.extStatus;
+                }
+            }
+
+            simPut16(&buf[pos], heartRate);
+            buf[pos + 2] = confidence;
+            simPut16(&buf[pos + 3], oxygen);
+            buf[pos + 5] = state;
+            if(sim.whrmMode == MODE_TWO){
+                simPut16(&buf[pos + 6], (uint16_t)((sim.cfg.rValueX1000 + 50) / 100)); //R value, LSB = 0.1
+                buf[pos + 8] = (uint8_t)ext;
+            }
+        }
+        pos += algoSize;
+    }
+
+    return pos;
+}
+
+
+/**
+ * @brief   Resets the hub configuration to its power-on state (used on reset pin, RESET and EXIT_BOOTLOADER)
+ */
+static void simResetHubState(void){
+    sim.outputMode = PAUSE;
+    sim.fifoThresh = 1;
+    sim.agcEnable = 0;
+    sim.sensorEnable = 0;
+    sim.hubAccelEnable = 0;
+    sim.hostAccelEnable = 0;
+    sim.whrmMode = 0;
+    sim.agcConfig[0] = 15; //target percent of full scale
+    sim.agcConfig[1] = 5;  //step size
+    sim.agcConfig[2] = 15; //sensitivity
+    sim.agcConfig[3] = 100; //samples averaged
+    memcpy(sim.coef, simDefaultCoef, sizeof(sim.coef));
+    sim.fifoCount = 0;
+    sim.fifoHead = 0;
+    sim.samplesProduced = 0;
+    sim.rateBaseSamples = 0;
+    sim.rateBaseUs = sim.nowUs;
+    sim.fifoOverflowed = false;
+    sim.inputCount = 0;
+    sim.inputOverflowed = false;
+}
+
+
+/**
+ * @brief   Resets the MAX30101 registers to their power-on values
+ */
+static void simResetMax30101(void){
+    memset(sim.regs, 0, sizeof(sim.regs));
+    sim.regs[MODE_REGISTER] = SIM_DEFAULT_MODE_REG;
+    sim.regs[CONFIGURATION_REGISTER] = SIM_DEFAULT_CONFIG_REG;
+    sim.regs[LED1_REGISTER] = SIM_DEFAULT_LED_AMP;
+    sim.regs[LED2_REGISTER] = SIM_DEFAULT_LED_AMP;
+    sim.regs[LED3_REGISTER] = SIM_DEFAULT_LED_AMP;
+    sim.regs[LED4_REGISTER] = SIM_DEFAULT_LED_AMP;
+    sim.regs[0xFF] = 0x15; //part ID
+}
+
+
+/**
+ * @brief   Queues a response for the read phase
+ */
+static void simRespond(uint8_t status, const uint8_t *data, size_t len){
+    sim.respStatus = status;
+    sim.respLen = len;
+    if(len > 0){
+        memcpy(sim.resp, data, len);
+    }
+}
+
+
+static void simRespondByte(uint8_t value){
+    simRespond(SUCCESS, &value, 1);
+}
+
+
+static void simRespond16(uint16_t value){
+    uint8_t data[2];
+    simPut16(data, value);
+    simRespond(SUCCESS, data, 2);
+}
+
+
+/**
+ * @brief   Processing time of a command (the read phase returns ERR_TRY_AGAIN before it elapses)
+ */
+static uint32_t simLatencyUs(uint8_t family){
+    if(family == ENABLE_SENSOR || family == ENABLE_ALGORITHM){
+        return sim.cfg.enableLatencyUs;
+    }
+    return sim.cfg.cmdLatencyUs;
+}
+
+
+/**
+ * @brief   CRC-32 (IEEE, reflected) of a buffer, continuing from crc (0 for a new CRC)
+ */
+static uint32_t simCrc32(uint32_t crc, const uint8_t *buf, size_t len){
+    size_t i;
+    int bit;
+
+    crc = ~crc;
+    for(i = 0; i < len; i++){
+        crc ^= buf[i];
+        for(bit = 0; bit < 8; bit++){
+            crc = (crc >> 1) ^ (0xEDB88320U & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+
+void max32664SimPageMac(uint16_t pageIndex, const uint8_t *page, uint16_t len, uint8_t *mac){
+    uint8_t index[2] = {(uint8_t)pageIndex, (uint8_t)(pageIndex >> 8)};
+    uint32_t crc = simCrc32(simCrc32(0, index, 2), page, len);
+    int i;
+
+    for(i = 0; i < SIM_PAGE_MAC_SIZE; i++){ //four copies of the CRC, little endian
+        mac[i] = (uint8_t)(crc >> (8 * (i % 4)));
+    }
+}
+
+
+/**
+ * @brief   Executes a bootloader flash command (BOOTLOADER_FLASH family, bootloader mode only). Erase and page writes
+ *          keep the bootloader busy: their status reads ERR_BTLDR_TRY_AGAIN until done, and commands written
+ *          meanwhile are refused with ERR_BTLDR_TRY_AGAIN
+ */
+static void simBootloaderFlash(uint8_t index, const uint8_t *data, size_t len){
+    uint8_t mac[SIM_PAGE_MAC_SIZE];
+
+    if(sim.nowUs < sim.btlBusyUntilUs){ //previous erase/page write still running
+        simRespond(ERR_BTLDR_TRY_AGAIN, NULL, 0);
+        return;
+    }
+
+    switch(index){
+    case SET_NUM_PAGES:
+        if(len != 2){
+            simRespond(ERR_DATA_FORMAT, NULL, 0);
+            break;
+        }
+        sim.btlNumPages = (uint16_t)((data[0] << 8) | data[1]); //MSB first
+        simRespond(SUCCESS, NULL, 0);
+        break;
+
+    case SET_INIT_VECTOR_BYTES:
+    case SET_AUTH_BYTES:
+        if(len != (index == SET_INIT_VECTOR_BYTES ? SIM_IV_SIZE : SIM_AUTH_SIZE)){
+            simRespond(ERR_DATA_FORMAT, NULL, 0);
+            break;
+        }
+        if(index == SET_INIT_VECTOR_BYTES) sim.btlIvSet = true;
+        else sim.btlAuthSet = true;
+        simRespond(SUCCESS, NULL, 0);
+        break;
+
+    case ERASE_FLASH:
+        if(sim.btlNumPages == 0){
+            simRespond(ERR_BTLDR_GENERAL, NULL, 0);
+            break;
+        }
+        sim.btlErased = true;
+        sim.btlPages = 0;
+        sim.btlBusyUntilUs = sim.nowUs + sim.cfg.btlEraseUs;
+        sim.cmdReadyUs = sim.btlBusyUntilUs;
+        simRespond(SUCCESS, NULL, 0);
+        break;
+
+    case SEND_PAGE_VALUE:
+        if(len != SIM_PAGE_SIZE + SIM_PAGE_MAC_SIZE){
+            simRespond(ERR_DATA_FORMAT, NULL, 0);
+            break;
+        }
+        if(!sim.btlErased || !sim.btlIvSet || !sim.btlAuthSet || sim.btlPages >= sim.btlNumPages){ //out of sequence
+            simRespond(ERR_BTLDR_GENERAL, NULL, 0);
+            break;
+        }
+        if(sim.btlPages + 1 == sim.cfg.btlDropPage && !sim.btlDropped){ //lost: the status never settles, a resend is taken
+            sim.btlDropped = true;
+            sim.cmdReadyUs = UINT64_MAX;
+            break;
+        }
+        max32664SimPageMac(sim.btlPages, data, SIM_PAGE_SIZE, mac);
+        sim.btlBusyUntilUs = sim.nowUs + sim.cfg.btlPageUs;
+        sim.cmdReadyUs = sim.btlBusyUntilUs;
+        if(memcmp(mac, &data[SIM_PAGE_SIZE], SIM_PAGE_MAC_SIZE) != 0){ //page does not authenticate
+            simRespond(ERR_BTLDR_CHECKSUM, NULL, 0);
+            break;
+        }
+        sim.btlPages++;
+        sim.counters.pagesFlashed++;
+        simRespond(SUCCESS, NULL, 0);
+        break;
+
+    default:
+        simRespond(ERR_UNAVAIL_CMD, NULL, 0);
+        break;
+    }
+}
+
+
+/**
+ * @brief   Executes a host command (write phase) and queues its response
+ */
+static void simExecute(const uint8_t *cmd, size_t len){
+    uint8_t family = len > 0 ? cmd[0] : 0xFF;
+    uint8_t index = len > 1 ? cmd[1] : 0xFF;
+    uint8_t w0 = len > 2 ? cmd[2] : 0;
+    size_t writeBytes = len > 2 ? len - 2 : 0;
+    uint8_t data[SIM_MAX_RESPONSE];
+    int i;
+
+    simRespond(ERR_UNAVAIL_CMD, NULL, 0);
+
+    if(len < 2){ //need at least a family and an index byte
+        simRespond(ERR_DATA_FORMAT, NULL, 0);
+        return;
+    }
+
+    //commands handled in every device mode
+    if(family == READ_DEVICE_MODE){
+        simRespondByte(sim.deviceMode);
+        return;
+    }
+    if(family == SET_DEVICE_MODE){
+        if(writeBytes != 1){
+            simRespond(ERR_DATA_FORMAT, NULL, 0);
+        }
+        else if(w0 == EXIT_BOOTLOADER){
+            if(sim.deviceMode == BOOTLOADER_MODE && sim.btlErased && sim.btlPages != sim.btlNumPages){ //partial image
+                simRespond(ERR_BTLDR_INVALID_APP, NULL, 0);
+                return;
+            }
+            sim.btlErased = false;
+            if(sim.deviceMode != APP_MODE){ //leaving reset/bootloader starts the application
+                sim.deviceMode = APP_MODE;
+                simResetHubState();
+                sim.busyUntilUs = sim.nowUs + sim.cfg.appInitUs;
+            }
+            simRespond(SUCCESS, NULL, 0);
+        }
+        else if(w0 == RESET){
+            sim.deviceMode = RESET;
+            simResetHubState();
+            simResetMax30101();
+            simRespond(SUCCESS, NULL, 0);
+        }
+        else if(w0 == ENTER_BOOTLOADER){
+            sim.deviceMode = BOOTLOADER_MODE;
+            simResetHubState();
+            simRespond(SUCCESS, NULL, 0);
+        }
+        else{
+            simRespond(ERR_INPUT_VALUE, NULL, 0);
+        }
+        return;
+    }
+    if(family == HUB_STATUS){
+        uint8_t status = 0;
+        simUpdateFifo();
+        if(sim.fifoCount >= sim.fifoThresh && sim.fifoCount > 0) status |= SIM_HUB_STATUS_DATA_RDY;
+        if(sim.fifoOverflowed) status |= SIM_HUB_STATUS_OUT_OVR;
+        if(sim.inputOverflowed) status |= SIM_HUB_STATUS_IN_OVR;
+        if(sim.nowUs < sim.busyUntilUs) status |= SIM_HUB_STATUS_DEV_BUSY;
+        sim.fifoOverflowed = false;
+        sim.inputOverflowed = false;
+        simRespondByte(status);
+        return;
+    }
+    if(family == IDENTITY){
+        if(index == READ_MCU_TYPE) simRespondByte(0x01); //MAX32660/MAX32664
+        else if(index == READ_SENSOR_HUB_VERS) simRespond(SUCCESS, simHubVersion, 3);
+        else if(index == READ_ALGO_VERS) simRespond(ERR_UNAVAIL_CMD, NULL, 0); //deprecated, as on the real hub
+        return;
+    }
+    if(family == BOOTLOADER_INFO){
+        if(index == BOOTLOADER_VERS) simRespond(SUCCESS, simBootVersion, 3);
+        else if(index == PAGE_SIZE) simRespond16(SIM_PAGE_SIZE);
+        return;
+    }
+
+    if(sim.deviceMode == BOOTLOADER_MODE){ //application commands are not available in the bootloader
+        if(family == BOOTLOADER_FLASH){
+            simBootloaderFlash(index, &cmd[2], writeBytes);
+        }
+        else{
+            simRespond(ERR_UNAVAIL_CMD, NULL, 0);
+        }
+        return;
+    }
+    if(sim.deviceMode != APP_MODE || sim.nowUs < sim.busyUntilUs){ //held in reset or still initializing
+        simRespond(ERR_TRY_AGAIN, NULL, 0);
+        return;
+    }
+
+    switch(family){
+    case OUTPUT_MODE:
+        if(writeBytes != 1){
+            simRespond(ERR_DATA_FORMAT, NULL, 0);
+        }
+        else if(index == SET_FORMAT){
+            if(w0 > SENSOR_ALGO_COUNTER){
+                simRespond(ERR_INPUT_VALUE, NULL, 0);
+                break;
+            }
+            simRebase();
+            sim.outputMode = w0;
+            sim.fifoCount = 0; //changing the format flushes the FIFO
+            simRespond(SUCCESS, NULL, 0);
+        }
+        else if(index == WRITE_SET_THRESHOLD){
+            if(w0 == 0){
+                simRespond(ERR_INPUT_VALUE, NULL, 0);
+                break;
+            }
+            sim.fifoThresh = w0;
+            simRespond(SUCCESS, NULL, 0);
+        }
+        break;
+
+    case READ_OUTPUT_MODE:
+        if(index == SET_FORMAT) simRespondByte(sim.outputMode);
+        else if(index == READ_FORMAT) simRespondByte(sim.fifoThresh);
+        break;
+
+    case READ_DATA_OUTPUT:
+        if(index == NUM_SAMPLES){
+            simUpdateFifo();
+            simRespondByte((uint8_t)sim.fifoCount);
+        }
+        else if(index == READ_DATA){
+            simRespond(SUCCESS, NULL, 0); //samples are popped during the read phase
+        }
+        break;
+
+    case READ_DATA_INPUT:
+        if(index == SAMPLE_SIZE) simRespondByte(6); //3 axis x 16-bit
+        else if(index == READ_INPUT_DATA) simRespond16(SIM_INPUT_FIFO_DEPTH);
+        else if(index == READ_SENSOR_DATA) simRespond16(SIM_OUTPUT_FIFO_DEPTH);
+        else if(index == READ_NUM_SAMPLES_INPUT){
+            simUpdateFifo();
+            simRespond16((uint16_t)sim.inputCount);
+        }
+        else if(index == READ_NUM_SAMPLES_SENSOR) simRespond16(0);
+        break;
+
+    case WRITE_INPUT:
+        if(index != WRITE_EXTERNAL_TO_FIFO){
+            simRespond(ERR_UNAVAIL_FUNC, NULL, 0);
+        }
+        else if(writeBytes == 0 || writeBytes % SIM_ACCEL_BYTES != 0){
+            simRespond(ERR_DATA_FORMAT, NULL, 0);
+        }
+        else if(!sim.hostAccelEnable){
+            simRespond(ERR_UNAVAIL_FUNC, NULL, 0);
+        }
+        else{
+            uint32_t samples = (uint32_t)(writeBytes / SIM_ACCEL_BYTES);
+            uint32_t room;
+
+            simUpdateFifo(); //samples produced so far used what was already there
+            room = SIM_INPUT_FIFO_DEPTH - sim.inputCount;
+            if(samples > room){ //newest samples are lost
+                sim.counters.accelOverflows += samples - room;
+                sim.inputOverflowed = true;
+                samples = room;
+            }
+            sim.inputCount += samples;
+            sim.counters.accelWritten += samples;
+            simRespond(SUCCESS, NULL, 0);
+        }
+        break;
+
+    case WRITE_REGISTER:
+        if(index == WRITE_MAX30101){
+            if(writeBytes != 2){
+                simRespond(ERR_DATA_FORMAT, NULL, 0);
+                break;
+            }
+            uint8_t reg = cmd[2];
+            uint8_t val = cmd[3];
+            if(reg == MODE_REGISTER && (val & SET_RESET_BIT)){ //reset control bit
+                simRebase();
+                simResetMax30101();
+                simRebase();
+            }
+            else if(reg == CONFIGURATION_REGISTER){ //sample rate may change
+                simRebase();
+                sim.regs[reg] = val;
+            }
+            else{
+                sim.regs[reg] = val;
+            }
+            simRespond(SUCCESS, NULL, 0);
+        }
+        else{
+            simRespond(ERR_UNAVAIL_FUNC, NULL, 0);
+        }
+        break;
+
+    case READ_REGISTER:
+        if(index == READ_MAX30101 && writeBytes == 1) simRespondByte(sim.regs[w0]);
+        else if(index == READ_MAX30101) simRespond(ERR_DATA_FORMAT, NULL, 0);
+        else simRespond(ERR_UNAVAIL_FUNC, NULL, 0);
+        break;
+
+    case READ_ATTRIBUTES_AFE:
+        if(index == RETRIEVE_AFE_MAX30101){
+            data[0] = 1;    //bytes per word
+            data[1] = 0x36; //number of registers
+            simRespond(SUCCESS, data, 2);
+        }
+        else if(index == RETRIEVE_AFE_ACCELEROMETER){
+            data[0] = 1;
+            data[1] = 0x3B;
+            simRespond(SUCCESS, data, 2);
+        }
+        break;
+
+    case DUMP_REGISTERS:
+        simRespond(ERR_UNAVAIL_FUNC, NULL, 0);
+        break;
+
+    case ENABLE_SENSOR:
+        if(writeBytes < 1 || w0 > 1){
+            simRespond(ERR_INPUT_VALUE, NULL, 0);
+        }
+        else if(index == ENABLE_MAX30101){
+            simRebase();
+            if(w0 && !sim.sensorEnable){ //sampling starts now
+                sim.rateBaseUs = sim.nowUs;
+            }
+            sim.sensorEnable = w0;
+            simRespond(SUCCESS, NULL, 0);
+        }
+        else if(index == ENABLE_ACCELEROMETER){
+            simUpdateFifo();
+            sim.hubAccelEnable = w0;
+            sim.hostAccelEnable = (writeBytes > 1) ? cmd[3] : 0;
+            simRespond(SUCCESS, NULL, 0);
+        }
+        break;
+
+    case READ_SENSOR_MODE:
+        if(index == READ_ENABLE_MAX30101){
+            simRespondByte(sim.sensorEnable);
+        }
+        else if(index == READ_ENABLE_ACCELEROMETER){
+            data[0] = sim.hubAccelEnable;
+            data[1] = sim.hostAccelEnable;
+            simRespond(SUCCESS, data, 2);
+        }
+        break;
+
+    case CHANGE_ALGORITHM_CONFIG:
+        if(index == SET_TARG_PERC && writeBytes == 2 && w0 <= AGC_NUM_SAMP_ID){
+            sim.agcConfig[w0] = cmd[3];
+            simRespond(SUCCESS, NULL, 0);
+        }
+        else if(index == SET_PULSE_OX_COEF && w0 == MAXIMFAST_COEF_ID && writeBytes == 1 + 4 * NUM_MAXIM_FAST_COEF){
+            for(i = 0; i < NUM_MAXIM_FAST_COEF; i++){
+                sim.coef[i] = (int32_t)(((uint32_t)cmd[3 + 4 * i] << 24) | ((uint32_t)cmd[4 + 4 * i] << 16) |
+                                        ((uint32_t)cmd[5 + 4 * i] << 8) | (uint32_t)cmd[6 + 4 * i]);
+            }
+            simRespond(SUCCESS, NULL, 0);
+        }
+        else{
+            simRespond(ERR_INPUT_VALUE, NULL, 0);
+        }
+        break;
+
+    case READ_ALGORITHM_CONFIG:
+        if(index == READ_AGC_PERCENTAGE && writeBytes == 1 && w0 <= READ_AGC_NUM_SAMPLES_ID){
+            simRespondByte(sim.agcConfig[w0]);
+        }
+        else if(index == READ_MAX_FAST_RATE && w0 == READ_MAX_FAST_RATE_ID){
+            simRespond16(100); //WHRM runs at 100Hz
+        }
+        else if(index == READ_MAX_FAST_COEF && w0 == READ_MAX_FAST_COEF_ID){
+            for(i = 0; i < NUM_MAXIM_FAST_COEF; i++){
+                data[4 * i] = (uint8_t)((uint32_t)sim.coef[i] >> 24);
+                data[4 * i + 1] = (uint8_t)((uint32_t)sim.coef[i] >> 16);
+                data[4 * i + 2] = (uint8_t)((uint32_t)sim.coef[i] >> 8);
+                data[4 * i + 3] = (uint8_t)sim.coef[i];
+            }
+            simRespond(SUCCESS, data, 4 * NUM_MAXIM_FAST_COEF);
+        }
+        else{
+            simRespond(ERR_UNAVAIL_CMD, NULL, 0); //e.g. default height, motion threshold: not in this firmware
+        }
+        break;
+
+    case ENABLE_ALGORITHM:
+        if(writeBytes != 1){
+            simRespond(ERR_DATA_FORMAT, NULL, 0);
+        }
+        else if(index == ENABLE_AGC_ALGO && w0 <= 1){
+            sim.agcEnable = w0;
+            simRespond(SUCCESS, NULL, 0);
+        }
+        else if(index == ENABLE_WHRM_ALGO && w0 <= MODE_TWO){
+            simRebase();
+            if(w0 != sim.whrmMode){
+                sim.whrmStartUs = sim.nowUs;
+                sim.fifoCount = 0; //sample layout changed, flush
+            }
+            sim.whrmMode = w0;
+            simRespond(SUCCESS, NULL, 0);
+        }
+        else{
+            simRespond(ERR_INPUT_VALUE, NULL, 0);
+        }
+        break;
+
+    default:
+        simRespond(ERR_UNAVAIL_CMD, NULL, 0);
+        break;
+    }
+}
+
+
+/**
+ * @brief   Fills the read phase of a transfer
+ */
+static void simRead(uint8_t *buf, size_t count){
+    memset(buf, 0, count);
+
+    if(!sim.cmdPending){ //nothing was asked
+        buf[0] = ERR_UNAVAIL_CMD;
+        return;
+    }
+
+    if(sim.nowUs < sim.cmdReadyUs || simChance(sim.cfg.tryAgainPerMille)){ //hub still processing
+        buf[0] = (sim.deviceMode == BOOTLOADER_MODE && sim.cmd[0] == BOOTLOADER_FLASH) ? ERR_BTLDR_TRY_AGAIN : ERR_TRY_AGAIN;
+        sim.counters.tryAgain++;
+        return;
+    }
+
+    buf[0] = sim.respStatus;
+
+    if(sim.respStatus != SUCCESS){
+        return;
+    }
+
+    if(sim.cmd[0] == READ_DATA_OUTPUT && sim.cmd[1] == READ_DATA){ //pop as many whole samples as fit in the read
+        size_t sampleSize = simSampleSize();
+        size_t pos = 1;
+
+        simUpdateFifo();
+
+        if(sim.fifoCount == 0){
+            sim.counters.emptyReads++;
+            return;
+        }
+
+        while(sampleSize > 0 && pos + sampleSize <= count && sim.fifoCount > 0){
+            simEncodeSample(sim.fifoHead, &buf[pos]);
+            sim.lastReadSampleUs = (uint64_t)simSampleTimeUs(sim.fifoHead + 1); //a sample is complete at the end of its period
+            pos += sampleSize;
+            sim.fifoHead++;
+            sim.fifoCount--;
+            sim.counters.samplesRead++;
+        }
+        return;
+    }
+
+    memcpy(&buf[1], sim.resp, (sim.respLen < count - 1) ? sim.respLen : count - 1);
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// Public simulator API
+
+
+void max32664SimDefaultConfig(struct max32664SimConfig *cfg){
+    cfg->busHz = 400000;
+    cfg->cmdLatencyUs = 2000;
+    cfg->enableLatencyUs = 40000;
+    cfg->resetBootUs = 50000;
+    cfg->appInitUs = 800000;
+    cfg->confidenceRampUs = 8000000;
+    cfg->heartRateX10 = 720;
+    cfg->respRateX10 = 150;
+    cfg->rsaX10 = 0;
+    cfg->irDc = 120000;
+    cfg->redDc = 100000;
+    cfg->irAc = 1200;
+    cfg->rValueX1000 = 500;
+    cfg->noise = 40;
+    cfg->tryAgainPerMille = 0;
+    cfg->nackPerMille = 0;
+    cfg->seed = 0x1234567;
+    cfg->btlEraseUs = 1400000;
+    cfg->btlPageUs = 340000;
+    cfg->btlDropPage = 0;
+}
+
+
+void max32664SimInit(const struct max32664SimConfig *cfg){
+    memset(&sim, 0, sizeof(sim));
+
+    if(cfg){
+        sim.cfg = *cfg;
+    }
+    else{
+        max32664SimDefaultConfig(&sim.cfg);
+    }
+
+    sim.rng = sim.cfg.seed ? sim.cfg.seed : 1;
+    sim.deviceMode = APP_MODE;
+    sim.finger = true;
+    simResetMax30101();
+    simResetHubState();
+    simUartObject.txBusy = false; //no write in progress on the new clock
+}
+
+
+uint64_t max32664SimNowUs(void){
+    return sim.nowUs;
+}
+
+
+void max32664SimAdvanceUs(uint64_t us){
+    simAdvance(us);
+}
+
+
+void max32664SimGetCounters(struct max32664SimCounters *counters){
+    *counters = sim.counters;
+}
+
+
+void max32664SimResetCounters(void){
+    memset(&sim.counters, 0, sizeof(sim.counters));
+}
+
+
+void max32664SimSetFinger(bool present){
+    sim.finger = present;
+}
+
+
+void max32664SimSetExtStatus(int8_t extStatus){
+    sim.extStatus = extStatus;
+}
+
+
+void max32664SimSetVitals(uint16_t heartRateX10, uint16_t rValueX1000){
+    sim.cfg.heartRateX10 = heartRateX10;
+    sim.cfg.rValueX1000 = rValueX1000;
+}
+
+
+void max32664SimPpg(uint64_t n, uint16_t sampleRate, uint32_t *ir, uint32_t *red){
+    simPpgAt(n, (double)n / sampleRate, ir, red);
+}
+
+
+double max32664SimCardiacCycles(double t){
+    return simCardiacCycles(t);
+}
+
+
+uint32_t max32664SimFifoCount(void){
+    simUpdateFifo();
+    return sim.fifoCount;
+}
+
+
+uint64_t max32664SimLastReadSampleUs(void){
+    return sim.lastReadSampleUs;
+}
+
+
+/////////////////////////////////////////////////////////////////////////////
+// TI-Drivers I2C/GPIO/UART/NVS and POSIX time entry points used by the library
+
+
+static struct I2C_Config_ {
+    uint32_t busHz;
+} simI2cObject;
+
+
+void I2C_init(void){
+}
+
+
+void I2C_Params_init(I2C_Params *params){
+    memset(params, 0, sizeof(*params));
+    params->transferMode = I2C_MODE_BLOCKING;
+    params->bitRate = I2C_100kHz;
+}
+
+
+I2C_Handle I2C_open(uint_least8_t index, I2C_Params *params){
+    if(index >= CONFIG_TI_DRIVERS_I2C_COUNT){
+        return NULL;
+    }
+    simI2cObject.busHz = (params && params->bitRate == I2C_100kHz) ? 100000 : sim.cfg.busHz;
+    return &simI2cObject;
+}
+
+
+void I2C_close(I2C_Handle handle){
+    (void)handle;
+}
+
+
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction){
+    uint32_t busHz = (handle && handle->busHz) ? handle->busHz : sim.cfg.busHz;
+    size_t bits = 0;
+
+    sim.counters.transfers++;
+
+    //START + address + ACK, data bytes + ACKs, STOP (repeated START for a combined write/read)
+    if(transaction->writeCount > 0) bits += 2 + 9 + 9 * transaction->writeCount;
+    if(transaction->readCount > 0) bits += 2 + 9 + 9 * transaction->readCount;
+    uint64_t busUs = (bits * 1000000ULL + busHz - 1) / busHz;
+    simAdvance(busUs);
+    sim.counters.busUs += busUs;
+
+    if(sim.resetHeld || sim.nowUs < sim.nackUntilUs || transaction->slaveAddress != SIM_I2C_ADDRESS){
+        transaction->status = I2C_STATUS_ADDR_NACK;
+        sim.counters.nacks++;
+        return false;
+    }
+    if(simChance(sim.cfg.nackPerMille)){
+        transaction->status = I2C_STATUS_DATA_NACK;
+        sim.counters.nacks++;
+        return false;
+    }
+
+    sim.counters.bytesTx += (uint32_t)transaction->writeCount;
+    sim.counters.bytesRx += (uint32_t)transaction->readCount;
+
+    if(transaction->writeCount > 0){ //write phase: a new host command
+        const uint8_t *tx = (const uint8_t *)transaction->writeBuf;
+        size_t len = transaction->writeCount < SIM_MAX_COMMAND ? transaction->writeCount : SIM_MAX_COMMAND;
+
+        memcpy(sim.cmd, tx, len);
+        sim.cmdLen = len;
+        sim.cmdPending = true;
+        sim.cmdReadyUs = sim.nowUs + simLatencyUs(tx[0]);
+        sim.counters.commands++;
+        simExecute(tx, transaction->writeCount); //whole command: page writes are longer than what is kept
+    }
+
+    if(transaction->readCount > 0){ //read phase: status byte + response
+        simRead((uint8_t *)transaction->readBuf, transaction->readCount);
+    }
+
+    transaction->status = I2C_STATUS_SUCCESS;
+    return true;
+}
+
+
+void GPIO_init(void){
+}
+
+
+int_fast16_t GPIO_setConfig(uint_least8_t index, GPIO_PinConfig pinConfig){
+    if(index == Board_GPIO_DIO0_RESET && !(pinConfig & GPIO_CFG_INPUT)){
+        GPIO_write(index, (pinConfig & GPIO_CFG_OUT_HIGH) ? 1 : 0);
+    }
+    return 0;
+}
+
+
+void GPIO_write(uint_least8_t index, unsigned int value){
+    if(index != Board_GPIO_DIO0_RESET){ //only the hub reset pin is modelled
+        return;
+    }
+
+    if(!value){ //hub held in reset
+        sim.resetHeld = true;
+    }
+    else if(sim.resetHeld){ //rising edge: boot the application (MFIO high)
+        sim.resetHeld = false;
+        sim.cmdPending = false;
+        sim.deviceMode = APP_MODE;
+        simResetMax30101();
+        simResetHubState();
+        sim.nackUntilUs = sim.nowUs + sim.cfg.resetBootUs;
+        sim.busyUntilUs = sim.nackUntilUs + sim.cfg.appInitUs;
+    }
+}
+
+
+uint_fast8_t GPIO_read(uint_least8_t index){
+    (void)index;
+    return 1;
+}
+
+
+void UART_init(void){
+}
+
+
+void UART_Params_init(UART_Params *params){
+    memset(params, 0, sizeof(*params));
+    params->readMode = UART_MODE_BLOCKING;
+    params->writeMode = UART_MODE_BLOCKING;
+    params->readTimeout = UART_WAIT_FOREVER;
+    params->writeTimeout = UART_WAIT_FOREVER;
+    params->readReturnMode = UART_RETURN_FULL;
+    params->readDataMode = UART_DATA_TEXT;
+    params->writeDataMode = UART_DATA_TEXT;
+    params->readEcho = UART_ECHO_ON;
+    params->baudRate = 115200;
+    params->dataLength = UART_LEN_8;
+}
+
+
+UART_Handle UART_open(uint_least8_t index, UART_Params *params){
+    if(index >= CONFIG_TI_DRIVERS_UART_COUNT || params == NULL || params->baudRate == 0){
+        return NULL;
+    }
+    if(params->writeMode == UART_MODE_CALLBACK && params->writeCallback == NULL){
+        return NULL;
+    }
+    memset(&simUartObject, 0, sizeof(simUartObject));
+    simUartObject.baudRate = params->baudRate;
+    simUartObject.writeMode = params->writeMode;
+    simUartObject.writeCallback = params->writeCallback;
+    return &simUartObject;
+}
+
+
+void UART_close(UART_Handle handle){
+    handle->txBusy = false;
+}
+
+
+/**
+ * @brief   Time to send bytes at 8N1 (10 bit times per byte), us
+ */
+static uint64_t simUartTimeUs(UART_Handle handle, size_t count){
+    return (count * 10ULL * 1000000ULL + handle->baudRate - 1) / handle->baudRate;
+}
+
+
+int_fast32_t UART_write(UART_Handle handle, const void *buffer, size_t size){
+    uint64_t us = simUartTimeUs(handle, size);
+
+    if(handle->writeMode == UART_MODE_CALLBACK){
+        if(handle->txBusy){ //the driver allows one write at a time
+            return UART_ERROR;
+        }
+        handle->txBuf = buffer;
+        handle->txCount = size;
+        handle->txStartUs = sim.nowUs;
+        handle->txDoneUs = sim.nowUs + us;
+        handle->txBusy = true;
+    }
+    else{
+        simAdvance(us);
+    }
+
+    sim.counters.uartWrites++;
+    sim.counters.uartBytes += (uint32_t)size;
+    sim.counters.uartBusyUs += us;
+    return handle->writeMode == UART_MODE_CALLBACK ? 0 : (int_fast32_t)size;
+}
+
+
+void UART_writeCancel(UART_Handle handle){
+    size_t sent;
+
+    if(!handle->txBusy){
+        return;
+    }
+    sent = (size_t)((sim.nowUs - handle->txStartUs) * handle->baudRate / 10000000ULL); //bytes out so far
+    sim.counters.uartBusyUs -= handle->txDoneUs - sim.nowUs;
+    handle->txBusy = false;
+    if(handle->writeCallback){
+        handle->writeCallback(handle, (void *)handle->txBuf, sent);
+    }
+}
+
+
+/**
+ * @brief State of the simulated NVS region. Not touched by max32664SimInit(): flash keeps its contents over a reset
+ */
+static struct NVS_Config_ {
+    uint8_t data[SIM_NVS_REGION_SIZE];
+    bool formatted; //erased to 0xFF on first open
+} simNvsObject;
+
+
+void NVS_init(void){
+}
+
+
+void NVS_Params_init(NVS_Params *params){
+    memset(params, 0, sizeof(*params));
+}
+
+
+NVS_Handle NVS_open(uint_least8_t index, NVS_Params *params){
+    if(index >= CONFIG_TI_DRIVERS_NVS_COUNT){
+        return NULL;
+    }
+    if(!simNvsObject.formatted){ //blank flash
+        memset(simNvsObject.data, 0xFF, sizeof(simNvsObject.data));
+        simNvsObject.formatted = true;
+    }
+    return &simNvsObject;
+}
+
+
+void NVS_close(NVS_Handle handle){
+}
+
+
+void NVS_getAttrs(NVS_Handle handle, NVS_Attrs *attrs){
+    attrs->regionBase = handle->data;
+    attrs->regionSize = sizeof(handle->data);
+    attrs->sectorSize = SIM_NVS_SECTOR_SIZE;
+}
+
+
+int_fast16_t NVS_read(NVS_Handle handle, size_t offset, void *buffer, size_t bufferSize){
+    if(offset + bufferSize > sizeof(handle->data)){
+        return NVS_STATUS_INV_OFFSET;
+    }
+    memcpy(buffer, &handle->data[offset], bufferSize);
+    return NVS_STATUS_SUCCESS;
+}
+
+
+int_fast16_t NVS_erase(NVS_Handle handle, size_t offset, size_t size){
+    if(offset % SIM_NVS_SECTOR_SIZE || size % SIM_NVS_SECTOR_SIZE || offset + size > sizeof(handle->data)){
+        return NVS_STATUS_INV_OFFSET;
+    }
+    memset(&handle->data[offset], 0xFF, size);
+    simAdvance((size / SIM_NVS_SECTOR_SIZE) * (uint64_t)SIM_NVS_ERASE_US);
+    sim.counters.nvsErases += (uint32_t)(size / SIM_NVS_SECTOR_SIZE);
+    return NVS_STATUS_SUCCESS;
+}
+
+
+int_fast16_t NVS_write(NVS_Handle handle, size_t offset, void *buffer, size_t bufferSize, uint_fast16_t flags){
+    const uint8_t *src = (const uint8_t *)buffer;
+    size_t i;
+
+    if(offset + bufferSize > sizeof(handle->data)){
+        return NVS_STATUS_INV_OFFSET;
+    }
+    if(flags & NVS_WRITE_ERASE){ //erase the sectors covered
+        size_t first = offset - offset % SIM_NVS_SECTOR_SIZE;
+        size_t last = (offset + bufferSize + SIM_NVS_SECTOR_SIZE - 1) / SIM_NVS_SECTOR_SIZE * SIM_NVS_SECTOR_SIZE;
+        NVS_erase(handle, first, last - first);
+    }
+    for(i = 0; i < bufferSize; i++){ //programming can only clear bits
+        handle->data[offset + i] &= src[i];
+    }
+    simAdvance((bufferSize + 3) / 4 * (uint64_t)SIM_NVS_WRITE_US);
+    sim.counters.nvsWrites++;
+    if((flags & NVS_WRITE_POST_VERIFY) && memcmp(&handle->data[offset], src, bufferSize) != 0){
+        return NVS_STATUS_INV_WRITE;
+    }
+    return NVS_STATUS_SUCCESS;
+}
+
+
+int usleep(useconds_t us){
+    simAdvance(us);
+    sim.counters.sleepUs += us;
+    return 0;
+}
+
+
+unsigned int sleep(unsigned int seconds){
+    simAdvance((uint64_t)seconds * 1000000ULL);
+    sim.counters.sleepUs += (uint64_t)seconds * 1000000ULL;
+    return 0;
+}
+
+
+int clock_gettime(clockid_t clockId, struct timespec *tp){
+    if(clockId == CLOCK_MONOTONIC){ //the simulated clock
+        tp->tv_sec = (time_t)(sim.nowUs / 1000000ULL);
+        tp->tv_nsec = (long)(sim.nowUs % 1000000ULL) * 1000L;
+        return 0;
+    }
+    return (int)syscall(SYS_clock_gettime, clockId, tp); //real clocks (CPU time, realtime)
+}
@@ -0,0 +1,224 @@
+/**
+ * @file max32664_sim.h
+ *
+ * @brief Host (Linux) simulator of the MAX32664 Biometric Sensor Hub and its MAX30101 pulse oximeter
+ *
+ * The simulator implements the TI-Drivers I2C_transfer()/GPIO_write() entry points declared in host/include so that
+ * bio_sensor.c can be compiled and run unchanged on a workstation. It models:
+ *
+ * - the family/index/write byte command protocol, with a read phase that returns the status byte followed by data
+ *
+ * - command processing latency (ERR_TRY_AGAIN is returned when the read phase comes too early)
+ *
+ * - reset pin and device mode handling, including the boot and application initialization windows
+ *
+ * - the output FIFO, filled at the MAX30101 sample rate held in the CONFIGURATION_REGISTER, with overflow
+ *
+ * - the external (host accelerometer) input FIFO: with the host accelerometer enabled, every sample the hub produces
+ *   uses one input sample, and an empty input FIFO counts as an underflow
+ *
+ * - PPG waveforms (IR/red) with a configurable heart rate, respiration modulation, R value and noise
+ *
+ * - the WHRM/MaximFast algorithm output (mode 1 and mode 2)
+ *
+ * - the UART used for streaming output, in blocking and callback write modes (8N1 at the opened baud rate)
+ *
+ * - the bootloader flash sequence (page count, IV, auth, erase, authenticated pages) with erase and page write times
+ *
+ * - an internal flash NVS region (erase/program timing, contents kept over max32664SimInit())
+ *
+ * Time is virtual: usleep() and sleep() advance a simulated clock instead of blocking and every I2C transfer is
+ * charged the time needed to clock its bytes at the configured bus rate. CLOCK_MONOTONIC reads through
+ * clock_gettime() return the simulated clock, so library timestamps stay consistent with simulated time.
+ */
+
+#ifndef MAX32664_SIM_H_
+#define MAX32664_SIM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SIM_OUTPUT_FIFO_DEPTH  64  ///< Number of samples the simulated output FIFO holds before overflowing
+#define SIM_INPUT_FIFO_DEPTH   32  ///< Number of samples the simulated external (accelerometer) input FIFO holds
+
+/**
+ * @brief Simulation parameters. Fill with max32664SimDefaultConfig() and override what is needed
+ */
+struct max32664SimConfig {
+    uint32_t busHz;             ///< I2C SCL frequency used to charge bus time, Hz
+    uint32_t cmdLatencyUs;      ///< Time the hub needs to process a command before its status byte is valid, us
+    uint32_t enableLatencyUs;   ///< Time the hub needs to process a sensor/algorithm enable command, us
+    uint32_t resetBootUs;       ///< Time after the reset pin is released during which the hub does not ACK, us
+    uint32_t appInitUs;         ///< Time after boot/EXIT_BOOTLOADER during which application commands get ERR_TRY_AGAIN, us
+    uint32_t confidenceRampUs;  ///< Time after the WHRM algorithm is enabled until confidence reaches 100%, us
+    uint16_t heartRateX10;      ///< Simulated heart rate, LSB = 0.1bpm
+    uint16_t respRateX10;       ///< Simulated respiration rate, LSB = 0.1 breaths/min
+    uint16_t rsaX10;            ///< Peak heart rate swing with respiration (sinus arrhythmia), LSB = 0.1bpm, 0 = none
+    uint32_t irDc;              ///< DC level of the IR channel, ADC counts
+    uint32_t redDc;             ///< DC level of the red channel, ADC counts
+    uint32_t irAc;              ///< Peak AC amplitude of the IR channel, ADC counts
+    uint16_t rValueX1000;       ///< Ratio of ratios (red AC/DC over IR AC/DC) * 1000, sets the red AC amplitude
+    uint16_t noise;             ///< Peak uniform noise added to each channel, ADC counts
+    uint16_t tryAgainPerMille;  ///< Probability (per 1000 reads) of an injected ERR_TRY_AGAIN status byte
+    uint16_t nackPerMille;      ///< Probability (per 1000 transfers) of an injected data NACK
+    uint32_t seed;              ///< Seed of the noise and fault injection generator
+    uint32_t btlEraseUs;        ///< Time the bootloader needs for ERASE_FLASH, us
+    uint32_t btlPageUs;         ///< Time the bootloader needs to write one page after receiving it, us
+    uint16_t btlDropPage;       ///< Page (1 = first) the bootloader loses once: no status until it is sent again, 0 = none
+};
+
+/**
+ * @brief Counters kept by the simulator. Everything the host does on the bus is visible here
+ */
+struct max32664SimCounters {
+    uint32_t transfers;         ///< Calls to I2C_transfer()
+    uint32_t commands;          ///< Write phases (host commands) received
+    uint32_t bytesTx;           ///< Bytes written by the host, excluding the address byte
+    uint32_t bytesRx;           ///< Bytes read by the host, excluding the address byte
+    uint32_t nacks;             ///< Transfers that were NACKed (reset, booting or injected)
+    uint32_t tryAgain;          ///< Read phases answered with ERR_TRY_AGAIN
+    uint32_t samplesProduced;   ///< Samples pushed into the output FIFO
+    uint32_t samplesRead;       ///< Samples popped from the output FIFO by the host
+    uint32_t samplesOverflowed; ///< Samples lost because the output FIFO was full
+    uint32_t emptyReads;        ///< FIFO data reads done while the output FIFO was empty
+    uint64_t sleepUs;           ///< Simulated time spent in usleep()/sleep(), us
+    uint64_t busUs;             ///< Simulated time spent clocking bytes on the bus, us
+    uint32_t uartWrites;        ///< Calls to UART_write()
+    uint32_t uartBytes;         ///< Bytes sent on the UART
+    uint64_t uartBusyUs;        ///< Simulated time the UART spent sending, us
+    uint32_t pagesFlashed;      ///< Bootloader pages accepted (authenticated and written)
+    uint32_t nvsWrites;         ///< Calls to NVS_write()
+    uint32_t nvsErases;         ///< NVS sectors erased
+    uint32_t accelWritten;      ///< Host accelerometer samples accepted into the input FIFO
+    uint32_t accelOverflows;    ///< Host accelerometer samples lost because the input FIFO was full
+    uint32_t accelUnderflows;   ///< Samples the hub produced with host accelerometer enabled and the input FIFO empty
+};
+
+
+/**
+ * @brief   Fills a configuration structure with the default model: 400kHz bus, 2ms command latency, 40ms enable latency,
+ *          72bpm heart rate, 15 breaths/min, R = 0.5, light noise, no fault injection
+ *
+ * @param   *cfg Pointer to configuration to fill
+ */
+void max32664SimDefaultConfig(struct max32664SimConfig *cfg);
+
+
+/**
+ * @brief   Powers up the simulated hub with the given configuration. Resets the simulated clock, counters and all
+ *          hub/MAX30101 state. The hub starts in application mode, ready to accept commands
+ *
+ * @param   *cfg Pointer to configuration, NULL for the default configuration
+ */
+void max32664SimInit(const struct max32664SimConfig *cfg);
+
+
+/**
+ * @brief   Reads the simulated clock
+ *
+ * @return  Simulated time since max32664SimInit(), us
+ */
+uint64_t max32664SimNowUs(void);
+
+
+/**
+ * @brief   Advances the simulated clock without counting it as sleep time (e.g. to model host processing time)
+ *
+ * @param   us Time to advance, us
+ */
+void max32664SimAdvanceUs(uint64_t us);
+
+
+/**
+ * @brief   Copies the simulator counters
+ *
+ * @param   *counters Pointer to structure to fill
+ */
+void max32664SimGetCounters(struct max32664SimCounters *counters);
+
+
+/**
+ * @brief   Computes the 16 authentication bytes the simulated bootloader expects after a page of an .msbl image
+ *          (stands in for the AES MAC of a real image, so host programs can generate images it accepts)
+ *
+ * @param   pageIndex Page number in the image, from 0
+ * @param   *page     Pointer to page data
+ * @param   len       Page size, bytes
+ * @param   *mac      Pointer to 16 bytes to fill
+ */
+void max32664SimPageMac(uint16_t pageIndex, const uint8_t *page, uint16_t len, uint8_t *mac);
+
+
+/**
+ * @brief   Clears the simulator counters. The simulated clock and hub state are left untouched
+ */
+void max32664SimResetCounters(void);
+
+
+/**
+ * @brief   Places or removes the simulated finger. Without a finger the PPG drops to ambient level,
+ *          the algorithm state goes to 0 and extStatus to -3 (no object)
+ *
+ * @param   present true when a finger is on the sensor
+ */
+void max32664SimSetFinger(bool present);
+
+
+/**
+ * @brief   Forces the algorithm extended status (e.g. -2 device motion, -4 pressing too hard, -6 finger motion).
+ *          0 returns to normal operation
+ *
+ * @param   extStatus Extended status to report while a finger is present
+ */
+void max32664SimSetExtStatus(int8_t extStatus);
+
+
+/**
+ * @brief   Changes the simulated heart rate and SpO2 ratio while running
+ *
+ * @param   heartRateX10 Heart rate, LSB = 0.1bpm
+ * @param   rValueX1000  Ratio of ratios * 1000
+ */
+void max32664SimSetVitals(uint16_t heartRateX10, uint16_t rValueX1000);
+
+
+/**
+ * @brief   Generates sample n of a gap-free IR/red stream at any sample rate, with the current vitals, noise and finger
+ *          state. For signal processing benchmarks that need more samples per second than the I2C transport drains
+ *
+ * @param   n          Sample index, sample 0 is at time 0
+ * @param   sampleRate Sample rate, Hz
+ * @param   *ir        Pointer to IR ADC count
+ * @param   *red       Pointer to red ADC count
+ */
+void max32664SimPpg(uint64_t n, uint16_t sampleRate, uint32_t *ir, uint32_t *red);
+
+
+/**
+ * @brief   Cardiac cycles completed at a time, from the heart rate and its respiratory swing (rsaX10). The waveform
+ *          repeats with each whole cycle, so beat k of the simulated pulse is where this reaches k plus a constant
+ *
+ * @param   t Time, s (sample n of max32664SimPpg() is at n / sampleRate)
+ *
+ * @return  Cycles since time 0
+ */
+double max32664SimCardiacCycles(double t);
+
+
+/**
+ * @brief   Number of samples currently waiting in the simulated output FIFO
+ *
+ * @return  Output FIFO depth in samples
+ */
+uint32_t max32664SimFifoCount(void);
+
+
+/**
+ * @brief   Time at which the most recent sample popped from the output FIFO by the host was produced.
+ *          Subtracting it from max32664SimNowUs() after a read gives the drain latency of that sample
+ *
+ * @return  Production time of the last sample read, us (simulated clock)
+ */
+uint64_t max32664SimLastReadSampleUs(void);
+
+#endif /* MAX32664_SIM_H_ */
@@ -0,0 +1,18 @@
+#!/bin/sh
+# Builds the host benchmarks and gates them against the committed baselines.
+# Run from the project root: sh host/run_bench.sh [--tolerance <percent>]
+# Exits non-zero when a benchmark regresses.
+
+set -e
+
+CC=${CC:-gcc}
+CFLAGS="-std=gnu99 -O2 -Wall -Ihost/include -Ihost -I."
+LIB="bio_sensor.c bio_latency.c bio_codec.c bio_frame.c bio_uart_out.c bio_format.c bio_sched.c bio_nvs.c bio_flash.c bio_accel.c bio_math.c bio_hr.c bio_spo2.c bio_hrv.c bio_resp.c bio_decim.c bio_sqi.c bio_agg.c bio_event.c host/max32664_sim.c host/bench_common.c"
+BUILD=host/build
+
+mkdir -p $BUILD
+
+for bench in bench_api bench_stream bench_startup bench_codec bench_output bench_format bench_sched bench_flash bench_accel bench_hr bench_spo2 bench_hrv bench_resp bench_decim bench_sqi bench_agg bench_event; do
+    $CC $CFLAGS $LIB host/$bench.c -lm -o $BUILD/$bench
+    $BUILD/$bench --check host/${bench}_baseline.tsv "$@" > $BUILD/$bench.tsv
+done
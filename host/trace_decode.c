@@ -0,0 +1,94 @@
+/**
+ * @file trace_decode.c
+ *
+ * @brief Converts a binary transaction trace dump (bioTraceDump(), library built with -DBIO_TRACE) to CSV
+ *
+ * Usage: trace_decode [dump file]   (reads stdin without a file)
+ *
+ * One line is printed per hub transaction, oldest first:
+ * record, start_us, delta_us (since the previous record), family, index, write_count, write_bytes, status, i2c_status,
+ * gap_us (write phase end to read phase start), read_us (read phase duration)
+ *
+ * Several dumps may be concatenated in one file (e.g. a capture of the UART over a whole session).
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define BIO_TRACE //trace record layout
+
+#include "bio_sensor.h"
+
+
+/**
+ * @brief   Reads a little endian 16/32-bit value
+ */
+static uint16_t traceGet16(const uint8_t *buf){
+    return (uint16_t)(buf[0] | (buf[1] << 8));
+}
+
+
+static uint32_t traceGet32(const uint8_t *buf){
+    return (uint32_t)buf[0] | ((uint32_t)buf[1] << 8) | ((uint32_t)buf[2] << 16) | ((uint32_t)buf[3] << 24);
+}
+
+
+int main(int argc, char **argv){
+    FILE *in = stdin;
+    uint8_t header[sizeof(struct bioTraceHeader)];
+    uint8_t record[256];
+    uint32_t dumps = 0;
+
+    if(argc > 1 && !(in = fopen(argv[1], "rb"))){
+        fprintf(stderr, "trace_decode: cannot open %s\n", argv[1]);
+        return 1;
+    }
+
+    printf("record,start_us,delta_us,family,index,write_count,write_bytes,status,i2c_status,gap_us,read_us\n");
+
+    while(fread(header, sizeof(header), 1, in) == 1){
+        uint16_t recordSize = traceGet16(&header[4]);
+        uint16_t numRecords = traceGet16(&header[6]);
+        uint32_t totalRecords = traceGet32(&header[8]);
+        uint32_t previousUs = 0;
+        uint16_t n;
+
+        if(traceGet32(&header[0]) != BIO_TRACE_MAGIC || recordSize < sizeof(struct bioTraceRecord) || recordSize > sizeof(record)){
+            fprintf(stderr, "trace_decode: bad dump header after %u dump(s)\n", dumps);
+            return 1;
+        }
+        if(totalRecords > numRecords){
+            fprintf(stderr, "trace_decode: dump %u: %u older records were overwritten\n", dumps, totalRecords - numRecords);
+        }
+
+        for(n = 0; n < numRecords; n++){
+            uint32_t startUs;
+            uint8_t writeCount, i;
+            char writeBytes[4 * BIO_TRACE_WRITE_BYTES + 4] = "";
+
+            if(fread(record, recordSize, 1, in) != 1){
+                fprintf(stderr, "trace_decode: dump %u truncated at record %u\n", dumps, n);
+                return 1;
+            }
+
+            startUs = traceGet32(&record[0]);
+            writeCount = record[10];
+            for(i = 0; i < writeCount && i < BIO_TRACE_WRITE_BYTES; i++){ //write bytes kept in the record
+                snprintf(&writeBytes[strlen(writeBytes)], sizeof(writeBytes) - strlen(writeBytes), "%s%02X", i ? " " : "", record[13 + i]);
+            }
+            if(writeCount > BIO_TRACE_WRITE_BYTES){
+                strcat(writeBytes, " ..");
+            }
+
+            printf("%u,%u,%u,0x%02X,0x%02X,%u,%s,0x%02X,%d,%u,%u\n",
+                   totalRecords - numRecords + n, startUs, n ? startUs - previousUs : 0,
+                   record[8], record[9], writeCount, writeBytes, record[11], (int8_t)record[12],
+                   traceGet16(&record[4]), traceGet16(&record[6]));
+            previousUs = startUs;
+        }
+        dumps++;
+    }
+
+    return 0;
+}